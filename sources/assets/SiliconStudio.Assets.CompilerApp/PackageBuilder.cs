@@ -10,10 +10,12 @@ using SiliconStudio.BuildEngine;
 using SiliconStudio.Core;
 using SiliconStudio.Core.Diagnostics;
 using SiliconStudio.Core.IO;
+using SiliconStudio.Core.LZ4;
 using SiliconStudio.Core.MicroThreading;
 using SiliconStudio.Core.Serialization.Assets;
 
 using System.Threading;
+using SiliconStudio.Xenko;
 using SiliconStudio.Xenko.Assets;
 using SiliconStudio.Xenko.Graphics;
 
@@ -158,9 +160,10 @@ namespace SiliconStudio.Assets.CompilerApp
                 var result = builder.Run(Builder.Mode.Build);
                 builder.WriteIndexFile(false);
 
-                // Fill list of bundles
+                // Fill list of bundles, compressed with LZ4HC and optimal parsing for end-user releases, and with the faster LZ4 otherwise
                 var bundlePacker = new BundlePacker();
-                bundlePacker.Build(builderOptions.Logger, projectSession, buildProfile, indexName, outputDirectory, builder.DisableCompressionIds);
+                var compressionLevel = context.GetCompilationMode() == CompilationMode.AppStore ? LZ4Codec.OptimalCompressionLevelHC : 0;
+                bundlePacker.Build(builderOptions.Logger, projectSession, buildProfile, indexName, outputDirectory, builder.DisableCompressionIds, compressionLevel);
 
                 return result;
             }
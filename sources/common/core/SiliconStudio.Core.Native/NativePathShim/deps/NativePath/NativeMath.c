@@ -0,0 +1,11 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+#include <math.h>
+#include "NativeMath.h"
+
+void npLolSincosf(float x, float* s, float* c)
+{
+	*s = sinf(x);
+	*c = cosf(x);
+}
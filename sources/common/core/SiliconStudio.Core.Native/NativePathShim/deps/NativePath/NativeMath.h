@@ -0,0 +1,15 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Same signature as NativePath, implemented with sinf and cosf in NativeMath.c
+extern void npLolSincosf(float x, float* s, float* c);
+
+#ifdef __cplusplus
+}
+#endif
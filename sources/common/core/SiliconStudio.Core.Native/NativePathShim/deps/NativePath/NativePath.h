@@ -0,0 +1,7 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+// Stand-in for the NativePath headers included by libxenkonative, used by the benchmark target of Makefile.Linux when deps/NativePath is not checked out.
+// The includes of libxenkonative are relative ("../../../deps/NativePath/..."), they are resolved here through -iquote NativePathShim/deps/NativePath/standard.
+
+#pragma once
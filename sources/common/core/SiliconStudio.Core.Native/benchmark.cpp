@@ -0,0 +1,796 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+// Microbenchmarks of the native kernels of libcore and libxenkonative.
+// Build and run with: CFLAGS=-O3 make -f Makefile.Linux benchmark [BENCHMARK_ARGS="<filter> --min-time=<seconds>"]
+// Each result is printed as one JSON object per line, so that the output can be collected and compared by CI.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "XenkoNative.h"
+#include "matrix.h"
+
+extern "C" {
+int Core_LZ4_compress(const char* source, char* dest, int inputSize);
+int Core_LZ4_compress_fast(const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+int Core_LZ4_compress_HC(const char* source, char* dest, int inputSize, int maxOutputSize, int compressionLevel);
+void* Core_LZ4_createStream(void);
+int Core_LZ4_freeStream(void* streamPtr);
+int Core_LZ4_compress_fast_extState(void* state, const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+void* Core_LZ4_createStreamHC(void);
+int Core_LZ4_freeStreamHC(void* streamHCPtr);
+int Core_LZ4_compress_HC_extStateHC(void* state, const char* source, char* dest, int inputSize, int maxOutputSize, int compressionLevel);
+void Core_LZ4_resetStream(void* streamPtr);
+int Core_LZ4_compress_fast_continue(void* streamPtr, const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+int Core_LZ4_saveDict(void* streamPtr, char* safeBuffer, int dictSize);
+void Core_LZ4_resetStreamHC(void* streamHCPtr, int compressionLevel);
+int Core_LZ4_compress_HC_continue(void* streamHCPtr, const char* source, char* dest, int inputSize, int maxOutputSize);
+int Core_LZ4_saveDictHC(void* streamHCPtr, char* safeBuffer, int dictSize);
+int Core_LZ4_decompress_safe_usingDict(const char* source, char* dest, int compressedSize, int maxDecompressedSize, const char* dictStart, int dictSize);
+int Core_LZ4_loadDict(void* streamPtr, const char* dictionary, int dictSize);
+int Core_LZ4_loadDictHC(void* streamHCPtr, const char* dictionary, int dictSize);
+void Core_LZ4_attachDictionary(void* workingStream, const void* dictionaryStream);
+void Core_LZ4_attachDictionaryHC(void* workingStream, const void* dictionaryStream);
+int Core_LZ4_trainDict(char* dictBuffer, int dictCapacity, const char* samplesBuffer, const int* sampleSizes, int nbSamples);
+unsigned int Core_LZ4_checksum(const void* input, int length, unsigned int seed);
+int Core_LZ4_compress_limitedOutput(const char* source, char* dest, int inputSize, int maxOutputSize);
+int Core_LZ4_compressHC(const char* source, char* dest, int inputSize);
+int Core_LZ4_compressHC_limitedOutput(const char* source, char* dest, int inputSize, int maxOutputSize);
+int Core_LZ4_uncompress(const char* source, char* dest, int outputSize);
+int Core_LZ4_uncompress_unknownOutputSize(const char* source, char* dest, int inputSize, int maxOutputSize);
+}
+
+static const char* Filter = NULL;
+static double MinimumTime = 0.5;
+static int Failures = 0;
+
+static double Now()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+// Deterministic pseudo random numbers, so that every run measures the same payloads
+static unsigned int RandomState = 1;
+
+static unsigned int NextRandom()
+{
+	RandomState = RandomState * 1664525u + 1013904223u;
+	return RandomState >> 8;
+}
+
+static float NextRandomFloat()
+{
+	return (NextRandom() & 0xFFFF) / 65535.0f;
+}
+
+static bool IsSelected(const char* name)
+{
+	return Filter == NULL || strstr(name, Filter) != NULL;
+}
+
+static void Report(const char* name, const char* unit, double workPerIteration, long long iterations, double seconds, const char* extra)
+{
+	printf("{\"benchmark\":\"%s\",\"unit\":\"%s\",\"value\":%.6g,\"iterations\":%lld,\"seconds\":%.6f%s%s}\n",
+		name, unit, workPerIteration * iterations / seconds, iterations, seconds, extra ? "," : "", extra ? extra : "");
+	fflush(stdout);
+}
+
+// Runs 'run' until MinimumTime is spent, doubling the number of iterations of each timed batch
+template<typename Function>
+static void Measure(const char* name, const char* unit, double workPerIteration, const char* extra, Function run)
+{
+	if (!IsSelected(name))
+		return;
+
+	run(); // warm up caches and lazily selected kernels
+
+	long long iterations = 0;
+	long long batch = 1;
+	double start = Now();
+	double elapsed = 0;
+	while (elapsed < MinimumTime)
+	{
+		for (long long i = 0; i < batch; i++)
+			run();
+		iterations += batch;
+		batch *= 2;
+		elapsed = Now() - start;
+	}
+
+	Report(name, unit, workPerIteration, iterations, elapsed, extra);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Sprites (libxenkonative)
+//----------------------------------------------------------------------------------------------------------------------------------
+
+// Same layout as BatchBase<SpriteDrawInfo>.ElementInfo
+struct SpriteElementInfo
+{
+	int VertexCount;
+	int IndexCount;
+	float Depth;
+	SpriteDrawInfo DrawInfo;
+};
+
+static const int SpriteCount = 16384;
+
+static void BenchmarkSprites()
+{
+	SpriteElementInfo* elementInfos = (SpriteElementInfo*)calloc(SpriteCount, sizeof(SpriteElementInfo));
+	VertexPositionColorTextureSwizzle* vertices = (VertexPositionColorTextureSwizzle*)malloc(SpriteCount * 4 * sizeof(VertexPositionColorTextureSwizzle));
+	VertexPositionColorTextureSwizzleCompact* compactVertices = (VertexPositionColorTextureSwizzleCompact*)malloc(SpriteCount * 4 * sizeof(VertexPositionColorTextureSwizzleCompact));
+
+	for (int rotated = 0; rotated < 2; rotated++)
+	{
+		RandomState = 1;
+		for (int i = 0; i < SpriteCount; i++)
+		{
+			SpriteDrawInfo* drawInfo = &elementInfos[i].DrawInfo;
+			drawInfo->Source.x = (float)(NextRandom() % 224);
+			drawInfo->Source.y = (float)(NextRandom() % 224);
+			drawInfo->Source.width = drawInfo->Source.height = 32;
+			drawInfo->Destination.x = NextRandomFloat() * 1920;
+			drawInfo->Destination.y = NextRandomFloat() * 1080;
+			drawInfo->Destination.width = drawInfo->Destination.height = 32;
+			drawInfo->Origin.X = drawInfo->Origin.Y = 16;
+			drawInfo->Rotation = rotated ? NextRandomFloat() * 6.2831853f : 0.0f;
+			drawInfo->Depth = NextRandomFloat();
+			drawInfo->Color.R = drawInfo->Color.G = drawInfo->Color.B = drawInfo->Color.A = 1.0f;
+			drawInfo->TextureSize.X = drawInfo->TextureSize.Y = 256;
+		}
+
+		static const char* PrecisionNames[3] = { "exact", "fast", "approximate" };
+		const char* spritesName = rotated ? "rotated" : "unrotated";
+		char name[256];
+
+		for (int precision = 0; precision < 3; precision++)
+		{
+			snprintf(name, sizeof(name), "sprite/vertices/%s/%s", spritesName, PrecisionNames[precision]);
+			Measure(name, "sprites/s", SpriteCount, NULL, [&]()
+			{
+				UpdateBufferValuesFromElementInfoBatch(&elementInfos[0].DrawInfo, sizeof(SpriteElementInfo), NULL, SpriteCount, vertices, NULL, 0, precision);
+			});
+
+			snprintf(name, sizeof(name), "sprite/compact/%s/%s", spritesName, PrecisionNames[precision]);
+			Measure(name, "sprites/s", SpriteCount, NULL, [&]()
+			{
+				UpdateBufferValuesFromElementInfoBatchCompact(&elementInfos[0].DrawInfo, sizeof(SpriteElementInfo), NULL, SpriteCount, compactVertices, NULL, 0, precision);
+			});
+		}
+	}
+
+	free(compactVertices);
+	free(vertices);
+	free(elementInfos);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Matrices (libcore)
+//----------------------------------------------------------------------------------------------------------------------------------
+
+// Interleaved vertex of a mesh: position, normal and texture coordinate
+struct MeshVertex
+{
+	float Position[3];
+	float Normal[3];
+	float TextureCoordinate[2];
+};
+
+static void BenchmarkMatrices()
+{
+	const int MatrixCount = 1024;
+	const int VertexCount = 65536;
+	float* matrices = (float*)malloc(MatrixCount * 16 * sizeof(float));
+	float* results = (float*)malloc(MatrixCount * 16 * sizeof(float));
+	float* scales = (float*)malloc(MatrixCount * 3 * sizeof(float));
+	float* rotations = (float*)malloc(MatrixCount * 4 * sizeof(float));
+	float* translations = (float*)malloc(MatrixCount * 3 * sizeof(float));
+	int* parentIndices = (int*)malloc(MatrixCount * sizeof(int));
+	MeshVertex* vertices = (MeshVertex*)malloc(VertexCount * sizeof(MeshVertex));
+	MeshVertex* transformedVertices = (MeshVertex*)malloc(VertexCount * sizeof(MeshVertex));
+	float* vectors = (float*)malloc(VertexCount * 4 * sizeof(float));
+	float* transformedVectors = (float*)malloc(VertexCount * 4 * sizeof(float));
+
+	RandomState = 1;
+	for (int i = 0; i < MatrixCount * 16; i++)
+		matrices[i] = NextRandomFloat() * 2 - 1;
+
+	// a skeleton: every node but the root has an earlier parent
+	parentIndices[0] = -1;
+	for (int i = 1; i < MatrixCount; i++)
+		parentIndices[i] = NextRandom() % i;
+
+	for (int i = 0; i < VertexCount; i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			vertices[i].Position[j] = NextRandomFloat() * 100 - 50;
+			vertices[i].Normal[j] = NextRandomFloat() * 2 - 1;
+		}
+		vertices[i].TextureCoordinate[0] = vertices[i].TextureCoordinate[1] = 0;
+	}
+	for (int i = 0; i < VertexCount * 4; i++)
+		vectors[i] = NextRandomFloat() * 2 - 1;
+
+	static const int KernelSets[] = { MATRIX_KERNELS_SCALAR, MATRIX_KERNELS_SSE, MATRIX_KERNELS_AVX, MATRIX_KERNELS_NEON };
+	static const char* KernelNames[] = { "scalar", "sse", "avx", "neon" };
+	for (int k = 0; k < 4; k++)
+	{
+		// not compiled in or not supported by this CPU
+		if (MatrixSelectKernels(KernelSets[k]) != KernelSets[k])
+			continue;
+
+		char name[256];
+		snprintf(name, sizeof(name), "matrix/Matrix4Multiply/%s", KernelNames[k]);
+		Measure(name, "matrices/s", MatrixCount, NULL, [&]()
+		{
+			for (int i = 0; i < MatrixCount; i++)
+				Matrix4Multiply(matrices + 16 * i, matrices + 16 * ((i + 1) & (MatrixCount - 1)), results + 16 * i);
+		});
+
+		snprintf(name, sizeof(name), "matrix/Matrix4TransformVector4/%s", KernelNames[k]);
+		Measure(name, "vectors/s", MatrixCount * 4, NULL, [&]()
+		{
+			for (int i = 0; i < MatrixCount; i++)
+			{
+				for (int j = 0; j < 4; j++)
+					Matrix4TransformVector4(matrices + 16 * i, matrices + 16 * ((i + 1) & (MatrixCount - 1)) + 4 * j, results + 16 * i + 4 * j);
+			}
+		});
+
+		snprintf(name, sizeof(name), "matrix/Matrix4Transpose/%s", KernelNames[k]);
+		Measure(name, "matrices/s", MatrixCount, NULL, [&]()
+		{
+			for (int i = 0; i < MatrixCount; i++)
+				Matrix4Transpose(matrices + 16 * i, results + 16 * i);
+		});
+
+		snprintf(name, sizeof(name), "matrix/Matrix4Invert/%s", KernelNames[k]);
+		Measure(name, "matrices/s", MatrixCount, NULL, [&]()
+		{
+			for (int i = 0; i < MatrixCount; i++)
+				Matrix4Invert(matrices + 16 * i, results + 16 * i);
+		});
+
+		snprintf(name, sizeof(name), "matrix/Matrix4Decompose/%s", KernelNames[k]);
+		Measure(name, "matrices/s", MatrixCount, NULL, [&]()
+		{
+			for (int i = 0; i < MatrixCount; i++)
+				Matrix4Decompose(matrices + 16 * i, scales + 3 * i, rotations + 4 * i, translations + 3 * i);
+		});
+
+		// Array kernels: the whole array in a single call
+		snprintf(name, sizeof(name), "matrix/Matrix4MultiplyArray/%s", KernelNames[k]);
+		Measure(name, "matrices/s", MatrixCount, NULL, [&]()
+		{
+			Matrix4MultiplyArray(matrices, 16 * sizeof(float), matrices + 16, 16 * sizeof(float), results, 16 * sizeof(float), MatrixCount - 1);
+		});
+
+		snprintf(name, sizeof(name), "matrix/Matrix4MultiplyArrayByMatrix/%s", KernelNames[k]);
+		Measure(name, "matrices/s", MatrixCount, NULL, [&]()
+		{
+			Matrix4MultiplyArrayByMatrix(matrices, 16 * sizeof(float), matrices, results, 16 * sizeof(float), MatrixCount);
+		});
+
+		snprintf(name, sizeof(name), "matrix/Matrix4ConcatenateHierarchy/%s", KernelNames[k]);
+		Measure(name, "matrices/s", MatrixCount, NULL, [&]()
+		{
+			Matrix4ConcatenateHierarchy(matrices, 16 * sizeof(float), parentIndices, sizeof(int), results, 16 * sizeof(float), MatrixCount);
+		});
+
+		// Vector streams: positions and normals of an interleaved vertex buffer, packed float4
+		snprintf(name, sizeof(name), "matrix/Vector3TransformCoordinateArray/%s", KernelNames[k]);
+		Measure(name, "vectors/s", VertexCount, NULL, [&]()
+		{
+			Vector3TransformCoordinateArray(matrices, vertices[0].Position, sizeof(MeshVertex), transformedVertices[0].Position, sizeof(MeshVertex), VertexCount);
+		});
+
+		snprintf(name, sizeof(name), "matrix/Vector3TransformNormalArray/%s", KernelNames[k]);
+		Measure(name, "vectors/s", VertexCount, NULL, [&]()
+		{
+			Vector3TransformNormalArray(matrices, vertices[0].Normal, sizeof(MeshVertex), transformedVertices[0].Normal, sizeof(MeshVertex), VertexCount);
+		});
+
+		snprintf(name, sizeof(name), "matrix/Vector4TransformArray/%s", KernelNames[k]);
+		Measure(name, "vectors/s", VertexCount, NULL, [&]()
+		{
+			Vector4TransformArray(matrices, vectors, 4 * sizeof(float), transformedVectors, 4 * sizeof(float), VertexCount);
+		});
+	}
+	MatrixSelectKernels(MATRIX_KERNELS_AUTO);
+
+	free(transformedVectors);
+	free(vectors);
+	free(transformedVertices);
+	free(vertices);
+	free(parentIndices);
+	free(translations);
+	free(rotations);
+	free(scales);
+	free(results);
+	free(matrices);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// LZ4 (libcore)
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static const int PayloadSize = 1 << 20;
+
+// Words of a small vocabulary: compresses like text and serialized asset names
+static void FillText(char* buffer, int size)
+{
+	static const char* Words[] = { "the ", "entity ", "component ", "transform ", "model ", "material ", "texture ", "of ", "and ", "sprite ", "asset ", "scene ", "0.5 ", "1.0 ", "\n" };
+	int position = 0;
+	while (position < size)
+	{
+		const char* word = Words[NextRandom() % (sizeof(Words) / sizeof(Words[0]))];
+		for (; *word && position < size; word++)
+			buffer[position++] = *word;
+	}
+}
+
+// Interleaved position, normal and texture coordinate floats of a tessellated grid: compresses like vertex buffers
+static void FillMesh(char* buffer, int size)
+{
+	float* vertex = (float*)buffer;
+	int floatCount = size / (int)sizeof(float);
+	for (int i = 0; i + 8 <= floatCount; i += 8)
+	{
+		int index = i / 8;
+		vertex[i + 0] = (float)(index % 256) * 0.1f;
+		vertex[i + 1] = NextRandomFloat() * 0.01f;
+		vertex[i + 2] = (float)(index / 256) * 0.1f;
+		vertex[i + 3] = 0.0f;
+		vertex[i + 4] = 1.0f;
+		vertex[i + 5] = 0.0f;
+		vertex[i + 6] = (float)(index % 256) / 255.0f;
+		vertex[i + 7] = (float)(index / 256 % 256) / 255.0f;
+	}
+}
+
+static void FillRandom(char* buffer, int size)
+{
+	for (int i = 0; i < size; i++)
+		buffer[i] = (char)NextRandom();
+}
+
+static void FillZeros(char* buffer, int size)
+{
+	memset(buffer, 0, size);
+}
+
+// Serialized assets of a few types, sharing their type and field names: the small objects of a bundle, compressed one by one
+static int FillObject(char* buffer, int capacity)
+{
+	static const char* Types[] = { "Entity", "ModelComponent", "TransformComponent", "MaterialAsset", "TextureAsset", "PrefabAsset" };
+	static const char* Fields[] = { "Position", "Rotation", "Scale", "Enabled", "Name", "Material", "Texture", "Priority", "Layer", "Color" };
+	int position = snprintf(buffer, capacity, "!SiliconStudio.Xenko.Engine.%s,SiliconStudio.Xenko.Engine\nId: %08x-%04x-%04x-%08x\n",
+		Types[NextRandom() % 6], NextRandom(), NextRandom() & 0xFFFF, NextRandom() & 0xFFFF, NextRandom());
+	int fieldCount = 3 + NextRandom() % 40;
+	for (int i = 0; i < fieldCount && position < capacity; i++)
+	{
+		const char* field = Fields[NextRandom() % 10];
+		switch (NextRandom() % 3)
+		{
+		case 0: position += snprintf(buffer + position, capacity - position, "    %s: {X: %.2f, Y: %.2f, Z: %.2f}\n", field, NextRandomFloat() * 20, NextRandomFloat() * 20, NextRandomFloat() * 20); break;
+		case 1: position += snprintf(buffer + position, capacity - position, "    %s: %s\n", field, NextRandom() % 2 ? "true" : "false"); break;
+		default: position += snprintf(buffer + position, capacity - position, "    %s: %u\n", field, NextRandom() % 100000); break;
+		}
+	}
+	return position < capacity ? position : capacity;
+}
+
+struct Payload
+{
+	const char* Name;
+	void (*Fill)(char* buffer, int size);
+};
+
+struct LZ4EntryPoints
+{
+	const char* Prefix;
+	int (*Compress)(const char* source, char* dest, int inputSize);
+	int (*CompressLimitedOutput)(const char* source, char* dest, int inputSize, int maxOutputSize);
+	int (*CompressHC)(const char* source, char* dest, int inputSize);
+	int (*CompressHCLimitedOutput)(const char* source, char* dest, int inputSize, int maxOutputSize);
+	int (*Uncompress)(const char* source, char* dest, int outputSize);
+	int (*UncompressUnknownOutputSize)(const char* source, char* dest, int inputSize, int maxOutputSize);
+	int (*CompressFast)(const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+	int (*CompressHCLevel)(const char* source, char* dest, int inputSize, int maxOutputSize, int compressionLevel);
+	void* (*CreateStream)(void);
+	int (*FreeStream)(void* streamPtr);
+	int (*CompressFastExtState)(void* state, const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+	void* (*CreateStreamHC)(void);
+	int (*FreeStreamHC)(void* streamHCPtr);
+	int (*CompressHCExtStateHC)(void* state, const char* source, char* dest, int inputSize, int maxOutputSize, int compressionLevel);
+	void (*ResetStream)(void* streamPtr);
+	int (*CompressFastContinue)(void* streamPtr, const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+	int (*SaveDict)(void* streamPtr, char* safeBuffer, int dictSize);
+	void (*ResetStreamHC)(void* streamHCPtr, int compressionLevel);
+	int (*CompressHCContinue)(void* streamHCPtr, const char* source, char* dest, int inputSize, int maxOutputSize);
+	int (*SaveDictHC)(void* streamHCPtr, char* safeBuffer, int dictSize);
+	int (*DecompressSafeUsingDict)(const char* source, char* dest, int compressedSize, int maxDecompressedSize, const char* dictStart, int dictSize);
+	int (*LoadDict)(void* streamPtr, const char* dictionary, int dictSize);
+	int (*LoadDictHC)(void* streamHCPtr, const char* dictionary, int dictSize);
+	void (*AttachDictionary)(void* workingStream, const void* dictionaryStream);
+	void (*AttachDictionaryHC)(void* workingStream, const void* dictionaryStream);
+	int (*TrainDict)(char* dictBuffer, int dictCapacity, const char* samplesBuffer, const int* sampleSizes, int nbSamples);
+	unsigned int (*Checksum)(const void* input, int length, unsigned int seed);
+};
+
+// Size of the blocks compressed in a row, as LZ4Stream does with the chunks of small assets
+static const int LZ4BlockSize = 64 * 1024;
+
+// Size of the small blocks compressed independently or linked to the previous ones, and of the native history of the linked
+// blocks (as LZ4CompressionContext.EncodeLinked keeps it: copied after the last 64KB of the previous ones)
+static const int LZ4SmallBlockSize = 16 * 1024;
+static const int LZ4HistorySize = 256 * 1024;
+
+// Small objects compressed alone or with a dictionary trained out of other ones of the same bundle (as BundleOdbBackend does)
+static const int LZ4ObjectCapacity = 4 * 1024;
+static const int LZ4ObjectCount = 1024;
+static const int LZ4DictionaryCapacity = 16 * 1024;
+
+static void CheckRoundTrip(const char* name, const char* original, const char* decoded, int size, int result, int expectedResult)
+{
+	if (result != expectedResult || memcmp(original, decoded, size) != 0)
+	{
+		fprintf(stderr, "%s: round trip failed\n", name);
+		Failures++;
+	}
+}
+
+static void BenchmarkLZ4()
+{
+	static const Payload Payloads[] = { { "text", FillText }, { "mesh", FillMesh }, { "random", FillRandom }, { "zeros", FillZeros } };
+	static const LZ4EntryPoints EntryPoints[] =
+	{
+		{ "Core", Core_LZ4_compress, Core_LZ4_compress_limitedOutput, Core_LZ4_compressHC, Core_LZ4_compressHC_limitedOutput, Core_LZ4_uncompress, Core_LZ4_uncompress_unknownOutputSize, Core_LZ4_compress_fast, Core_LZ4_compress_HC,
+		  Core_LZ4_createStream, Core_LZ4_freeStream, Core_LZ4_compress_fast_extState, Core_LZ4_createStreamHC, Core_LZ4_freeStreamHC, Core_LZ4_compress_HC_extStateHC,
+		  Core_LZ4_resetStream, Core_LZ4_compress_fast_continue, Core_LZ4_saveDict, Core_LZ4_resetStreamHC, Core_LZ4_compress_HC_continue, Core_LZ4_saveDictHC, Core_LZ4_decompress_safe_usingDict,
+		  Core_LZ4_loadDict, Core_LZ4_loadDictHC, Core_LZ4_attachDictionary, Core_LZ4_attachDictionaryHC, Core_LZ4_trainDict, Core_LZ4_checksum },
+	};
+
+	// Bound of the payload compressed as small blocks, each of them having the worst case expansion
+	int boundSize = PayloadSize + (PayloadSize / LZ4SmallBlockSize) * (LZ4SmallBlockSize / 255 + 16);
+	char* source = (char*)malloc(PayloadSize);
+	char* compressed = (char*)malloc(boundSize);
+	char* compressedHC = (char*)malloc(boundSize);
+	char* scratch = (char*)malloc(boundSize);
+	char* decoded = (char*)malloc(PayloadSize);
+	const double megabytes = PayloadSize / (1024.0 * 1024.0);
+
+	for (size_t p = 0; p < sizeof(Payloads) / sizeof(Payloads[0]); p++)
+	{
+		const Payload& payload = Payloads[p];
+		RandomState = 1;
+		payload.Fill(source, PayloadSize);
+
+		for (size_t e = 0; e < sizeof(EntryPoints) / sizeof(EntryPoints[0]); e++)
+		{
+			const LZ4EntryPoints& lz4 = EntryPoints[e];
+			char name[256];
+			char extra[64];
+
+			int compressedSize = lz4.Compress(source, compressed, PayloadSize);
+			int compressedHCSize = lz4.CompressHC(source, compressedHC, PayloadSize);
+
+			snprintf(extra, sizeof(extra), "\"ratio\":%.4f", (double)compressedSize / PayloadSize);
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compress/%s", lz4.Prefix, payload.Name);
+			Measure(name, "MB/s", megabytes, extra, [&]() { lz4.Compress(source, compressed, PayloadSize); });
+
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_limitedOutput/%s", lz4.Prefix, payload.Name);
+			Measure(name, "MB/s", megabytes, extra, [&]() { lz4.CompressLimitedOutput(source, compressed, PayloadSize, boundSize); });
+
+			snprintf(extra, sizeof(extra), "\"ratio\":%.4f", (double)compressedHCSize / PayloadSize);
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compressHC/%s", lz4.Prefix, payload.Name);
+			Measure(name, "MB/s", megabytes, extra, [&]() { lz4.CompressHC(source, compressedHC, PayloadSize); });
+
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compressHC_limitedOutput/%s", lz4.Prefix, payload.Name);
+			Measure(name, "MB/s", megabytes, extra, [&]() { lz4.CompressHCLimitedOutput(source, compressedHC, PayloadSize, boundSize); });
+
+			// Accelerations and levels around the defaults (1 and 9) measured above
+			static const int Accelerations[] = { 4, 16 };
+			for (size_t a = 0; a < sizeof(Accelerations) / sizeof(Accelerations[0]); a++)
+			{
+				int acceleration = Accelerations[a];
+				snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_fast/acceleration%d/%s", lz4.Prefix, acceleration, payload.Name);
+				if (!IsSelected(name))
+					continue;
+				snprintf(extra, sizeof(extra), "\"ratio\":%.4f", (double)lz4.CompressFast(source, scratch, PayloadSize, boundSize, acceleration) / PayloadSize);
+				Measure(name, "MB/s", megabytes, extra, [&]() { lz4.CompressFast(source, scratch, PayloadSize, boundSize, acceleration); });
+			}
+
+			// Up to the optimal parsing (LZ4HC_OPT_CLEVEL), checked to decode as the other levels
+			static const int Levels[] = { 4, 12, 16, 17 };
+			for (size_t l = 0; l < sizeof(Levels) / sizeof(Levels[0]); l++)
+			{
+				int level = Levels[l];
+				snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_HC/level%d/%s", lz4.Prefix, level, payload.Name);
+				if (!IsSelected(name))
+					continue;
+				int levelSize = lz4.CompressHCLevel(source, scratch, PayloadSize, boundSize, level);
+				memset(decoded, 0, PayloadSize);
+				CheckRoundTrip(name, source, decoded, PayloadSize, lz4.Uncompress(scratch, decoded, PayloadSize), levelSize);
+				snprintf(extra, sizeof(extra), "\"ratio\":%.4f", (double)levelSize / PayloadSize);
+				Measure(name, "MB/s", megabytes, extra, [&]() { lz4.CompressHCLevel(source, scratch, PayloadSize, boundSize, level); });
+			}
+
+			// The payload as a sequence of blocks: tables allocated and cleared for each block, or reused by all of them
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_fast/blocks64K/%s", lz4.Prefix, payload.Name);
+			Measure(name, "MB/s", megabytes, NULL, [&]()
+			{
+				for (int offset = 0; offset < PayloadSize; offset += LZ4BlockSize)
+					lz4.CompressFast(source + offset, scratch, LZ4BlockSize, boundSize, 1);
+			});
+
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_fast_extState/blocks64K/%s", lz4.Prefix, payload.Name);
+			if (IsSelected(name))
+			{
+				void* state = lz4.CreateStream();
+				Measure(name, "MB/s", megabytes, NULL, [&]()
+				{
+					for (int offset = 0; offset < PayloadSize; offset += LZ4BlockSize)
+						lz4.CompressFastExtState(state, source + offset, scratch, LZ4BlockSize, boundSize, 1);
+				});
+				lz4.FreeStream(state);
+			}
+
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_HC/blocks64K/%s", lz4.Prefix, payload.Name);
+			Measure(name, "MB/s", megabytes, NULL, [&]()
+			{
+				for (int offset = 0; offset < PayloadSize; offset += LZ4BlockSize)
+					lz4.CompressHCLevel(source + offset, scratch, LZ4BlockSize, boundSize, 9);
+			});
+
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_HC_extStateHC/blocks64K/%s", lz4.Prefix, payload.Name);
+			if (IsSelected(name))
+			{
+				void* state = lz4.CreateStreamHC();
+				Measure(name, "MB/s", megabytes, NULL, [&]()
+				{
+					for (int offset = 0; offset < PayloadSize; offset += LZ4BlockSize)
+						lz4.CompressHCExtStateHC(state, source + offset, scratch, LZ4BlockSize, boundSize, 9);
+				});
+				lz4.FreeStreamHC(state);
+			}
+
+			// Small blocks, independent or linked to the previous ones: the ratio is the one of the whole payload
+			for (int linked = 0; linked < 2; linked++)
+			for (int highCompression = 0; highCompression < 2; highCompression++)
+			{
+				snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_%s/%s16K/%s", lz4.Prefix,
+					highCompression ? (linked ? "HC_continue" : "HC_extStateHC") : (linked ? "fast_continue" : "fast_extState"), linked ? "linked" : "blocks", payload.Name);
+				char decodeName[256];
+				snprintf(decodeName, sizeof(decodeName), "lz4/%s_LZ4_decompress_safe_usingDict/linked16K%s/%s", lz4.Prefix, highCompression ? "HC" : "", payload.Name);
+				if (!IsSelected(name) && !(linked && IsSelected(decodeName)))
+					continue;
+
+				void* state = highCompression ? lz4.CreateStreamHC() : lz4.CreateStream();
+				char* history = (char*)malloc(LZ4HistorySize);
+				int blockSizes[PayloadSize / LZ4SmallBlockSize];
+				int totalSize = 0;
+				auto compressBlocks = [&]()
+				{
+					int historySize = 0;
+					totalSize = 0;
+					if (highCompression)
+						lz4.ResetStreamHC(state, 9);
+					else
+						lz4.ResetStream(state);
+					for (int offset = 0; offset < PayloadSize; offset += LZ4SmallBlockSize)
+					{
+						char* block = source + offset;
+						if (linked)
+						{
+							if (historySize + LZ4SmallBlockSize > LZ4HistorySize)
+								historySize = highCompression ? lz4.SaveDictHC(state, history, 64 * 1024) : lz4.SaveDict(state, history, 64 * 1024);
+							block = history + historySize;
+							memcpy(block, source + offset, LZ4SmallBlockSize);
+							historySize += LZ4SmallBlockSize;
+						}
+						int blockSize = linked
+							? (highCompression
+								? lz4.CompressHCContinue(state, block, scratch + totalSize, LZ4SmallBlockSize, boundSize - totalSize)
+								: lz4.CompressFastContinue(state, block, scratch + totalSize, LZ4SmallBlockSize, boundSize - totalSize, 1))
+							: (highCompression
+								? lz4.CompressHCExtStateHC(state, block, scratch + totalSize, LZ4SmallBlockSize, boundSize - totalSize, 9)
+								: lz4.CompressFastExtState(state, block, scratch + totalSize, LZ4SmallBlockSize, boundSize - totalSize, 1));
+						blockSizes[offset / LZ4SmallBlockSize] = blockSize;
+						totalSize += blockSize;
+					}
+				};
+				compressBlocks();
+				snprintf(extra, sizeof(extra), "\"ratio\":%.4f", (double)totalSize / PayloadSize);
+				Measure(name, "MB/s", megabytes, extra, compressBlocks);
+
+				// Linked blocks are decoded right after the previous ones, which are their dictionary (as LZ4Stream does)
+				if (linked && IsSelected(decodeName))
+				{
+					auto decodeBlocks = [&]()
+					{
+						int decodedSize = 0;
+						for (int offset = 0, compressedOffset = 0; offset < PayloadSize; offset += LZ4SmallBlockSize)
+						{
+							int dictSize = offset < 64 * 1024 ? offset : 64 * 1024;
+							int blockSize = blockSizes[offset / LZ4SmallBlockSize];
+							decodedSize += lz4.DecompressSafeUsingDict(scratch + compressedOffset, decoded + offset, blockSize, LZ4SmallBlockSize, decoded + offset - dictSize, dictSize);
+							compressedOffset += blockSize;
+						}
+						return decodedSize;
+					};
+					memset(decoded, 0, PayloadSize);
+					CheckRoundTrip(decodeName, source, decoded, PayloadSize, decodeBlocks(), PayloadSize);
+					Measure(decodeName, "MB/s", megabytes, NULL, decodeBlocks);
+				}
+
+				free(history);
+				if (highCompression)
+					lz4.FreeStreamHC(state);
+				else
+					lz4.FreeStream(state);
+			}
+
+			// Decompression throughput is given in decompressed MB/s
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_uncompress/%s", lz4.Prefix, payload.Name);
+			if (IsSelected(name))
+			{
+				memset(decoded, 0, PayloadSize);
+				CheckRoundTrip(name, source, decoded, PayloadSize, lz4.Uncompress(compressed, decoded, PayloadSize), compressedSize);
+			}
+			Measure(name, "MB/s", megabytes, NULL, [&]() { lz4.Uncompress(compressed, decoded, PayloadSize); });
+
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_uncompress_unknownOutputSize/%s", lz4.Prefix, payload.Name);
+			if (IsSelected(name))
+			{
+				memset(decoded, 0, PayloadSize);
+				CheckRoundTrip(name, source, decoded, PayloadSize, lz4.UncompressUnknownOutputSize(compressedHC, decoded, compressedHCSize, PayloadSize), PayloadSize);
+			}
+			Measure(name, "MB/s", megabytes, NULL, [&]() { lz4.UncompressUnknownOutputSize(compressedHC, decoded, compressedHCSize, PayloadSize); });
+
+			// The checksum of the frames of LZ4Stream, computed over the content and checked before the decompression
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_checksum/%s", lz4.Prefix, payload.Name);
+			Measure(name, "MB/s", megabytes, NULL, [&]() { lz4.Checksum(source, PayloadSize, 0); });
+		}
+	}
+
+	// Small objects: the samples of the dictionary are the first half of the objects, the second half is compressed
+	RandomState = 1;
+	char* objectBuffer = (char*)malloc(LZ4ObjectCount * LZ4ObjectCapacity);
+	int objectSizes[LZ4ObjectCount];
+	int objectOffsets[LZ4ObjectCount];
+	int objectsSize = 0;
+	for (int i = 0; i < LZ4ObjectCount; i++)
+	{
+		objectOffsets[i] = objectsSize;
+		objectSizes[i] = FillObject(objectBuffer + objectsSize, LZ4ObjectCapacity);
+		objectsSize += objectSizes[i];
+	}
+	const int sampleCount = LZ4ObjectCount / 2;
+	const char* objects = objectBuffer + objectOffsets[sampleCount];
+	const int compressedObjectsSize = objectsSize - objectOffsets[sampleCount];
+	const double objectMegabytes = compressedObjectsSize / (1024.0 * 1024.0);
+	char* dictionary = (char*)malloc(LZ4DictionaryCapacity);
+	int compressedSizes[LZ4ObjectCount];
+
+	for (size_t e = 0; e < sizeof(EntryPoints) / sizeof(EntryPoints[0]); e++)
+	{
+		const LZ4EntryPoints& lz4 = EntryPoints[e];
+		char name[256];
+		char extra[64];
+
+		snprintf(name, sizeof(name), "lz4/%s_LZ4_trainDict/objects", lz4.Prefix);
+		int dictionarySize = lz4.TrainDict(dictionary, LZ4DictionaryCapacity, objectBuffer, objectSizes, sampleCount);
+		Measure(name, "MB/s", objectOffsets[sampleCount] / (1024.0 * 1024.0), NULL, [&]() { lz4.TrainDict(dictionary, LZ4DictionaryCapacity, objectBuffer, objectSizes, sampleCount); });
+
+		void* dictionaryState = lz4.CreateStream();
+		void* dictionaryStateHC = lz4.CreateStreamHC();
+		lz4.LoadDict(dictionaryState, dictionary, dictionarySize);
+		lz4.LoadDictHC(dictionaryStateHC, dictionary, dictionarySize);
+
+		for (int withDictionary = 0; withDictionary < 2; withDictionary++)
+		for (int highCompression = 0; highCompression < 2; highCompression++)
+		{
+			snprintf(name, sizeof(name), "lz4/%s_LZ4_compress_%s/objects%s", lz4.Prefix,
+				highCompression ? (withDictionary ? "HC_continue" : "HC_extStateHC") : (withDictionary ? "fast_continue" : "fast_extState"), withDictionary ? "Dictionary" : "");
+			char decodeName[256];
+			snprintf(decodeName, sizeof(decodeName), "lz4/%s_LZ4_decompress_safe_usingDict/objects%s%s", lz4.Prefix, withDictionary ? "Dictionary" : "", highCompression ? "HC" : "");
+			if (!IsSelected(name) && !IsSelected(decodeName))
+				continue;
+
+			// The dictionary is loaded once, and its tables copied for each object
+			void* state = highCompression ? lz4.CreateStreamHC() : lz4.CreateStream();
+			if (highCompression)
+				lz4.ResetStreamHC(state, 9);
+			int totalSize = 0;
+			auto compressObjects = [&]()
+			{
+				totalSize = 0;
+				for (int i = sampleCount; i < LZ4ObjectCount; i++)
+				{
+					const char* object = objectBuffer + objectOffsets[i];
+					int objectSize;
+					if (withDictionary && highCompression)
+					{
+						lz4.AttachDictionaryHC(state, dictionaryStateHC);
+						objectSize = lz4.CompressHCContinue(state, object, scratch + totalSize, objectSizes[i], boundSize - totalSize);
+					}
+					else if (withDictionary)
+					{
+						lz4.AttachDictionary(state, dictionaryState);
+						objectSize = lz4.CompressFastContinue(state, object, scratch + totalSize, objectSizes[i], boundSize - totalSize, 1);
+					}
+					else
+					{
+						objectSize = highCompression
+							? lz4.CompressHCExtStateHC(state, object, scratch + totalSize, objectSizes[i], boundSize - totalSize, 9)
+							: lz4.CompressFastExtState(state, object, scratch + totalSize, objectSizes[i], boundSize - totalSize, 1);
+					}
+					compressedSizes[i] = objectSize;
+					totalSize += objectSize;
+				}
+			};
+			compressObjects();
+			snprintf(extra, sizeof(extra), "\"ratio\":%.4f", (double)totalSize / compressedObjectsSize);
+			Measure(name, "MB/s", objectMegabytes, extra, compressObjects);
+
+			if (IsSelected(decodeName))
+			{
+				auto decodeObjects = [&]()
+				{
+					int decodedSize = 0;
+					for (int i = sampleCount, compressedOffset = 0; i < LZ4ObjectCount; i++)
+					{
+						decodedSize += lz4.DecompressSafeUsingDict(scratch + compressedOffset, decoded + objectOffsets[i] - objectOffsets[sampleCount], compressedSizes[i], objectSizes[i],
+							dictionary, withDictionary ? dictionarySize : 0);
+						compressedOffset += compressedSizes[i];
+					}
+					return decodedSize;
+				};
+				memset(decoded, 0, PayloadSize);
+				CheckRoundTrip(decodeName, objects, decoded, compressedObjectsSize, decodeObjects(), compressedObjectsSize);
+				Measure(decodeName, "MB/s", objectMegabytes, NULL, decodeObjects);
+			}
+
+			if (highCompression)
+				lz4.FreeStreamHC(state);
+			else
+				lz4.FreeStream(state);
+		}
+
+		lz4.FreeStreamHC(dictionaryStateHC);
+		lz4.FreeStream(dictionaryState);
+	}
+
+	free(dictionary);
+	free(objectBuffer);
+	free(decoded);
+	free(scratch);
+	free(compressedHC);
+	free(compressed);
+	free(source);
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strncmp(argv[i], "--min-time=", 11) == 0)
+			MinimumTime = atof(argv[i] + 11);
+		else
+			Filter = argv[i];
+	}
+
+	BenchmarkSprites();
+	BenchmarkMatrices();
+	BenchmarkLZ4();
+
+	return Failures == 0 ? 0 : 1;
+}
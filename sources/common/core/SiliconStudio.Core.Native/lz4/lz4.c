@@ -31,7 +31,7 @@
    - LZ4 source repository : http://code.google.com/p/lz4/
 */
 
-#ifndef LZ4_CS_ADAPTER
+
 //**************************************
 // Tuning parameters
 //**************************************
@@ -42,11 +42,14 @@
 // Default value is 14, for 16KB, which nicely fits into Intel x86 L1 cache
 #define MEMORY_USAGE 14
 
-// BIG_ENDIAN_NATIVE_BUT_INCOMPATIBLE :
-// This will provide a small boost to performance for big endian cpu, but the resulting compressed stream will be incompatible with little-endian CPU.
-// You can set this option to 1 in situations where data will remain within closed environment
-// This option is useless on Little_Endian CPU (such as x86)
-//#define BIG_ENDIAN_NATIVE_BUT_INCOMPATIBLE 1
+// HEAPMODE :
+// Select how default compression functions will allocate memory for their hash table,
+// in memory stack (0:default, fastest), or in memory heap (1:requires malloc()).
+#define HEAPMODE 0
+
+// ACCELERATION_DEFAULT :
+// Select "acceleration" for LZ4_compress_fast() when parameter value <= 0
+#define ACCELERATION_DEFAULT LZ4_ACCELERATION_DEFAULT
 
 //**************************************
 // CPU Feature Detection
@@ -54,7 +57,7 @@
 // 32 or 64 bits ?
 #ifndef LZ4_ARCH64
 
-#if (defined(__x86_64__) || defined(__x86_64) || defined(__amd64__) || defined(__amd64) || defined(__ppc64__) || defined(_WIN64) || defined(__LP64__) || defined(_LP64) )   // Detects 64 bits mode
+#if (defined(__x86_64__) || defined(__x86_64) || defined(__amd64__) || defined(__amd64) || defined(__aarch64__) || defined(__ppc64__) || defined(_WIN64) || defined(__LP64__) || defined(_LP64) )   // Detects 64 bits mode
 #  define LZ4_ARCH64 1
 #else
 #  define LZ4_ARCH64 0
@@ -80,13 +83,6 @@
 // Little Endian assumed. PDP Endian and other very rare endian format are unsupported.
 #endif
 
-// Unaligned memory access is automatically enabled for "common" CPU, such as x86.
-// For others CPU, the compiler will be more cautious, and insert extra code to ensure aligned access is respected
-// If you know your target CPU supports unaligned memory access, you want to force this option manually to improve performance
-#if defined(__ARM_FEATURE_UNALIGNED)
-#  define LZ4_FORCE_UNALIGNED_ACCESS 1
-#endif
-
 // Define this parameter if your target system or compiler does not support hardware bit count
 #if defined(_MSC_VER) && defined(_WIN32_WCE)            // Visual Studio for Windows CE does not support Hardware bit count
 #  define LZ4_FORCE_SW_BITCOUNT
@@ -95,30 +91,19 @@
 //**************************************
 // Compiler Options
 //**************************************
-#if __STDC_VERSION__ >= 199901L   // C99
-/* "restrict" is a known keyword */
-#else
-#  define restrict // Disable restrict
-#endif
-
 #define GCC_VERSION (__GNUC__ * 100 + __GNUC_MINOR__)
 
-#if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT) // Visual Studio
-#  include <intrin.h>   // For Visual 2005
-#  if LZ4_ARCH64 && defined(_M_X64) // 64-bit
-#    pragma intrinsic(_BitScanForward64) // For Visual 2005
-#    pragma intrinsic(_BitScanReverse64) // For Visual 2005
-#  else
-#    pragma intrinsic(_BitScanForward) // For Visual 2005
-#    pragma intrinsic(_BitScanReverse) // For Visual 2005
-#  endif
+#ifdef _MSC_VER    // Visual Studio
+#  define forceinline static __forceinline
+#  include <intrin.h>
 #  pragma warning(disable : 4127)        // disable: C4127: conditional expression is constant
-#endif
-
-#ifdef _MSC_VER
-#  define lz4_bswap16(x) _byteswap_ushort(x)
+#  pragma warning(disable : 4293)        // disable: C4293: too large shift (32-bits)
 #else
-#  define lz4_bswap16(x) ((unsigned short int) ((((x) >> 8) & 0xffu) | (((x) & 0xffu) << 8)))
+#  if defined(__GNUC__) || defined(__clang__)
+#    define forceinline static inline __attribute__((always_inline))
+#  else
+#    define forceinline static inline
+#  endif
 #endif
 
 #if (GCC_VERSION >= 302) || (__INTEL_COMPILER >= 800) || defined(__clang__)
@@ -135,45 +120,105 @@
 // Includes
 //**************************************
 #include <stdlib.h>   // for malloc
-#include <string.h>   // for memset
+#include <string.h>   // for memset, memcpy
 #include "lz4.h"
 
+#define ALLOCATOR(n,s) calloc(n,s)
+#define FREEMEM        free
+#define MEM_INIT       memset
+
 
 //**************************************
 // Basic Types
 //**************************************
 #if defined(_MSC_VER)    // Visual Studio does not support 'stdint' natively
-#  define BYTE      unsigned __int8
-#  define U16       unsigned __int16
-#  define U32       unsigned __int32
-#  define S32       __int32
-#  define U64       unsigned __int64
-#  define S64       __int64
+  typedef unsigned __int8  BYTE;
+  typedef unsigned __int16 U16;
+  typedef unsigned __int32 U32;
+  typedef          __int32 S32;
+  typedef unsigned __int64 U64;
+  typedef          __int64 S64;
 #else
 #  include <stdint.h>
-#  define BYTE      uint8_t
-#  define U16       uint16_t
-#  define U32       uint32_t
-#  define S32       int32_t
-#  define U64       uint64_t
-#  define S64       int64_t
+  typedef uint8_t  BYTE;
+  typedef uint16_t U16;
+  typedef uint32_t U32;
+  typedef int32_t  S32;
+  typedef uint64_t U64;
+  typedef int64_t  S64;
 #endif
 
-#ifndef LZ4_FORCE_UNALIGNED_ACCESS
-#  pragma pack(push, 1)
+#if LZ4_ARCH64
+  typedef U64 reg_t;   // Word compared at once by LZ4_count
+#else
+  typedef U32 reg_t;
 #endif
 
-typedef struct _U16_S { U16 v; } U16_S;
-typedef struct _U32_S { U32 v; } U32_S;
-typedef struct _U64_S { U64 v; } U64_S;
 
-#ifndef LZ4_FORCE_UNALIGNED_ACCESS
-#  pragma pack(pop)
+//**************************************
+// Memory access
+//**************************************
+// memcpy() of a constant size is the portable way to express unaligned accesses: compilers turn it into a single load or store
+// on the CPUs that support them, and into byte accesses on the others.
+
+static inline U16 LZ4_read16(const void* memPtr) { U16 val; memcpy(&val, memPtr, sizeof(val)); return val; }
+static inline U32 LZ4_read32(const void* memPtr) { U32 val; memcpy(&val, memPtr, sizeof(val)); return val; }
+static inline U64 LZ4_read64(const void* memPtr) { U64 val; memcpy(&val, memPtr, sizeof(val)); return val; }
+static inline reg_t LZ4_read_ARCH(const void* memPtr) { reg_t val; memcpy(&val, memPtr, sizeof(val)); return val; }
+
+static inline void LZ4_write16(void* memPtr, U16 value) { memcpy(memPtr, &value, sizeof(value)); }
+static inline void LZ4_write32(void* memPtr, U32 value) { memcpy(memPtr, &value, sizeof(value)); }
+
+static inline U16 LZ4_readLE16(const void* memPtr)
+{
+#if defined(LZ4_BIG_ENDIAN)
+    const BYTE* p = (const BYTE*)memPtr;
+    return (U16)((U16)p[0] + (p[1]<<8));
+#else
+    return LZ4_read16(memPtr);
 #endif
+}
+
+static inline void LZ4_writeLE16(void* memPtr, U16 value)
+{
+#if defined(LZ4_BIG_ENDIAN)
+    BYTE* p = (BYTE*)memPtr;
+    p[0] = (BYTE) value;
+    p[1] = (BYTE)(value>>8);
+#else
+    LZ4_write16(memPtr, value);
+#endif
+}
+
+static inline void LZ4_copy8(void* dst, const void* src)
+{
+    memcpy(dst,src,8);
+}
+
+// customized variant of memcpy, which can overwrite up to 7 bytes beyond dstEnd
+forceinline void LZ4_wildCopy(void* dstPtr, const void* srcPtr, void* dstEnd)
+{
+    BYTE* d = (BYTE*)dstPtr;
+    const BYTE* s = (const BYTE*)srcPtr;
+    BYTE* const e = (BYTE*)dstEnd;
+    do { LZ4_copy8(d,s); d+=8; s+=8; } while (d<e);
+}
+
+// A single SSE2 or NEON load and store on the CPUs that have them (every x86-64 and ARM64 one), two 8 bytes ones elsewhere
+static inline void LZ4_copy16(void* dst, const void* src)
+{
+    memcpy(dst,src,16);
+}
 
-#define A64(x) (((U64_S *)(x))->v)
-#define A32(x) (((U32_S *)(x))->v)
-#define A16(x) (((U16_S *)(x))->v)
+// customized variant of memcpy, which can overwrite up to 15 bytes beyond dstEnd, and reads 16 bytes at once from srcPtr:
+// the source must be at least 16 bytes before the destination when they overlap
+forceinline void LZ4_wildCopy16(void* dstPtr, const void* srcPtr, void* dstEnd)
+{
+    BYTE* d = (BYTE*)dstPtr;
+    const BYTE* s = (const BYTE*)srcPtr;
+    BYTE* const e = (BYTE*)dstEnd;
+    do { LZ4_copy16(d,s); d+=16; s+=16; } while (d<e);
+}
 
 
 //**************************************
@@ -181,18 +226,14 @@ typedef struct _U64_S { U64 v; } U64_S;
 //**************************************
 #define MINMATCH 4
 
-#define HASH_LOG (MEMORY_USAGE-2)
-#define HASHTABLESIZE (1 << HASH_LOG)
-#define HASH_MASK (HASHTABLESIZE - 1)
-
-#define NOTCOMPRESSIBLE_DETECTIONLEVEL 6 // Increasing this value will make the algorithm slower on incompressible data
-#define SKIPSTRENGTH (NOTCOMPRESSIBLE_DETECTIONLEVEL>2?NOTCOMPRESSIBLE_DETECTIONLEVEL:2)
-#define STACKLIMIT 13
-#define HEAPMODE (HASH_LOG>STACKLIMIT)  // Defines if memory is allocated into the stack (local variable), or into the heap (malloc()).
-#define COPYLENGTH 8
+#define WILDCOPYLENGTH 8
 #define LASTLITERALS 5
-#define MFLIMIT (COPYLENGTH+MINMATCH)
-#define MINLENGTH (MFLIMIT+1)
+#define MFLIMIT (WILDCOPYLENGTH+MINMATCH)
+static const int LZ4_minLength = (MFLIMIT+1);
+
+#define KB *(1 <<10)
+#define MB *(1 <<20)
+#define GB *(1U<<30)
 
 #define MAXD_LOG 16
 #define MAX_DISTANCE ((1 << MAXD_LOG) - 1)
@@ -203,73 +244,23 @@ typedef struct _U64_S { U64 v; } U64_S;
 #define RUN_MASK ((1U<<RUN_BITS)-1)
 
 
-//**************************************
-// Architecture-specific macros
-//**************************************
-#if LZ4_ARCH64  // 64-bit
-#  define STEPSIZE 8
-#  define UARCH U64
-#  define AARCH A64
-#  define LZ4_COPYSTEP(s,d)       A64(d) = A64(s); d+=8; s+=8;
-#  define LZ4_COPYPACKET(s,d)     LZ4_COPYSTEP(s,d)
-#  define LZ4_SECURECOPY(s,d,e)   if (d<e) LZ4_WILDCOPY(s,d,e)
-#  define HTYPE                   U32
-#  define INITBASE(base)          const BYTE* const base = ip
-#else       // 32-bit
-#  define STEPSIZE 4
-#  define UARCH U32
-#  define AARCH A32
-#  define LZ4_COPYSTEP(s,d)       A32(d) = A32(s); d+=4; s+=4;
-#  define LZ4_COPYPACKET(s,d)     LZ4_COPYSTEP(s,d); LZ4_COPYSTEP(s,d);
-#  define LZ4_SECURECOPY          LZ4_WILDCOPY
-#  define HTYPE                   const BYTE*
-#  define INITBASE(base)          const int base = 0
-#endif
-
-#if (defined(LZ4_BIG_ENDIAN) && !defined(BIG_ENDIAN_NATIVE_BUT_INCOMPATIBLE))
-#  define LZ4_READ_LITTLEENDIAN_16(d,s,p) { U16 v = A16(p); v = lz4_bswap16(v); d = (s) - v; }
-#  define LZ4_WRITE_LITTLEENDIAN_16(p,i)  { U16 v = (U16)(i); v = lz4_bswap16(v); A16(p) = v; p+=2; }
-#else       // Little Endian
-#  define LZ4_READ_LITTLEENDIAN_16(d,s,p) { d = (s) - A16(p); }
-#  define LZ4_WRITE_LITTLEENDIAN_16(p,v)  { A16(p) = v; p+=2; }
-#endif
-
-//**************************************
-// Local structures
-//**************************************
-struct refTables
-{
-    HTYPE hashTable[HASHTABLESIZE];
-};
-
-//**************************************
-// Macros
-//**************************************
-#define LZ4_HASH_FUNCTION(i)    (((i) * 2654435761U) >> ((MINMATCH*8)-HASH_LOG))
-#define LZ4_HASH_VALUE(p)       LZ4_HASH_FUNCTION(A32(p))
-#define LZ4_WILDCOPY(s,d,e)     do { LZ4_COPYPACKET(s,d) } while (d<e);
-#define LZ4_BLINDCOPY(s,d,l)    { BYTE* e=(d)+l; LZ4_WILDCOPY(s,d,e); d=e; }
-
-#endif // LZ4_CS_ADAPTER
-
 //****************************
 // Private functions
 //****************************
-#ifndef LZ4_CS_ADAPTER
 
 #if LZ4_ARCH64
 
-static inline int LZ4_NbCommonBytes (register U64 val)
+static inline unsigned LZ4_NbCommonBytes (reg_t val)
 {
 #if defined(LZ4_BIG_ENDIAN)
     #if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT) && defined(_M_X64)
     unsigned long r = 0;
     _BitScanReverse64( &r, val );
-    return (int)(r>>3);
-    #elif defined(__GNUC__) && (GCC_VERSION >= 304) && !defined(LZ4_FORCE_SW_BITCOUNT)
-    return (__builtin_clzll(val) >> 3);
+    return (unsigned)(r>>3);
+    #elif (defined(__clang__) || (GCC_VERSION >= 304)) && !defined(LZ4_FORCE_SW_BITCOUNT)
+    return (__builtin_clzll((U64)val) >> 3);
     #else
-    int r;
+    unsigned r;
     if (!(val>>32)) { r=4; } else { r=0; val>>=32; }
     if (!(val>>16)) { r+=2; val>>=8; } else { val>>=24; }
     r += (!val);
@@ -279,33 +270,29 @@ static inline int LZ4_NbCommonBytes (register U64 val)
     #if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT) && defined(_M_X64)
     unsigned long r = 0;
     _BitScanForward64( &r, val );
-    return (int)(r>>3);
-    #elif defined(__GNUC__) && (GCC_VERSION >= 304) && !defined(LZ4_FORCE_SW_BITCOUNT)
-    return (__builtin_ctzll(val) >> 3);
+    return (unsigned)(r>>3);
+    #elif (defined(__clang__) || (GCC_VERSION >= 304)) && !defined(LZ4_FORCE_SW_BITCOUNT)
+    return (__builtin_ctzll((U64)val) >> 3);
     #else
     static const int DeBruijnBytePos[64] = { 0, 0, 0, 0, 0, 1, 1, 2, 0, 3, 1, 3, 1, 4, 2, 7, 0, 2, 3, 6, 1, 5, 3, 5, 1, 3, 4, 4, 2, 5, 6, 7, 7, 0, 1, 2, 3, 3, 4, 6, 2, 6, 5, 5, 3, 4, 5, 6, 7, 1, 2, 4, 6, 4, 4, 5, 7, 2, 6, 5, 7, 6, 7, 7 };
-#ifdef LZ4_MK_OPT
-    return DeBruijnBytePos[((U64)((U64)((S64)val & -(S64)val) * 0x0218A392CDABBD3F)) >> 58];
-#else
-    return DeBruijnBytePos[((U64)((val & -val) * 0x0218A392CDABBD3F)) >> 58];
-#endif
+    return DeBruijnBytePos[((U64)((U64)((S64)val & -(S64)val) * 0x0218A392CDABBD3FULL)) >> 58];
     #endif
 #endif
 }
 
 #else
 
-static inline int LZ4_NbCommonBytes (register U32 val)
+static inline unsigned LZ4_NbCommonBytes (reg_t val)
 {
 #if defined(LZ4_BIG_ENDIAN)
     #if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT)
     unsigned long r = 0;
     _BitScanReverse( &r, val );
-    return (int)(r>>3);
-    #elif defined(__GNUC__) && (GCC_VERSION >= 304) && !defined(LZ4_FORCE_SW_BITCOUNT)
-    return (__builtin_clz(val) >> 3);
+    return (unsigned)(r>>3);
+    #elif (defined(__clang__) || (GCC_VERSION >= 304)) && !defined(LZ4_FORCE_SW_BITCOUNT)
+    return (__builtin_clz((U32)val) >> 3);
     #else
-    int r;
+    unsigned r;
     if (!(val>>16)) { r=2; val>>=8; } else { r=0; val>>=24; }
     r += (!val);
     return r;
@@ -314,731 +301,1265 @@ static inline int LZ4_NbCommonBytes (register U32 val)
     #if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT)
     unsigned long r;
     _BitScanForward( &r, val );
-    return (int)(r>>3);
-    #elif defined(__GNUC__) && (GCC_VERSION >= 304) && !defined(LZ4_FORCE_SW_BITCOUNT)
-    return (__builtin_ctz(val) >> 3);
+    return (unsigned)(r>>3);
+    #elif (defined(__clang__) || (GCC_VERSION >= 304)) && !defined(LZ4_FORCE_SW_BITCOUNT)
+    return (__builtin_ctz((U32)val) >> 3);
     #else
     static const int DeBruijnBytePos[32] = { 0, 0, 3, 0, 3, 1, 3, 0, 3, 2, 2, 1, 3, 2, 0, 1, 3, 3, 1, 2, 2, 2, 2, 0, 3, 1, 2, 0, 1, 0, 1, 1 };
-#ifdef LZ4_MK_OPT
     return DeBruijnBytePos[((U32)((U32)((S32)val & -(S32)val) * 0x077CB531U)) >> 27];
-#else
-    return DeBruijnBytePos[((U32)((val & -(S32)val) * 0x077CB531U)) >> 27];
-#endif
     #endif
 #endif
 }
 
 #endif
 
-#endif // LZ4_CS_ADAPTER
+#define STEPSIZE sizeof(reg_t)
 
-//******************************
-// Compression functions
-//******************************
-
-// LZ4_compressCtx :
-// -----------------
-// Compress 'isize' bytes from 'source' into an output buffer 'dest' of maximum size 'maxOutputSize'.
-// If it cannot achieve it, compression will stop, and result of the function will be zero.
-// return : the number of bytes written in buffer 'dest', or 0 if the compression fails
-
-static inline int LZ4_compressCtx(void** ctx,
-    const char* source,
-    char* dest,
-    int inputSize,
-    int maxOutputSize)
+// Length of the common prefix of pIn and pMatch, pIn never going beyond pInLimit
+forceinline unsigned LZ4_count(const BYTE* pIn, const BYTE* pMatch, const BYTE* pInLimit)
 {
-#if HEAPMODE
-    struct refTables *srt = (struct refTables *) (*ctx);
-    HTYPE* HashTable;
-#else
-    HTYPE HashTable[HASHTABLESIZE] = {0};
-#endif
-
-    const BYTE* ip = (BYTE*) source;
-    INITBASE(base);
-    const BYTE* anchor = ip;
-    const BYTE* const iend = ip + inputSize;
-    const BYTE* const mflimit = iend - MFLIMIT;
-
-    BYTE* op = (BYTE*) dest;
-    BYTE* const oend = op + maxOutputSize;
-
-#ifdef LZ4_MK_OPT
-    const BYTE* matchlimit = iend - LASTLITERALS;
-    const BYTE* matchlimit_1 = matchlimit - 1;
-    #if (LZ4_ARCH64 == 1)
-    const BYTE* matchlimit_3 = matchlimit - 3;
-    #endif
-    const BYTE* matchlimit_STEPSIZE_1 = matchlimit - (STEPSIZE - 1);
-    const BYTE* oend_LASTLITERALS_1 = oend - (1 + LASTLITERALS);
-    const BYTE* oend_LASTLITERALS_3 = oend - (2 + 1 + LASTLITERALS);
-#else
-    #define matchlimit (iend - LASTLITERALS)
-#endif
-
-    int length;
-#ifndef LZ4_CS_ADAPTER
-    const int skipStrength = SKIPSTRENGTH;
-#endif
-    U32 forwardH;
+    const BYTE* const pStart = pIn;
 
-    // Init
-    if (inputSize<MINLENGTH) goto _last_literals;
-#ifndef LZ4_CS_ADAPTER
-#if HEAPMODE
-    if (*ctx == NULL)
+    while (likely(pIn<pInLimit-(STEPSIZE-1)))
     {
-        srt = (struct refTables *) malloc ( sizeof(struct refTables) );
-        *ctx = (void*) srt;
+        reg_t diff = LZ4_read_ARCH(pMatch) ^ LZ4_read_ARCH(pIn);
+        if (!diff) { pIn+=STEPSIZE; pMatch+=STEPSIZE; continue; }
+        pIn += LZ4_NbCommonBytes(diff);
+        return (unsigned)(pIn - pStart);
     }
-    HashTable = (HTYPE*)(srt->hashTable);
-    memset((void*)HashTable, 0, sizeof(srt->hashTable));
-#else
-    (void) ctx;
-#endif
-#endif
 
-    // First Byte
-    HashTable[LZ4_HASH_VALUE(ip)] = (HTYPE)(ip - base);
-    ip++; forwardH = LZ4_HASH_VALUE(ip);
-
-    // Main Loop
-    while (1)
-    {
-        int findMatchAttempts = (1U << skipStrength) + 3;
-        const BYTE* forwardIp = ip;
-        const BYTE* ref;
-        BYTE* token;
-
-        // Find a match
-        do {
-            U32 h = forwardH;
-            int step = findMatchAttempts++ >> skipStrength;
-            ip = forwardIp;
-            forwardIp = ip + step;
-
-            if unlikely(forwardIp > mflimit) goto _last_literals;
+    if (LZ4_ARCH64) if ((pIn<(pInLimit-3)) && (LZ4_read32(pMatch) == LZ4_read32(pIn))) { pIn+=4; pMatch+=4; }
+    if ((pIn<(pInLimit-1)) && (LZ4_read16(pMatch) == LZ4_read16(pIn))) { pIn+=2; pMatch+=2; }
+    if ((pIn<pInLimit) && (*pMatch == *pIn)) pIn++;
+    return (unsigned)(pIn - pStart);
+}
 
-            forwardH = LZ4_HASH_VALUE(forwardIp);
-            ref = base + HashTable[h];
-            HashTable[h] = (HTYPE)(ip - base);
 
-        } while ((ref < ip - MAX_DISTANCE) || (A32(ref) != A32(ip)));
+#ifndef LZ4_COMMONDEFS_ONLY
+//**************************************
+// Local Constants
+//**************************************
+#define LZ4_HASHLOG   (MEMORY_USAGE-2)
+#define HASHTABLESIZE (1 << MEMORY_USAGE)
+#define HASH_SIZE_U32 (1 << LZ4_HASHLOG)
 
-        // Catch up
-        while ((ip>anchor) && (ref>(BYTE*)source) && unlikely(ip[-1]==ref[-1])) { ip--; ref--; }
+static const int LZ4_64Klimit = ((64 KB) + (MFLIMIT-1));
+static const U32 LZ4_skipTrigger = 6;  // Increase this value ==> compression run slower on incompressible data
 
-        // Encode Literal length
-        length = (int)(ip - anchor);
-        token = op++;
-#ifdef LZ4_MK_OPT
-        if unlikely(op + length + (length>>8) > oend_LASTLITERALS_3) return 0; // Check output limit
-#else
-        if unlikely(op + length + (2 + 1 + LASTLITERALS) + (length>>8) > oend) return 0; // Check output limit
-#endif
-#ifdef _MSC_VER
-        if (length>=(int)RUN_MASK)
-        {
-            int len = length-RUN_MASK;
-            *token=(RUN_MASK<<ML_BITS);
-            if (len>254)
-            {
-                do { *op++ = 255; len -= 255; } while (len>254);
-                *op++ = (BYTE)len;
-                memcpy(op, anchor, length);
-                op += length;
-                goto _next_match;
-            }
-            else
-            *op++ = (BYTE)len;
-        }
-        else *token = (BYTE)(length<<ML_BITS);
-#else
-        if (length>=(int)RUN_MASK)
-        {
-            int len;
-            *token=(RUN_MASK<<ML_BITS);
-            len = length-RUN_MASK;
-            for(; len > 254 ; len-=255) *op++ = 255;
-            *op++ = (BYTE)len;
-        }
-        else *token = (length<<ML_BITS);
-#endif
 
-        // Copy Literals
-        LZ4_BLINDCOPY(anchor, op, length);
+//**************************************
+// Local Structures and types
+//**************************************
+// Internal layout of LZ4_stream_t
+typedef struct
+{
+    U32 hashTable[HASH_SIZE_U32];
+    U32 currentOffset;          // Index of the end of the data seen by the stream: positions are indexes relative to 'source - currentOffset'
+    const BYTE* dictionary;     // Data preceding the next block, up to 64KB
+    U32 dictSize;
+} LZ4_stream_t_internal;
 
-_next_match:
-        // Encode Offset
-        LZ4_WRITE_LITTLEENDIAN_16(op,(U16)(ip-ref));
+typedef char LZ4_stream_t_size_check[(sizeof(LZ4_stream_t_internal) <= sizeof(LZ4_stream_t)) ? 1 : -1];
 
-        // Start Counting
-        ip+=MINMATCH; ref+=MINMATCH;    // MinMatch already verified
-        anchor = ip;
-#ifdef LZ4_MK_OPT
-        while likely(ip < matchlimit_STEPSIZE_1)
-#else
-        while likely(ip<matchlimit-(STEPSIZE-1))
-#endif
-        {
-            UARCH diff = AARCH(ref) ^ AARCH(ip);
-            if (!diff) { ip += STEPSIZE; ref += STEPSIZE; continue; }
-            ip += LZ4_NbCommonBytes(diff);
-            goto _endCount;
-        }
-#ifdef LZ4_MK_OPT
-        #if (LZ4_ARCH64 == 1)
-        if ((ip<matchlimit_3) && (A32(ref) == A32(ip))) { ip+=4; ref+=4; }
-        #endif
-        if ((ip<matchlimit_1) && (A16(ref) == A16(ip))) { ip+=2; ref+=2; }
-        if ((ip<matchlimit) && (*ref == *ip)) ip++;
-#else
-        if (LZ4_ARCH64) if ((ip<(matchlimit-3)) && (A32(ref) == A32(ip))) { ip+=4; ref+=4; }
-        if ((ip<(matchlimit-1)) && (A16(ref) == A16(ip))) { ip+=2; ref+=2; }
-        if ((ip<matchlimit) && (*ref == *ip)) ip++;
-#endif
+typedef enum { notLimited = 0, limitedOutput = 1 } limitedOutput_directive;
+typedef enum { byU32, byU16 } tableType_t;   // byU16 indexes blocks under 64KB with half of the table, which makes it fit in L1
 
-_endCount:
+// noDict: the block is alone, withPrefix64k: the dictionary immediately precedes the block, usingExtDict: the dictionary is elsewhere
+typedef enum { noDict = 0, withPrefix64k, usingExtDict } dict_directive;
+typedef enum { noDictIssue = 0, dictSmall } dictIssue_directive;   // dictSmall: the table can refer to data before the dictionary
 
-        // Encode MatchLength
-        length = (int)(ip - anchor);
-#ifdef LZ4_MK_OPT
-        if unlikely(op + (length>>8) > oend_LASTLITERALS_1) return 0; // Check output limit
-#else
-        if unlikely(op + (1 + LASTLITERALS) + (length>>8) > oend) return 0;         // Check output limit
-#endif
+typedef enum { endOnOutputSize = 0, endOnInputSize = 1 } endCondition_directive;
 
-        if (length>=(int)ML_MASK)
-        {
-            *token+=ML_MASK;
-            length -= ML_MASK;
-            for (; length > 509 ; length-=510) { *op++ = 255; *op++ = 255; }
-            if (length > 254) { length-=255; *op++ = 255; }
-            *op++ = (BYTE)length;
-        }
-        else *token += (BYTE)length;
 
-        // Test end of chunk
-        if (ip > mflimit) { anchor = ip;  break; }
+//********************************
+// Compression functions
+//********************************
 
-        // Fill table
-        HashTable[LZ4_HASH_VALUE(ip-2)] = (HTYPE)(ip - 2 - base);
+static U32 LZ4_hash4(U32 sequence, tableType_t const tableType)
+{
+    if (tableType == byU16)
+        return ((sequence * 2654435761U) >> ((MINMATCH*8)-(LZ4_HASHLOG+1)));
+    else
+        return ((sequence * 2654435761U) >> ((MINMATCH*8)-LZ4_HASHLOG));
+}
 
-        // Test next position
-#ifdef LZ4_MK_OPT
-        U32 h = LZ4_HASH_VALUE(ip);
-        ref = base + HashTable[h];
-        HashTable[h] = (HTYPE)(ip - base);
+// Hash of the 5 first bytes: fewer collisions than 4 bytes and a single multiplication on 64-bit CPUs
+static U32 LZ4_hash5(U64 sequence, tableType_t const tableType)
+{
+    static const U64 prime5bytes = 889523592379ULL;
+    static const U64 prime8bytes = 11400714785074694791ULL;
+    const U32 hashLog = (tableType == byU16) ? LZ4_HASHLOG+1 : LZ4_HASHLOG;
+#if defined(LZ4_BIG_ENDIAN)
+    return (U32)(((sequence >> 24) * prime8bytes) >> (64 - hashLog));
 #else
-        ref = base + HashTable[LZ4_HASH_VALUE(ip)];
-        HashTable[LZ4_HASH_VALUE(ip)] = (HTYPE)(ip - base);
+    (void)prime8bytes;
+    return (U32)(((sequence << 24) * prime5bytes) >> (64 - hashLog));
 #endif
+}
 
-        if ((ref > ip - (MAX_DISTANCE + 1)) && (A32(ref) == A32(ip))) { token = op++; *token=0; goto _next_match; }
-
-        // Prepare next loop
-        anchor = ip++;
-        forwardH = LZ4_HASH_VALUE(ip);
-    }
+forceinline U32 LZ4_hashPosition(const void* p, tableType_t const tableType)
+{
+    if (LZ4_ARCH64) return LZ4_hash5(LZ4_read64(p), tableType);
+    return LZ4_hash4(LZ4_read32(p), tableType);
+}
 
-_last_literals:
-    // Encode Last Literals
+static void LZ4_putPositionOnHash(const BYTE* p, U32 h, void* tableBase, tableType_t const tableType, const BYTE* srcBase)
+{
+    switch (tableType)
     {
-        int lastRun = (int)(iend - anchor);
-#ifdef LZ4_MK_OPT
-        if ((BYTE*)op + lastRun + 1 + ((lastRun+255-RUN_MASK)/255) > oend) return 0;
-#else
-        if (((char*)op - dest) + lastRun + 1 + ((lastRun+255-RUN_MASK)/255) > (U32)maxOutputSize) return 0;  // Check output limit
-#endif
-        if (lastRun>=(int)RUN_MASK) { *op++=(RUN_MASK<<ML_BITS); lastRun-=RUN_MASK; for(; lastRun > 254 ; lastRun-=255) *op++ = 255; *op++ = (BYTE) lastRun; }
-        else *op++ = (BYTE)(lastRun<<ML_BITS);
-        memcpy(op, anchor, iend - anchor);
-        op += iend-anchor;
+    case byU32: { U32* hashTable = (U32*) tableBase; hashTable[h] = (U32)(p-srcBase); return; }
+    case byU16: { U16* hashTable = (U16*) tableBase; hashTable[h] = (U16)(p-srcBase); return; }
     }
+}
 
-    // End
-    return (int) (((char*)op)-dest);
+forceinline void LZ4_putPosition(const BYTE* p, void* tableBase, tableType_t tableType, const BYTE* srcBase)
+{
+    U32 const h = LZ4_hashPosition(p, tableType);
+    LZ4_putPositionOnHash(p, h, tableBase, tableType, srcBase);
 }
 
-// Note : this function is valid only if isize < LZ4_64KLIMIT
-#ifndef LZ4_CS_ADAPTER
-#define LZ4_64KLIMIT ((1<<16) + (MFLIMIT-1))
-#define HASHLOG64K (HASH_LOG+1)
-#define HASH64KTABLESIZE (1U<<HASHLOG64K)
-#define LZ4_HASH64K_FUNCTION(i) (((i) * 2654435761U) >> ((MINMATCH*8)-HASHLOG64K))
-#define LZ4_HASH64K_VALUE(p)    LZ4_HASH64K_FUNCTION(A32(p))
-#endif
+static const BYTE* LZ4_getPositionOnHash(U32 h, void* tableBase, tableType_t tableType, const BYTE* srcBase)
+{
+    if (tableType == byU32) { const U32* const hashTable = (U32*) tableBase; return hashTable[h] + srcBase; }
+    { const U16* const hashTable = (U16*) tableBase; return hashTable[h] + srcBase; }   // default, to ensure a return
+}
 
-static inline int LZ4_compress64kCtx(void** ctx,
-                 const char* source,
-                 char* dest,
-                 int isize,
-                 int maxOutputSize)
+forceinline const BYTE* LZ4_getPosition(const BYTE* p, void* tableBase, tableType_t tableType, const BYTE* srcBase)
 {
-#if HEAPMODE
-    struct refTables *srt = (struct refTables *) (*ctx);
-    U16* HashTable;
-#else
-    U16 HashTable[HASH64KTABLESIZE] = {0};
-#endif
+    U32 const h = LZ4_hashPosition(p, tableType);
+    return LZ4_getPositionOnHash(h, tableBase, tableType, srcBase);
+}
 
-    const BYTE* ip = (BYTE*) source;
-    const BYTE* anchor = ip;
-    const BYTE* const base = ip;
-    const BYTE* const iend = ip + isize;
+// Compresses a block, with a hash table cleared by the caller for noDict, or filled with the positions of the dictionary.
+// The positions of the extDict dictionary are indexes of a virtual space where it would precede the block: a match found
+// there is read at 'match + refDelta', and ends at the end of the dictionary or continues at the start of the block.
+// The search for a match skips faster and faster over incompressible data, 'acceleration' making it skip from the start.
+forceinline int LZ4_compress_generic(
+                 LZ4_stream_t_internal* const cctx,
+                 const char* const source,
+                 char* const dest,
+                 const int inputSize,
+                 const int maxOutputSize,
+                 const limitedOutput_directive outputLimited,
+                 const tableType_t tableType,
+                 const dict_directive dict,
+                 const dictIssue_directive dictIssue,
+                 const U32 acceleration)
+{
+    void* const ctx = cctx->hashTable;
+    const BYTE* ip = (const BYTE*) source;
+    const BYTE* base;
+    const BYTE* lowLimit;
+    const BYTE* const lowRefLimit = ip - cctx->dictSize;
+    const BYTE* const dictionary = cctx->dictionary;
+    const BYTE* const dictEnd = dictionary + cctx->dictSize;
+    const size_t dictDelta = dictEnd - (const BYTE*)source;
+    const BYTE* anchor = (const BYTE*) source;
+    const BYTE* const iend = ip + inputSize;
     const BYTE* const mflimit = iend - MFLIMIT;
+    const BYTE* const matchlimit = iend - LASTLITERALS;
 
     BYTE* op = (BYTE*) dest;
-    BYTE* const oend = op + maxOutputSize;
-
-#ifdef LZ4_MK_OPT
-    const BYTE* matchlimit = iend - LASTLITERALS;
-    const BYTE* matchlimit_1 = matchlimit - 1;
-    #if (LZ4_ARCH64 == 1)
-    const BYTE* matchlimit_3 = matchlimit - 3;
-    #endif
-    const BYTE* matchlimit_STEPSIZE_1 = matchlimit - (STEPSIZE - 1);
-    const BYTE* oend_LASTLITERALS_1 = oend - (1 + LASTLITERALS);
-    const BYTE* oend_LASTLITERALS_3 = oend - (2 + 1 + LASTLITERALS);
-#else
-    #define matchlimit (iend - LASTLITERALS)
-#endif
+    BYTE* const olimit = op + maxOutputSize;
 
-    int len, length;
-#ifndef LZ4_CS_ADAPTER
-    const int skipStrength = SKIPSTRENGTH;
-#endif
     U32 forwardH;
+    size_t refDelta = 0;
 
-    // Init
-    if (isize < MINLENGTH) goto _last_literals;
-#ifndef LZ4_CS_ADAPTER
-#if HEAPMODE
-    if (*ctx == NULL)
+    // Init conditions
+    if ((U32)inputSize > (U32)LZ4_MAX_INPUT_SIZE) return 0;   // Unsupported input size, too large (or negative)
+    switch (dict)
     {
-        srt = (struct refTables *) malloc ( sizeof(struct refTables) );
-        *ctx = (void*) srt;
+    case noDict:
+    default:
+        base = (const BYTE*) source;
+        lowLimit = (const BYTE*) source;
+        break;
+    case withPrefix64k:
+        base = (const BYTE*) source - cctx->currentOffset;
+        lowLimit = (const BYTE*) source - cctx->dictSize;
+        break;
+    case usingExtDict:
+        base = (const BYTE*) source - cctx->currentOffset;
+        lowLimit = (const BYTE*) source;
+        break;
     }
-    HashTable = (U16*)(srt->hashTable);
-    memset((void*)HashTable, 0, sizeof(srt->hashTable));
-#else
-    (void) ctx;
-#endif
-#endif
+    if ((tableType == byU16) && (inputSize>=LZ4_64Klimit)) return 0;   // Size too large (not within 64K limit)
+    if (inputSize<LZ4_minLength) goto _last_literals;   // Input too small, no compression (all literals)
 
     // First Byte
-    ip++; forwardH = LZ4_HASH64K_VALUE(ip);
+    LZ4_putPosition(ip, ctx, tableType, base);
+    ip++; forwardH = LZ4_hashPosition(ip, tableType);
 
     // Main Loop
-    while (1)
+    for ( ; ; )
     {
-        int findMatchAttempts = (1U << skipStrength) + 3;
-        const BYTE* forwardIp = ip;
-        const BYTE* ref;
+        const BYTE* match;
         BYTE* token;
 
         // Find a match
-        do {
-            U32 h = forwardH;
-            int step = findMatchAttempts++ >> skipStrength;
-            ip = forwardIp;
-            forwardIp = ip + step;
-
-            if (forwardIp > mflimit) goto _last_literals;
-
-            forwardH = LZ4_HASH64K_VALUE(forwardIp);
-            ref = base + HashTable[h];
-            HashTable[h] = (U16)(ip - base);
-
-        } while (A32(ref) != A32(ip));
+        {
+            const BYTE* forwardIp = ip;
+            unsigned step = 1;
+            unsigned searchMatchNb = acceleration << LZ4_skipTrigger;
+            do
+            {
+                U32 const h = forwardH;
+                ip = forwardIp;
+                forwardIp += step;
+                step = (searchMatchNb++ >> LZ4_skipTrigger);
+
+                if (unlikely(forwardIp > mflimit)) goto _last_literals;
+
+                match = LZ4_getPositionOnHash(h, ctx, tableType, base);
+                if (dict==usingExtDict)
+                {
+                    if (match < (const BYTE*)source) { refDelta = dictDelta; lowLimit = dictionary; }
+                    else { refDelta = 0; lowLimit = (const BYTE*)source; }
+                }
+                forwardH = LZ4_hashPosition(forwardIp, tableType);
+                LZ4_putPositionOnHash(ip, h, ctx, tableType, base);
+
+            } while (((dictIssue==dictSmall) ? (match < lowRefLimit) : 0)
+                || ((tableType==byU16) ? 0 : (match + MAX_DISTANCE < ip))
+                || (LZ4_read32(match+refDelta) != LZ4_read32(ip)));
+        }
 
         // Catch up
-        while ((ip>anchor) && (ref>(BYTE*)source) && (ip[-1]==ref[-1])) { ip--; ref--; }
+        while ((ip>anchor) && (match+refDelta > lowLimit) && (unlikely(ip[-1]==match[refDelta-1]))) { ip--; match--; }
 
         // Encode Literal length
-        length = (int)(ip - anchor);
-        token = op++;
-#ifdef LZ4_MK_OPT
-        if unlikely(op + length + (length>>8) > oend_LASTLITERALS_3) return 0; // Check output limit
-#else
-        if unlikely(op + length + (2 + 1 + LASTLITERALS) + (length>>8) > oend) return 0;        // Check output limit
-#endif
-
-#ifdef _MSC_VER
-        if (length>=(int)RUN_MASK)
         {
-            int len = length-RUN_MASK;
-            *token=(RUN_MASK<<ML_BITS);
-            if (len>254)
+            unsigned const litLength = (unsigned)(ip - anchor);
+            token = op++;
+            if ((outputLimited) && (unlikely(op + litLength + (2 + 1 + LASTLITERALS) + (litLength/255) > olimit)))
+                return 0;   // Check output limit
+            if (litLength>=RUN_MASK)
             {
-                do { *op++ = 255; len -= 255; } while (len>254);
+                int len = (int)litLength-RUN_MASK;
+                *token=(RUN_MASK<<ML_BITS);
+                for(; len >= 255 ; len-=255) *op++ = 255;
                 *op++ = (BYTE)len;
-                memcpy(op, anchor, length);
-                op += length;
-                goto _next_match;
             }
-            else
-            *op++ = (BYTE)len;
-        }
-        else *token = (BYTE)(length<<ML_BITS);
-#else
-        if (length>=(int)RUN_MASK) { *token=(RUN_MASK<<ML_BITS); len = length-RUN_MASK; for(; len > 254 ; len-=255) *op++ = 255; *op++ = (BYTE)len; }
-        else *token = (length<<ML_BITS);
-#endif
+            else *token = (BYTE)(litLength<<ML_BITS);
 
-        // Copy Literals
-        LZ4_BLINDCOPY(anchor, op, length);
+            // Copy Literals
+            LZ4_wildCopy(op, anchor, op+litLength);
+            op+=litLength;
+        }
 
 _next_match:
         // Encode Offset
-        LZ4_WRITE_LITTLEENDIAN_16(op,(U16)(ip-ref));
+        LZ4_writeLE16(op, (U16)(ip-match)); op+=2;
 
-        // Start Counting
-        ip+=MINMATCH; ref+=MINMATCH;   // MinMatch verified
-        anchor = ip;
-#ifdef LZ4_MK_OPT
-        while (ip<matchlimit_STEPSIZE_1)
-#else
-        while (ip<matchlimit-(STEPSIZE-1))
-#endif
+        // Encode MatchLength
         {
-            UARCH diff = AARCH(ref) ^ AARCH(ip);
-            if (!diff) { ip+=STEPSIZE; ref+=STEPSIZE; continue; }
-            ip += LZ4_NbCommonBytes(diff);
-            goto _endCount;
-        }
-#ifdef LZ4_MK_OPT
-        #if (LZ4_ARCH64 == 1)
-        if ((ip<matchlimit_3) && (A32(ref) == A32(ip))) { ip+=4; ref+=4; }
-        #endif
-        if ((ip<matchlimit_1) && (A16(ref) == A16(ip))) { ip+=2; ref+=2; }
-        if ((ip<matchlimit) && (*ref == *ip)) ip++;
-#else
-        if (LZ4_ARCH64) if ((ip<(matchlimit-3)) && (A32(ref) == A32(ip))) { ip+=4; ref+=4; }
-        if ((ip<(matchlimit-1)) && (A16(ref) == A16(ip))) { ip+=2; ref+=2; }
-        if ((ip<matchlimit) && (*ref == *ip)) ip++;
-#endif
+            unsigned matchLength;
 
-_endCount:
+            if ((dict==usingExtDict) && (lowLimit==dictionary))
+            {
+                // The match stops at the end of the dictionary, and may go on with the start of the block
+                const BYTE* limit;
+                match += refDelta;
+                limit = ip + (dictEnd-match);
+                if (limit > matchlimit) limit = matchlimit;
+                matchLength = LZ4_count(ip+MINMATCH, match+MINMATCH, limit);
+                ip += MINMATCH + matchLength;
+                if (ip==limit)
+                {
+                    unsigned const more = LZ4_count(ip, (const BYTE*)source, matchlimit);
+                    matchLength += more;
+                    ip += more;
+                }
+            }
+            else
+            {
+                matchLength = LZ4_count(ip+MINMATCH, match+MINMATCH, matchlimit);
+                ip += MINMATCH + matchLength;
+            }
 
-        // Encode MatchLength
-        len = (int)(ip - anchor);
-#ifdef LZ4_MK_OPT
-        if unlikely(op + (len>>8) > oend_LASTLITERALS_1) return 0; // Check output limit
-#else
-        if unlikely(op + (1 + LASTLITERALS) + (len>>8) > oend) return 0; // Check output limit
-#endif
-        if (len>=(int)ML_MASK) { *token+=ML_MASK; len-=ML_MASK; for(; len > 509 ; len-=510) { *op++ = 255; *op++ = 255; } if (len > 254) { len-=255; *op++ = 255; } *op++ = (BYTE)len; }
-        else *token += (BYTE)len;
+            if ((outputLimited) && (unlikely(op + (1 + LASTLITERALS) + (matchLength/255) > olimit)))
+                return 0;    // Check output limit
+            if (matchLength>=ML_MASK)
+            {
+                *token += ML_MASK;
+                matchLength -= ML_MASK;
+                for (; matchLength >= 510 ; matchLength-=510) { *op++ = 255; *op++ = 255; }
+                if (matchLength >= 255) { matchLength-=255; *op++ = 255; }
+                *op++ = (BYTE)matchLength;
+            }
+            else *token += (BYTE)(matchLength);
+        }
+
+        anchor = ip;
 
         // Test end of chunk
-        if (ip > mflimit) { anchor = ip;  break; }
+        if (ip > mflimit) break;
 
         // Fill table
-        HashTable[LZ4_HASH64K_VALUE(ip-2)] = (U16)(ip - 2 - base);
+        LZ4_putPosition(ip-2, ctx, tableType, base);
 
         // Test next position
-#ifdef LZ4_MK_OPT
-        U32 h = LZ4_HASH64K_VALUE(ip);
-        ref = base + HashTable[h];
-        HashTable[h] = (U16)(ip - base);
-#else
-        ref = base + HashTable[LZ4_HASH64K_VALUE(ip)];
-        HashTable[LZ4_HASH64K_VALUE(ip)] = (U16)(ip - base);
-#endif
-
-        if (A32(ref) == A32(ip)) { token = op++; *token=0; goto _next_match; }
+        match = LZ4_getPosition(ip, ctx, tableType, base);
+        if (dict==usingExtDict)
+        {
+            if (match < (const BYTE*)source) { refDelta = dictDelta; lowLimit = dictionary; }
+            else { refDelta = 0; lowLimit = (const BYTE*)source; }
+        }
+        LZ4_putPosition(ip, ctx, tableType, base);
+        if (((dictIssue==dictSmall) ? (match>=lowRefLimit) : 1)
+            && (match+MAX_DISTANCE>=ip)
+            && (LZ4_read32(match+refDelta)==LZ4_read32(ip)))
+        { token=op++; *token=0; goto _next_match; }
 
         // Prepare next loop
-        anchor = ip++;
-        forwardH = LZ4_HASH64K_VALUE(ip);
+        forwardH = LZ4_hashPosition(++ip, tableType);
     }
 
 _last_literals:
     // Encode Last Literals
     {
-        int lastRun = (int)(iend - anchor);
-        if (op + lastRun + 1 + (lastRun-RUN_MASK+255)/255 > oend) return 0;
-        if (lastRun>=(int)RUN_MASK) { *op++=(RUN_MASK<<ML_BITS); lastRun-=RUN_MASK; for(; lastRun > 254 ; lastRun-=255) *op++ = 255; *op++ = (BYTE) lastRun; }
-        else *op++ = (BYTE)(lastRun<<ML_BITS);
-        memcpy(op, anchor, iend - anchor);
-        op += iend-anchor;
+        size_t const lastRun = (size_t)(iend - anchor);
+        if ((outputLimited) && ((op - (BYTE*)dest) + lastRun + 1 + ((lastRun+255-RUN_MASK)/255) > (U32)maxOutputSize))
+            return 0;   // Check output limit
+        if (lastRun >= RUN_MASK)
+        {
+            size_t accumulator = lastRun - RUN_MASK;
+            *op++ = RUN_MASK << ML_BITS;
+            for(; accumulator >= 255 ; accumulator-=255) *op++ = 255;
+            *op++ = (BYTE) accumulator;
+        }
+        else
+        {
+            *op++ = (BYTE)(lastRun<<ML_BITS);
+        }
+        memcpy(op, anchor, lastRun);
+        op += lastRun;
     }
 
     // End
     return (int) (((char*)op)-dest);
 }
 
+//****************************
+// Reusable States
+//****************************
+
+CORE_EXPORT( int ) LZ4_sizeofState(void)
+{
+    return LZ4_STREAMSIZE;
+}
+
+CORE_EXPORT( void ) LZ4_resetStream(LZ4_stream_t* streamPtr)
+{
+    MEM_INIT(streamPtr, 0, sizeof(LZ4_stream_t));
+}
+
+CORE_EXPORT( LZ4_stream_t* ) LZ4_createStream(void)
+{
+    LZ4_stream_t* const streamPtr = (LZ4_stream_t*) ALLOCATOR(1, sizeof(LZ4_stream_t));   // calloc: already reset
+    return streamPtr;
+}
+
+CORE_EXPORT( int ) LZ4_freeStream(LZ4_stream_t* streamPtr)
+{
+    FREEMEM(streamPtr);
+    return 0;
+}
+
+// The table is cleared for every block: its 16KB are cleared in much less time than a block is compressed, while skipping the
+// entries of the previous blocks, as LZ4HC does, costs a test per candidate match and slows the compression down by 10 to 40%.
+CORE_EXPORT( int ) LZ4_compress_fast_extState(void* state, const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration)
+{
+    LZ4_stream_t_internal* const ctx = (LZ4_stream_t_internal*) state;
+
+    if (acceleration < 1) acceleration = ACCELERATION_DEFAULT;
+
+    LZ4_resetStream((LZ4_stream_t*)state);
+
+    // The output limit can only be reached when the output is smaller than the worst case
+    if (maxOutputSize >= LZ4_compressBound(inputSize))
+    {
+        if (inputSize < LZ4_64Klimit)
+            return LZ4_compress_generic(ctx, source, dest, inputSize, 0, notLimited, byU16, noDict, noDictIssue, acceleration);
+        else
+            return LZ4_compress_generic(ctx, source, dest, inputSize, 0, notLimited, byU32, noDict, noDictIssue, acceleration);
+    }
+    else
+    {
+        if (inputSize < LZ4_64Klimit)
+            return LZ4_compress_generic(ctx, source, dest, inputSize, maxOutputSize, limitedOutput, byU16, noDict, noDictIssue, acceleration);
+        else
+            return LZ4_compress_generic(ctx, source, dest, inputSize, maxOutputSize, limitedOutput, byU32, noDict, noDictIssue, acceleration);
+    }
+}
 
-CORE_EXPORT( int ) LZ4_compress_limitedOutput(const char* source,
-    char* dest,
-    int isize,
-    int maxOutputSize)
+CORE_EXPORT( int ) LZ4_compress_fast(const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration)
 {
-#if HEAPMODE
-    void* ctx = malloc(sizeof(struct refTables));
     int result;
-    if (ctx == NULL) return 0;    // Failed allocation => compression not done
-    if (isize < LZ4_64KLIMIT)
-        result = LZ4_compress64kCtx(&ctx, source, dest, isize, maxOutputSize);
-    else result = LZ4_compressCtx(&ctx, source, dest, isize, maxOutputSize);
-    free(ctx);
-    return result;
+#if (HEAPMODE)
+    LZ4_stream_t* const ctxPtr = LZ4_createStream();
+    if (ctxPtr == NULL) return 0;
 #else
-    if (isize < (int)LZ4_64KLIMIT) return LZ4_compress64kCtx(NULL, source, dest, isize, maxOutputSize);
-    return LZ4_compressCtx(NULL, source, dest, isize, maxOutputSize);
+    LZ4_stream_t ctx;
+    LZ4_stream_t* const ctxPtr = &ctx;
+#endif
+
+    result = LZ4_compress_fast_extState(ctxPtr, source, dest, inputSize, maxOutputSize, acceleration);
+
+#if (HEAPMODE)
+    LZ4_freeStream(ctxPtr);
 #endif
+    return result;
 }
 
-CORE_EXPORT( int ) LZ4_compress(const char* source,
-    char* dest,
-    int isize)
+CORE_EXPORT( int ) LZ4_compress_default(const char* source, char* dest, int inputSize, int maxOutputSize)
 {
-    return LZ4_compress_limitedOutput(source, dest, isize, LZ4_compressBound(isize));
+    return LZ4_compress_fast(source, dest, inputSize, maxOutputSize, 1);
 }
 
+
 //****************************
-// Decompression functions
+// Streaming Compression
 //****************************
 
-// Note : The decoding functions LZ4_uncompress() and LZ4_uncompress_unknownOutputSize()
-//      are safe against "buffer overflow" attack type.
-//      They will never write nor read outside of the provided output buffers.
-//      LZ4_uncompress_unknownOutputSize() also insures that it will never read outside of the input buffer.
-//      LZ4_uncompress() guarantees that it will never read before source, nor beyond source + LZ4_compressBound(osize)
-//      A corrupted input will produce an error result, a negative int, indicating the position of the error within input stream.
+#define HASH_UNIT sizeof(reg_t)
 
-CORE_EXPORT( int ) LZ4_uncompress(const char* source,
-    char* dest,
-    int osize)
+CORE_EXPORT( int ) LZ4_loadDict(LZ4_stream_t* LZ4_dict, const char* dictionary, int dictSize)
 {
-    // Local Variables
-    const BYTE* restrict ip = (const BYTE*) source;
-    const BYTE* ref;
+    LZ4_stream_t_internal* const dict = (LZ4_stream_t_internal*) LZ4_dict;
+    const BYTE* p = (const BYTE*) dictionary;
+    const BYTE* const dictEnd = p + dictSize;
+    const BYTE* base;
 
-    BYTE* op = (BYTE*) dest;
-    BYTE* const oend = op + osize;
-    BYTE* cpy;
-
-    #ifdef LZ4_MK_OPT
-		const BYTE* oend_LASTLITERALS = oend - LASTLITERALS;
-        const BYTE* oend_COPYLENGTH = oend - COPYLENGTH;
-        const BYTE* oend_COPYLENGTH_STEPSIZE_4 = oend - COPYLENGTH - (STEPSIZE - 4);
-    #endif
+    LZ4_resetStream(LZ4_dict);
 
-    unsigned token;
+    if (dictSize < (int)HASH_UNIT) return 0;
 
-    size_t dec32table[] = {0, 3, 2, 3, 0, 0, 0, 0};
-#if LZ4_ARCH64
-    size_t dec64table[] = {0, 0, 0, (size_t)-1, 0, 1, 2, 3};
-#endif
+    // Only the last 64KB can be referenced. The table starts after a 64KB gap so that the empty entries are out of reach.
+    if ((dictEnd - p) > 64 KB) p = dictEnd - 64 KB;
+    dict->currentOffset += 64 KB;
+    base = p - dict->currentOffset;
+    dict->dictionary = p;
+    dict->dictSize = (U32)(dictEnd - p);
+    dict->currentOffset += dict->dictSize;
 
-    // Main Loop
-    while (1)
+    while (p <= dictEnd-HASH_UNIT)
     {
-        size_t length;
+        LZ4_putPosition(p, dict->hashTable, byU32, base);
+        p+=3;
+    }
 
-        // get runlength
-        token = *ip++;
-        if ((length=(token>>ML_BITS)) == RUN_MASK)  { size_t len; for (;(len=*ip++)==255;length+=255) { } length += len; }
+    return dict->dictSize;
+}
 
-        // copy literals
-        cpy = op+length;
-#ifdef LZ4_MK_OPT
-        if (cpy>oend_COPYLENGTH)
-#else
-        if (cpy>oend-COPYLENGTH)
-#endif
-        {
-            if (cpy != oend) goto _output_error;         // Error : not enough place for another match (min 4) + 5 literals
-            memcpy(op, ip, length);
-            ip += length;
-            break;                                       // EOF
+// Rebases the positions before the offsets overflow, or before 'src - currentOffset' goes below the address space
+static void LZ4_renormDictT(LZ4_stream_t_internal* LZ4_dict, const BYTE* src)
+{
+    if ((LZ4_dict->currentOffset > 0x80000000) || ((size_t)LZ4_dict->currentOffset > (size_t)src))
+    {
+        U32 const delta = LZ4_dict->currentOffset - 64 KB;
+        const BYTE* const dictEnd = LZ4_dict->dictionary + LZ4_dict->dictSize;
+        int i;
+        for (i=0; i<HASH_SIZE_U32; i++)
+        {
+            if (LZ4_dict->hashTable[i] < delta) LZ4_dict->hashTable[i] = 0;
+            else LZ4_dict->hashTable[i] -= delta;
         }
-        LZ4_WILDCOPY(ip, op, cpy); ip -= (op-cpy); op = cpy;
+        LZ4_dict->currentOffset = 64 KB;
+        if (LZ4_dict->dictSize > 64 KB) LZ4_dict->dictSize = 64 KB;
+        LZ4_dict->dictionary = dictEnd - LZ4_dict->dictSize;
+    }
+}
 
-        // get offset
-        LZ4_READ_LITTLEENDIAN_16(ref,cpy,ip); ip+=2;
-        if unlikely(ref < (BYTE* const)dest) goto _output_error;   // Error : offset outside destination buffer
+// Compresses a block that can refer to the previous ones (up to 64KB back), which must still be at the same place, or saved by LZ4_saveDict.
+// The block immediately following the previous one in memory is compressed as a prefix continuation, otherwise the previous data is an
+// external dictionary: both produce the same kind of block, but the first one is faster.
+CORE_EXPORT( int ) LZ4_compress_fast_continue(LZ4_stream_t* LZ4_stream, const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration)
+{
+    LZ4_stream_t_internal* const streamPtr = (LZ4_stream_t_internal*) LZ4_stream;
+    const BYTE* dictEnd = streamPtr->dictionary + streamPtr->dictSize;
+    const BYTE* smallest = (const BYTE*) source;
+    limitedOutput_directive const outputLimited = (maxOutputSize >= LZ4_compressBound(inputSize)) ? notLimited : limitedOutput;
+    int result;
 
-        // get matchlength
-        if ((length=(token&ML_MASK)) == ML_MASK) { for (;*ip==255;length+=255) {ip++;} length += *ip++; }
+    // A dictionary of less than 4 bytes can't hold a match, but the empty entries of the table point to its start:
+    // dropping it keeps the search from reading past its end
+    if ((streamPtr->dictSize < 4) && (dictEnd != (const BYTE*)source))
+    {
+        streamPtr->dictSize = 0;
+        streamPtr->dictionary = (const BYTE*)source;
+        dictEnd = (const BYTE*)source;
+    }
+
+    if ((streamPtr->dictSize > 0) && (smallest > dictEnd)) smallest = dictEnd;
+    LZ4_renormDictT(streamPtr, smallest);
+    if (acceleration < 1) acceleration = ACCELERATION_DEFAULT;
 
-        // copy repeated sequence
-        if unlikely((op-ref)<STEPSIZE)
+    // Check overlapping input/dictionary space
+    {
+        const BYTE* const sourceEnd = (const BYTE*) source + inputSize;
+        if ((sourceEnd > streamPtr->dictionary) && (sourceEnd < dictEnd))
         {
-#if LZ4_ARCH64
-            size_t dec64 = dec64table[op-ref];
-#else
-            const int dec64 = 0;
-#endif
-            op[0] = ref[0];
-            op[1] = ref[1];
-            op[2] = ref[2];
-            op[3] = ref[3];
-            op += 4; ref += 4; ref -= dec32table[op-ref];
-            A32(op) = A32(ref);
-            op += STEPSIZE-4; ref -= dec64;
-        } else { LZ4_COPYSTEP(ref,op); }
-        cpy = op + length - (STEPSIZE-4);
-
-#ifdef LZ4_MK_OPT
-        if unlikely(cpy > oend_COPYLENGTH_STEPSIZE_4)
-#else
-        if unlikely(cpy>oend-(COPYLENGTH)-(STEPSIZE-4))
-#endif
+            streamPtr->dictSize = (U32)(dictEnd - sourceEnd);
+            if (streamPtr->dictSize > 64 KB) streamPtr->dictSize = 64 KB;
+            if (streamPtr->dictSize < 4) streamPtr->dictSize = 0;
+            streamPtr->dictionary = dictEnd - streamPtr->dictSize;
+        }
+    }
+
+    // The table can refer to data preceding the dictionary when the dictionary is smaller than 64KB and than the data seen so far
+    {
+        int const dictIssue = (streamPtr->dictSize < 64 KB) && (streamPtr->dictSize < streamPtr->currentOffset);
+
+        if (dictEnd == (const BYTE*)source)
         {
-#ifdef LZ4_MK_OPT
-            if (cpy > oend_LASTLITERALS) goto _output_error;    // Error : last 5 bytes must be literals
-            LZ4_SECURECOPY(ref, op, oend_COPYLENGTH);
-#else
-            if (cpy > oend-LASTLITERALS) goto _output_error;    // Error : last 5 bytes must be literals
-            LZ4_SECURECOPY(ref, op, (oend-COPYLENGTH));
-#endif
-            while(op<cpy) *op++=*ref++;
-            op=cpy;
+            // Prefix mode: source data follows dictionary
+            if (outputLimited)
+            {
+                if (dictIssue) result = LZ4_compress_generic(streamPtr, source, dest, inputSize, maxOutputSize, limitedOutput, byU32, withPrefix64k, dictSmall, acceleration);
+                else           result = LZ4_compress_generic(streamPtr, source, dest, inputSize, maxOutputSize, limitedOutput, byU32, withPrefix64k, noDictIssue, acceleration);
+            }
+            else
+            {
+                if (dictIssue) result = LZ4_compress_generic(streamPtr, source, dest, inputSize, 0, notLimited, byU32, withPrefix64k, dictSmall, acceleration);
+                else           result = LZ4_compress_generic(streamPtr, source, dest, inputSize, 0, notLimited, byU32, withPrefix64k, noDictIssue, acceleration);
+            }
+            streamPtr->dictSize += (U32)inputSize;
+            streamPtr->currentOffset += (U32)inputSize;
+        }
+        else
+        {
+            // External dictionary mode
+            if (outputLimited)
+            {
+                if (dictIssue) result = LZ4_compress_generic(streamPtr, source, dest, inputSize, maxOutputSize, limitedOutput, byU32, usingExtDict, dictSmall, acceleration);
+                else           result = LZ4_compress_generic(streamPtr, source, dest, inputSize, maxOutputSize, limitedOutput, byU32, usingExtDict, noDictIssue, acceleration);
+            }
+            else
+            {
+                if (dictIssue) result = LZ4_compress_generic(streamPtr, source, dest, inputSize, 0, notLimited, byU32, usingExtDict, dictSmall, acceleration);
+                else           result = LZ4_compress_generic(streamPtr, source, dest, inputSize, 0, notLimited, byU32, usingExtDict, noDictIssue, acceleration);
+            }
+            streamPtr->dictionary = (const BYTE*)source;
+            streamPtr->dictSize = (U32)inputSize;
+            streamPtr->currentOffset += (U32)inputSize;
+        }
+    }
+
+    return result;
+}
+
+// Copies the last 64KB (at most) of the data seen by the stream into 'safeBuffer', so that the previous blocks can be overwritten
+CORE_EXPORT( int ) LZ4_saveDict(LZ4_stream_t* LZ4_dict, char* safeBuffer, int dictSize)
+{
+    LZ4_stream_t_internal* const dict = (LZ4_stream_t_internal*) LZ4_dict;
+    const BYTE* const previousDictEnd = dict->dictionary + dict->dictSize;
+
+    if ((U32)dictSize > 64 KB) dictSize = 64 KB;   // useless to define a dictionary > 64 KB
+    if ((U32)dictSize > dict->dictSize) dictSize = dict->dictSize;
+
+    memmove(safeBuffer, previousDictEnd - dictSize, dictSize);
+
+    dict->dictionary = (const BYTE*)safeBuffer;
+    dict->dictSize = (U32)dictSize;
+
+    return dictSize;
+}
+
+
+//****************************
+// Dictionaries
+//****************************
+
+// Copies a state prepared once by LZ4_loadDict(), which is much faster than hashing the dictionary again for each stream
+CORE_EXPORT( void ) LZ4_attachDictionary(LZ4_stream_t* workingStream, const LZ4_stream_t* dictionaryStream)
+{
+    memcpy(workingStream, dictionaryStream, sizeof(LZ4_stream_t_internal));
+}
+
+// The dictionary is made of the segments of the samples that hold the most sequences found in many samples, as the COVER
+// algorithm of zstd does: the samples are split in as many epochs as there are segments in the dictionary, and each epoch
+// gives its best segment. A segment scores, for each distinct sequence of DICT_DMER_SIZE bytes it holds, the number of other
+// samples holding it: the scores of its sequences are then cleared so that the next segments bring new content, and the
+// content found in a single sample is left out.
+#define DICT_DMER_SIZE      8
+#define DICT_SEGMENT_SIZE   (1 KB)
+#define DICT_HASHLOG        20
+#define DICT_HASH_SIZE      (1 << DICT_HASHLOG)
+
+static U32 LZ4_hashDmer(const BYTE* p)
+{
+    return (U32)((LZ4_read64(p) * 11400714785074694791ULL) >> (64 - DICT_HASHLOG));
+}
+
+CORE_EXPORT( int ) LZ4_trainDict(char* dictBuffer, int dictCapacity, const char* samplesBuffer, const int* sampleSizes, int nbSamples)
+{
+    const BYTE* const samples = (const BYTE*) samplesBuffer;
+    U32* frequencies;
+    U32* lastSample;
+    U16* windowCounts;
+    size_t totalSize = 0;
+    size_t epochSize, nbEpochs, epoch;
+    size_t dictTail;
+    int epochsWithoutSegment = 0;
+    int i;
+
+    if ((dictBuffer == NULL) || (samplesBuffer == NULL) || (sampleSizes == NULL)) return 0;
+    if (dictCapacity > 64 KB) dictCapacity = 64 KB;   // Only the last 64KB can be referenced
+    for (i = 0; i < nbSamples; i++)
+    {
+        if (sampleSizes[i] < 0) return 0;
+        totalSize += (size_t)sampleSizes[i];
+    }
+    if ((dictCapacity < DICT_DMER_SIZE) || (totalSize < DICT_SEGMENT_SIZE)) return 0;
+
+    frequencies = (U32*) ALLOCATOR(DICT_HASH_SIZE, sizeof(U32));
+    lastSample = (U32*) ALLOCATOR(DICT_HASH_SIZE, sizeof(U32));
+    windowCounts = (U16*) ALLOCATOR(DICT_HASH_SIZE, sizeof(U16));
+    if ((frequencies == NULL) || (lastSample == NULL) || (windowCounts == NULL))
+    {
+        FREEMEM(frequencies); FREEMEM(lastSample); FREEMEM(windowCounts);
+        return 0;
+    }
+
+    // Number of samples holding each sequence, minus one (lastSample holds the index + 1 of the last sample counted)
+    {
+        const BYTE* sample = samples;
+        for (i = 0; i < nbSamples; i++)
+        {
+            const BYTE* p;
+            for (p = sample; p + DICT_DMER_SIZE <= sample + sampleSizes[i]; p++)
+            {
+                U32 const h = LZ4_hashDmer(p);
+                if (lastSample[h] == (U32)i + 1) continue;
+                if (lastSample[h] != 0) frequencies[h]++;
+                lastSample[h] = (U32)i + 1;
+            }
+            sample += sampleSizes[i];
+        }
+    }
+
+    nbEpochs = (size_t)dictCapacity / DICT_SEGMENT_SIZE;
+    if (nbEpochs == 0) nbEpochs = 1;
+    epochSize = totalSize / nbEpochs;
+    if (epochSize < DICT_SEGMENT_SIZE)
+    {
+        epochSize = DICT_SEGMENT_SIZE;
+        nbEpochs = totalSize / epochSize;
+    }
+
+    // The segments are placed from the end, the best ones being the closest to the data compressed
+    dictTail = (size_t)dictCapacity;
+    for (epoch = 0; (dictTail > 0) && (epochsWithoutSegment < (int)nbEpochs); epoch = (epoch + 1) % nbEpochs)
+    {
+        const BYTE* const epochStart = samples + epoch * epochSize;
+        const BYTE* const epochEnd = (epoch == nbEpochs - 1) ? samples + totalSize : epochStart + epochSize;
+        size_t const segmentSize = (dictTail < DICT_SEGMENT_SIZE) ? dictTail : DICT_SEGMENT_SIZE;
+        size_t const windowDmers = (segmentSize > DICT_DMER_SIZE) ? segmentSize - DICT_DMER_SIZE + 1 : 1;
+        const BYTE* bestSegment = NULL;
+        U64 bestScore = 0, score = 0;
+        const BYTE* p;
+
+        // Sliding window of 'segmentSize' bytes, scoring each of its distinct sequences once
+        for (p = epochStart; p + DICT_DMER_SIZE <= epochEnd; p++)
+        {
+            U32 const h = LZ4_hashDmer(p);
+            if (windowCounts[h]++ == 0) score += frequencies[h];
+            if ((size_t)(p - epochStart) >= windowDmers)
+            {
+                U32 const hOut = LZ4_hashDmer(p - windowDmers);
+                if (--windowCounts[hOut] == 0) score -= frequencies[hOut];
+            }
+            if (((size_t)(p - epochStart) + 1 >= windowDmers) && (score > bestScore))
+            {
+                bestScore = score;
+                bestSegment = p + 1 - windowDmers;
+            }
+        }
+        // Empties the window for the next epoch
+        p = epochStart;
+        if ((size_t)(epochEnd - epochStart) > windowDmers + DICT_DMER_SIZE - 1) p = epochEnd - (DICT_DMER_SIZE - 1) - windowDmers;
+        for ( ; p + DICT_DMER_SIZE <= epochEnd; p++) windowCounts[LZ4_hashDmer(p)] = 0;
+
+        // A segment scoring less than one shared sequence every 16 bytes holds little more than hash collisions
+        if ((bestSegment == NULL) || (bestScore < windowDmers / 16))
+        {
+            epochsWithoutSegment++;
             continue;
         }
+        epochsWithoutSegment = 0;
 
-        LZ4_WILDCOPY(ref, op, cpy);
-        op = cpy;       // correction
+        {
+            size_t const length = (bestSegment + segmentSize <= epochEnd) ? segmentSize : (size_t)(epochEnd - bestSegment);
+            for (p = bestSegment; p + DICT_DMER_SIZE <= bestSegment + length; p++)
+                frequencies[LZ4_hashDmer(p)] = 0;
+            dictTail -= length;
+            memcpy(dictBuffer + dictTail, bestSegment, length);
+        }
     }
 
-    // end of decoding
-    return (int) (((char*)ip)-source);
+    FREEMEM(frequencies);
+    FREEMEM(lastSample);
+    FREEMEM(windowCounts);
 
-    // write overflow error detected
-_output_error:
-    return (int) (-(((char*)ip)-source));
+    memmove(dictBuffer, dictBuffer + dictTail, (size_t)dictCapacity - dictTail);
+    return dictCapacity - (int)dictTail;
 }
 
-CORE_EXPORT( int ) LZ4_uncompress_unknownOutputSize(
-    const char* source,
-    char* dest,
-    int isize,
-    int maxOutputSize)
+
+//****************************
+// Decompression functions
+//****************************
+
+// This generic decompression function covers both use cases: the safe one, ending on the compressed size and checking every
+// read and write, and the fast one, ending on the decompressed size.
+// Sequences are usually short: the first branch handles them with fixed size copies, and falls back to the general path otherwise.
+// Matches can refer to the 'lowPrefix' bytes decoded before 'dest' and, with usingExtDict, to the 'dictSize' bytes of a dictionary
+// found elsewhere, which virtually precede 'lowPrefix'.
+forceinline int LZ4_decompress_generic(
+                 const char* const source,
+                 char* const dest,
+                 int inputSize,
+                 int outputSize,          // If endOnInput==endOnInputSize, this value is the max size of Output Buffer.
+                 int endOnInput,          // endOnOutputSize, endOnInputSize
+                 int dict,                // noDict, usingExtDict
+                 const BYTE* const lowPrefix,   // Start of the contiguous history, dest when there is none
+                 const BYTE* const dictStart,   // Only used with usingExtDict
+                 const size_t dictSize)         // Only used with usingExtDict
 {
     // Local Variables
-    const BYTE* restrict ip = (const BYTE*) source;
-    const BYTE* const iend = ip + isize;
-    const BYTE* ref;
+    const BYTE* ip = (const BYTE*) source;
+    const BYTE* const iend = ip + inputSize;
 
     BYTE* op = (BYTE*) dest;
-    BYTE* const oend = op + maxOutputSize;
+    BYTE* const oend = op + outputSize;
     BYTE* cpy;
 
-#ifdef LZ4_MK_OPT
-    const BYTE* iend_LASTLITERALS_3 = (iend-(2+1+LASTLITERALS));
-    const BYTE* iend_LASTLITERALS_1 = (iend-(LASTLITERALS+1));
-    const BYTE* oend_COPYLENGTH = (oend-COPYLENGTH);
-    const BYTE* oend_COPYLENGTH_STEPSIZE_4 = (oend-(COPYLENGTH+(STEPSIZE-4)));
-    const BYTE* oend_LASTLITERALS = (oend - LASTLITERALS);
-    const BYTE* oend_MFLIMIT = (oend - MFLIMIT);
-#endif
+    const BYTE* const lowLimit = lowPrefix - dictSize;
+    const BYTE* const dictEnd = dictStart + dictSize;
 
-    size_t dec32table[] = {0, 3, 2, 3, 0, 0, 0, 0};
-#if LZ4_ARCH64
-    size_t dec64table[] = {0, 0, 0, (size_t)-1, 0, 1, 2, 3};
-#endif
+    static const unsigned inc32table[8] = {0, 1, 2,  1,  0,  4, 4, 4};
+    static const int      dec64table[8] = {0, 0, 0, -1, -4,  1, 2, 3};
 
-    // Special case
-    if unlikely(ip==iend) goto _output_error;    // A correctly formed null-compressed LZ4 must have at least one byte (token=0)
+    const int safeDecode = (endOnInput==endOnInputSize);
 
-    // Main Loop
+    // Set up the "end" pointers for the shortcut
+    const BYTE* const shortiend = iend - (endOnInput ? 14 : 8) /*maxLL*/ - 2 /*offset*/;
+    const BYTE* const shortoend = oend - (endOnInput ? 14 : 8) /*maxLL*/ - 18 /*maxML*/;
+
+    // Special cases
+    if ((endOnInput) && (unlikely(outputSize==0))) return ((inputSize==1) && (*ip==0)) ? 0 : -1;   // Empty output buffer
+    if ((!endOnInput) && (unlikely(outputSize==0))) return (*ip==0?1:-1);
+    if ((endOnInput) && unlikely(inputSize==0)) return -1;
+
+    // Main Loop : decode sequences
     while (1)
     {
-        unsigned token;
         size_t length;
+        size_t offset;
+        const BYTE* match;
+
+        // get literal length
+        unsigned const token = *ip++;
+        length = token >> ML_BITS;
+
+        // A two-stage shortcut for the most common case:
+        // 1) If the literal length is 0..14, and there is enough space, enter the shortcut and copy 16 bytes on behalf of the literals
+        //    (in the fast mode, only 8 bytes can be safely read, so the shortcut is only taken up to 8 literals).
+        // 2) Further if the match length is 4..18, copy 18 bytes in a similar manner; but only when the offset is at least 8,
+        //    so that the copy doesn't overlap its source.
+        if ((endOnInput ? length != RUN_MASK : length <= 8)
+            && likely((endOnInput ? ip < shortiend : 1) & (op <= shortoend)))
+        {
+            // Copy the literals
+            memcpy(op, ip, endOnInput ? 16 : 8);
+            op += length; ip += length;
+
+            // The second stage: prepare for match copying, decode full info.
+            // If it doesn't work out, the info won't be wasted.
+            length = token & ML_MASK;   // match length
+            offset = LZ4_readLE16(ip); ip += 2;
+            match = op - offset;
+
+            // Do not deal with overlapping matches, nor with the ones in the external dictionary
+            if ((length != ML_MASK) && (offset >= 8) && (match >= lowPrefix))
+            {
+                // Copy the match
+                memcpy(op + 0, match + 0, 8);
+                memcpy(op + 8, match + 8, 8);
+                memcpy(op +16, match +16, 2);
+                op += length + MINMATCH;
+                // Both stages worked, load the next token
+                continue;
+            }
 
-        // get runlength
-        token = *ip++;
-        if ((length=(token>>ML_BITS)) == RUN_MASK)
+            // The second stage didn't work out, but the info is ready: propel it right to the point of match copying
+            goto _copy_match;
+        }
+
+        // decode literal length
+        if (length == RUN_MASK)
         {
-            int s=255;
-            while (likely(ip<iend) && (s==255)) { s=*ip++; length += s; }
+            unsigned s;
+            if ((endOnInput) && unlikely(ip >= iend-RUN_MASK)) goto _output_error;   // Error : the length would be read beyond the input
+            do
+            {
+                s = *ip++;
+                length += s;
+            } while (likely(endOnInput ? ip<iend-RUN_MASK : 1) & (s==255));
+            if ((safeDecode) && unlikely((size_t)(op)+length<(size_t)(op))) goto _output_error;   // overflow detection
+            if ((safeDecode) && unlikely((size_t)(ip)+length<(size_t)(ip))) goto _output_error;   // overflow detection
         }
 
         // copy literals
         cpy = op+length;
-#ifdef LZ4_MK_OPT
-        if ((cpy>oend_MFLIMIT) || (ip+length>iend_LASTLITERALS_3))
-#else
-        if ((cpy>oend-MFLIMIT) || (ip+length>iend-(2+1+LASTLITERALS)))
-#endif
+        if (((endOnInput) && ((cpy>oend-MFLIMIT) || (ip+length>iend-(2+1+LASTLITERALS))))
+            || ((!endOnInput) && (cpy>oend-WILDCOPYLENGTH)))
         {
-            if (cpy > oend) goto _output_error;          // Error : writes beyond output buffer
-            if (ip+length != iend) goto _output_error;   // Error : LZ4 format requires to consume all input at this stage (no match within the last 11 bytes, and at least 8 remaining input bytes for another match+literals)
+            if (endOnInput)
+            {
+                if ((ip+length != iend) || (cpy > oend)) goto _output_error;   // Error : input must be consumed
+            }
+            else
+            {
+                if (cpy != oend) goto _output_error;   // Error : block decoding must stop exactly there
+            }
             memcpy(op, ip, length);
+            ip += length;
             op += length;
-            break;                                       // Necessarily EOF, due to parsing restrictions
+            break;     // Necessarily EOF, due to parsing restrictions
         }
-        LZ4_WILDCOPY(ip, op, cpy); ip -= (op-cpy); op = cpy;
+        // Long literals are copied 16 bytes at a time, as long as the input and the output have room for the overrun
+        if ((endOnInput) && (cpy <= oend-16) && (ip+length <= iend-16))
+            LZ4_wildCopy16(op, ip, cpy);
+        else
+            LZ4_wildCopy(op, ip, cpy);
+        ip += length; op = cpy;
 
         // get offset
-        LZ4_READ_LITTLEENDIAN_16(ref,cpy,ip); ip+=2;
-        if unlikely(ref < (BYTE* const)dest) goto _output_error;   // Error : offset outside of destination buffer
+        offset = LZ4_readLE16(ip); ip+=2;
+        match = op - offset;
 
         // get matchlength
-        if ((length=(token&ML_MASK)) == ML_MASK)
+        length = token & ML_MASK;
+
+_copy_match:
+        if (unlikely(match < lowLimit)) goto _output_error;   // Error : offset outside of destination buffer and dictionary
+
+        if (length == ML_MASK)
         {
-#ifdef LZ4_MK_OPT
-            while likely(ip<iend_LASTLITERALS_1) // Error : a minimum input bytes must remain for LASTLITERALS + token
-#else
-            while likely(ip<iend-(LASTLITERALS+1)) // Error : a minimum input bytes must remain for LASTLITERALS + token
-#endif
+            unsigned s;
+            do
             {
-                int s = *ip++;
-                length +=s;
-                if (s==255) continue;
-                break;
+                s = *ip++;
+                if ((endOnInput) && (ip > iend-LASTLITERALS)) goto _output_error;
+                length += s;
+            } while (s==255);
+            if ((safeDecode) && unlikely((size_t)(op)+length<(size_t)op)) goto _output_error;   // overflow detection
+        }
+        length += MINMATCH;
+
+        // copy match from the external dictionary, possibly followed by the start of the prefix
+        if ((dict==usingExtDict) && (match < lowPrefix))
+        {
+            if (unlikely(op+length > oend-LASTLITERALS)) goto _output_error;   // Error : last LASTLITERALS bytes must be literals
+            if (length <= (size_t)(lowPrefix-match))
+            {
+                memmove(op, dictEnd - (lowPrefix-match), length);
+                op += length;
             }
+            else
+            {
+                size_t const copySize = (size_t)(lowPrefix-match);
+                size_t const restSize = length - copySize;
+                memcpy(op, dictEnd - copySize, copySize);
+                op += copySize;
+                if (restSize > (size_t)(op-lowPrefix))
+                {
+                    // overlapping copy
+                    BYTE* const endOfMatch = op + restSize;
+                    const BYTE* copyFrom = lowPrefix;
+                    while (op < endOfMatch) *op++ = *copyFrom++;
+                }
+                else
+                {
+                    memcpy(op, lowPrefix, restSize);
+                    op += restSize;
+                }
+            }
+            continue;
         }
 
-        // copy repeated sequence
-        if unlikely(op-ref<STEPSIZE)
+        // copy match within block
+        cpy = op + length;
+        if (unlikely(offset<8))
         {
-#if LZ4_ARCH64
-            size_t dec64 = dec64table[op-ref];
-#else
-            const int dec64 = 0;
-#endif
-            op[0] = ref[0];
-            op[1] = ref[1];
-            op[2] = ref[2];
-            op[3] = ref[3];
-            op += 4; ref += 4; ref -= dec32table[op-ref];
-            A32(op) = A32(ref);
-            op += STEPSIZE-4; ref -= dec64;
-        } else { LZ4_COPYSTEP(ref,op); }
-        cpy = op + length - (STEPSIZE-4);
-
-#ifdef LZ4_MK_OPT
-        if unlikely(cpy>oend_COPYLENGTH_STEPSIZE_4)
-#else
-        if unlikely(cpy>oend-(COPYLENGTH+(STEPSIZE-4)))
-#endif
+            op[0] = match[0];
+            op[1] = match[1];
+            op[2] = match[2];
+            op[3] = match[3];
+            match += inc32table[offset];
+            memcpy(op+4, match, 4);
+            match -= dec64table[offset];
+        }
+        else
         {
-#ifdef LZ4_MK_OPT
-            if (cpy > oend_LASTLITERALS) goto _output_error;    // Error : last 5 bytes must be literals
-            LZ4_SECURECOPY(ref, op, oend_COPYLENGTH);
-#else
-            if (cpy > oend-LASTLITERALS) goto _output_error;    // Error : last 5 bytes must be literals
-            LZ4_SECURECOPY(ref, op, (oend-COPYLENGTH));
-#endif
-            while(op<cpy) *op++=*ref++;
-            op=cpy;
-            continue;
+            LZ4_copy8(op, match);
+            match += 8;
         }
+        op += 8;
 
-        LZ4_WILDCOPY(ref, op, cpy);
-        op=cpy;     // correction
+        if (unlikely(cpy > oend-12))
+        {
+            BYTE* const oCopyLimit = oend-(WILDCOPYLENGTH-1);
+            if (cpy > oend-LASTLITERALS) goto _output_error;   // Error : last LASTLITERALS bytes must be literals (uncompressed)
+            if (op < oCopyLimit)
+            {
+                LZ4_wildCopy(op, match, oCopyLimit);
+                match += oCopyLimit - op;
+                op = oCopyLimit;
+            }
+            while (op<cpy) *op++ = *match++;
+        }
+        else if ((length>16) && (op-match >= 16) && (cpy <= oend-16))
+        {
+            // Long matches far enough behind are copied 16 bytes at a time
+            LZ4_wildCopy16(op, match, cpy);
+        }
+        else
+        {
+            LZ4_copy8(op, match);
+            if (length>16) LZ4_wildCopy(op+8, match+8, cpy);
+        }
+        op = cpy;   // correction
     }
 
     // end of decoding
-    return (int) (((char*)op)-dest);
+    if (endOnInput)
+       return (int) (((char*)op)-dest);     // Nb of output bytes decoded
+    else
+       return (int) (((const char*)ip)-source);   // Nb of input bytes read
 
-    // write overflow error detected
+    // Overflow error detected
 _output_error:
-    return (int) (-(((char*)ip)-source));
+    return (int) (-(((const char*)ip)-source))-1;
+}
+
+
+CORE_EXPORT( int ) LZ4_decompress_safe(const char* source, char* dest, int compressedSize, int maxDecompressedSize)
+{
+    return LZ4_decompress_generic(source, dest, compressedSize, maxDecompressedSize, endOnInputSize, noDict, (BYTE*)dest, NULL, 0);
+}
+
+CORE_EXPORT( int ) LZ4_decompress_fast(const char* source, char* dest, int originalSize)
+{
+    return LZ4_decompress_generic(source, dest, 0, originalSize, endOnOutputSize, noDict, (BYTE*)dest, NULL, 0);
+}
+
+
+//****************************
+// Streaming Decompression
+//****************************
+
+// Internal layout of LZ4_streamDecode_t: the blocks decoded contiguously form the prefix, the ones before become the external dictionary
+typedef struct
+{
+    const BYTE* externalDict;
+    size_t extDictSize;
+    const BYTE* prefixEnd;
+    size_t prefixSize;
+} LZ4_streamDecode_t_internal;
+
+typedef char LZ4_streamDecode_t_internal_fits[(sizeof(LZ4_streamDecode_t_internal) <= sizeof(LZ4_streamDecode_t)) ? 1 : -1];
+
+CORE_EXPORT( LZ4_streamDecode_t* ) LZ4_createStreamDecode(void)
+{
+    LZ4_streamDecode_t* const lz4s = (LZ4_streamDecode_t*) ALLOCATOR(1, sizeof(LZ4_streamDecode_t));
+    return lz4s;
+}
+
+CORE_EXPORT( int ) LZ4_freeStreamDecode(LZ4_streamDecode_t* LZ4_stream)
+{
+    FREEMEM(LZ4_stream);
+    return 0;
+}
+
+CORE_EXPORT( int ) LZ4_setStreamDecode(LZ4_streamDecode_t* LZ4_streamDecode, const char* dictionary, int dictSize)
+{
+    LZ4_streamDecode_t_internal* const lz4sd = (LZ4_streamDecode_t_internal*) LZ4_streamDecode;
+    lz4sd->prefixSize = (size_t) dictSize;
+    lz4sd->prefixEnd = (const BYTE*) dictionary + dictSize;
+    lz4sd->externalDict = NULL;
+    lz4sd->extDictSize  = 0;
+    return 1;
+}
+
+// A block decoded right after the previous one extends the prefix, otherwise the prefix becomes the external dictionary.
+// The previous blocks must stay in place, or have been copied along with the decoded data as a new dictionary with LZ4_setStreamDecode.
+CORE_EXPORT( int ) LZ4_decompress_safe_continue(LZ4_streamDecode_t* LZ4_streamDecode, const char* source, char* dest, int compressedSize, int maxOutputSize)
+{
+    LZ4_streamDecode_t_internal* const lz4sd = (LZ4_streamDecode_t_internal*) LZ4_streamDecode;
+    int result;
+
+    if (lz4sd->prefixEnd == (BYTE*)dest)
+    {
+        result = LZ4_decompress_generic(source, dest, compressedSize, maxOutputSize, endOnInputSize,
+                                        usingExtDict, lz4sd->prefixEnd - lz4sd->prefixSize, lz4sd->externalDict, lz4sd->extDictSize);
+        if (result <= 0) return result;
+        lz4sd->prefixSize += result;
+        lz4sd->prefixEnd  += result;
+    }
+    else
+    {
+        lz4sd->extDictSize = lz4sd->prefixSize;
+        lz4sd->externalDict = lz4sd->prefixEnd - lz4sd->extDictSize;
+        result = LZ4_decompress_generic(source, dest, compressedSize, maxOutputSize, endOnInputSize,
+                                        usingExtDict, (BYTE*)dest, lz4sd->externalDict, lz4sd->extDictSize);
+        if (result <= 0) return result;
+        lz4sd->prefixSize = result;
+        lz4sd->prefixEnd  = (BYTE*)dest + result;
+    }
+
+    return result;
 }
+
+CORE_EXPORT( int ) LZ4_decompress_fast_continue(LZ4_streamDecode_t* LZ4_streamDecode, const char* source, char* dest, int originalSize)
+{
+    LZ4_streamDecode_t_internal* const lz4sd = (LZ4_streamDecode_t_internal*) LZ4_streamDecode;
+    int result;
+
+    if (lz4sd->prefixEnd == (BYTE*)dest)
+    {
+        result = LZ4_decompress_generic(source, dest, 0, originalSize, endOnOutputSize,
+                                        usingExtDict, lz4sd->prefixEnd - lz4sd->prefixSize, lz4sd->externalDict, lz4sd->extDictSize);
+        if (result <= 0) return result;
+        lz4sd->prefixSize += originalSize;
+        lz4sd->prefixEnd  += originalSize;
+    }
+    else
+    {
+        lz4sd->extDictSize = lz4sd->prefixSize;
+        lz4sd->externalDict = lz4sd->prefixEnd - lz4sd->extDictSize;
+        result = LZ4_decompress_generic(source, dest, 0, originalSize, endOnOutputSize,
+                                        usingExtDict, (BYTE*)dest, lz4sd->externalDict, lz4sd->extDictSize);
+        if (result <= 0) return result;
+        lz4sd->prefixSize = originalSize;
+        lz4sd->prefixEnd  = (BYTE*)dest + originalSize;
+    }
+
+    return result;
+}
+
+// One-shot versions of the above: a dictionary immediately preceding 'dest' is decoded as a prefix, which is faster than an external one
+CORE_EXPORT( int ) LZ4_decompress_safe_usingDict(const char* source, char* dest, int compressedSize, int maxOutputSize, const char* dictStart, int dictSize)
+{
+    if (dictSize <= 0 || dictStart + dictSize == dest)
+        return LZ4_decompress_generic(source, dest, compressedSize, maxOutputSize, endOnInputSize, noDict, (BYTE*)dest - (dictSize > 0 ? dictSize : 0), NULL, 0);
+    return LZ4_decompress_generic(source, dest, compressedSize, maxOutputSize, endOnInputSize, usingExtDict, (BYTE*)dest, (const BYTE*)dictStart, dictSize);
+}
+
+CORE_EXPORT( int ) LZ4_decompress_fast_usingDict(const char* source, char* dest, int originalSize, const char* dictStart, int dictSize)
+{
+    if (dictSize <= 0 || dictStart + dictSize == dest)
+        return LZ4_decompress_generic(source, dest, 0, originalSize, endOnOutputSize, noDict, (BYTE*)dest - (dictSize > 0 ? dictSize : 0), NULL, 0);
+    return LZ4_decompress_generic(source, dest, 0, originalSize, endOnOutputSize, usingExtDict, (BYTE*)dest, (const BYTE*)dictStart, dictSize);
+}
+
+
+//****************************
+// Checksums
+//****************************
+
+// XXH32, the checksum of the LZ4 frame format: 4 lanes of 32-bit multiplications, at several GB/s
+#define XXH_PRIME32_1 2654435761U
+#define XXH_PRIME32_2 2246822519U
+#define XXH_PRIME32_3 3266489917U
+#define XXH_PRIME32_4  668265263U
+#define XXH_PRIME32_5  374761393U
+
+// Internal layout of LZ4_checksum_t: the 4 lanes, and the last bytes of the input not yet forming a stripe of 16 bytes
+typedef struct
+{
+    U32 totalLength;
+    U32 largeLength;
+    U32 v1, v2, v3, v4;
+    U32 memory[4];
+    U32 memorySize;
+} LZ4_checksum_t_internal;
+
+typedef char LZ4_checksum_t_internal_fits[(sizeof(LZ4_checksum_t_internal) <= sizeof(LZ4_checksum_t)) ? 1 : -1];
+
+static U32 LZ4_rotl32(U32 x, int r) { return (x << r) | (x >> (32 - r)); }
+
+static U32 LZ4_checksumRound(U32 acc, U32 input)
+{
+    acc += input * XXH_PRIME32_2;
+    acc  = LZ4_rotl32(acc, 13);
+    return acc * XXH_PRIME32_1;
+}
+
+// Mixes the bytes after the last stripe, and the final avalanche
+static U32 LZ4_checksumFinalize(U32 h32, const BYTE* p, size_t length)
+{
+    while (length >= 4)
+    {
+        h32 += LZ4_read32(p) * XXH_PRIME32_3;
+        h32  = LZ4_rotl32(h32, 17) * XXH_PRIME32_4;
+        p += 4; length -= 4;
+    }
+    while (length > 0)
+    {
+        h32 += (*p) * XXH_PRIME32_5;
+        h32  = LZ4_rotl32(h32, 11) * XXH_PRIME32_1;
+        p++; length--;
+    }
+
+    h32 ^= h32 >> 15;
+    h32 *= XXH_PRIME32_2;
+    h32 ^= h32 >> 13;
+    h32 *= XXH_PRIME32_3;
+    h32 ^= h32 >> 16;
+    return h32;
+}
+
+CORE_EXPORT( unsigned int ) LZ4_checksum(const void* input, int length, unsigned int seed)
+{
+    const BYTE* p = (const BYTE*)input;
+    const BYTE* const end = p + length;
+    U32 h32;
+
+    if (length >= 16)
+    {
+        const BYTE* const limit = end - 16;
+        U32 v1 = seed + XXH_PRIME32_1 + XXH_PRIME32_2;
+        U32 v2 = seed + XXH_PRIME32_2;
+        U32 v3 = seed + 0;
+        U32 v4 = seed - XXH_PRIME32_1;
+
+        do
+        {
+            v1 = LZ4_checksumRound(v1, LZ4_read32(p)); p += 4;
+            v2 = LZ4_checksumRound(v2, LZ4_read32(p)); p += 4;
+            v3 = LZ4_checksumRound(v3, LZ4_read32(p)); p += 4;
+            v4 = LZ4_checksumRound(v4, LZ4_read32(p)); p += 4;
+        } while (p <= limit);
+
+        h32 = LZ4_rotl32(v1, 1) + LZ4_rotl32(v2, 7) + LZ4_rotl32(v3, 12) + LZ4_rotl32(v4, 18);
+    }
+    else
+    {
+        h32 = seed + XXH_PRIME32_5;
+    }
+
+    h32 += (U32)length;
+    return LZ4_checksumFinalize(h32, p, end - p);
+}
+
+CORE_EXPORT( void ) LZ4_resetChecksum(LZ4_checksum_t* state, unsigned int seed)
+{
+    LZ4_checksum_t_internal* const cs = (LZ4_checksum_t_internal*)state;
+    MEM_INIT(cs, 0, sizeof(LZ4_checksum_t_internal));
+    cs->v1 = seed + XXH_PRIME32_1 + XXH_PRIME32_2;
+    cs->v2 = seed + XXH_PRIME32_2;
+    cs->v3 = seed + 0;
+    cs->v4 = seed - XXH_PRIME32_1;
+}
+
+CORE_EXPORT( void ) LZ4_updateChecksum(LZ4_checksum_t* state, const void* input, int length)
+{
+    LZ4_checksum_t_internal* const cs = (LZ4_checksum_t_internal*)state;
+    const BYTE* p = (const BYTE*)input;
+    const BYTE* const end = p + length;
+
+    if (length <= 0) return;
+    cs->totalLength += (U32)length;
+    cs->largeLength |= (length >= 16) | (cs->totalLength >= 16);
+
+    // Not enough for a stripe yet
+    if (cs->memorySize + length < 16)
+    {
+        memcpy((BYTE*)cs->memory + cs->memorySize, input, length);
+        cs->memorySize += (U32)length;
+        return;
+    }
+
+    // Completes the stripe started by the previous updates
+    if (cs->memorySize > 0)
+    {
+        memcpy((BYTE*)cs->memory + cs->memorySize, input, 16 - cs->memorySize);
+        cs->v1 = LZ4_checksumRound(cs->v1, LZ4_read32(cs->memory + 0));
+        cs->v2 = LZ4_checksumRound(cs->v2, LZ4_read32(cs->memory + 1));
+        cs->v3 = LZ4_checksumRound(cs->v3, LZ4_read32(cs->memory + 2));
+        cs->v4 = LZ4_checksumRound(cs->v4, LZ4_read32(cs->memory + 3));
+        p += 16 - cs->memorySize;
+        cs->memorySize = 0;
+    }
+
+    if (p <= end - 16)
+    {
+        const BYTE* const limit = end - 16;
+        U32 v1 = cs->v1, v2 = cs->v2, v3 = cs->v3, v4 = cs->v4;
+
+        do
+        {
+            v1 = LZ4_checksumRound(v1, LZ4_read32(p)); p += 4;
+            v2 = LZ4_checksumRound(v2, LZ4_read32(p)); p += 4;
+            v3 = LZ4_checksumRound(v3, LZ4_read32(p)); p += 4;
+            v4 = LZ4_checksumRound(v4, LZ4_read32(p)); p += 4;
+        } while (p <= limit);
+
+        cs->v1 = v1; cs->v2 = v2; cs->v3 = v3; cs->v4 = v4;
+    }
+
+    if (p < end)
+    {
+        memcpy(cs->memory, p, end - p);
+        cs->memorySize = (U32)(end - p);
+    }
+}
+
+CORE_EXPORT( unsigned int ) LZ4_digestChecksum(const LZ4_checksum_t* state)
+{
+    const LZ4_checksum_t_internal* const cs = (const LZ4_checksum_t_internal*)state;
+    U32 h32;
+
+    if (cs->largeLength)
+        h32 = LZ4_rotl32(cs->v1, 1) + LZ4_rotl32(cs->v2, 7) + LZ4_rotl32(cs->v3, 12) + LZ4_rotl32(cs->v4, 18);
+    else
+        h32 = cs->v3 /* == seed */ + XXH_PRIME32_5;
+
+    h32 += cs->totalLength;
+    return LZ4_checksumFinalize(h32, (const BYTE*)cs->memory, cs->memorySize);
+}
+
+
+//****************************
+// Previous Functions
+//****************************
+
+CORE_EXPORT( int ) LZ4_versionNumber(void)
+{
+    return LZ4_VERSION_NUMBER;
+}
+
+CORE_EXPORT( int ) LZ4_compress_limitedOutput(const char* source, char* dest, int inputSize, int maxOutputSize)
+{
+    return LZ4_compress_default(source, dest, inputSize, maxOutputSize);
+}
+
+CORE_EXPORT( int ) LZ4_compress(const char* source, char* dest, int inputSize)
+{
+    return LZ4_compress_default(source, dest, inputSize, LZ4_compressBound(inputSize));
+}
+
+CORE_EXPORT( int ) LZ4_uncompress(const char* source, char* dest, int outputSize)
+{
+    return LZ4_decompress_fast(source, dest, outputSize);
+}
+
+CORE_EXPORT( int ) LZ4_uncompress_unknownOutputSize(const char* source, char* dest, int isize, int maxOutputSize)
+{
+    return LZ4_decompress_safe(source, dest, isize, maxOutputSize);
+}
+
+#endif // LZ4_COMMONDEFS_ONLY
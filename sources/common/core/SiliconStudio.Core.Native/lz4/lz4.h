@@ -41,6 +41,32 @@
 	#define LZ4_compressBound LZ4_FUNC(LZ4_compressBound)
 	#define LZ4_compress_limitedOutput LZ4_FUNC(LZ4_compress_limitedOutput)
 	#define LZ4_uncompress_unknownOutputSize LZ4_FUNC(LZ4_uncompress_unknownOutputSize)
+	#define LZ4_compress_fast LZ4_FUNC(LZ4_compress_fast)
+	#define LZ4_compress_default LZ4_FUNC(LZ4_compress_default)
+	#define LZ4_decompress_safe LZ4_FUNC(LZ4_decompress_safe)
+	#define LZ4_decompress_fast LZ4_FUNC(LZ4_decompress_fast)
+	#define LZ4_versionNumber LZ4_FUNC(LZ4_versionNumber)
+	#define LZ4_sizeofState LZ4_FUNC(LZ4_sizeofState)
+	#define LZ4_compress_fast_extState LZ4_FUNC(LZ4_compress_fast_extState)
+	#define LZ4_createStream LZ4_FUNC(LZ4_createStream)
+	#define LZ4_resetStream LZ4_FUNC(LZ4_resetStream)
+	#define LZ4_freeStream LZ4_FUNC(LZ4_freeStream)
+	#define LZ4_loadDict LZ4_FUNC(LZ4_loadDict)
+	#define LZ4_compress_fast_continue LZ4_FUNC(LZ4_compress_fast_continue)
+	#define LZ4_saveDict LZ4_FUNC(LZ4_saveDict)
+	#define LZ4_createStreamDecode LZ4_FUNC(LZ4_createStreamDecode)
+	#define LZ4_freeStreamDecode LZ4_FUNC(LZ4_freeStreamDecode)
+	#define LZ4_setStreamDecode LZ4_FUNC(LZ4_setStreamDecode)
+	#define LZ4_decompress_safe_continue LZ4_FUNC(LZ4_decompress_safe_continue)
+	#define LZ4_decompress_fast_continue LZ4_FUNC(LZ4_decompress_fast_continue)
+	#define LZ4_decompress_safe_usingDict LZ4_FUNC(LZ4_decompress_safe_usingDict)
+	#define LZ4_decompress_fast_usingDict LZ4_FUNC(LZ4_decompress_fast_usingDict)
+	#define LZ4_attachDictionary LZ4_FUNC(LZ4_attachDictionary)
+	#define LZ4_trainDict LZ4_FUNC(LZ4_trainDict)
+	#define LZ4_checksum LZ4_FUNC(LZ4_checksum)
+	#define LZ4_resetChecksum LZ4_FUNC(LZ4_resetChecksum)
+	#define LZ4_updateChecksum LZ4_FUNC(LZ4_updateChecksum)
+	#define LZ4_digestChecksum LZ4_FUNC(LZ4_digestChecksum)
 #endif
 
 #if defined (__cplusplus)
@@ -54,38 +80,50 @@ extern "C" {
 #  define inline __inline           // Visual is not C99, but supports some kind of inline
 #endif
 
+//**************************************
+// Version
+//**************************************
+// The block format is the one of every LZ4 version: blocks compressed by this version are decoded by the previous ones and the other way around.
+#define LZ4_VERSION_MAJOR    1
+#define LZ4_VERSION_MINOR    7
+#define LZ4_VERSION_RELEASE  1
+#define LZ4_VERSION_NUMBER (LZ4_VERSION_MAJOR *100*100 + LZ4_VERSION_MINOR *100 + LZ4_VERSION_RELEASE)
+
+CORE_EXPORT( int ) LZ4_versionNumber (void);
+
 //****************************
 // Simple Functions
 //****************************
 
-CORE_EXPORT( int ) LZ4_compress   (const char* source, char* dest, int inputSize);
-CORE_EXPORT( int ) LZ4_uncompress (const char* source, char* dest, int outputSize);
+#define LZ4_MAX_INPUT_SIZE        0x7E000000   // 2 113 929 216 bytes
+#define LZ4_ACCELERATION_DEFAULT  1
+
+CORE_EXPORT( int ) LZ4_compress_default (const char* source, char* dest, int inputSize, int maxOutputSize);
+CORE_EXPORT( int ) LZ4_decompress_safe  (const char* source, char* dest, int compressedSize, int maxDecompressedSize);
 
 /*
-LZ4_compress() :
-	Compresses 'inputSize' bytes from 'source' into 'dest'.
-	Destination buffer must be already allocated,
-	and must be sized to handle worst cases situations (input data not compressible)
-	Worst case size evaluation is provided by function LZ4_compressBound()
-	inputSize : Max supported value is ~1.9GB
+LZ4_compress_default() :
+	Compresses 'inputSize' bytes from 'source' into an output buffer 'dest' of maximum size 'maxOutputSize'.
+	Compression is guaranteed to succeed if 'maxOutputSize' >= LZ4_compressBound(inputSize).
+	inputSize : Max supported value is LZ4_MAX_INPUT_SIZE
 	return : the number of bytes written in buffer dest
-			 or 0 if the compression fails
-
-LZ4_uncompress() :
-	outputSize : is the original (uncompressed) size
-	return : the number of bytes read in the source buffer (in other words, the compressed size)
-			 If the source stream is malformed, the function will stop decoding and return a negative result, indicating the byte position of the faulty instruction.
-	note : This function never writes outside of provided buffers, and never modifies input buffer.
-		   Destination buffer must be already allocated.
-		   Its size must be a minimum of 'output_size' bytes.
+			 or 0 if the compression fails (output buffer too small)
+
+LZ4_decompress_safe() :
+	compressedSize : is the exact size of the compressed block
+	maxDecompressedSize : is the size of the destination buffer (which must be already allocated)
+	return : the number of bytes decompressed into the destination buffer (necessarily <= maxDecompressedSize)
+			 If the source stream is malformed, the function will stop decoding and return a negative result.
+			 This function never writes outside of the output buffer, and never reads outside of the input buffer,
+			 it is therefore protected against malicious data packets.
 */
 
 //****************************
 // Advanced Functions
 //****************************
 
-static inline int LZ4_compressBound(int isize) { return ((isize) + ((isize)/255) + 16); }
-#define LZ4_COMPRESSBOUND(isize)                        ((isize) + ((isize)/255) + 16)
+static inline int LZ4_compressBound(int isize) { return ((unsigned)(isize) > (unsigned)LZ4_MAX_INPUT_SIZE) ? 0 : ((isize) + ((isize)/255) + 16); }
+#define LZ4_COMPRESSBOUND(isize)                        ((unsigned)(isize) > (unsigned)LZ4_MAX_INPUT_SIZE ? 0 : (isize) + ((isize)/255) + 16)
 
 /*
 LZ4_compressBound() :
@@ -94,41 +132,194 @@ LZ4_compressBound() :
 	inline function is recommended for the general case,
 	but macro is also provided when results need to be evaluated at compile time (such as table size allocation).
 
-	isize  : is the input size. Max supported value is ~1.9GB
+	isize  : is the input size. Max supported value is LZ4_MAX_INPUT_SIZE
 	return : maximum output size in a "worst case" scenario
-	note : this function is limited by "int" range (2^31-1)
+			 or 0, if input size is too large ( > LZ4_MAX_INPUT_SIZE)
+*/
+
+
+CORE_EXPORT( int ) LZ4_compress_fast (const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+
+/*
+LZ4_compress_fast() :
+	Same as LZ4_compress_default(), but allows to select an "acceleration" factor.
+	The larger the acceleration value, the faster the algorithm, but also the lesser the compression.
+	It's a trade-off. It can be fine tuned, with each successive value providing roughly +~3% to speed.
+	An acceleration value of "1" is the same as regular LZ4_compress_default(), values <= 0 are replaced by LZ4_ACCELERATION_DEFAULT.
+*/
+
+
+CORE_EXPORT( int ) LZ4_decompress_fast (const char* source, char* dest, int originalSize);
+
+/*
+LZ4_decompress_fast() :
+	originalSize : is the original (uncompressed) size
+	return : the number of bytes read from the source buffer (in other words, the compressed size)
+			 If the source stream is detected malformed, the function will stop decoding and return a negative result.
+	note : This function never writes outside of the output buffer, but it reads the input up to the end of the last sequence
+		   without knowing its size: only use it on trusted sources. Destination buffer must be already allocated.
+		   Its size must be a minimum of 'originalSize' bytes.
+*/
+
+
+//****************************
+// Reusable States
+//****************************
+
+// Tables of the compression, to be allocated once and reused for a sequence of blocks.
+// The size is the one of the hash table (MEMORY_USAGE 14 in lz4.c) plus some room, it must not be changed independently.
+#define LZ4_STREAMSIZE_U64 ((1 << (14-3)) + 4)
+#define LZ4_STREAMSIZE     (LZ4_STREAMSIZE_U64 * sizeof(long long))
+
+typedef struct { long long table[LZ4_STREAMSIZE_U64]; } LZ4_stream_t;
+
+CORE_EXPORT( LZ4_stream_t* ) LZ4_createStream (void);
+CORE_EXPORT( void ) LZ4_resetStream (LZ4_stream_t* streamPtr);
+CORE_EXPORT( int ) LZ4_freeStream (LZ4_stream_t* streamPtr);
+
+CORE_EXPORT( int ) LZ4_sizeofState (void);
+CORE_EXPORT( int ) LZ4_compress_fast_extState (void* state, const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+
+/*
+LZ4_createStream() / LZ4_freeStream() :
+	Allocate and release a state. LZ4_createStream() returns NULL if the allocation fails.
+	A state can also live in memory provided by the caller, of LZ4_sizeofState() bytes and aligned for a long long,
+	in which case it must be initialized with LZ4_resetStream() before its first use.
+
+LZ4_resetStream() :
+	Clears a state, as if it had just been created.
+
+LZ4_compress_fast_extState() :
+	Same as LZ4_compress_fast(), using the table of 'state' instead of its own, which is then neither allocated (HEAPMODE)
+	nor placed on the stack for each block. The blocks are independent, each one is decoded by LZ4_decompress_safe() alone.
+	A state is used by one thread at a time, keep one per thread or per stream.
+*/
+
+
+//****************************
+// Streaming Compression
+//****************************
+
+CORE_EXPORT( int ) LZ4_loadDict (LZ4_stream_t* streamPtr, const char* dictionary, int dictSize);
+CORE_EXPORT( int ) LZ4_compress_fast_continue (LZ4_stream_t* streamPtr, const char* source, char* dest, int inputSize, int maxOutputSize, int acceleration);
+CORE_EXPORT( int ) LZ4_saveDict (LZ4_stream_t* streamPtr, char* safeBuffer, int dictSize);
+
+/*
+LZ4_loadDict() :
+	Resets the state and uses the last 64KB (at most) of 'dictionary' as the history of the first block.
+	Returns the size of the dictionary kept.
+
+LZ4_compress_fast_continue() :
+	Compresses a block whose matches can refer to the previous blocks of the stream, up to 64KB back, which improves the ratio
+	of small blocks. The previous blocks (or the dictionary) must still be in memory, unmodified, at the same place.
+	Blocks written one after the other in a buffer (or in a 64KB ring buffer) are compressed at the speed of independent ones.
+	Returns the size of the block, or 0 if it didn't fit in 'maxOutputSize' bytes, in which case the stream is unusable.
+
+LZ4_saveDict() :
+	Copies the last 64KB (at most) of the history into 'safeBuffer', for when the memory of the previous blocks is about to
+	be reused. Returns the size saved.
+
+A new stream is started with LZ4_resetStream(), or with LZ4_loadDict() to start from a known dictionary.
 */
 
 
-CORE_EXPORT( int ) LZ4_compress_limitedOutput   (const char* source, char* dest, int isize, int maxOutputSize);
+//****************************
+// Streaming Decompression
+//****************************
+
+// Position of the previous blocks, opaque to the caller
+#define LZ4_STREAMDECODESIZE_U64  4
+#define LZ4_STREAMDECODESIZE     (LZ4_STREAMDECODESIZE_U64 * sizeof(unsigned long long))
+
+typedef struct { unsigned long long table[LZ4_STREAMDECODESIZE_U64]; } LZ4_streamDecode_t;
+
+CORE_EXPORT( LZ4_streamDecode_t* ) LZ4_createStreamDecode (void);
+CORE_EXPORT( int ) LZ4_freeStreamDecode (LZ4_streamDecode_t* LZ4_stream);
+CORE_EXPORT( int ) LZ4_setStreamDecode (LZ4_streamDecode_t* LZ4_streamDecode, const char* dictionary, int dictSize);
+
+CORE_EXPORT( int ) LZ4_decompress_safe_continue (LZ4_streamDecode_t* LZ4_streamDecode, const char* source, char* dest, int compressedSize, int maxDecompressedSize);
+CORE_EXPORT( int ) LZ4_decompress_fast_continue (LZ4_streamDecode_t* LZ4_streamDecode, const char* source, char* dest, int originalSize);
+
+CORE_EXPORT( int ) LZ4_decompress_safe_usingDict (const char* source, char* dest, int compressedSize, int maxDecompressedSize, const char* dictStart, int dictSize);
+CORE_EXPORT( int ) LZ4_decompress_fast_usingDict (const char* source, char* dest, int originalSize, const char* dictStart, int dictSize);
 
 /*
-LZ4_compress_limitedOutput() :
-	Compress 'isize' bytes from 'source' into an output buffer 'dest' of maximum size 'maxOutputSize'.
-	If it cannot achieve it, compression will stop, and result of the function will be zero.
-	This function never writes outside of provided output buffer.
-
-	isize  : is the input size. Max supported value is ~1.9GB
-	maxOutputSize : is the size of the destination buffer (which must be already allocated)
-	return : the number of bytes written in buffer 'dest'
-			 or 0 if the compression fails
+LZ4_setStreamDecode() :
+	Starts a stream, with the given dictionary (the one given to LZ4_loadDict()) or none (dictSize = 0).
+	A stream created by LZ4_createStreamDecode() needs no other initialization.
+
+LZ4_decompress_*_continue() :
+	Decodes the blocks of LZ4_compress_*_continue() in order. The previously decoded data must stay in memory and unmodified
+	(at least the last 64KB): blocks decoded one after the other in a buffer are faster to decode than in separate buffers.
+
+LZ4_decompress_*_usingDict() :
+	Decodes one block with the given history, without a stream. When the history immediately precedes 'dest', as the end of
+	the previous block kept in front of the next one, it is decoded at the speed of an independent block.
 */
 
 
-CORE_EXPORT( int ) LZ4_uncompress_unknownOutputSize (const char* source, char* dest, int isize, int maxOutputSize);
+//****************************
+// Dictionaries
+//****************************
+
+CORE_EXPORT( void ) LZ4_attachDictionary (LZ4_stream_t* workingStream, const LZ4_stream_t* dictionaryStream);
+CORE_EXPORT( int ) LZ4_trainDict (char* dictBuffer, int dictCapacity, const char* samplesBuffer, const int* sampleSizes, int nbSamples);
 
 /*
-LZ4_uncompress_unknownOutputSize() :
-	isize  : is the input size, therefore the compressed size
-	maxOutputSize : is the size of the destination buffer (which must be already allocated)
-	return : the number of bytes decoded in the destination buffer (necessarily <= maxOutputSize)
-			 If the source stream is malformed, the function will stop decoding and return a negative result, indicating the byte position of the faulty instruction
-			 This function never writes beyond dest + maxOutputSize, and is therefore protected against malicious data packets
-	note   : Destination buffer must be already allocated.
-			 This version is slightly slower than LZ4_uncompress()
+LZ4_attachDictionary() :
+	Starts a stream from the dictionary loaded in 'dictionaryStream' by LZ4_loadDict(), as LZ4_loadDict() would, without hashing
+	the dictionary again: the dictionary is loaded once and attached to the stream of each object compressed with it.
+	The dictionary must stay in memory, unmodified, while its streams compress. 'dictionaryStream' is not modified.
+
+LZ4_trainDict() :
+	Builds a dictionary of at most 'dictCapacity' bytes (and 64KB) out of the content shared by many small samples, stored one
+	after the other in 'samplesBuffer', the size of each one in 'sampleSizes'. Small blocks compress much better with a
+	dictionary of the content they have in common than alone.
+	Returns the size of the dictionary written at the start of 'dictBuffer', or 0 if the samples (less than 1KB in total) or
+	their common content are too small, or if the memory (10MB) couldn't be allocated.
+	The blocks are compressed by LZ4_loadDict() (or LZ4_attachDictionary()) followed by LZ4_compress_fast_continue(), or by
+	the HC equivalents, and decoded by LZ4_decompress_*_usingDict() with the same dictionary.
 */
 
 
+//****************************
+// Checksums
+//****************************
+
+// State of a checksum computed over several calls, to be initialized by LZ4_resetChecksum()
+#define LZ4_CHECKSUMSIZE_U32 12
+#define LZ4_CHECKSUMSIZE     (LZ4_CHECKSUMSIZE_U32 * sizeof(unsigned int))
+
+typedef struct { unsigned int table[LZ4_CHECKSUMSIZE_U32]; } LZ4_checksum_t;
+
+CORE_EXPORT( unsigned int ) LZ4_checksum (const void* input, int length, unsigned int seed);
+CORE_EXPORT( void ) LZ4_resetChecksum (LZ4_checksum_t* state, unsigned int seed);
+CORE_EXPORT( void ) LZ4_updateChecksum (LZ4_checksum_t* state, const void* input, int length);
+CORE_EXPORT( unsigned int ) LZ4_digestChecksum (const LZ4_checksum_t* state);
+
+/*
+LZ4_checksum() :
+	Returns the 32-bit xxHash (XXH32) of 'length' bytes, the checksum of the LZ4 frame format. It runs several times faster
+	than the decompression, so that blocks can be validated before being decoded.
+
+LZ4_resetChecksum() / LZ4_updateChecksum() / LZ4_digestChecksum() :
+	The same checksum over data given in several parts, such as the content of a stream block after block:
+	the digest of the parts is the one of LZ4_checksum() over all of them, and can be taken at any point.
+*/
+
+
+//****************************
+// Previous Functions
+//****************************
+
+// Kept for the existing bindings, they give the same results as their replacement
+
+CORE_EXPORT( int ) LZ4_compress   (const char* source, char* dest, int inputSize);                              // LZ4_compress_default with a LZ4_compressBound sized output
+CORE_EXPORT( int ) LZ4_compress_limitedOutput (const char* source, char* dest, int isize, int maxOutputSize);   // LZ4_compress_default
+CORE_EXPORT( int ) LZ4_uncompress (const char* source, char* dest, int outputSize);                             // LZ4_decompress_fast
+CORE_EXPORT( int ) LZ4_uncompress_unknownOutputSize (const char* source, char* dest, int isize, int maxOutputSize);   // LZ4_decompress_safe
+
+
 #if defined (__cplusplus)
 }
 #endif
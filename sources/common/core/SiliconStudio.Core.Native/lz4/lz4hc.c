@@ -32,534 +32,357 @@
 */
 
 
-#ifndef LZ4_CS_ADAPTER
-//**************************************
-// CPU Feature Detection
-//**************************************
-// 32 or 64 bits ?
-#ifndef LZ4_ARCH64
-
-#if (defined(__x86_64__) || defined(__x86_64) || defined(__amd64__) || defined(__amd64) || defined(__ppc64__) || defined(_WIN64) || defined(__LP64__) || defined(_LP64) )   // Detects 64 bits mode
-#define LZ4_ARCH64 1
-#else
-#define LZ4_ARCH64 0
-#endif
-
-#endif
-
-// Little Endian or Big Endian ? 
-// Overwrite the #define below if you know your architecture endianess
-#if defined (__GLIBC__)
-#  include <endian.h>
-#  if (__BYTE_ORDER == __BIG_ENDIAN)
-#     define LZ4_BIG_ENDIAN 1
-#  endif
-#elif (defined(__BIG_ENDIAN__) || defined(__BIG_ENDIAN) || defined(_BIG_ENDIAN)) && !(defined(__LITTLE_ENDIAN__) || defined(__LITTLE_ENDIAN) || defined(_LITTLE_ENDIAN))
-#  define LZ4_BIG_ENDIAN 1
-#elif defined(__sparc) || defined(__sparc__) \
-   || defined(__ppc__) || defined(_POWER) || defined(__powerpc__) || defined(_ARCH_PPC) || defined(__PPC__) || defined(__PPC) || defined(PPC) || defined(__powerpc__) || defined(__powerpc) || defined(powerpc) \
-   || defined(__hpux)  || defined(__hppa) \
-   || defined(_MIPSEB) || defined(__s390__)
-#define LZ4_BIG_ENDIAN 1
-#else
-// Little Endian assumed. PDP Endian and other very rare endian format are unsupported.
-#endif
-
-// Unaligned memory access is automatically enabled for "common" CPU, such as x86.
-// For others CPU, the compiler will be more cautious, and insert extra code to ensure aligned access is respected
-// If you know your target CPU supports unaligned memory access, you want to force this option manually to improve performance
-#if defined(__ARM_FEATURE_UNALIGNED)
-#define LZ4_FORCE_UNALIGNED_ACCESS 1
-#endif
-
-// Define this parameter if your target system or compiler does not support hardware bit count
-#if defined(_MSC_VER) && defined(_WIN32_WCE)            // Visual Studio for Windows CE does not support Hardware bit count
-#  define LZ4_FORCE_SW_BITCOUNT
-#endif
-
-
-//**************************************
-// Compiler Options
-//**************************************
-#if __STDC_VERSION__ >= 199901L    // C99
-  /* "restrict" is a known keyword */
-#else
-#define restrict  // Disable restrict
-#endif
-
-#ifdef _MSC_VER
-	#define inline __inline // Visual is not C99, but supports some kind of inline
-	#define forceinline __forceinline
-#else 
-#  ifdef __GNUC__
-#    define forceinline inline __attribute__((always_inline))
-#  else
-#    define forceinline inline
-#  endif
-#endif
-
-#if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT) // Visual Studio
-#include <intrin.h>             // For Visual 2005
-#  if LZ4_ARCH64 && defined(_M_X64) // 64-bit
-#    pragma intrinsic(_BitScanForward64) // For Visual 2005
-#    pragma intrinsic(_BitScanReverse64) // For Visual 2005
-#  else
-#    pragma intrinsic(_BitScanForward)   // For Visual 2005
-#    pragma intrinsic(_BitScanReverse)   // For Visual 2005
-#  endif
-#  pragma warning(disable : 4127)        // disable: C4127: conditional expression is constant
-#  pragma warning(disable : 4701)        // disable: C4701: potentially uninitialized local variable used
-#endif
-
-#ifdef _MSC_VER  // Visual Studio
-#define lz4_bswap16(x) _byteswap_ushort(x)
-#else
-#define lz4_bswap16(x)  ((unsigned short int) ((((x) >> 8) & 0xffu) | (((x) & 0xffu) << 8)))
-#endif
-
 
 //**************************************
 // Includes
 //**************************************
-#include <stdlib.h>   // calloc, free
-#include <string.h>   // memset, memcpy
 #include "lz4hc.h"
 
-#define ALLOCATOR(s) calloc(1,s)
-#define FREEMEM free
-#define MEM_INIT memset
-
-
-//**************************************
-// Basic Types
-//**************************************
-#if defined(_MSC_VER)    // Visual Studio does not support 'stdint' natively
-#define BYTE	unsigned __int8
-#define U16		unsigned __int16
-#define U32		unsigned __int32
-#define S32		__int32
-#define U64		unsigned __int64
-#define S64       __int64
-#else
-#include <stdint.h>
-#define BYTE	uint8_t
-#define U16		uint16_t
-#define U32		uint32_t
-#define S32		int32_t
-#define U64		uint64_t
-#define S64       int64_t
-#endif
-
-#ifndef LZ4_FORCE_UNALIGNED_ACCESS
-#pragma pack(push, 1) 
-#endif
-
-typedef struct _U16_S { U16 v; } U16_S;
-typedef struct _U32_S { U32 v; } U32_S;
-typedef struct _U64_S { U64 v; } U64_S;
-
-#ifndef LZ4_FORCE_UNALIGNED_ACCESS
-#pragma pack(pop) 
-#endif
-
-#define A64(x) (((U64_S *)(x))->v)
-#define A32(x) (((U32_S *)(x))->v)
-#define A16(x) (((U16_S *)(x))->v)
+// Common definitions of lz4.c: basic types, memory accesses, LZ4_count and the constants of the block format
+#define LZ4_COMMONDEFS_ONLY
+#include "lz4.c"
 
 
 //**************************************
 // Constants
 //**************************************
-#define MINMATCH 4
-
 #define DICTIONARY_LOGSIZE 16
 #define MAXD (1<<DICTIONARY_LOGSIZE)
-#define MAXD_MASK ((U32)(MAXD - 1))
-#define MAX_DISTANCE (MAXD - 1)
+#define MAXD_MASK (MAXD - 1)
 
 #define HASH_LOG (DICTIONARY_LOGSIZE-1)
 #define HASHTABLESIZE (1 << HASH_LOG)
 #define HASH_MASK (HASHTABLESIZE - 1)
 
-#define MAX_NB_ATTEMPTS 256
-
-#define ML_BITS  4
-#define ML_MASK  (size_t)((1U<<ML_BITS)-1)
-#define RUN_BITS (8-ML_BITS)
-#define RUN_MASK ((1U<<RUN_BITS)-1)
-
-#define COPYLENGTH 8
-#define LASTLITERALS 5
-#define MFLIMIT (COPYLENGTH+MINMATCH)
-#define MINLENGTH (MFLIMIT+1)
 #define OPTIMAL_ML (int)((ML_MASK-1)+MINMATCH)
 
-
-//**************************************
-// Architecture-specific macros
-//**************************************
-#if LZ4_ARCH64	// 64-bit
-#define STEPSIZE 8
-#define LZ4_COPYSTEP(s,d)		A64(d) = A64(s); d+=8; s+=8;
-#define LZ4_COPYPACKET(s,d)		LZ4_COPYSTEP(s,d)
-#define UARCH U64
-#define AARCH A64
-#define HTYPE					U32
-#define INITBASE(b,s)			const BYTE* const b = s
-#else		// 32-bit
-#define STEPSIZE 4
-#define LZ4_COPYSTEP(s,d)		A32(d) = A32(s); d+=4; s+=4;
-#define LZ4_COPYPACKET(s,d)		LZ4_COPYSTEP(s,d); LZ4_COPYSTEP(s,d);
-#define UARCH U32
-#define AARCH A32
-#define HTYPE					const BYTE*
-#define INITBASE(b,s)		    const int b = 0
-#endif
-
-#if defined(LZ4_BIG_ENDIAN)
-#define LZ4_READ_LITTLEENDIAN_16(d,s,p) { U16 v = A16(p); v = lz4_bswap16(v); d = (s) - v; }
-#define LZ4_WRITE_LITTLEENDIAN_16(p,i)  { U16 v = (U16)(i); v = lz4_bswap16(v); A16(p) = v; p+=2; }
-#else		// Little Endian
-#define LZ4_READ_LITTLEENDIAN_16(d,s,p) { d = (s) - A16(p); }
-#define LZ4_WRITE_LITTLEENDIAN_16(p,v)  { A16(p) = v; p+=2; }
-#endif
+#define LZ4HC_OPT_NUM               (1<<12)   // Positions priced at a time by the optimal parsing
+#define LZ4HC_OPT_SUFFICIENT_LENGTH 256       // Matches at least this long are taken as found by the optimal parsing
+#define LZ4HC_OPT_ATTEMPTS          (1<<11)   // Candidate matches examined at each position by the optimal parsing, a quarter of them where the previous match goes on
 
 
 //************************************************************
 // Local Types
 //************************************************************
+// Positions are indexes relative to 'base', the start of an independent block being 64KB after the end of the previous one (or after 0):
+// the entries left by the previous blocks, or zeroed, are then always out of the window, and the chains don't need to be tested
+// against the start of the block. This is also what allows to reuse the tables without clearing them.
+// Streaming keeps the indexes growing: the data since 'dictLimit' is contiguous in memory, the data between 'lowLimit' and
+// 'dictLimit' is the external dictionary, found at the same indexes relative to 'dictBase'.
+// Internal layout of LZ4_streamHC_t.
 typedef struct 
 {
-	const BYTE* base;
-	HTYPE hashTable[HASHTABLESIZE];
+	U32 hashTable[HASHTABLESIZE];
 	U16 chainTable[MAXD];
-	const BYTE* nextToUpdate;
+	const BYTE* end;        // End of the previous block, NULL when the tables must be cleared
+	const BYTE* base;       // All indexes relative to this position
+	const BYTE* dictBase;   // Alternate base for the external dictionary
+	U32 dictLimit;          // Index of the start of the contiguous data
+	U32 lowLimit;           // Index of the start of the external dictionary, dictLimit when there is none
+	U32 nextToUpdate;       // Index from which to continue the update of the chains
+	int compressionLevel;   // Level used when the one given to the compression is <= 0
 } LZ4HC_Data_Structure;
 
+typedef char LZ4HC_Data_Structure_size_check[(sizeof(LZ4HC_Data_Structure) <= sizeof(LZ4_streamHC_t)) ? 1 : -1];
+
+#define LZ4HC_RESET_LIMIT (1 GB)   // Positions at which reused tables are cleared, before they could overflow
+
+typedef enum { noLimit = 0, limitedOutput = 1 } limitedOutput_directive;
+
 
 //**************************************
 // Macros
 //**************************************
-#define LZ4_WILDCOPY(s,d,e)		do { LZ4_COPYPACKET(s,d) } while (d<e);
-#define LZ4_BLINDCOPY(s,d,l)	{ BYTE* e=d+l; LZ4_WILDCOPY(s,d,e); d=e; }
 #define HASH_FUNCTION(i)	(((i) * 2654435761U) >> ((MINMATCH*8)-HASH_LOG))
-#define HASH_VALUE(p)		   HASH_FUNCTION(A32(p))
-#define HASH_POINTER(p)		(HashTable[HASH_VALUE(p)] + base)
-#define DELTANEXT(p)		chainTable[(size_t)(p) & MAXD_MASK] 
-#define GETNEXT(p)			((p) - (size_t)DELTANEXT(p))
+#define DELTANEXT(p)		chainTable[(U16)(p)]
+
+static inline U32 LZ4HC_hashPtr(const void* ptr) { return HASH_FUNCTION(LZ4_read32(ptr)); }
 
 
 //**************************************
-// Private functions
+// HC Compression
 //**************************************
-#if LZ4_ARCH64
-
-inline static int LZ4_NbCommonBytes (register U64 val)
-{
-#if defined(LZ4_BIG_ENDIAN)
-	#if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT) && defined(_M_X64)
-	unsigned long r = 0;
-	_BitScanReverse64( &r, val );
-	return (int)(r>>3);
-	#elif defined(__GNUC__) && ((__GNUC__ * 100 + __GNUC_MINOR__) >= 304) && !defined(LZ4_FORCE_SW_BITCOUNT)
-	return (__builtin_clzll(val) >> 3); 
-	#else
-	int r;
-	if (!(val>>32)) { r=4; } else { r=0; val>>=32; }
-	if (!(val>>16)) { r+=2; val>>=8; } else { val>>=24; }
-	r += (!val);
-	return r;
-	#endif
-#else
-	#if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT) && defined(_M_X64)
-	unsigned long r = 0;
-	_BitScanForward64( &r, val );
-	return (int)(r>>3);
-	#elif defined(__GNUC__) && ((__GNUC__ * 100 + __GNUC_MINOR__) >= 304) && !defined(LZ4_FORCE_SW_BITCOUNT)
-	return (__builtin_ctzll(val) >> 3); 
-	#else
-	static const int DeBruijnBytePos[64] = { 0, 0, 0, 0, 0, 1, 1, 2, 0, 3, 1, 3, 1, 4, 2, 7, 0, 2, 3, 6, 1, 5, 3, 5, 1, 3, 4, 4, 2, 5, 6, 7, 7, 0, 1, 2, 3, 3, 4, 6, 2, 6, 5, 5, 3, 4, 5, 6, 7, 1, 2, 4, 6, 4, 4, 5, 7, 2, 6, 5, 7, 6, 7, 7 };
-#ifdef LZ4_MK_OPT
-	return DeBruijnBytePos[((U64)((U64)((S64)val & -(S64)val) * 0x0218A392CDABBD3F)) >> 58];
-#else
-	return DeBruijnBytePos[((U64)((val & -val) * 0x0218A392CDABBD3F)) >> 58];
-#endif
-	#endif
-#endif
-}
-
-#else
-
-inline static int LZ4_NbCommonBytes (register U32 val)
-{
-#if defined(LZ4_BIG_ENDIAN)
-	#if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT)
-	unsigned long r;
-	_BitScanReverse( &r, val );
-	return (int)(r>>3);
-	#elif defined(__GNUC__) && ((__GNUC__ * 100 + __GNUC_MINOR__) >= 304) && !defined(LZ4_FORCE_SW_BITCOUNT)
-	return (__builtin_clz(val) >> 3); 
-	#else
-	int r;
-	if (!(val>>16)) { r=2; val>>=8; } else { r=0; val>>=24; }
-	r += (!val);
-	return r;
-	#endif
-#else
-	#if defined(_MSC_VER) && !defined(LZ4_FORCE_SW_BITCOUNT)
-	unsigned long r;
-	_BitScanForward( &r, val );
-	return (int)(r>>3);
-	#elif defined(__GNUC__) && ((__GNUC__ * 100 + __GNUC_MINOR__) >= 304) && !defined(LZ4_FORCE_SW_BITCOUNT)
-	return (__builtin_ctz(val) >> 3); 
-	#else
-	static const int DeBruijnBytePos[32] = { 0, 0, 3, 0, 3, 1, 3, 0, 3, 2, 2, 1, 3, 2, 0, 1, 3, 3, 1, 2, 2, 2, 2, 0, 3, 1, 2, 0, 1, 0, 1, 1 };
-#ifdef LZ4_MK_OPT
-	return DeBruijnBytePos[((U32)((U32)((S32)val & -(S32)val) * 0x077CB531U)) >> 27];
-#else
-	return DeBruijnBytePos[((U32)((val & -(S32)val) * 0x077CB531U)) >> 27];
-#endif
-	#endif
-#endif
-}
-
-#endif
-
-#endif // LZ4_CS_ADAPTER
-
-inline static int LZ4HC_Init (LZ4HC_Data_Structure* hc4, const BYTE* base)
+// Prepares the tables for a block starting at 'start', only clearing them on their first use and every GB
+static void LZ4HC_Init (LZ4HC_Data_Structure* hc4, const BYTE* start)
 {
-	MEM_INIT((void*)hc4->hashTable, 0, sizeof(hc4->hashTable));
-	MEM_INIT(hc4->chainTable, 0xFF, sizeof(hc4->chainTable));
-	hc4->nextToUpdate = base + LZ4_ARCH64;
-	hc4->base = base;
-	return 1;
-}
-
-
-inline static void* LZ4HC_Create (const BYTE* base)
-{
-	void* hc4 = ALLOCATOR(sizeof(LZ4HC_Data_Structure));
-
-	LZ4HC_Init ((LZ4HC_Data_Structure*)hc4, base);
-	return hc4;
-}
-
-
-inline static int LZ4HC_Free (void** LZ4HC_Data)
-{
-	FREEMEM(*LZ4HC_Data);
-	*LZ4HC_Data = NULL;
-	return (1);
-}
-
-
-// Update chains up to ip (excluded)
-forceinline static void LZ4HC_Insert (LZ4HC_Data_Structure* hc4, const BYTE* ip)
-{
-	U16*   chainTable = hc4->chainTable;
-	HTYPE* HashTable  = hc4->hashTable;
-	INITBASE(base,hc4->base);
-
-	while(hc4->nextToUpdate < ip)
+	size_t startingOffset = (size_t)(hc4->end - hc4->base);
+	if ((hc4->end == NULL) || (startingOffset > LZ4HC_RESET_LIMIT))
 	{
-		const BYTE* p = hc4->nextToUpdate;
-		size_t delta = (p) - HASH_POINTER(p); 
-		if (delta>MAX_DISTANCE) delta = MAX_DISTANCE; 
-		DELTANEXT(p) = (U16)delta; 
-		HashTable[HASH_VALUE(p)] = (HTYPE)((p) - base);
-		hc4->nextToUpdate++;
+		MEM_INIT((void*)hc4->hashTable, 0, sizeof(hc4->hashTable));
+		MEM_INIT(hc4->chainTable, 0xFF, sizeof(hc4->chainTable));
+		startingOffset = 0;
 	}
+	startingOffset += 64 KB;
+	hc4->nextToUpdate = (U32)startingOffset;
+	hc4->base = start - startingOffset;
+	hc4->dictBase = start - startingOffset;
+	hc4->end = start;
+	hc4->dictLimit = (U32)startingOffset;
+	hc4->lowLimit = (U32)startingOffset;
 }
 
 
-forceinline static size_t LZ4HC_CommonLength (const BYTE* p1, const BYTE* p2, const BYTE* const matchlimit)
+// Update chains up to ip (excluded)
+forceinline void LZ4HC_Insert (LZ4HC_Data_Structure* hc4, const BYTE* ip)
 {
-	const BYTE* p1t = p1;
+	U16* const chainTable = hc4->chainTable;
+	U32* const hashTable  = hc4->hashTable;
+	const BYTE* const base = hc4->base;
+	const U32 target = (U32)(ip - base);
+	U32 idx = hc4->nextToUpdate;
 
-	while (p1t<matchlimit-(STEPSIZE-1))
+	while(idx < target)
 	{
-		UARCH diff = AARCH(p2) ^ AARCH(p1t);
-		if (!diff) { p1t+=STEPSIZE; p2+=STEPSIZE; continue; }
-		p1t += LZ4_NbCommonBytes(diff);
-		return (p1t - p1);
+		U32 h = LZ4HC_hashPtr(base+idx);
+		size_t delta = idx - hashTable[h];
+		if (delta>MAX_DISTANCE) delta = MAX_DISTANCE;
+		DELTANEXT(idx) = (U16)delta;
+		hashTable[h] = idx;
+		idx++;
 	}
-	if (LZ4_ARCH64) if ((p1t<(matchlimit-3)) && (A32(p2) == A32(p1t))) { p1t+=4; p2+=4; }
-	if ((p1t<(matchlimit-1)) && (A16(p2) == A16(p1t))) { p1t+=2; p2+=2; }
-	if ((p1t<matchlimit) && (*p2 == *p1t)) p1t++;
-	return (p1t - p1);
+
+	hc4->nextToUpdate = target;
 }
 
 
-forceinline static int LZ4HC_InsertAndFindBestMatch (LZ4HC_Data_Structure* hc4, const BYTE* ip, const BYTE* const matchlimit, const BYTE** matchpos)
+// Longest match at ip among the 'maxNbAttempts' most recent candidates of its chain
+forceinline int LZ4HC_InsertAndFindBestMatch (LZ4HC_Data_Structure* hc4, const BYTE* ip, const BYTE* const iLimit, const BYTE** matchpos, const int maxNbAttempts)
 {
 	U16* const chainTable = hc4->chainTable;
-	HTYPE* const HashTable = hc4->hashTable;
-	const BYTE* ref;
-	INITBASE(base,hc4->base);
-	int nbAttempts=MAX_NB_ATTEMPTS;
-	size_t repl=0, ml=0;
-	U16 delta;
+	U32* const HashTable = hc4->hashTable;
+	const BYTE* const base = hc4->base;
+	const BYTE* const dictBase = hc4->dictBase;
+	const U32 dictLimit = hc4->dictLimit;
+	const U32 lowLimit = (hc4->lowLimit + 64 KB > (U32)(ip-base)) ? hc4->lowLimit : (U32)(ip - base) - (64 KB - 1);
+	U32 matchIndex;
+	int nbAttempts = maxNbAttempts;
+	size_t ml = 0;
 
 	// HC4 match finder
 	LZ4HC_Insert(hc4, ip);
-	ref = HASH_POINTER(ip);
-
-#define REPEAT_OPTIMIZATION
-#ifdef REPEAT_OPTIMIZATION
-	// Detect repetitive sequences of length <= 4
-	if (ref >= ip-4)               // potential repetition
-	{
-		if (A32(ref) == A32(ip))   // confirmed
-		{
-			delta = (U16)(ip-ref);
-			repl = ml  = LZ4HC_CommonLength(ip+MINMATCH, ref+MINMATCH, matchlimit) + MINMATCH;
-			*matchpos = ref;
-		}
-		ref = GETNEXT(ref);
-	}
-#endif
+	matchIndex = HashTable[LZ4HC_hashPtr(ip)];
 
-	while ((ref >= ip-MAX_DISTANCE) && (nbAttempts))
+	while ((matchIndex>=lowLimit) && (nbAttempts))
 	{
 		nbAttempts--;
-		if (*(ref+ml) == *(ip+ml))
-		if (A32(ref) == A32(ip))
+		if (matchIndex >= dictLimit)
 		{
-			size_t mlt = LZ4HC_CommonLength(ip+MINMATCH, ref+MINMATCH, matchlimit) + MINMATCH;
-			if (mlt > ml) { ml = mlt; *matchpos = ref; }
+			const BYTE* const match = base + matchIndex;
+			if (*(match+ml) == *(ip+ml)
+				&& (LZ4_read32(match) == LZ4_read32(ip)))
+			{
+				size_t const mlt = LZ4_count(ip+MINMATCH, match+MINMATCH, iLimit) + MINMATCH;
+				if (mlt > ml) { ml = mlt; *matchpos = match; }
+			}
 		}
-		ref = GETNEXT(ref);
-	}
-
-#ifdef REPEAT_OPTIMIZATION
-	// Complete table
-	if (repl)
-	{
-		const BYTE* ptr = ip;
-		const BYTE* end;
-
-		end = ip + repl - (MINMATCH-1);
-		while(ptr < end-delta)
+		else
 		{
-			DELTANEXT(ptr) = delta;    // Pre-Load
-			ptr++;
+			// Match in the external dictionary, which may go on with the start of the contiguous data
+			const BYTE* const match = dictBase + matchIndex;
+			if (LZ4_read32(match) == LZ4_read32(ip))
+			{
+				size_t mlt;
+				const BYTE* vLimit = ip + (dictLimit - matchIndex);
+				if (vLimit > iLimit) vLimit = iLimit;
+				mlt = LZ4_count(ip+MINMATCH, match+MINMATCH, vLimit) + MINMATCH;
+				if ((ip+mlt == vLimit) && (vLimit < iLimit))
+					mlt += LZ4_count(ip+mlt, base+dictLimit, iLimit);
+				if (mlt > ml) { ml = mlt; *matchpos = base + matchIndex; }   // virtual position, only used for its offset
+			}
 		}
-		do
-		{
-			DELTANEXT(ptr) = delta;    
-			HashTable[HASH_VALUE(ptr)] = (HTYPE)((ptr) - base);     // Head of chain
-			ptr++;
-		} while(ptr < end);
-		hc4->nextToUpdate = end;
+		if (ml == (size_t)(iLimit - ip)) break;   // Nothing longer to find (runs of the same bytes reach there on each candidate)
+		matchIndex -= DELTANEXT(matchIndex);
 	}
-#endif 
 
 	return (int)ml;
 }
 
 
-forceinline static int LZ4HC_InsertAndGetWiderMatch (LZ4HC_Data_Structure* hc4, const BYTE* ip, const BYTE* startLimit, const BYTE* matchlimit, int longest, const BYTE** matchpos, const BYTE** startpos)
+// Longest match at ip, extended backwards down to iLowLimit, that is longer than 'longest'
+forceinline int LZ4HC_InsertAndGetWiderMatch (
+	LZ4HC_Data_Structure* hc4,
+	const BYTE* const ip,
+	const BYTE* const iLowLimit,
+	const BYTE* const iHighLimit,
+	int longest,
+	const BYTE** matchpos,
+	const BYTE** startpos,
+	const int maxNbAttempts)
 {
-	U16* const  chainTable = hc4->chainTable;
-	HTYPE* const HashTable = hc4->hashTable;
-	INITBASE(base,hc4->base);
-	const BYTE*  ref;
-	int nbAttempts = MAX_NB_ATTEMPTS;
-	int delta = (int)(ip-startLimit);
+	U16* const chainTable = hc4->chainTable;
+	U32* const HashTable = hc4->hashTable;
+	const BYTE* const base = hc4->base;
+	const BYTE* const dictBase = hc4->dictBase;
+	const U32 dictLimit = hc4->dictLimit;
+	const BYTE* const lowPrefixPtr = base + dictLimit;
+	const U32 lowLimit = (hc4->lowLimit + 64 KB > (U32)(ip-base)) ? hc4->lowLimit : (U32)(ip - base) - (64 KB - 1);
+	U32 matchIndex;
+	int nbAttempts = maxNbAttempts;
+	int delta = (int)(ip-iLowLimit);
 
 	// First Match
 	LZ4HC_Insert(hc4, ip);
-	ref = HASH_POINTER(ip);
+	matchIndex = HashTable[LZ4HC_hashPtr(ip)];
 
-	while ((ref >= ip-MAX_DISTANCE) && (nbAttempts))
+	while ((matchIndex>=lowLimit) && (nbAttempts))
 	{
 		nbAttempts--;
-		if (*(startLimit + longest) == *(ref - delta + longest))
-		if (A32(ref) == A32(ip))
+		if (matchIndex >= dictLimit)
 		{
-#if 1
-			const BYTE* reft = ref+MINMATCH;
-			const BYTE* ipt = ip+MINMATCH;
-			const BYTE* startt = ip;
-
-			while (ipt<matchlimit-(STEPSIZE-1))
+			const BYTE* const matchPtr = base + matchIndex;
+			if (*(iLowLimit + longest) == *(matchPtr - delta + longest))
 			{
-				UARCH diff = AARCH(reft) ^ AARCH(ipt);
-				if (!diff) { ipt+=STEPSIZE; reft+=STEPSIZE; continue; }
-				ipt += LZ4_NbCommonBytes(diff);
-				goto _endCount;
+				if (LZ4_read32(matchPtr) == LZ4_read32(ip))
+				{
+					int mlt = MINMATCH + LZ4_count(ip+MINMATCH, matchPtr+MINMATCH, iHighLimit);
+					int back = 0;
+
+					while ((ip+back > iLowLimit) && (matchPtr+back > lowPrefixPtr) && (ip[back-1] == matchPtr[back-1])) back--;
+
+					mlt -= back;
+
+					if (mlt > longest)
+					{
+						longest = (int)mlt;
+						*matchpos = matchPtr+back;
+						*startpos = ip+back;
+					}
+				}
 			}
-			if (LZ4_ARCH64) if ((ipt<(matchlimit-3)) && (A32(reft) == A32(ipt))) { ipt+=4; reft+=4; }
-			if ((ipt<(matchlimit-1)) && (A16(reft) == A16(ipt))) { ipt+=2; reft+=2; }
-			if ((ipt<matchlimit) && (*reft == *ipt)) ipt++;
-_endCount:
-			reft = ref;
-#else
-			// Easier for code maintenance, but unfortunately slower too
-			const BYTE* startt = ip;
-			const BYTE* reft = ref;
-			const BYTE* ipt = ip + MINMATCH + LZ4HC_CommonLength(ip+MINMATCH, ref+MINMATCH, matchlimit);
-#endif
-
-			while ((startt>startLimit) && (reft > hc4->base) && (startt[-1] == reft[-1])) {startt--; reft--;}
-
-			if ((ipt-startt) > longest)
+		}
+		else
+		{
+			// Match in the external dictionary, which may go on with the start of the contiguous data
+			const BYTE* const matchPtr = dictBase + matchIndex;
+			if (LZ4_read32(matchPtr) == LZ4_read32(ip))
 			{
-				longest = (int)(ipt-startt);
-				*matchpos = reft;
-				*startpos = startt;
+				int mlt;
+				int back = 0;
+				const BYTE* vLimit = ip + (dictLimit - matchIndex);
+				if (vLimit > iHighLimit) vLimit = iHighLimit;
+				mlt = LZ4_count(ip+MINMATCH, matchPtr+MINMATCH, vLimit) + MINMATCH;
+				if ((ip+mlt == vLimit) && (vLimit < iHighLimit))
+					mlt += LZ4_count(ip+mlt, base+dictLimit, iHighLimit);
+
+				while ((ip+back > iLowLimit) && (matchIndex+back > lowLimit) && (ip[back-1] == matchPtr[back-1])) back--;
+
+				mlt -= back;
+
+				if (mlt > longest)
+				{
+					longest = mlt;
+					*matchpos = base + matchIndex + back;   // virtual position, only used for its offset
+					*startpos = ip+back;
+				}
 			}
 		}
-		ref = GETNEXT(ref);
+		if (longest == (int)(iHighLimit - iLowLimit)) break;   // Nothing longer to find
+		matchIndex -= DELTANEXT(matchIndex);
 	}
 
 	return longest;
 }
 
 
-forceinline static int LZ4_encodeSequence(const BYTE** ip, BYTE** op, const BYTE** anchor, int matchLength, const BYTE* ref, BYTE* oend)
+forceinline int LZ4HC_encodeSequence (
+	const BYTE** ip,
+	BYTE** op,
+	const BYTE** anchor,
+	int matchLength,
+	const BYTE* const match,
+	limitedOutput_directive limitedOutputBuffer,
+	BYTE* oend)
 {
-	int length, len; 
+	size_t length;
 	BYTE* token;
 
 	// Encode Literal length
-	length = (int)(*ip - *anchor);
+	length = (size_t)(*ip - *anchor);
 	token = (*op)++;
-	if ((*op + length + (2 + 1 + LASTLITERALS) + (length>>8)) > oend) return 1; 		// Check output limit
-	if (length>=(int)RUN_MASK) { *token=(RUN_MASK<<ML_BITS); len = length-RUN_MASK; for(; len > 254 ; len-=255) *(*op)++ = 255;  *(*op)++ = (BYTE)len; } 
+	if ((limitedOutputBuffer) && ((*op + (length/255) + length + (2 + 1 + LASTLITERALS)) > oend)) return 1;   // Check output limit
+	if (length>=RUN_MASK) { size_t len; *token=(RUN_MASK<<ML_BITS); len = length-RUN_MASK; for(; len > 254 ; len-=255) *(*op)++ = 255;  *(*op)++ = (BYTE)len; }
 	else *token = (BYTE)(length<<ML_BITS);
 
 	// Copy Literals
-	LZ4_BLINDCOPY(*anchor, *op, length);
+	LZ4_wildCopy(*op, *anchor, (*op) + length);
+	*op += length;
 
 	// Encode Offset
-	LZ4_WRITE_LITTLEENDIAN_16(*op,(U16)(*ip-ref));
+	LZ4_writeLE16(*op, (U16)(*ip-match)); *op += 2;
 
 	// Encode MatchLength
-	len = (int)(matchLength-MINMATCH);
-	if (*op + (1 + LASTLITERALS) + (length>>8) > oend) return 1; 		// Check output limit
-	if (len>=(int)ML_MASK) { *token+=ML_MASK; len-=ML_MASK; for(; len > 509 ; len-=510) { *(*op)++ = 255; *(*op)++ = 255; } if (len > 254) { len-=255; *(*op)++ = 255; } *(*op)++ = (BYTE)len; } 
-	else *token += (BYTE)len;	
+	length = (size_t)(matchLength-MINMATCH);
+	if ((limitedOutputBuffer) && (*op + (length/255) + (1 + LASTLITERALS) > oend)) return 1;   // Check output limit
+	if (length>=ML_MASK) { *token+=ML_MASK; length-=ML_MASK; for(; length > 509 ; length-=510) { *(*op)++ = 255; *(*op)++ = 255; } if (length > 254) { length-=255; *(*op)++ = 255; } *(*op)++ = (BYTE)length; }
+	else *token += (BYTE)(length);
 
 	// Prepare next loop
 	*ip += matchLength;
-	*anchor = *ip; 
+	*anchor = *ip;
 
 	return 0;
 }
 
 
-//****************************
-// Compression CODE
-//****************************
+forceinline int LZ4HC_encodeLastLiterals (
+	const BYTE* const anchor,
+	const BYTE* const iend,
+	BYTE* op,
+	const char* const dest,
+	int maxOutputSize,
+	limitedOutput_directive limit)
+{
+	size_t lastRun = (size_t)(iend - anchor);
+	if ((limit) && (((char*)op - dest) + lastRun + 1 + ((lastRun+255-RUN_MASK)/255) > (U32)maxOutputSize)) return 0;  // Check output limit
+	if (lastRun>=RUN_MASK) { *op++=(RUN_MASK<<ML_BITS); lastRun-=RUN_MASK; for(; lastRun > 254 ; lastRun-=255) *op++ = 255; *op++ = (BYTE) lastRun; }
+	else *op++ = (BYTE)(lastRun<<ML_BITS);
+	memcpy(op, anchor, iend - anchor);
+	op += iend-anchor;
+
+	return (int) (((char*)op)-dest);
+}
 
-int LZ4_compressHCCtx(LZ4HC_Data_Structure* ctx,
-				 const char* source, 
-				 char* dest,
-				 int inputSize,
-				 int maxOutputSize)
-{	
+
+//**************************************
+// Optimal Parsing
+//**************************************
+typedef struct
+{
+	int price;           // Size of the output from the start of the segment to this position
+	int matchLength;     // Length of the match ending here, 0 when the position is reached by a literal
+	int offset;          // Offset of that match
+	int literalLength;   // Length of the run of literals ending here
+	int next;            // Next position of the path selected
+} LZ4HC_optimal_t;
+
+#define LZ4HC_OPT_INFINITE_PRICE (1<<30)
+
+// Size of a run of literals, with the bytes of its length that don't fit in the token
+static inline int LZ4HC_literalsPrice(int literalLength)
+{
+	int price = literalLength;
+	if (literalLength >= (int)RUN_MASK) price += 1 + (literalLength - (int)RUN_MASK) / 255;
+	return price;
+}
+
+// Size of a sequence without its literals: the token, the offset and the bytes of the match length that don't fit in the token
+static inline int LZ4HC_matchPrice(int matchLength)
+{
+	int price = 1 + 2;
+	if (matchLength - MINMATCH >= (int)ML_MASK) price += 1 + (matchLength - MINMATCH - (int)ML_MASK) / 255;
+	return price;
+}
+
+// Optimal parsing: the sequences of the smallest output over segments of up to LZ4HC_OPT_NUM positions, given the longest match at each of them.
+// The size of a match doesn't depend on its offset in the block format, so the shorter matches at a position are the prefixes of the longest one.
+static int LZ4HC_compress_optimal (
+	LZ4HC_Data_Structure* ctx,
+	const char* source,
+	char* dest,
+	int inputSize,
+	int maxOutputSize,
+	limitedOutput_directive limit)
+{
 	const BYTE* ip = (const BYTE*) source;
 	const BYTE* anchor = ip;
 	const BYTE* const iend = ip + inputSize;
@@ -569,21 +392,180 @@ int LZ4_compressHCCtx(LZ4HC_Data_Structure* ctx,
 	BYTE* op = (BYTE*) dest;
 	BYTE* const oend = op + maxOutputSize;
 
-	int	ml, ml2, ml3, ml0;
-	const BYTE* ref=NULL;
-	const BYTE* start2=NULL;
-	const BYTE* ref2=NULL;
-	const BYTE* start3=NULL;
-	const BYTE* ref3=NULL;
+	const int positionCount = inputSize < LZ4HC_OPT_NUM ? inputSize : LZ4HC_OPT_NUM;
+	LZ4HC_optimal_t* opt;
+	int result = 0;
+
+	if (inputSize < LZ4_minLength) return LZ4HC_encodeLastLiterals(anchor, iend, op, dest, maxOutputSize, limit);   // Input too small, no compression (all literals)
+	opt = (LZ4HC_optimal_t*) ALLOCATOR(positionCount + 1, sizeof(LZ4HC_optimal_t));
+	if (opt == NULL) return 0;
+
+	ip++;
+
+	// Main Loop
+	while (ip < mflimit)
+	{
+		const BYTE* match = NULL;
+		int matchLength = LZ4HC_InsertAndFindBestMatch(ctx, ip, matchlimit, &match, LZ4HC_OPT_ATTEMPTS);
+		int position, lastPosition;
+		int endLength = 0, endOffset = 0;
+		if (!matchLength) { ip++; continue; }
+
+		if (matchLength >= LZ4HC_OPT_SUFFICIENT_LENGTH)
+		{
+			if (LZ4HC_encodeSequence(&ip, &op, &anchor, matchLength, match, limit, oend)) goto _end;
+			continue;
+		}
+
+		// Prices of the positions of the segment starting at ip, following the literals before it
+		opt[0].price = 0;
+		opt[0].matchLength = 0;
+		opt[0].literalLength = (int)(ip - anchor);
+		lastPosition = 0;
+		for (position = 0; ; position++)
+		{
+			const BYTE* const current = ip + position;
+			if (position == 0)
+			{
+				// Already found
+			}
+			else if (current >= mflimit)
+			{
+				matchLength = 0;
+			}
+			else if (matchLength > MINMATCH)
+			{
+				// The match of the previous position goes on here, only longer ones are looked for
+				const BYTE* start;
+				match++;
+				matchLength = LZ4HC_InsertAndGetWiderMatch(ctx, current, current, matchlimit, matchLength - 1, &match, &start, LZ4HC_OPT_ATTEMPTS / 4);
+			}
+			else
+			{
+				matchLength = LZ4HC_InsertAndFindBestMatch(ctx, current, matchlimit, &match, LZ4HC_OPT_ATTEMPTS);
+			}
+
+			if (matchLength)
+			{
+				int const offset = (int)(current - match);
+				int length;
+
+				// A long match, or one going beyond the segment, ends it as found
+				if ((matchLength >= LZ4HC_OPT_SUFFICIENT_LENGTH) || (position + matchLength > positionCount))
+				{
+					lastPosition = position;
+					endLength = matchLength;
+					endOffset = offset;
+					break;
+				}
+
+				for (length = matchLength; length >= MINMATCH; length--)
+				{
+					int const target = position + length;
+					int const price = opt[position].price + LZ4HC_matchPrice(length);
+					while (lastPosition < target) opt[++lastPosition].price = LZ4HC_OPT_INFINITE_PRICE;
+					if (price < opt[target].price)
+					{
+						opt[target].price = price;
+						opt[target].matchLength = length;
+						opt[target].offset = offset;
+						opt[target].literalLength = 0;
+					}
+				}
+			}
+
+			if (position >= lastPosition) break;
+
+			// One more literal
+			{
+				int const literalLength = opt[position].literalLength + 1;
+				int const price = opt[position].price + LZ4HC_literalsPrice(literalLength) - LZ4HC_literalsPrice(literalLength - 1);
+				if (price < opt[position + 1].price)
+				{
+					opt[position + 1].price = price;
+					opt[position + 1].matchLength = 0;
+					opt[position + 1].literalLength = literalLength;
+				}
+			}
+		}
+
+		// The cheapest path, from the end of the segment, then its matches from the start (its final literals go on in the next segment, unless the match ending it follows)
+		for (position = lastPosition; position > 0; )
+		{
+			int const previous = position - (opt[position].matchLength ? opt[position].matchLength : 1);
+			opt[previous].next = position;
+			position = previous;
+		}
+		for (position = 0; position < lastPosition; position = opt[position].next)
+		{
+			int const next = opt[position].next;
+			if (opt[next].matchLength)
+			{
+				const BYTE* start = ip + position;
+				if (LZ4HC_encodeSequence(&start, &op, &anchor, opt[next].matchLength, start - opt[next].offset, limit, oend)) goto _end;
+			}
+		}
+		ip += lastPosition;
+		if (endLength)
+			if (LZ4HC_encodeSequence(&ip, &op, &anchor, endLength, ip - endOffset, limit, oend)) goto _end;
+	}
+
+	result = LZ4HC_encodeLastLiterals(anchor, iend, op, dest, maxOutputSize, limit);
+
+_end:
+	FREEMEM(opt);
+	return result;
+}
+
+
+//**************************************
+// Lazy Parsing
+//**************************************
+// Lazy parsing: a match is only emitted once the two next searches, from within it, couldn't find a longer one
+static int LZ4HC_compress_generic (
+	void* ctxvoid,
+	const char* source,
+	char* dest,
+	int inputSize,
+	int maxOutputSize,
+	int compressionLevel,
+	limitedOutput_directive limit)
+{
+	LZ4HC_Data_Structure* ctx = (LZ4HC_Data_Structure*) ctxvoid;
+	const BYTE* ip = (const BYTE*) source;
+	const BYTE* anchor = ip;
+	const BYTE* const iend = ip + inputSize;
+	const BYTE* const mflimit = iend - MFLIMIT;
+	const BYTE* const matchlimit = (iend - LASTLITERALS);
+
+	BYTE* op = (BYTE*) dest;
+	BYTE* const oend = op + maxOutputSize;
+
+	int maxNbAttempts;
+	int ml, ml2, ml3, ml0;
+	const BYTE* ref = NULL;
+	const BYTE* start2 = NULL;
+	const BYTE* ref2 = NULL;
+	const BYTE* start3 = NULL;
+	const BYTE* ref3 = NULL;
 	const BYTE* start0;
 	const BYTE* ref0;
 
+	// init
+	if ((U32)inputSize > (U32)LZ4_MAX_INPUT_SIZE) return 0;   // Unsupported input size, too large (or negative)
+	ctx->end += inputSize;
+	if (compressionLevel < LZ4HC_MIN_CLEVEL) compressionLevel = LZ4HC_DEFAULT_CLEVEL;
+	if (compressionLevel > LZ4HC_MAX_CLEVEL) compressionLevel = LZ4HC_MAX_CLEVEL;
+	if (compressionLevel >= LZ4HC_OPT_CLEVEL) return LZ4HC_compress_optimal(ctx, source, dest, inputSize, maxOutputSize, limit);
+	maxNbAttempts = 1 << (compressionLevel-1);
+	if (inputSize < LZ4_minLength) goto _last_literals;   // Input too small, no compression (all literals)
+
 	ip++;
 
 	// Main Loop
 	while (ip < mflimit)
 	{
-		ml = LZ4HC_InsertAndFindBestMatch (ctx, ip, matchlimit, (&ref));
+		ml = LZ4HC_InsertAndFindBestMatch (ctx, ip, matchlimit, (&ref), maxNbAttempts);
 		if (!ml) { ip++; continue; }
 
 		// saved, in case we would skip too much
@@ -593,12 +575,12 @@ int LZ4_compressHCCtx(LZ4HC_Data_Structure* ctx,
 
 _Search2:
 		if (ip+ml < mflimit)
-			ml2 = LZ4HC_InsertAndGetWiderMatch(ctx, ip + ml - 2, ip + 1, matchlimit, ml, &ref2, &start2);
-		else ml2=ml;
+			ml2 = LZ4HC_InsertAndGetWiderMatch(ctx, ip + ml - 2, ip + 0, matchlimit, ml, &ref2, &start2, maxNbAttempts);
+		else ml2 = ml;
 
 		if (ml2 == ml)  // No better match
 		{
-			if (LZ4_encodeSequence(&ip, &op, &anchor, ml, ref, oend)) return 0;
+			if (LZ4HC_encodeSequence(&ip, &op, &anchor, ml, ref, limit, oend)) return 0;
 			continue;
 		}
 
@@ -639,20 +621,20 @@ _Search3:
 				ml2 -= correction;
 			}
 		}
-		// Now, we have start2 = ip+new_ml, with new_ml=min(ml, OPTIMAL_ML=18)
+		// Now, we have start2 = ip+new_ml, with new_ml = min(ml, OPTIMAL_ML=18)
 
 		if (start2 + ml2 < mflimit)
-			ml3 = LZ4HC_InsertAndGetWiderMatch(ctx, start2 + ml2 - 3, start2, matchlimit, ml2, &ref3, &start3);
-		else ml3=ml2;
+			ml3 = LZ4HC_InsertAndGetWiderMatch(ctx, start2 + ml2 - 3, start2, matchlimit, ml2, &ref3, &start3, maxNbAttempts);
+		else ml3 = ml2;
 
 		if (ml3 == ml2) // No better match : 2 sequences to encode
 		{
 			// ip & ref are known; Now for ml
 			if (start2 < ip+ml)  ml = (int)(start2 - ip);
 			// Now, encode 2 sequences
-			if (LZ4_encodeSequence(&ip, &op, &anchor, ml, ref, oend)) return 0;
+			if (LZ4HC_encodeSequence(&ip, &op, &anchor, ml, ref, limit, oend)) return 0;
 			ip = start2;
-			if (LZ4_encodeSequence(&ip, &op, &anchor, ml2, ref2, oend)) return 0;
+			if (LZ4HC_encodeSequence(&ip, &op, &anchor, ml2, ref2, limit, oend)) return 0;
 			continue;
 		}
 
@@ -674,7 +656,7 @@ _Search3:
 					}
 				}
 
-				if (LZ4_encodeSequence(&ip, &op, &anchor, ml, ref, oend)) return 0;
+				if (LZ4HC_encodeSequence(&ip, &op, &anchor, ml, ref, limit, oend)) return 0;
 				ip  = start3;
 				ref = ref3;
 				ml  = ml3;
@@ -713,7 +695,7 @@ _Search3:
 				ml = (int)(start2 - ip);
 			}
 		}
-		if (LZ4_encodeSequence(&ip, &op, &anchor, ml, ref, oend)) return 0;
+		if (LZ4HC_encodeSequence(&ip, &op, &anchor, ml, ref, limit, oend)) return 0;
 
 		ip = start2;
 		ref = ref2;
@@ -724,41 +706,205 @@ _Search3:
 		ml2 = ml3;
 
 		goto _Search3;
+	}
+
+_last_literals:
+	return LZ4HC_encodeLastLiterals(anchor, iend, op, dest, maxOutputSize, limit);
+}
+
+
+//****************************
+// Reusable States
+//****************************
+
+CORE_EXPORT( int ) LZ4_sizeofStateHC(void)
+{
+	return LZ4_STREAMHCSIZE;
+}
+
+
+CORE_EXPORT( void ) LZ4_resetStreamHC(LZ4_streamHC_t* streamHCPtr, int compressionLevel)
+{
+	LZ4HC_Data_Structure* const hc4 = (LZ4HC_Data_Structure*) streamHCPtr;
+	hc4->end = NULL;
+	hc4->base = NULL;
+	hc4->compressionLevel = compressionLevel;
+}
+
+
+CORE_EXPORT( LZ4_streamHC_t* ) LZ4_createStreamHC(void)
+{
+	LZ4_streamHC_t* const streamHCPtr = (LZ4_streamHC_t*) ALLOCATOR(1, sizeof(LZ4_streamHC_t));
+	if (streamHCPtr == NULL) return NULL;
+	LZ4_resetStreamHC(streamHCPtr, LZ4HC_DEFAULT_CLEVEL);
+	return streamHCPtr;
+}
 
+
+CORE_EXPORT( int ) LZ4_freeStreamHC(LZ4_streamHC_t* streamHCPtr)
+{
+	FREEMEM(streamHCPtr);
+	return 0;
+}
+
+
+CORE_EXPORT( int ) LZ4_compress_HC_extStateHC(void* state, const char* source, char* dest, int inputSize, int maxOutputSize, int compressionLevel)
+{
+	LZ4HC_Data_Structure* const hc4 = (LZ4HC_Data_Structure*) state;
+	int result;
+
+	if ((U32)inputSize > (U32)LZ4_MAX_INPUT_SIZE) return 0;   // Unsupported input size, too large (or negative)
+	if (compressionLevel < LZ4HC_MIN_CLEVEL) compressionLevel = hc4->compressionLevel;
+
+	LZ4HC_Init(hc4, (const BYTE*)source);
+
+	// The output limit can only be reached when the output is smaller than the worst case
+	if (maxOutputSize < LZ4_compressBound(inputSize))
+		result = LZ4HC_compress_generic(hc4, source, dest, inputSize, maxOutputSize, compressionLevel, limitedOutput);
+	else
+		result = LZ4HC_compress_generic(hc4, source, dest, inputSize, maxOutputSize, compressionLevel, noLimit);
+
+	return result;
+}
+
+
+// One block with tables of its own: use a reusable state to compress several ones
+CORE_EXPORT( int ) LZ4_compress_HC(const char* source, char* dest, int inputSize, int maxOutputSize, int compressionLevel)
+{
+	int result;
+	LZ4_streamHC_t* const state = LZ4_createStreamHC();
+	if (state == NULL) return 0;
+
+	result = LZ4_compress_HC_extStateHC(state, source, dest, inputSize, maxOutputSize, compressionLevel);
+
+	LZ4_freeStreamHC(state);
+	return result;
+}
+
+
+//****************************
+// Streaming Compression
+//****************************
+
+CORE_EXPORT( int ) LZ4_loadDictHC(LZ4_streamHC_t* streamHCPtr, const char* dictionary, int dictSize)
+{
+	LZ4HC_Data_Structure* const hc4 = (LZ4HC_Data_Structure*) streamHCPtr;
+	if (dictSize > 64 KB)
+	{
+		dictionary += dictSize - 64 KB;
+		dictSize = 64 KB;
+	}
+	if (dictSize < 0) dictSize = 0;
+	LZ4HC_Init(hc4, (const BYTE*)dictionary);
+	hc4->end = (const BYTE*)dictionary + dictSize;
+	if (dictSize >= 4) LZ4HC_Insert(hc4, hc4->end-3);
+	return dictSize;
+}
+
+// Copies a state prepared once by LZ4_loadDictHC(), keeping the compression level of the working state
+CORE_EXPORT( void ) LZ4_attachDictionaryHC(LZ4_streamHC_t* workingStream, const LZ4_streamHC_t* dictionaryStream)
+{
+	LZ4HC_Data_Structure* const hc4 = (LZ4HC_Data_Structure*) workingStream;
+	int const compressionLevel = hc4->compressionLevel;
+	memcpy(workingStream, dictionaryStream, sizeof(LZ4HC_Data_Structure));
+	hc4->compressionLevel = compressionLevel;
+}
+
+
+// The data since dictLimit becomes the external dictionary of a block that doesn't follow it in memory
+static void LZ4HC_setExternalDict(LZ4HC_Data_Structure* hc4, const BYTE* newBlock)
+{
+	if (hc4->end >= hc4->base + hc4->dictLimit + 4) LZ4HC_Insert(hc4, hc4->end-3);   // Reference the remaining dictionary content
+
+	// Only one memory segment for the dictionary: the previous one is lost
+	hc4->lowLimit = hc4->dictLimit;
+	hc4->dictLimit = (U32)(hc4->end - hc4->base);
+	hc4->dictBase = hc4->base;
+	hc4->base = newBlock - hc4->dictLimit;
+	hc4->end = newBlock;
+	hc4->nextToUpdate = hc4->dictLimit;   // Match referencing resumes from there
+}
+
+
+CORE_EXPORT( int ) LZ4_compress_HC_continue(LZ4_streamHC_t* streamHCPtr, const char* source, char* dest, int inputSize, int maxOutputSize)
+{
+	LZ4HC_Data_Structure* const hc4 = (LZ4HC_Data_Structure*) streamHCPtr;
+
+	if ((U32)inputSize > (U32)LZ4_MAX_INPUT_SIZE) return 0;   // Unsupported input size, too large (or negative)
+
+	// First block of the stream
+	if (hc4->base == NULL) LZ4HC_Init(hc4, (const BYTE*)source);
+
+	// Restart from the last 64KB before the indexes overflow
+	if ((size_t)(hc4->end - hc4->base) > LZ4HC_RESET_LIMIT)
+	{
+		size_t dictSize = (size_t)(hc4->end - hc4->base) - hc4->dictLimit;
+		if (dictSize > 64 KB) dictSize = 64 KB;
+		LZ4_loadDictHC(streamHCPtr, (const char*)(hc4->end) - dictSize, (int)dictSize);
 	}
 
-	// Encode Last Literals
+	// Check if blocks follow each other
+	if ((const BYTE*)source != hc4->end) LZ4HC_setExternalDict(hc4, (const BYTE*)source);
+
+	// Check overlapping input/dictionary space
+	if (hc4->lowLimit < hc4->dictLimit)
 	{
-		int lastRun = (int)(iend - anchor);
-		if (((char*)op - dest) + lastRun + 1 + ((lastRun+255-RUN_MASK)/255) > (U32)maxOutputSize) return 0;  // Check output limit
-		if (lastRun>=(int)RUN_MASK) { *op++=(RUN_MASK<<ML_BITS); lastRun-=RUN_MASK; for(; lastRun > 254 ; lastRun-=255) *op++ = 255; *op++ = (BYTE) lastRun; } 
-		else *op++ = (BYTE)(lastRun<<ML_BITS);
-		memcpy(op, anchor, iend - anchor);
-		op += iend-anchor;
-	} 
-
-	// End
-	return (int) (((char*)op)-dest);
+		const BYTE* sourceEnd = (const BYTE*) source + inputSize;
+		const BYTE* const dictBegin = hc4->dictBase + hc4->lowLimit;
+		const BYTE* const dictEnd = hc4->dictBase + hc4->dictLimit;
+		if ((sourceEnd > dictBegin) && ((const BYTE*)source < dictEnd))
+		{
+			if (sourceEnd > dictEnd) sourceEnd = dictEnd;
+			hc4->lowLimit = (U32)(sourceEnd - hc4->dictBase);
+			if (hc4->dictLimit - hc4->lowLimit < 4) hc4->lowLimit = hc4->dictLimit;
+		}
+	}
+
+	if (maxOutputSize < LZ4_compressBound(inputSize))
+		return LZ4HC_compress_generic(hc4, source, dest, inputSize, maxOutputSize, hc4->compressionLevel, limitedOutput);
+	else
+		return LZ4HC_compress_generic(hc4, source, dest, inputSize, maxOutputSize, hc4->compressionLevel, noLimit);
 }
 
 
-CORE_EXPORT( int ) LZ4_compressHC_limitedOutput(const char* source, 
-				 char* dest,
-				 int inputSize,
-				 int maxOutputSize)
+CORE_EXPORT( int ) LZ4_saveDictHC(LZ4_streamHC_t* streamHCPtr, char* safeBuffer, int dictSize)
 {
-	void* ctx = LZ4HC_Create((const BYTE*)source);
-	int result = LZ4_compressHCCtx((LZ4HC_Data_Structure*)ctx, source, dest, inputSize, maxOutputSize);
-	LZ4HC_Free (&ctx);
+	LZ4HC_Data_Structure* const hc4 = (LZ4HC_Data_Structure*) streamHCPtr;
+	int prefixSize;
+	U32 endIndex;
 
-	return result;
+	if (hc4->base == NULL) return 0;   // Nothing compressed yet
+
+	prefixSize = (int)(hc4->end - (hc4->base + hc4->dictLimit));
+	if (dictSize > 64 KB) dictSize = 64 KB;
+	if (dictSize < 4) dictSize = 0;
+	if (dictSize > prefixSize) dictSize = prefixSize;
+
+	memmove(safeBuffer, hc4->end - dictSize, dictSize);
+
+	endIndex = (U32)(hc4->end - hc4->base);
+	hc4->end = (const BYTE*)safeBuffer + dictSize;
+	hc4->base = hc4->end - endIndex;
+	hc4->dictBase = hc4->base;   // No external dictionary left
+	hc4->dictLimit = endIndex - dictSize;
+	hc4->lowLimit = endIndex - dictSize;
+	if (hc4->nextToUpdate < hc4->dictLimit) hc4->nextToUpdate = hc4->dictLimit;
+
+	return dictSize;
 }
 
 
-CORE_EXPORT( int ) LZ4_compressHC(const char* source, 
-				 char* dest,
-				 int inputSize)
+//****************************
+// Previous Functions
+//****************************
+
+CORE_EXPORT( int ) LZ4_compressHC_limitedOutput(const char* source, char* dest, int inputSize, int maxOutputSize)
 {
-	return LZ4_compressHC_limitedOutput(source, dest, inputSize, LZ4_compressBound(inputSize)+1);
+	return LZ4_compress_HC(source, dest, inputSize, maxOutputSize, LZ4HC_DEFAULT_CLEVEL);
 }
 
+
+CORE_EXPORT( int ) LZ4_compressHC(const char* source, char* dest, int inputSize)
+{
+	return LZ4_compress_HC(source, dest, inputSize, LZ4_compressBound(inputSize), LZ4HC_DEFAULT_CLEVEL);
+}
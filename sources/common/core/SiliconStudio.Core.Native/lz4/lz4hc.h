@@ -33,44 +33,123 @@
 */
 #pragma once
 
+#include <stddef.h>   // for size_t
 #include "../coreconfig.h"
 
 #ifdef LZ4_FUNC
 	#define LZ4_compressHC LZ4_FUNC(LZ4_compressHC)
 	#define LZ4_compressHC_limitedOutput LZ4_FUNC(LZ4_compressHC_limitedOutput)
+	#define LZ4_compress_HC LZ4_FUNC(LZ4_compress_HC)
 	#define LZ4HC_Data_Structure LZ4_FUNC(LZ4HC_Data_Structure)
+	#define LZ4_sizeofStateHC LZ4_FUNC(LZ4_sizeofStateHC)
+	#define LZ4_compress_HC_extStateHC LZ4_FUNC(LZ4_compress_HC_extStateHC)
+	#define LZ4_createStreamHC LZ4_FUNC(LZ4_createStreamHC)
+	#define LZ4_resetStreamHC LZ4_FUNC(LZ4_resetStreamHC)
+	#define LZ4_freeStreamHC LZ4_FUNC(LZ4_freeStreamHC)
+	#define LZ4_loadDictHC LZ4_FUNC(LZ4_loadDictHC)
+	#define LZ4_compress_HC_continue LZ4_FUNC(LZ4_compress_HC_continue)
+	#define LZ4_saveDictHC LZ4_FUNC(LZ4_saveDictHC)
+	#define LZ4_attachDictionaryHC LZ4_FUNC(LZ4_attachDictionaryHC)
 #endif
 
 #if defined (__cplusplus)
 extern "C" {
 #endif
 
+// Compression levels: each level doubles the number of candidate matches examined at every position,
+// the last one selects the matches by optimal parsing, for content compressed once and loaded many times
+#define LZ4HC_MIN_CLEVEL        1
+#define LZ4HC_DEFAULT_CLEVEL    9
+#define LZ4HC_OPT_CLEVEL        17
+#define LZ4HC_MAX_CLEVEL        17
 
-CORE_EXPORT( int ) LZ4_compressHC (const char* source, char* dest, int inputSize);
+
+CORE_EXPORT( int ) LZ4_compress_HC (const char* source, char* dest, int inputSize, int maxOutputSize, int compressionLevel);
 
 /*
-LZ4_compressHC :
-	return : the number of bytes in compressed buffer dest
-	note : destination buffer must be already allocated. 
-		To avoid any problem, size it to handle worst cases situations (input data not compressible)
-		Worst case size evaluation is provided by function LZ4_compressBound() (see "lz4.h")
+LZ4_compress_HC :
+	Compress 'inputSize' bytes from 'source' into an output buffer 'dest' of maximum size 'maxOutputSize'.
+	Compression is guaranteed to succeed if 'maxOutputSize' >= LZ4_compressBound(inputSize) (see "lz4.h").
+	The output is a regular LZ4 block, decoded by the functions of "lz4.h".
+
+	inputSize  : Max supported value is LZ4_MAX_INPUT_SIZE
+	compressionLevel : from LZ4HC_MIN_CLEVEL to LZ4HC_MAX_CLEVEL, higher levels are slower and compress better.
+					   Values <= 0 select LZ4HC_DEFAULT_CLEVEL, larger values are clamped to LZ4HC_MAX_CLEVEL.
+					   LZ4HC_OPT_CLEVEL prices the sequences of each segment of the block to keep the smallest ones, several times
+					   slower than the levels below, the output being decoded as fast.
+	return : the number of bytes written in buffer 'dest'
+			 or 0 if the compression fails
 */
 
-CORE_EXPORT( int ) LZ4_compressHC_limitedOutput (const char* source, char* dest, int inputSize, int maxOutputSize);
+
+//****************************
+// Reusable States
+//****************************
+
+// Tables of the HC compression (256KB), to be allocated once and reused for a sequence of blocks
+#define LZ4_STREAMHCSIZE        262192
+#define LZ4_STREAMHCSIZE_SIZET  (LZ4_STREAMHCSIZE / sizeof(size_t))
+
+typedef struct { size_t table[LZ4_STREAMHCSIZE_SIZET]; } LZ4_streamHC_t;
+
+CORE_EXPORT( LZ4_streamHC_t* ) LZ4_createStreamHC (void);
+CORE_EXPORT( void ) LZ4_resetStreamHC (LZ4_streamHC_t* streamHCPtr, int compressionLevel);
+CORE_EXPORT( int ) LZ4_freeStreamHC (LZ4_streamHC_t* streamHCPtr);
+
+CORE_EXPORT( int ) LZ4_sizeofStateHC (void);
+CORE_EXPORT( int ) LZ4_compress_HC_extStateHC (void* state, const char* source, char* dest, int inputSize, int maxOutputSize, int compressionLevel);
 
 /*
-LZ4_compress_limitedOutput() :
-	Compress 'inputSize' bytes from 'source' into an output buffer 'dest' of maximum size 'maxOutputSize'.
-	If it cannot achieve it, compression will stop, and result of the function will be zero.
-	This function never writes outside of provided output buffer.
+LZ4_createStreamHC() / LZ4_freeStreamHC() :
+	Allocate and release a state, LZ4_createStreamHC() returns NULL if the allocation fails.
+	A state can also live in memory provided by the caller, of LZ4_sizeofStateHC() bytes and aligned for a pointer,
+	in which case it must be initialized with LZ4_resetStreamHC() before its first use.
+
+LZ4_resetStreamHC() :
+	Marks a state to be cleared by its next compression, and sets the level used when the one given to the compression is <= 0.
+
+LZ4_compress_HC_extStateHC() :
+	Same as LZ4_compress_HC(), using the tables of 'state' instead of allocating and clearing its own.
+	Positions keep increasing from one block to the next, so that the entries of the previous blocks are recognized as out of
+	the current one: the tables are only cleared every GB of input. The blocks stay independent.
+	A state is used by one thread at a time.
+*/
 
-	inputSize  : Max supported value is ~1.9GB
-	maxOutputSize : is maximum allowed size into the destination buffer (which must be already allocated)
-	return : the number of output bytes written in buffer 'dest'
-			 or 0 if the compression fails
+
+//****************************
+// Streaming Compression
+//****************************
+
+CORE_EXPORT( int ) LZ4_loadDictHC (LZ4_streamHC_t* streamHCPtr, const char* dictionary, int dictSize);
+CORE_EXPORT( int ) LZ4_compress_HC_continue (LZ4_streamHC_t* streamHCPtr, const char* source, char* dest, int inputSize, int maxOutputSize);
+CORE_EXPORT( int ) LZ4_saveDictHC (LZ4_streamHC_t* streamHCPtr, char* safeBuffer, int dictSize);
+
+/*
+Same as the streaming functions of lz4.h, at the level given to LZ4_resetStreamHC(): blocks compressed by LZ4_compress_HC_continue()
+refer to the previous ones (up to 64KB back), which must stay in memory unless saved by LZ4_saveDictHC(), and are decoded by the
+LZ4_decompress_*_continue() or LZ4_decompress_*_usingDict() functions.
+A new stream is started with LZ4_resetStreamHC(), or with LZ4_loadDictHC() to start from a known dictionary.
+*/
+
+CORE_EXPORT( void ) LZ4_attachDictionaryHC (LZ4_streamHC_t* workingStream, const LZ4_streamHC_t* dictionaryStream);
+
+/*
+LZ4_attachDictionaryHC() :
+	Starts a stream from the dictionary loaded in 'dictionaryStream' by LZ4_loadDictHC(), at the level of 'workingStream'.
+	See LZ4_attachDictionary() in lz4.h.
 */
 
 
+//****************************
+// Previous Functions
+//****************************
+
+// Kept for the existing bindings, they compress at LZ4HC_DEFAULT_CLEVEL
+
+CORE_EXPORT( int ) LZ4_compressHC (const char* source, char* dest, int inputSize);
+CORE_EXPORT( int ) LZ4_compressHC_limitedOutput (const char* source, char* dest, int inputSize, int maxOutputSize);
+
+
 /* Note :
 Decompression functions are provided within regular LZ4 source code (see "lz4.h") (BSD license)
 */
@@ -0,0 +1,4 @@
+// This file imports lz4.c prefixing all functions with Core_
+
+#include "lz4_core.h"
+#include "lz4.c"
\ No newline at end of file
@@ -0,0 +1,11 @@
+// This file imports lz4.h prefixing all functions with Core_
+// The codec is compiled once for the target of the library: lz4.c picks the width of its copies and comparisons, and its
+// bit-scan instructions, from the architecture it is compiled for.
+
+#pragma once
+
+#define LZ4_FUNC(name) Core_ ## name
+#define LZ4_MK_OPT
+
+#include "lz4.h"
+#include "lz4hc.h"
\ No newline at end of file
@@ -1,4 +0,0 @@
-// This file imports lz4hc.c prefixing all functions with I32_
-
-#include "lz4_32.h"
-#include "lz4hc.c"
\ No newline at end of file
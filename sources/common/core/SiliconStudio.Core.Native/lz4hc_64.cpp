@@ -1,4 +0,0 @@
-// This file imports lz4hc.c prefixing all functions with I64_
-
-#include "lz4_64.h"
-#include "lz4hc.c"
\ No newline at end of file
@@ -0,0 +1,4 @@
+// This file imports lz4hc.c prefixing all functions with Core_
+
+#include "lz4_core.h"
+#include "lz4hc.c"
\ No newline at end of file
@@ -1,138 +1,984 @@
-/*
- NEON math library for the iPhone / iPod touch
- 
- Copyright (c) 2009 Justin Saunders
- 
- This software is provided 'as-is', without any express or implied warranty.
- In no event will the authors be held liable for any damages arising
- from the use of this software.
- Permission is granted to anyone to use this software for any purpose,
- including commercial applications, and to alter it and redistribute it freely,
- subject to the following restrictions:
- 
- 1. The origin of this software must not be misrepresented; you must
- not claim that you wrote the original software. If you use this
- software in a product, an acknowledgment in the product documentation
- would be appreciated but is not required.
- 
- 2. Altered source versions must be plainly marked as such, and must
- not be misrepresented as being the original software.
- 
- 3. This notice may not be removed or altered from any source distribution.
-*/
-
-#include "coreconfig.h"
-
-// possibly needed header for iOS
-//#ifdef __arm__
-//#include "arm/arch.h"
-//#endif
-
-#ifdef PLATFORM_ANDROID
-
-#ifdef __thumb__
-#error "This file should be compiled in ARM mode only."
-// Note in Xcode, right click file, Get Info->Build, Other compiler flags = "-marm"
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "matrix.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIX_SIMD_SSE 1
+#include <emmintrin.h>
+#endif
+
+// AVX kernels are compiled for the AVX target only, the rest of the library keeps the baseline instruction set
+#if MATRIX_SIMD_SSE
+#if defined(_MSC_VER)
+#define MATRIX_SIMD_AVX 1
+#define MATRIX_AVX_TARGET
+#include <intrin.h>
+#elif defined(__clang__) && defined(__has_attribute)
+#if __has_attribute(target)
+#define MATRIX_SIMD_AVX 1
+#define MATRIX_AVX_TARGET __attribute__((target("avx")))
+#endif
+#elif defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define MATRIX_SIMD_AVX 1
+#define MATRIX_AVX_TARGET __attribute__((target("avx")))
+#endif
+#if MATRIX_SIMD_AVX
+#include <immintrin.h>
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+#endif
 #endif
 
+// NEON is part of the ARM64 baseline, on ARMv7 it is enabled by the compiler flags (armeabi-v7a: -mfpu=neon)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM) || defined(_M_ARM64)
+#define MATRIX_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Same value as MathUtil.ZeroTolerance
+#define MATRIX_ZERO_TOLERANCE 1e-6f
+
 extern "C" {
 
-// Note asm is taken from reader "Jeff" post Wolfgang's blog:
-// https://www.blogger.com/comment.g?blogID=398682525365778708&postID=7527893703750196380&page=1
-CORE_EXPORT( void ) NEON_Matrix4Mul(const float* a, const float* b, float* output )
-{
-#ifdef _ARM_ARCH_7
-        __asm__ __volatile
-        (
-         // Store A & B leaving room at top of registers for result (q0-q3)
-         "vldmia %2, { q4-q7 }  \n\t"
-         "vldmia %1, { q8-q11 } \n\t"
-         
-         // result = first column of B x first row of A
-         "vmul.f32 q0, q8, d8[0]\n\t"
-         "vmul.f32 q1, q8, d10[0]\n\t"
-         "vmul.f32 q2, q8, d12[0]\n\t"
-         "vmul.f32 q3, q8, d14[0]\n\t"
-         
-         // result += second column of B x second row of A
-         "vmla.f32 q0, q9, d8[1]\n\t"
-         "vmla.f32 q1, q9, d10[1]\n\t"
-         "vmla.f32 q2, q9, d12[1]\n\t"
-         "vmla.f32 q3, q9, d14[1]\n\t"
-         
-         // result += third column of B x third row of A
-         "vmla.f32 q0, q10, d9[0]\n\t"
-         "vmla.f32 q1, q10, d11[0]\n\t"
-         "vmla.f32 q2, q10, d13[0]\n\t"
-         "vmla.f32 q3, q10, d15[0]\n\t"
-         
-         // result += last column of B x last row of A
-         "vmla.f32 q0, q11, d9[1]\n\t"
-         "vmla.f32 q1, q11, d11[1]\n\t"
-         "vmla.f32 q2, q11, d13[1]\n\t"
-         "vmla.f32 q3, q11, d15[1]\n\t"
-         
-         // output = result registers
-         "vstmia %0, { q0-q3 }"
-         : // no output
-         : "r" (output), "r" (a), "r" (b)       // input - note *value* of pointer doesn't change
-         : "memory", "q0", "q1", "q2", "q3", "q4", "q5", "q6", "q7", "q8", "q9", "q11" //clobber
-         );
+// Arrays are strided: the element 'index' starts 'index * stride' bytes after the first one
+static inline const float* ConstMatrixAt(const float* base, int stride, int index)
+{
+	return (const float*)((const char*)base + (ptrdiff_t)index * stride);
+}
+
+static inline float* MatrixAt(float* base, int stride, int index)
+{
+	return (float*)((char*)base + (ptrdiff_t)index * stride);
+}
+
+static inline const float* ConstVectorAt(const float* base, int stride, int index)
+{
+	return (const float*)((const char*)base + (ptrdiff_t)index * stride);
+}
+
+static inline float* VectorAt(float* base, int stride, int index)
+{
+	return (float*)((char*)base + (ptrdiff_t)index * stride);
+}
+
+// Array kernels of a kernel set, built on its Matrix4Multiply. Parents precede their children in the hierarchy,
+// so that the world matrix of a parent is always up to date when its children are concatenated.
+#define MATRIX_ARRAY_KERNELS(suffix, attributes) \
+static attributes void Matrix4MultiplyArray##suffix(const float* left, int leftStride, const float* right, int rightStride, float* result, int resultStride, int count) \
+{ \
+	for (int i = 0; i < count; i++) \
+		Matrix4Multiply##suffix(ConstMatrixAt(left, leftStride, i), ConstMatrixAt(right, rightStride, i), MatrixAt(result, resultStride, i)); \
+} \
+\
+static attributes void Matrix4ConcatenateHierarchy##suffix(const float* local, int localStride, const int* parentIndices, int parentIndexStride, float* world, int worldStride, int count) \
+{ \
+	for (int i = 0; i < count; i++) \
+	{ \
+		const float* localMatrix = ConstMatrixAt(local, localStride, i); \
+		float* worldMatrix = MatrixAt(world, worldStride, i); \
+		int parentIndex = *(const int*)((const char*)parentIndices + (ptrdiff_t)i * parentIndexStride); \
+		if (parentIndex >= 0) \
+			Matrix4Multiply##suffix(localMatrix, ConstMatrixAt(world, worldStride, parentIndex), worldMatrix); \
+		else if (worldMatrix != localMatrix) \
+			memcpy(worldMatrix, localMatrix, 16 * sizeof(float)); \
+	} \
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Scalar kernels, also the reference of the SIMD ones
+//----------------------------------------------------------------------------------------------------------------------------------
+
+static void Matrix4MultiplyScalar(const float* left, const float* right, float* result)
+{
+	float product[16];
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			product[r * 4 + c] = left[r * 4 + 0] * right[0 + c] + left[r * 4 + 1] * right[4 + c] + left[r * 4 + 2] * right[8 + c] + left[r * 4 + 3] * right[12 + c];
+		}
+	}
+
+	for (int i = 0; i < 16; i++)
+		result[i] = product[i];
+}
+
+static void Matrix4TransformVector4Scalar(const float* matrix, const float* vector, float* result)
+{
+	float x = vector[0], y = vector[1], z = vector[2], w = vector[3];
+	for (int c = 0; c < 4; c++)
+		result[c] = x * matrix[0 + c] + y * matrix[4 + c] + z * matrix[8 + c] + w * matrix[12 + c];
+}
+
+static void Matrix4TransposeScalar(const float* matrix, float* result)
+{
+	float transposed[16];
+	for (int r = 0; r < 4; r++)
+	{
+		for (int c = 0; c < 4; c++)
+			transposed[c * 4 + r] = matrix[r * 4 + c];
+	}
+
+	for (int i = 0; i < 16; i++)
+		result[i] = transposed[i];
+}
+
+// Same cofactors as Matrix.Invert
+static int Matrix4InvertScalar(const float* m, float* result)
+{
+	float b0 = (m[8] * m[13]) - (m[9] * m[12]);
+	float b1 = (m[8] * m[14]) - (m[10] * m[12]);
+	float b2 = (m[11] * m[12]) - (m[8] * m[15]);
+	float b3 = (m[9] * m[14]) - (m[10] * m[13]);
+	float b4 = (m[11] * m[13]) - (m[9] * m[15]);
+	float b5 = (m[10] * m[15]) - (m[11] * m[14]);
+
+	float d11 = m[5] * b5 + m[6] * b4 + m[7] * b3;
+	float d12 = m[4] * b5 + m[6] * b2 + m[7] * b1;
+	float d13 = m[4] * -b4 + m[5] * b2 + m[7] * b0;
+	float d14 = m[4] * b3 + m[5] * -b1 + m[6] * b0;
+
+	float det = m[0] * d11 - m[1] * d12 + m[2] * d13 - m[3] * d14;
+	if (det == 0.0f)
+	{
+		for (int i = 0; i < 16; i++)
+			result[i] = 0.0f;
+		return 0;
+	}
+
+	det = 1.0f / det;
+
+	float a0 = (m[0] * m[5]) - (m[1] * m[4]);
+	float a1 = (m[0] * m[6]) - (m[2] * m[4]);
+	float a2 = (m[3] * m[4]) - (m[0] * m[7]);
+	float a3 = (m[1] * m[6]) - (m[2] * m[5]);
+	float a4 = (m[3] * m[5]) - (m[1] * m[7]);
+	float a5 = (m[2] * m[7]) - (m[3] * m[6]);
+
+	float d21 = m[1] * b5 + m[2] * b4 + m[3] * b3;
+	float d22 = m[0] * b5 + m[2] * b2 + m[3] * b1;
+	float d23 = m[0] * -b4 + m[1] * b2 + m[3] * b0;
+	float d24 = m[0] * b3 + m[1] * -b1 + m[2] * b0;
+
+	float d31 = m[13] * a5 + m[14] * a4 + m[15] * a3;
+	float d32 = m[12] * a5 + m[14] * a2 + m[15] * a1;
+	float d33 = m[12] * -a4 + m[13] * a2 + m[15] * a0;
+	float d34 = m[12] * a3 + m[13] * -a1 + m[14] * a0;
+
+	float d41 = m[9] * a5 + m[10] * a4 + m[11] * a3;
+	float d42 = m[8] * a5 + m[10] * a2 + m[11] * a1;
+	float d43 = m[8] * -a4 + m[9] * a2 + m[11] * a0;
+	float d44 = m[8] * a3 + m[9] * -a1 + m[10] * a0;
+
+	result[0] = +d11 * det; result[1] = -d21 * det; result[2] = +d31 * det; result[3] = -d41 * det;
+	result[4] = -d12 * det; result[5] = +d22 * det; result[6] = -d32 * det; result[7] = +d42 * det;
+	result[8] = +d13 * det; result[9] = -d23 * det; result[10] = +d33 * det; result[11] = -d43 * det;
+	result[12] = -d14 * det; result[13] = +d24 * det; result[14] = -d34 * det; result[15] = +d44 * det;
+	return 1;
+}
+
+static inline void Cross(const float* left, const float* right, float* result)
+{
+	float x = left[1] * right[2] - left[2] * right[1];
+	float y = left[2] * right[0] - left[0] * right[2];
+	float z = left[0] * right[1] - left[1] * right[0];
+	result[0] = x;
+	result[1] = y;
+	result[2] = z;
+}
+
+static inline float Dot(const float* left, const float* right)
+{
+	return left[0] * right[0] + left[1] * right[1] + left[2] * right[2];
+}
+
+static inline void SetIdentityQuaternion(float* rotation)
+{
+	rotation[0] = rotation[1] = rotation[2] = 0.0f;
+	rotation[3] = 1.0f;
+}
+
+// Quaternion.RotationMatrix of the matrix of rows 'right', 'up' and 'at'
+static void QuaternionFromRotationRows(const float* right, const float* up, const float* at, float* rotation)
+{
+	float trace = right[0] + up[1] + at[2];
+	if (trace > 0.0f)
+	{
+		float root = sqrtf(trace + 1.0f);
+		rotation[3] = root * 0.5f;
+		root = 0.5f / root;
+		rotation[0] = (up[2] - at[1]) * root;
+		rotation[1] = (at[0] - right[2]) * root;
+		rotation[2] = (right[1] - up[0]) * root;
+	}
+	else if (right[0] >= up[1] && right[0] >= at[2])
+	{
+		float root = sqrtf(1.0f + right[0] - up[1] - at[2]);
+		float half = 0.5f / root;
+		rotation[0] = 0.5f * root;
+		rotation[1] = (right[1] + up[0]) * half;
+		rotation[2] = (right[2] + at[0]) * half;
+		rotation[3] = (up[2] - at[1]) * half;
+	}
+	else if (up[1] > at[2])
+	{
+		float root = sqrtf(1.0f + up[1] - right[0] - at[2]);
+		float half = 0.5f / root;
+		rotation[0] = (up[0] + right[1]) * half;
+		rotation[1] = 0.5f * root;
+		rotation[2] = (at[1] + up[2]) * half;
+		rotation[3] = (at[0] - right[2]) * half;
+	}
+	else
+	{
+		float root = sqrtf(1.0f + at[2] - right[0] - up[1]);
+		float half = 0.5f / root;
+		rotation[0] = (at[0] + right[2]) * half;
+		rotation[1] = (at[1] + up[2]) * half;
+		rotation[2] = 0.5f * root;
+		rotation[3] = (right[1] - up[0]) * half;
+	}
+}
+
+// Same steps as Matrix.Decompose: orthonormal rotation rebuilt from the scaled rows, reflections moved to the scale
+static int Matrix4DecomposeScalar(const float* m, float* scale, float* rotation, float* translation)
+{
+	float scaleX = sqrtf(Dot(m + 0, m + 0));
+	float scaleY = sqrtf(Dot(m + 4, m + 4));
+	float scaleZ = sqrtf(Dot(m + 8, m + 8));
+	float translationX = m[12], translationY = m[13], translationZ = m[14];
+
+	if (fabsf(scaleX) < MATRIX_ZERO_TOLERANCE || fabsf(scaleY) < MATRIX_ZERO_TOLERANCE || fabsf(scaleZ) < MATRIX_ZERO_TOLERANCE)
+	{
+		SetIdentityQuaternion(rotation);
+		scale[0] = scaleX; scale[1] = scaleY; scale[2] = scaleZ;
+		translation[0] = translationX; translation[1] = translationY; translation[2] = translationZ;
+		return 0;
+	}
+
+	float at[3] = { m[8] / scaleZ, m[9] / scaleZ, m[10] / scaleZ };
+	float rightScaled[3] = { m[0] / scaleX, m[1] / scaleX, m[2] / scaleX };
+	float up[3], right[3];
+	Cross(at, rightScaled, up);
+	Cross(up, at, right);
+
+	// In case of reflections
+	scaleX = Dot(right, m + 0) > 0.0f ? scaleX : -scaleX;
+	scaleY = Dot(up, m + 4) > 0.0f ? scaleY : -scaleY;
+	scaleZ = Dot(at, m + 8) > 0.0f ? scaleZ : -scaleZ;
+
+	QuaternionFromRotationRows(right, up, at, rotation);
+	scale[0] = scaleX; scale[1] = scaleY; scale[2] = scaleZ;
+	translation[0] = translationX; translation[1] = translationY; translation[2] = translationZ;
+	return 1;
+}
+
+MATRIX_ARRAY_KERNELS(Scalar, )
+
+static void Matrix4MultiplyArrayByMatrixScalar(const float* left, int leftStride, const float* right, float* result, int resultStride, int count)
+{
+	// the results can overwrite 'right'
+	float rightCopy[16];
+	memcpy(rightCopy, right, sizeof(rightCopy));
+
+	for (int i = 0; i < count; i++)
+		Matrix4MultiplyScalar(ConstMatrixAt(left, leftStride, i), rightCopy, MatrixAt(result, resultStride, i));
+}
+
+// Same formulas as Vector3.TransformCoordinate, Vector3.TransformNormal and Vector4.Transform, element by element.
+// Every element is read before its result is written, so that streams can be transformed in place.
+static void Vector3TransformCoordinateArrayScalar(const float* m, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const float* vector = ConstVectorAt(vectors, vectorStride, i);
+		float* resultVector = VectorAt(result, resultStride, i);
+		float x = vector[0], y = vector[1], z = vector[2];
+		float inverseW = 1.0f / (x * m[3] + y * m[7] + z * m[11] + m[15]);
+		resultVector[0] = (x * m[0] + y * m[4] + z * m[8] + m[12]) * inverseW;
+		resultVector[1] = (x * m[1] + y * m[5] + z * m[9] + m[13]) * inverseW;
+		resultVector[2] = (x * m[2] + y * m[6] + z * m[10] + m[14]) * inverseW;
+	}
+}
+
+static void Vector3TransformNormalArrayScalar(const float* m, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		const float* vector = ConstVectorAt(vectors, vectorStride, i);
+		float* resultVector = VectorAt(result, resultStride, i);
+		float x = vector[0], y = vector[1], z = vector[2];
+		resultVector[0] = x * m[0] + y * m[4] + z * m[8];
+		resultVector[1] = x * m[1] + y * m[5] + z * m[9];
+		resultVector[2] = x * m[2] + y * m[6] + z * m[10];
+	}
+}
+
+static void Vector4TransformArrayScalar(const float* m, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	for (int i = 0; i < count; i++)
+		Matrix4TransformVector4Scalar(m, ConstVectorAt(vectors, vectorStride, i), VectorAt(result, resultStride, i));
+}
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// SSE kernels
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#if MATRIX_SIMD_SSE
+
+#define MATRIX_SHUFFLE(left, right, x, y, z, w) _mm_shuffle_ps(left, right, _MM_SHUFFLE(w, z, y, x))
+#define MATRIX_SWIZZLE(value, x, y, z, w) MATRIX_SHUFFLE(value, value, x, y, z, w)
+
+static inline __m128 TransformRowSse(__m128 row, __m128 right0, __m128 right1, __m128 right2, __m128 right3)
+{
+	__m128 result = _mm_mul_ps(MATRIX_SWIZZLE(row, 0, 0, 0, 0), right0);
+	result = _mm_add_ps(result, _mm_mul_ps(MATRIX_SWIZZLE(row, 1, 1, 1, 1), right1));
+	result = _mm_add_ps(result, _mm_mul_ps(MATRIX_SWIZZLE(row, 2, 2, 2, 2), right2));
+	return _mm_add_ps(result, _mm_mul_ps(MATRIX_SWIZZLE(row, 3, 3, 3, 3), right3));
+}
+
+// 'right' is loaded first and each row of 'left' is read before its result is written, so the result can alias both inputs
+static void Matrix4MultiplySse(const float* left, const float* right, float* result)
+{
+	__m128 right0 = _mm_loadu_ps(right + 0);
+	__m128 right1 = _mm_loadu_ps(right + 4);
+	__m128 right2 = _mm_loadu_ps(right + 8);
+	__m128 right3 = _mm_loadu_ps(right + 12);
+
+	for (int r = 0; r < 16; r += 4)
+		_mm_storeu_ps(result + r, TransformRowSse(_mm_loadu_ps(left + r), right0, right1, right2, right3));
+}
+
+MATRIX_ARRAY_KERNELS(Sse, )
+
+static void Matrix4MultiplyArrayByMatrixSse(const float* left, int leftStride, const float* right, float* result, int resultStride, int count)
+{
+	__m128 right0 = _mm_loadu_ps(right + 0);
+	__m128 right1 = _mm_loadu_ps(right + 4);
+	__m128 right2 = _mm_loadu_ps(right + 8);
+	__m128 right3 = _mm_loadu_ps(right + 12);
+
+	for (int i = 0; i < count; i++)
+	{
+		const float* leftMatrix = ConstMatrixAt(left, leftStride, i);
+		float* resultMatrix = MatrixAt(result, resultStride, i);
+		for (int r = 0; r < 16; r += 4)
+			_mm_storeu_ps(resultMatrix + r, TransformRowSse(_mm_loadu_ps(leftMatrix + r), right0, right1, right2, right3));
+	}
+}
+
+static void Matrix4TransformVector4Sse(const float* matrix, const float* vector, float* result)
+{
+	_mm_storeu_ps(result, TransformRowSse(_mm_loadu_ps(vector), _mm_loadu_ps(matrix + 0), _mm_loadu_ps(matrix + 4), _mm_loadu_ps(matrix + 8), _mm_loadu_ps(matrix + 12)));
+}
+
+// float3 elements are read and written with scalar accesses, so that the last element of a stream can end a buffer
+static inline void StoreVector3Sse(float* destination, __m128 value)
+{
+	_mm_storel_pi((__m64*)destination, value);
+	_mm_store_ss(destination + 2, _mm_movehl_ps(value, value));
+}
+
+// Stream kernels, also compiled for AVX where the broadcasts of the elements become single loads.
+// Coordinates go by four, so that a single division gives their four 1/w.
+#define MATRIX_STREAM_KERNELS(suffix, attributes) \
+static attributes inline __m128 TransformCoordinate##suffix(const float* vector, __m128 row0, __m128 row1, __m128 row2, __m128 row3) \
+{ \
+	__m128 transformed = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(vector[0]), row0), _mm_mul_ps(_mm_set1_ps(vector[1]), row1)); \
+	transformed = _mm_add_ps(transformed, _mm_mul_ps(_mm_set1_ps(vector[2]), row2)); \
+	return _mm_add_ps(transformed, row3); \
+} \
+\
+static attributes void Vector3TransformCoordinateArray##suffix(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count) \
+{ \
+	__m128 row0 = _mm_loadu_ps(matrix + 0); \
+	__m128 row1 = _mm_loadu_ps(matrix + 4); \
+	__m128 row2 = _mm_loadu_ps(matrix + 8); \
+	__m128 row3 = _mm_loadu_ps(matrix + 12); \
+	__m128 one = _mm_set1_ps(1.0f); \
+	\
+	int i = 0; \
+	for (; i + 4 <= count; i += 4) \
+	{ \
+		__m128 transformed0 = TransformCoordinate##suffix(ConstVectorAt(vectors, vectorStride, i + 0), row0, row1, row2, row3); \
+		__m128 transformed1 = TransformCoordinate##suffix(ConstVectorAt(vectors, vectorStride, i + 1), row0, row1, row2, row3); \
+		__m128 transformed2 = TransformCoordinate##suffix(ConstVectorAt(vectors, vectorStride, i + 2), row0, row1, row2, row3); \
+		__m128 transformed3 = TransformCoordinate##suffix(ConstVectorAt(vectors, vectorStride, i + 3), row0, row1, row2, row3); \
+		__m128 w = _mm_movehl_ps(_mm_unpackhi_ps(transformed2, transformed3), _mm_unpackhi_ps(transformed0, transformed1)); \
+		__m128 inverseW = _mm_div_ps(one, w); \
+		StoreVector3Sse(VectorAt(result, resultStride, i + 0), _mm_mul_ps(transformed0, MATRIX_SWIZZLE(inverseW, 0, 0, 0, 0))); \
+		StoreVector3Sse(VectorAt(result, resultStride, i + 1), _mm_mul_ps(transformed1, MATRIX_SWIZZLE(inverseW, 1, 1, 1, 1))); \
+		StoreVector3Sse(VectorAt(result, resultStride, i + 2), _mm_mul_ps(transformed2, MATRIX_SWIZZLE(inverseW, 2, 2, 2, 2))); \
+		StoreVector3Sse(VectorAt(result, resultStride, i + 3), _mm_mul_ps(transformed3, MATRIX_SWIZZLE(inverseW, 3, 3, 3, 3))); \
+	} \
+	\
+	for (; i < count; i++) \
+	{ \
+		__m128 transformed = TransformCoordinate##suffix(ConstVectorAt(vectors, vectorStride, i), row0, row1, row2, row3); \
+		__m128 inverseW = _mm_div_ps(one, MATRIX_SWIZZLE(transformed, 3, 3, 3, 3)); \
+		StoreVector3Sse(VectorAt(result, resultStride, i), _mm_mul_ps(transformed, inverseW)); \
+	} \
+} \
+\
+static attributes void Vector3TransformNormalArray##suffix(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count) \
+{ \
+	__m128 row0 = _mm_loadu_ps(matrix + 0); \
+	__m128 row1 = _mm_loadu_ps(matrix + 4); \
+	__m128 row2 = _mm_loadu_ps(matrix + 8); \
+	\
+	for (int i = 0; i < count; i++) \
+	{ \
+		const float* vector = ConstVectorAt(vectors, vectorStride, i); \
+		__m128 transformed = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(vector[0]), row0), _mm_mul_ps(_mm_set1_ps(vector[1]), row1)); \
+		transformed = _mm_add_ps(transformed, _mm_mul_ps(_mm_set1_ps(vector[2]), row2)); \
+		StoreVector3Sse(VectorAt(result, resultStride, i), transformed); \
+	} \
+} \
+\
+static attributes void Vector4TransformArray##suffix(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count) \
+{ \
+	__m128 row0 = _mm_loadu_ps(matrix + 0); \
+	__m128 row1 = _mm_loadu_ps(matrix + 4); \
+	__m128 row2 = _mm_loadu_ps(matrix + 8); \
+	__m128 row3 = _mm_loadu_ps(matrix + 12); \
+	\
+	for (int i = 0; i < count; i++) \
+		_mm_storeu_ps(VectorAt(result, resultStride, i), TransformRowSse(_mm_loadu_ps(ConstVectorAt(vectors, vectorStride, i)), row0, row1, row2, row3)); \
+}
+
+MATRIX_STREAM_KERNELS(Sse, )
+
+static void Matrix4TransposeSse(const float* matrix, float* result)
+{
+	__m128 row0 = _mm_loadu_ps(matrix + 0);
+	__m128 row1 = _mm_loadu_ps(matrix + 4);
+	__m128 row2 = _mm_loadu_ps(matrix + 8);
+	__m128 row3 = _mm_loadu_ps(matrix + 12);
+	_MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+	_mm_storeu_ps(result + 0, row0);
+	_mm_storeu_ps(result + 4, row1);
+	_mm_storeu_ps(result + 8, row2);
+	_mm_storeu_ps(result + 12, row3);
+}
+
+// 2x2 matrices packed as (m11, m12, m21, m22): left * right
+static inline __m128 Matrix2MultiplySse(__m128 left, __m128 right)
+{
+	return _mm_add_ps(_mm_mul_ps(left, MATRIX_SWIZZLE(right, 0, 3, 0, 3)), _mm_mul_ps(MATRIX_SWIZZLE(left, 1, 0, 3, 2), MATRIX_SWIZZLE(right, 2, 1, 2, 1)));
+}
+
+// adjugate(left) * right
+static inline __m128 Matrix2AdjugateMultiplySse(__m128 left, __m128 right)
+{
+	return _mm_sub_ps(_mm_mul_ps(MATRIX_SWIZZLE(left, 3, 3, 0, 0), right), _mm_mul_ps(MATRIX_SWIZZLE(left, 1, 1, 2, 2), MATRIX_SWIZZLE(right, 2, 3, 0, 1)));
+}
+
+// left * adjugate(right)
+static inline __m128 Matrix2MultiplyAdjugateSse(__m128 left, __m128 right)
+{
+	return _mm_sub_ps(_mm_mul_ps(left, MATRIX_SWIZZLE(right, 3, 0, 3, 0)), _mm_mul_ps(MATRIX_SWIZZLE(left, 1, 0, 3, 2), MATRIX_SWIZZLE(right, 2, 1, 2, 1)));
+}
+
+// Inverse by 2x2 blocks: with M = | A B |, the inverse is 1/|M| | X Y | where X# = |D|A - B(D#C), Y# = |B|C - D(A#B)#,
+//                                 | C D |                      | Z W |       Z# = |C|B - A(D#C)#, W# = |A|D - C(A#B)
+// and |M| = |A||D| + |B||C| - tr((A#B)(D#C)), M# being the adjugate of M.
+static int Matrix4InvertSse(const float* matrix, float* result)
+{
+	__m128 row0 = _mm_loadu_ps(matrix + 0);
+	__m128 row1 = _mm_loadu_ps(matrix + 4);
+	__m128 row2 = _mm_loadu_ps(matrix + 8);
+	__m128 row3 = _mm_loadu_ps(matrix + 12);
+
+	__m128 a = _mm_movelh_ps(row0, row1);
+	__m128 b = _mm_movehl_ps(row1, row0);
+	__m128 c = _mm_movelh_ps(row2, row3);
+	__m128 d = _mm_movehl_ps(row3, row2);
+
+	// (|A|, |B|, |C|, |D|)
+	__m128 subDeterminants = _mm_sub_ps(
+		_mm_mul_ps(MATRIX_SHUFFLE(row0, row2, 0, 2, 0, 2), MATRIX_SHUFFLE(row1, row3, 1, 3, 1, 3)),
+		_mm_mul_ps(MATRIX_SHUFFLE(row0, row2, 1, 3, 1, 3), MATRIX_SHUFFLE(row1, row3, 0, 2, 0, 2)));
+	__m128 determinantA = MATRIX_SWIZZLE(subDeterminants, 0, 0, 0, 0);
+	__m128 determinantB = MATRIX_SWIZZLE(subDeterminants, 1, 1, 1, 1);
+	__m128 determinantC = MATRIX_SWIZZLE(subDeterminants, 2, 2, 2, 2);
+	__m128 determinantD = MATRIX_SWIZZLE(subDeterminants, 3, 3, 3, 3);
+
+	__m128 adjugateDC = Matrix2AdjugateMultiplySse(d, c);
+	__m128 adjugateAB = Matrix2AdjugateMultiplySse(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(determinantD, a), Matrix2MultiplySse(b, adjugateDC));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(determinantA, d), Matrix2MultiplySse(c, adjugateAB));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(determinantB, c), Matrix2MultiplyAdjugateSse(d, adjugateAB));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(determinantC, b), Matrix2MultiplyAdjugateSse(a, adjugateDC));
+
+	__m128 trace = _mm_mul_ps(adjugateAB, MATRIX_SWIZZLE(adjugateDC, 0, 2, 1, 3));
+	trace = _mm_add_ps(trace, MATRIX_SWIZZLE(trace, 2, 3, 0, 1));
+	trace = _mm_add_ps(trace, MATRIX_SWIZZLE(trace, 1, 0, 3, 2));
+	__m128 determinant = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(determinantA, determinantD), _mm_mul_ps(determinantB, determinantC)), trace);
+
+	if (_mm_cvtss_f32(determinant) == 0.0f)
+	{
+		__m128 zero = _mm_setzero_ps();
+		_mm_storeu_ps(result + 0, zero);
+		_mm_storeu_ps(result + 4, zero);
+		_mm_storeu_ps(result + 8, zero);
+		_mm_storeu_ps(result + 12, zero);
+		return 0;
+	}
+
+	// the signs of the adjugate are applied with the reciprocal of the determinant
+	__m128 inverseDeterminant = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), determinant);
+	x = _mm_mul_ps(x, inverseDeterminant);
+	y = _mm_mul_ps(y, inverseDeterminant);
+	z = _mm_mul_ps(z, inverseDeterminant);
+	w = _mm_mul_ps(w, inverseDeterminant);
+
+	// adjugate and block layout in the same shuffles
+	_mm_storeu_ps(result + 0, MATRIX_SHUFFLE(x, y, 3, 1, 3, 1));
+	_mm_storeu_ps(result + 4, MATRIX_SHUFFLE(x, y, 2, 0, 2, 0));
+	_mm_storeu_ps(result + 8, MATRIX_SHUFFLE(z, w, 3, 1, 3, 1));
+	_mm_storeu_ps(result + 12, MATRIX_SHUFFLE(z, w, 2, 0, 2, 0));
+	return 1;
+}
+
+static inline __m128 CrossSse(__m128 left, __m128 right)
+{
+	return _mm_sub_ps(
+		_mm_mul_ps(MATRIX_SWIZZLE(left, 1, 2, 0, 3), MATRIX_SWIZZLE(right, 2, 0, 1, 3)),
+		_mm_mul_ps(MATRIX_SWIZZLE(left, 2, 0, 1, 3), MATRIX_SWIZZLE(right, 1, 2, 0, 3)));
+}
+
+static int Matrix4DecomposeSse(const float* matrix, float* scale, float* rotation, float* translation)
+{
+	__m128 row0 = _mm_loadu_ps(matrix + 0);
+	__m128 row1 = _mm_loadu_ps(matrix + 4);
+	__m128 row2 = _mm_loadu_ps(matrix + 8);
+	__m128 row3 = _mm_loadu_ps(matrix + 12);
+
+	// the w column is cleared, so that the squared lengths of the rows are the sums of the transposed squares
+	__m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	row0 = _mm_and_ps(row0, xyzMask);
+	row1 = _mm_and_ps(row1, xyzMask);
+	row2 = _mm_and_ps(row2, xyzMask);
+	__m128 square0 = _mm_mul_ps(row0, row0);
+	__m128 square1 = _mm_mul_ps(row1, row1);
+	__m128 square2 = _mm_mul_ps(row2, row2);
+	__m128 square3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(square0, square1, square2, square3);
+	__m128 scales = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(square0, square1), square2));
+
+	float scaleValues[4], translationValues[4];
+	_mm_storeu_ps(scaleValues, scales);
+	_mm_storeu_ps(translationValues, row3);
+	translation[0] = translationValues[0];
+	translation[1] = translationValues[1];
+	translation[2] = translationValues[2];
+
+	if (scaleValues[0] < MATRIX_ZERO_TOLERANCE || scaleValues[1] < MATRIX_ZERO_TOLERANCE || scaleValues[2] < MATRIX_ZERO_TOLERANCE)
+	{
+		SetIdentityQuaternion(rotation);
+		scale[0] = scaleValues[0]; scale[1] = scaleValues[1]; scale[2] = scaleValues[2];
+		return 0;
+	}
+
+	__m128 at = _mm_div_ps(row2, MATRIX_SWIZZLE(scales, 2, 2, 2, 2));
+	__m128 up = CrossSse(at, _mm_div_ps(row0, MATRIX_SWIZZLE(scales, 0, 0, 0, 0)));
+	__m128 right = CrossSse(up, at);
+
+	// In case of reflections: dot products of the rebuilt rows with the original ones, transposed like the scales
+	__m128 dot0 = _mm_mul_ps(right, row0);
+	__m128 dot1 = _mm_mul_ps(up, row1);
+	__m128 dot2 = _mm_mul_ps(at, row2);
+	__m128 dot3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(dot0, dot1, dot2, dot3);
+	__m128 reflected = _mm_cmpngt_ps(_mm_add_ps(_mm_add_ps(dot0, dot1), dot2), _mm_setzero_ps());
+	scales = _mm_xor_ps(scales, _mm_and_ps(reflected, _mm_set1_ps(-0.0f)));
+	_mm_storeu_ps(scaleValues, scales);
+	scale[0] = scaleValues[0]; scale[1] = scaleValues[1]; scale[2] = scaleValues[2];
+
+	float rows[12];
+	_mm_storeu_ps(rows + 0, right);
+	_mm_storeu_ps(rows + 4, up);
+	_mm_storeu_ps(rows + 8, at);
+	QuaternionFromRotationRows(rows + 0, rows + 4, rows + 8, rotation);
+	return 1;
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// AVX kernels: two rows of the product at a time
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#if MATRIX_SIMD_AVX
+
+// two rows of 'left' times 'right', whose rows are in both halves
+static MATRIX_AVX_TARGET inline __m256 TransformRowPairAvx(__m256 rows, __m256 right0, __m256 right1, __m256 right2, __m256 right3)
+{
+	__m256 result = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), right0);
+	result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x55), right1));
+	result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xAA), right2));
+	return _mm256_add_ps(result, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xFF), right3));
+}
+
+static MATRIX_AVX_TARGET void Matrix4MultiplyAvx(const float* left, const float* right, float* result)
+{
+	__m256 right0 = _mm256_broadcast_ps((const __m128*)(right + 0));
+	__m256 right1 = _mm256_broadcast_ps((const __m128*)(right + 4));
+	__m256 right2 = _mm256_broadcast_ps((const __m128*)(right + 8));
+	__m256 right3 = _mm256_broadcast_ps((const __m128*)(right + 12));
+	__m256 left01 = _mm256_loadu_ps(left + 0);
+	__m256 left23 = _mm256_loadu_ps(left + 8);
+
+	_mm256_storeu_ps(result + 0, TransformRowPairAvx(left01, right0, right1, right2, right3));
+	_mm256_storeu_ps(result + 8, TransformRowPairAvx(left23, right0, right1, right2, right3));
+	_mm256_zeroupper();
+}
+
+MATRIX_ARRAY_KERNELS(Avx, MATRIX_AVX_TARGET)
+MATRIX_STREAM_KERNELS(Avx, MATRIX_AVX_TARGET)
+
+static MATRIX_AVX_TARGET void Matrix4MultiplyArrayByMatrixAvx(const float* left, int leftStride, const float* right, float* result, int resultStride, int count)
+{
+	__m256 right0 = _mm256_broadcast_ps((const __m128*)(right + 0));
+	__m256 right1 = _mm256_broadcast_ps((const __m128*)(right + 4));
+	__m256 right2 = _mm256_broadcast_ps((const __m128*)(right + 8));
+	__m256 right3 = _mm256_broadcast_ps((const __m128*)(right + 12));
+
+	for (int i = 0; i < count; i++)
+	{
+		const float* leftMatrix = ConstMatrixAt(left, leftStride, i);
+		float* resultMatrix = MatrixAt(result, resultStride, i);
+		__m256 left01 = _mm256_loadu_ps(leftMatrix + 0);
+		__m256 left23 = _mm256_loadu_ps(leftMatrix + 8);
+		_mm256_storeu_ps(resultMatrix + 0, TransformRowPairAvx(left01, right0, right1, right2, right3));
+		_mm256_storeu_ps(resultMatrix + 8, TransformRowPairAvx(left23, right0, right1, right2, right3));
+	}
+	_mm256_zeroupper();
+}
+
+// AVX needs both the CPU flag and the OS saving the YMM registers (OSXSAVE + XCR0)
+static int CpuSupportsAvx()
+{
+#if defined(_MSC_VER)
+	int registers[4];
+	__cpuid(registers, 1);
+	unsigned int ecx = (unsigned int)registers[2];
 #else
-         output[ 0] = a[0] * b[ 0] + a[4] * b[ 1] + a[ 8] * b[ 2] + a[12] * b[ 3];
-         output[ 1] = a[1] * b[ 0] + a[5] * b[ 1] + a[ 9] * b[ 2] + a[13] * b[ 3];
-         output[ 2] = a[2] * b[ 0] + a[6] * b[ 1] + a[10] * b[ 2] + a[14] * b[ 3];
-         output[ 3] = a[3] * b[ 0] + a[7] * b[ 1] + a[11] * b[ 2] + a[15] * b[ 3];
-         output[ 4] = a[0] * b[ 4] + a[4] * b[ 5] + a[ 8] * b[ 6] + a[12] * b[ 7];
-         output[ 5] = a[1] * b[ 4] + a[5] * b[ 5] + a[ 9] * b[ 6] + a[13] * b[ 7];
-         output[ 6] = a[2] * b[ 4] + a[6] * b[ 5] + a[10] * b[ 6] + a[14] * b[ 7];
-         output[ 7] = a[3] * b[ 4] + a[7] * b[ 5] + a[11] * b[ 6] + a[15] * b[ 7];
-         output[ 8] = a[0] * b[ 8] + a[4] * b[ 9] + a[ 8] * b[10] + a[12] * b[11];
-         output[ 9] = a[1] * b[ 8] + a[5] * b[ 9] + a[ 9] * b[10] + a[13] * b[11];
-         output[10] = a[2] * b[ 8] + a[6] * b[ 9] + a[10] * b[10] + a[14] * b[11];
-         output[11] = a[3] * b[ 8] + a[7] * b[ 9] + a[11] * b[10] + a[15] * b[11];
-         output[12] = a[0] * b[12] + a[4] * b[13] + a[ 8] * b[14] + a[12] * b[15];
-         output[13] = a[1] * b[12] + a[5] * b[13] + a[ 9] * b[14] + a[13] * b[15];
-         output[14] = a[2] * b[12] + a[6] * b[13] + a[10] * b[14] + a[14] * b[15];
-         output[15] = a[3] * b[12] + a[7] * b[13] + a[11] * b[14] + a[15] * b[15];
-#endif
-}
-         
-CORE_EXPORT( void ) NEON_Matrix4Vector4Mul(const float* m, const float* v, float* output)
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return 0;
+#endif
+	if ((ecx & (1u << 27)) == 0 || (ecx & (1u << 28)) == 0)
+		return 0;
+
+#if defined(_MSC_VER)
+	unsigned long long xcr0 = _xgetbv(0);
+	return (xcr0 & 6) == 6;
+#else
+	unsigned int xcr0Low, xcr0High;
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0)); // xgetbv
+	return (xcr0Low & 6) == 6;
+#endif
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// NEON kernels. Inverse and decompose keep the scalar kernels: without the SSE shuffles the 2x2 block inverse
+// needs more lane moves than it saves, and decompose is dominated by the branches of the quaternion conversion.
+//----------------------------------------------------------------------------------------------------------------------------------
+
+#if MATRIX_SIMD_NEON
+
+static inline float32x4_t TransformRowNeon(float32x4_t row, float32x4_t right0, float32x4_t right1, float32x4_t right2, float32x4_t right3)
+{
+	float32x2_t low = vget_low_f32(row);
+	float32x2_t high = vget_high_f32(row);
+	float32x4_t result = vmulq_lane_f32(right0, low, 0);
+	result = vmlaq_lane_f32(result, right1, low, 1);
+	result = vmlaq_lane_f32(result, right2, high, 0);
+	return vmlaq_lane_f32(result, right3, high, 1);
+}
+
+static void Matrix4MultiplyNeon(const float* left, const float* right, float* result)
+{
+	float32x4_t right0 = vld1q_f32(right + 0);
+	float32x4_t right1 = vld1q_f32(right + 4);
+	float32x4_t right2 = vld1q_f32(right + 8);
+	float32x4_t right3 = vld1q_f32(right + 12);
+
+	for (int r = 0; r < 16; r += 4)
+		vst1q_f32(result + r, TransformRowNeon(vld1q_f32(left + r), right0, right1, right2, right3));
+}
+
+MATRIX_ARRAY_KERNELS(Neon, )
+
+static void Matrix4MultiplyArrayByMatrixNeon(const float* left, int leftStride, const float* right, float* result, int resultStride, int count)
+{
+	float32x4_t right0 = vld1q_f32(right + 0);
+	float32x4_t right1 = vld1q_f32(right + 4);
+	float32x4_t right2 = vld1q_f32(right + 8);
+	float32x4_t right3 = vld1q_f32(right + 12);
+
+	for (int i = 0; i < count; i++)
+	{
+		const float* leftMatrix = ConstMatrixAt(left, leftStride, i);
+		float* resultMatrix = MatrixAt(result, resultStride, i);
+		for (int r = 0; r < 16; r += 4)
+			vst1q_f32(resultMatrix + r, TransformRowNeon(vld1q_f32(leftMatrix + r), right0, right1, right2, right3));
+	}
+}
+
+static void Matrix4TransformVector4Neon(const float* matrix, const float* vector, float* result)
+{
+	vst1q_f32(result, TransformRowNeon(vld1q_f32(vector), vld1q_f32(matrix + 0), vld1q_f32(matrix + 4), vld1q_f32(matrix + 8), vld1q_f32(matrix + 12)));
+}
+
+static void Vector3TransformCoordinateArrayNeon(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	float32x4_t row0 = vld1q_f32(matrix + 0);
+	float32x4_t row1 = vld1q_f32(matrix + 4);
+	float32x4_t row2 = vld1q_f32(matrix + 8);
+	float32x4_t row3 = vld1q_f32(matrix + 12);
+
+	for (int i = 0; i < count; i++)
+	{
+		const float* vector = ConstVectorAt(vectors, vectorStride, i);
+		float* resultVector = VectorAt(result, resultStride, i);
+		float32x4_t transformed = vaddq_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(row0, vector[0]), row1, vector[1]), row2, vector[2]), row3);
+		float inverseW = 1.0f / vgetq_lane_f32(transformed, 3);
+		float32x4_t scaled = vmulq_n_f32(transformed, inverseW);
+		vst1_f32(resultVector, vget_low_f32(scaled));
+		resultVector[2] = vgetq_lane_f32(scaled, 2);
+	}
+}
+
+static void Vector3TransformNormalArrayNeon(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	float32x4_t row0 = vld1q_f32(matrix + 0);
+	float32x4_t row1 = vld1q_f32(matrix + 4);
+	float32x4_t row2 = vld1q_f32(matrix + 8);
+
+	for (int i = 0; i < count; i++)
+	{
+		const float* vector = ConstVectorAt(vectors, vectorStride, i);
+		float* resultVector = VectorAt(result, resultStride, i);
+		float32x4_t transformed = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(row0, vector[0]), row1, vector[1]), row2, vector[2]);
+		vst1_f32(resultVector, vget_low_f32(transformed));
+		resultVector[2] = vgetq_lane_f32(transformed, 2);
+	}
+}
+
+static void Vector4TransformArrayNeon(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	float32x4_t row0 = vld1q_f32(matrix + 0);
+	float32x4_t row1 = vld1q_f32(matrix + 4);
+	float32x4_t row2 = vld1q_f32(matrix + 8);
+	float32x4_t row3 = vld1q_f32(matrix + 12);
+
+	for (int i = 0; i < count; i++)
+		vst1q_f32(VectorAt(result, resultStride, i), TransformRowNeon(vld1q_f32(ConstVectorAt(vectors, vectorStride, i)), row0, row1, row2, row3));
+}
+
+static void Matrix4TransposeNeon(const float* matrix, float* result)
 {
-#ifdef _ARM_ARCH_7
-         __asm__ __volatile
-         (
-         // Store m & v leaving room at top of registers for result (q0)
-         "vldmia %1, {q1-q4 }   \n\t"   // q2-q5 = m
-         "vldmia %2, {q5}               \n\t"   // q1    = v
-         
-         // result = first column of A x V.x
-         "vmul.f32 q0, q1, d10[0]\n\t"
-         
-         // result += second column of A x V.y
-         "vmla.f32 q0, q2, d10[1]\n\t"
-         
-         // result += third column of A x V.z
-         "vmla.f32 q0, q3, d11[0]\n\t"
-         
-         // result += last column of A x V.w
-         "vmla.f32 q0, q4, d11[1]\n\t"
-         
-         // output = result registers
-         "vstmia %0, {q0}"
-         
-         : // no output
-         : "r" (output), "r" (m), "r" (v)       // input - note *value* of pointer doesn't change
-         : "memory", "q0", "q1", "q2", "q3", "q4", "q5" //clobber
-         );
+	// the de-interleaving load gives the columns
+	float32x4x4_t columns = vld4q_f32(matrix);
+	vst1q_f32(result + 0, columns.val[0]);
+	vst1q_f32(result + 4, columns.val[1]);
+	vst1q_f32(result + 8, columns.val[2]);
+	vst1q_f32(result + 12, columns.val[3]);
+}
+
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------------------
+// Runtime selection
+//----------------------------------------------------------------------------------------------------------------------------------
+
+struct MatrixKernels
+{
+	int Kernels;
+	void (*Multiply)(const float* left, const float* right, float* result);
+	void (*TransformVector4)(const float* matrix, const float* vector, float* result);
+	void (*Transpose)(const float* matrix, float* result);
+	int (*Invert)(const float* matrix, float* result);
+	int (*Decompose)(const float* matrix, float* scale, float* rotation, float* translation);
+	void (*MultiplyArray)(const float* left, int leftStride, const float* right, int rightStride, float* result, int resultStride, int count);
+	void (*MultiplyArrayByMatrix)(const float* left, int leftStride, const float* right, float* result, int resultStride, int count);
+	void (*ConcatenateHierarchy)(const float* local, int localStride, const int* parentIndices, int parentIndexStride, float* world, int worldStride, int count);
+	void (*TransformCoordinateArray)(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count);
+	void (*TransformNormalArray)(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count);
+	void (*TransformVector4Array)(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count);
+};
+
+static const MatrixKernels ScalarKernels = { MATRIX_KERNELS_SCALAR, Matrix4MultiplyScalar, Matrix4TransformVector4Scalar, Matrix4TransposeScalar, Matrix4InvertScalar, Matrix4DecomposeScalar,
+	Matrix4MultiplyArrayScalar, Matrix4MultiplyArrayByMatrixScalar, Matrix4ConcatenateHierarchyScalar,
+	Vector3TransformCoordinateArrayScalar, Vector3TransformNormalArrayScalar, Vector4TransformArrayScalar };
+#if MATRIX_SIMD_SSE
+static const MatrixKernels SseKernels = { MATRIX_KERNELS_SSE, Matrix4MultiplySse, Matrix4TransformVector4Sse, Matrix4TransposeSse, Matrix4InvertSse, Matrix4DecomposeSse,
+	Matrix4MultiplyArraySse, Matrix4MultiplyArrayByMatrixSse, Matrix4ConcatenateHierarchySse,
+	Vector3TransformCoordinateArraySse, Vector3TransformNormalArraySse, Vector4TransformArraySse };
+#endif
+#if MATRIX_SIMD_AVX
+static const MatrixKernels AvxKernels = { MATRIX_KERNELS_AVX, Matrix4MultiplyAvx, Matrix4TransformVector4Sse, Matrix4TransposeSse, Matrix4InvertSse, Matrix4DecomposeSse,
+	Matrix4MultiplyArrayAvx, Matrix4MultiplyArrayByMatrixAvx, Matrix4ConcatenateHierarchyAvx,
+	Vector3TransformCoordinateArrayAvx, Vector3TransformNormalArrayAvx, Vector4TransformArrayAvx };
+#endif
+#if MATRIX_SIMD_NEON
+static const MatrixKernels NeonKernels = { MATRIX_KERNELS_NEON, Matrix4MultiplyNeon, Matrix4TransformVector4Neon, Matrix4TransposeNeon, Matrix4InvertScalar, Matrix4DecomposeScalar,
+	Matrix4MultiplyArrayNeon, Matrix4MultiplyArrayByMatrixNeon, Matrix4ConcatenateHierarchyNeon,
+	Vector3TransformCoordinateArrayNeon, Vector3TransformNormalArrayNeon, Vector4TransformArrayNeon };
+#endif
+
+static const MatrixKernels* FindBestKernels()
+{
+#if MATRIX_SIMD_AVX
+	if (CpuSupportsAvx())
+		return &AvxKernels;
+#endif
+#if MATRIX_SIMD_SSE
+	return &SseKernels;
+#elif MATRIX_SIMD_NEON
+	return &NeonKernels;
 #else
-         output[0] = m[0] * v[0] + m[4] * v[1] + m[ 8] * v[2] + m[12] * v[3];
-         output[1] = m[1] * v[0] + m[5] * v[1] + m[ 9] * v[2] + m[13] * v[3];
-         output[2] = m[2] * v[0] + m[6] * v[1] + m[10] * v[2] + m[14] * v[3];
-         output[3] = m[3] * v[0] + m[7] * v[1] + m[11] * v[2] + m[15] * v[3];
+	return &ScalarKernels;
 #endif
 }
+
+static const MatrixKernels* FindKernels(int kernels)
+{
+	switch (kernels)
+	{
+		case MATRIX_KERNELS_SCALAR:
+			return &ScalarKernels;
+#if MATRIX_SIMD_SSE
+		case MATRIX_KERNELS_SSE:
+			return &SseKernels;
+#endif
+#if MATRIX_SIMD_AVX
+		case MATRIX_KERNELS_AVX:
+			return CpuSupportsAvx() ? &AvxKernels : NULL;
+#endif
+#if MATRIX_SIMD_NEON
+		case MATRIX_KERNELS_NEON:
+			return &NeonKernels;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+// The kernel tables are constant data, so publishing the selection only needs the pointer itself to be read and written atomically.
+static const MatrixKernels* SelectedKernels;
+
+static inline const MatrixKernels* LoadSelectedKernels()
+{
+#if defined(_MSC_VER)
+	return *(const MatrixKernels* const volatile*)&SelectedKernels;
+#else
+	return __atomic_load_n(&SelectedKernels, __ATOMIC_RELAXED);
+#endif
 }
 
+static inline void StoreSelectedKernels(const MatrixKernels* kernels)
+{
+#if defined(_MSC_VER)
+	*(const MatrixKernels* volatile*)&SelectedKernels = kernels;
+#else
+	__atomic_store_n(&SelectedKernels, kernels, __ATOMIC_RELAXED);
 #endif
+}
+
+static inline const MatrixKernels* GetKernels()
+{
+	const MatrixKernels* kernels = LoadSelectedKernels();
+	if (!kernels)
+	{
+		kernels = FindBestKernels();
+		StoreSelectedKernels(kernels);
+	}
+	return kernels;
+}
+
+CORE_EXPORT( int ) MatrixSelectKernels(int kernels)
+{
+	const MatrixKernels* selected = FindKernels(kernels);
+	if (!selected)
+		selected = FindBestKernels();
+	StoreSelectedKernels(selected);
+	return selected->Kernels;
+}
+
+CORE_EXPORT( void ) Matrix4Multiply(const float* left, const float* right, float* result)
+{
+	GetKernels()->Multiply(left, right, result);
+}
+
+CORE_EXPORT( void ) Matrix4TransformVector4(const float* matrix, const float* vector, float* result)
+{
+	GetKernels()->TransformVector4(matrix, vector, result);
+}
+
+CORE_EXPORT( void ) Matrix4Transpose(const float* matrix, float* result)
+{
+	GetKernels()->Transpose(matrix, result);
+}
+
+CORE_EXPORT( int ) Matrix4Invert(const float* matrix, float* result)
+{
+	return GetKernels()->Invert(matrix, result);
+}
+
+CORE_EXPORT( int ) Matrix4Decompose(const float* matrix, float* scale, float* rotation, float* translation)
+{
+	return GetKernels()->Decompose(matrix, scale, rotation, translation);
+}
+
+CORE_EXPORT( void ) Matrix4MultiplyArray(const float* left, int leftStride, const float* right, int rightStride, float* result, int resultStride, int count)
+{
+	GetKernels()->MultiplyArray(left, leftStride, right, rightStride, result, resultStride, count);
+}
+
+CORE_EXPORT( void ) Matrix4MultiplyArrayByMatrix(const float* left, int leftStride, const float* right, float* result, int resultStride, int count)
+{
+	GetKernels()->MultiplyArrayByMatrix(left, leftStride, right, result, resultStride, count);
+}
+
+CORE_EXPORT( void ) Matrix4ConcatenateHierarchy(const float* local, int localStride, const int* parentIndices, int parentIndexStride, float* world, int worldStride, int count)
+{
+	GetKernels()->ConcatenateHierarchy(local, localStride, parentIndices, parentIndexStride, world, worldStride, count);
+}
+
+CORE_EXPORT( void ) Vector3TransformCoordinateArray(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	GetKernels()->TransformCoordinateArray(matrix, vectors, vectorStride, result, resultStride, count);
+}
+
+CORE_EXPORT( void ) Vector3TransformNormalArray(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	GetKernels()->TransformNormalArray(matrix, vectors, vectorStride, result, resultStride, count);
+}
+
+CORE_EXPORT( void ) Vector4TransformArray(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count)
+{
+	GetKernels()->TransformVector4Array(matrix, vectors, vectorStride, result, resultStride, count);
+}
+
+CORE_EXPORT( void ) NEON_Matrix4Mul(const float* a, const float* b, float* output)
+{
+	GetKernels()->Multiply(b, a, output);
+}
+
+CORE_EXPORT( void ) NEON_Matrix4Vector4Mul(const float* m, const float* v, float* output)
+{
+	GetKernels()->TransformVector4(m, v, output);
+}
+
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+// Matrix kernels of libcore.
+// Matrices are 16 floats with the layout of SiliconStudio.Core.Mathematics.Matrix (M11, M12, M13, M14, M21, ...)
+// and vectors are row vectors, so that every kernel gives the same result as its managed counterpart.
+// Pointers don't need to be aligned and results can alias the inputs.
+
+#pragma once
+
+#include "coreconfig.h"
+
+// Implementations of the kernels, see MatrixSelectKernels
+#define MATRIX_KERNELS_AUTO -1
+#define MATRIX_KERNELS_SCALAR 0
+#define MATRIX_KERNELS_SSE 1
+#define MATRIX_KERNELS_AVX 2
+#define MATRIX_KERNELS_NEON 3
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// result = left * right (Matrix.Multiply)
+CORE_EXPORT( void ) Matrix4Multiply(const float* left, const float* right, float* result);
+
+// result = vector * matrix (Vector4.Transform)
+CORE_EXPORT( void ) Matrix4TransformVector4(const float* matrix, const float* vector, float* result);
+
+// Matrix.Transpose
+CORE_EXPORT( void ) Matrix4Transpose(const float* matrix, float* result);
+
+// Matrix.Invert: returns 0 and a zero matrix when the determinant is zero
+CORE_EXPORT( int ) Matrix4Invert(const float* matrix, float* result);
+
+// Matrix.Decompose of an SRT matrix into a scale (3 floats), a rotation quaternion (4 floats) and a translation (3 floats).
+// Returns 0 with an identity rotation when a scale is zero.
+CORE_EXPORT( int ) Matrix4Decompose(const float* matrix, float* scale, float* rotation, float* translation);
+
+// Array versions, one call for a whole skeleton or node array. Strides are in bytes, so that the matrices can be fields of
+// larger structures (64 for packed matrices), and each result can alias its own left matrix.
+
+// result[i] = left[i] * right[i]
+CORE_EXPORT( void ) Matrix4MultiplyArray(const float* left, int leftStride, const float* right, int rightStride, float* result, int resultStride, int count);
+
+// result[i] = left[i] * right
+CORE_EXPORT( void ) Matrix4MultiplyArrayByMatrix(const float* left, int leftStride, const float* right, float* result, int resultStride, int count);
+
+// world[i] = local[i] * world[parentIndices[i]], or local[i] for a negative parent index (the loop of SkeletonUpdater.UpdateMatrices).
+// Parents must precede their children.
+CORE_EXPORT( void ) Matrix4ConcatenateHierarchy(const float* local, int localStride, const int* parentIndices, int parentIndexStride, float* world, int worldStride, int count);
+
+// Vector streams transformed by one matrix, such as the positions and normals of an interleaved vertex buffer.
+// Strides are in bytes and the results can overwrite the vectors.
+
+// result[i] = Vector3.TransformCoordinate(vectors[i], matrix), float3 elements
+CORE_EXPORT( void ) Vector3TransformCoordinateArray(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count);
+
+// result[i] = Vector3.TransformNormal(vectors[i], matrix), float3 elements
+CORE_EXPORT( void ) Vector3TransformNormalArray(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count);
+
+// result[i] = Vector4.Transform(vectors[i], matrix), float4 elements
+CORE_EXPORT( void ) Vector4TransformArray(const float* matrix, const float* vectors, int vectorStride, float* result, int resultStride, int count);
+
+// Selects the implementation of the kernels: MATRIX_KERNELS_AUTO picks the best one supported by the CPU, the first call of a kernel does it implicitly.
+// Returns the selected implementation, which falls back to MATRIX_KERNELS_AUTO when the requested one is not available.
+CORE_EXPORT( int ) MatrixSelectKernels(int kernels);
+
+// Same as Matrix4Multiply(b, a, output), kept for the existing Android bindings
+CORE_EXPORT( void ) NEON_Matrix4Mul(const float* a, const float* b, float* output);
+
+// Same as Matrix4TransformVector4(m, v, output), kept for the existing Android bindings
+CORE_EXPORT( void ) NEON_Matrix4Vector4Mul(const float* m, const float* v, float* output);
+
+#ifdef __cplusplus
+}
+#endif
@@ -27,13 +27,42 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #endregion
 
+using System;
+
 namespace SiliconStudio.Core.LZ4
 {
     internal interface ILZ4Service
     {
         string CodecName { get; }
-        int Encode(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength);
-        int EncodeHC(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength);
+        int Encode(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int acceleration);
+        int EncodeHC(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel);
         int Decode(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, bool knownOutputLength);
+
+        // Native compression tables reused from one block to the next, see LZ4CompressionContext
+        IntPtr CreateState(bool highCompression);
+        void FreeState(IntPtr state, bool highCompression);
+        int Encode(IntPtr state, byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int acceleration);
+        int EncodeHC(IntPtr state, byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel);
+
+        // Linked blocks, referring to the last 64KB of the previous ones, see LZ4CompressionContext.EncodeLinked
+        void ResetState(IntPtr state, bool highCompression, int compressionLevel);
+        int EncodeLinked(IntPtr state, bool highCompression, IntPtr input, int inputLength, byte[] output, int outputOffset, int outputLength, int acceleration);
+        int SaveDictionary(IntPtr state, bool highCompression, IntPtr dictionary, int dictionaryLength);
+        int DecodeLinked(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int dictionaryLength, bool knownOutputLength);
+
+        // Dictionaries of the content shared by small blocks, see LZ4Dictionary
+        int TrainDictionary(byte[] samples, int[] sampleLengths, byte[] dictionary);
+        int LoadDictionary(IntPtr state, bool highCompression, IntPtr dictionary, int dictionaryLength);
+        void AttachDictionary(IntPtr state, bool highCompression, IntPtr dictionaryState);
+        int DecodeDictionary(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, IntPtr dictionary, int dictionaryLength, bool knownOutputLength);
+
+        // Blocks decoded directly into native memory, never written beyond its end, see LZ4Stream.Read
+        int Decode(byte[] input, int inputOffset, int inputLength, IntPtr output, int outputLength, IntPtr dictionary, int dictionaryLength);
+
+        // XXH32 checksums of the frames, see LZ4Checksum
+        uint Checksum(byte[] input, int inputOffset, int inputLength, uint seed);
+        void ResetChecksum(IntPtr state, uint seed);
+        void UpdateChecksum(IntPtr state, IntPtr input, int inputLength);
+        uint DigestChecksum(IntPtr state);
     }
 }
\ No newline at end of file
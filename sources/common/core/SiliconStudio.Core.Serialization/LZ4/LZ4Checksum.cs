@@ -0,0 +1,112 @@
+﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under BSD 2-Clause License. See LICENSE.md for details.
+using System;
+using System.Runtime.InteropServices;
+
+namespace SiliconStudio.Core.LZ4
+{
+    /// <summary>
+    /// A checksum of data given in several parts, such as the content of a stream chunk after chunk.
+    /// </summary>
+    /// <remarks>
+    /// The checksum is the XXH32 of the LZ4 frame format, computed natively: the <see cref="Value"/> of the parts is the one of
+    /// <see cref="LZ4Codec.Checksum"/> over all of them, and can be taken at any point. A checksum is used by one thread at a time.
+    /// </remarks>
+    public sealed class LZ4Checksum : IDisposable
+    {
+        // The size of LZ4_checksum_t in lz4.h
+        private const int StateSize = 12 * sizeof(uint);
+
+        private readonly uint seed;
+
+        private IntPtr state;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LZ4Checksum"/> class.
+        /// </summary>
+        /// <param name="seed">The seed of the checksum.</param>
+        public LZ4Checksum(uint seed = 0)
+        {
+            this.seed = seed;
+            state = Marshal.AllocHGlobal(StateSize);
+            Reset();
+        }
+
+        ~LZ4Checksum()
+        {
+            Release();
+        }
+
+        /// <summary>
+        /// Gets the checksum of the data given since the last <see cref="Reset"/>.
+        /// </summary>
+        public uint Value
+        {
+            get { return LZ4Codec.Decoder.DigestChecksum(State); }
+        }
+
+        private IntPtr State
+        {
+            get
+            {
+                if (state == IntPtr.Zero)
+                    throw new ObjectDisposedException(GetType().Name);
+                return state;
+            }
+        }
+
+        /// <summary>
+        /// Starts the checksum of new data.
+        /// </summary>
+        public void Reset()
+        {
+            LZ4Codec.Decoder.ResetChecksum(State, seed);
+        }
+
+        /// <summary>
+        /// Adds the next part of the data.
+        /// </summary>
+        /// <param name="buffer">The buffer.</param>
+        /// <param name="offset">The offset of the part in the buffer.</param>
+        /// <param name="count">The length of the part.</param>
+        public unsafe void Update(byte[] buffer, int offset, int count)
+        {
+            if (buffer == null) throw new ArgumentNullException("buffer");
+            if (offset < 0 || count < 0 || offset + count > buffer.Length)
+                throw new ArgumentException("offset and count are invalid for given buffer");
+
+            fixed (byte* pBuffer = buffer)
+            {
+                LZ4Codec.Decoder.UpdateChecksum(State, (IntPtr)pBuffer + offset, count);
+            }
+        }
+
+        /// <summary>
+        /// Adds the next part of the data, in native memory.
+        /// </summary>
+        /// <param name="buffer">The part.</param>
+        /// <param name="count">The length of the part.</param>
+        public void Update(IntPtr buffer, int count)
+        {
+            if (buffer == IntPtr.Zero && count > 0) throw new ArgumentNullException("buffer");
+            if (count < 0) throw new ArgumentOutOfRangeException("count");
+
+            LZ4Codec.Decoder.UpdateChecksum(State, buffer, count);
+        }
+
+        public void Dispose()
+        {
+            Release();
+            GC.SuppressFinalize(this);
+        }
+
+        private void Release()
+        {
+            if (state != IntPtr.Zero)
+            {
+                Marshal.FreeHGlobal(state);
+                state = IntPtr.Zero;
+            }
+        }
+    }
+}
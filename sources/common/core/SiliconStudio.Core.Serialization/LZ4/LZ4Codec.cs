@@ -29,6 +29,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 using System;
 using System.Runtime.CompilerServices;
+using System.Runtime.InteropServices;
 using System.Text;
 
 using SiliconStudio.Core.LZ4.Services;
@@ -40,6 +41,25 @@ namespace SiliconStudio.Core.LZ4
     /// </summary>
     public static class LZ4Codec
     {
+        /// <summary>The acceleration of <see cref="Encode(byte[],int,int,byte[],int,int,int)"/> giving the best compression.</summary>
+        public const int DefaultAcceleration = 1;
+
+        /// <summary>The fastest and weakest compression level of <see cref="EncodeHC(byte[],int,int,byte[],int,int,int)"/>.</summary>
+        public const int MinimumCompressionLevelHC = 1;
+
+        /// <summary>The default compression level of <see cref="EncodeHC(byte[],int,int,byte[],int,int,int)"/>.</summary>
+        public const int DefaultCompressionLevelHC = 9;
+
+        /// <summary>The compression level of <see cref="EncodeHC(byte[],int,int,byte[],int,int,int)"/> selecting the matches by optimal parsing, which is
+        /// several times slower than the levels below for a smaller output, decoded as fast: for content compressed once and loaded many times.</summary>
+        public const int OptimalCompressionLevelHC = 17;
+
+        /// <summary>The slowest and strongest compression level of <see cref="EncodeHC(byte[],int,int,byte[],int,int,int)"/>.</summary>
+        public const int MaximumCompressionLevelHC = OptimalCompressionLevelHC;
+
+        /// <summary>The length of the end of the previous blocks that a block of <see cref="LZ4CompressionContext.EncodeLinked(byte[],int,int,byte[],int,int,int)"/> can refer to.</summary>
+        public const int LinkedHistoryLength = 64 * 1024;
+
         #region fields
 
         /// <summary>Encoding service.</summary>
@@ -51,11 +71,18 @@ namespace SiliconStudio.Core.LZ4
         /// <summary>Decoding service.</summary>
         private static readonly ILZ4Service decoder;
 
+        /// <summary>Compression tables of the current thread, reused by every block it compresses.</summary>
+        [ThreadStatic]
+        private static LZ4CompressionContext threadContext;
+
+        /// <summary>Compression tables of the current thread for the HC algorithm.</summary>
+        [ThreadStatic]
+        private static LZ4CompressionContext threadContextHC;
+
         // ReSharper disable InconsistentNaming
 
-        // mixed mode
-        private static ILZ4Service _service_Native32;
-        private static ILZ4Service _service_Native64;
+        // native library, compiled for the architecture of the process
+        private static ILZ4Service _service_Native;
 
         // ReSharper restore InconsistentNaming
 
@@ -72,36 +99,9 @@ namespace SiliconStudio.Core.LZ4
 
             Try(InitializeLZ4Native);
 
-            // refer to: http://lz4net.codeplex.com/wikipage?title=Performance%20Testing
-            // for explanation about this order
-            // feel free to change preferred order, just don't do it willy-nilly
-            // back it up with some evidence
-
-            if (IntPtr.Size == 4)
-            {
-                encoder =
-                    _service_Native32 ??
-                    _service_Native64;
-
-                decoder =
-                    _service_Native32 ??
-                    _service_Native64;
-                encoderHC =
-                    _service_Native32 ??
-                    _service_Native64;
-            }
-            else
-            {
-                encoder =
-                    _service_Native64 ??
-                    _service_Native32;
-                decoder =
-                    _service_Native64 ??
-                    _service_Native32;
-                encoderHC =
-                    _service_Native64 ??
-                    _service_Native32;
-            }
+            encoder = _service_Native;
+            decoder = _service_Native;
+            encoderHC = _service_Native;
 
             if (encoder == null || decoder == null)
             {
@@ -161,7 +161,7 @@ namespace SiliconStudio.Core.LZ4
             {
                 // compress it
                 var encoded = new byte[MaximumOutputLength(original.Length)];
-                var encodedLength = service.Encode(original, 0, original.Length, encoded, 0, encoded.Length);
+                var encodedLength = service.Encode(original, 0, original.Length, encoded, 0, encoded.Length, DefaultAcceleration);
                 if (encodedLength < 0) return null;
 
                 // decompress it (knowing original length)
@@ -182,7 +182,7 @@ namespace SiliconStudio.Core.LZ4
             {
                 // compress it
                 var encoded = new byte[MaximumOutputLength(original.Length)];
-                var encodedLength = service.EncodeHC(original, 0, original.Length, encoded, 0, encoded.Length);
+                var encodedLength = service.EncodeHC(original, 0, original.Length, encoded, 0, encoded.Length, DefaultCompressionLevelHC);
                 if (encodedLength < 0) return null;
 
                 // decompress it (knowing original length)
@@ -199,6 +199,95 @@ namespace SiliconStudio.Core.LZ4
                 if (outputText2 != inputText) return null;
             }
 
+            // LZ4 and LZ4HC with reused tables
+            for (var highCompression = 0; highCompression < 2; highCompression++)
+            {
+                var state = service.CreateState(highCompression != 0);
+                if (state == IntPtr.Zero) return null;
+                try
+                {
+                    var encoded = new byte[MaximumOutputLength(original.Length)];
+                    var decoded = new byte[original.Length];
+                    for (var block = 0; block < 2; block++)
+                    {
+                        var encodedLength = highCompression != 0
+                            ? service.EncodeHC(state, original, 0, original.Length, encoded, 0, encoded.Length, DefaultCompressionLevelHC)
+                            : service.Encode(state, original, 0, original.Length, encoded, 0, encoded.Length, DefaultAcceleration);
+                        if (encodedLength <= 0) return null;
+
+                        var decodedLength = service.Decode(encoded, 0, encodedLength, decoded, 0, decoded.Length, false);
+                        if (decodedLength != original.Length) return null;
+                        if (Encoding.UTF8.GetString(decoded, 0, decoded.Length) != inputText) return null;
+                    }
+                }
+                finally
+                {
+                    service.FreeState(state, highCompression != 0);
+                }
+            }
+
+            // Linked blocks, the second one referring to the first one
+            for (var highCompression = 0; highCompression < 2; highCompression++)
+            {
+                var state = service.CreateState(highCompression != 0);
+                if (state == IntPtr.Zero) return null;
+                var native = Marshal.AllocHGlobal(original.Length);
+                try
+                {
+                    Marshal.Copy(original, 0, native, original.Length);
+                    service.ResetState(state, highCompression != 0, 0);
+                    var half = original.Length / 2;
+                    var encoded = new byte[MaximumOutputLength(original.Length)];
+                    var encodedLength1 = service.EncodeLinked(state, highCompression != 0, native, half, encoded, 0, encoded.Length, DefaultAcceleration);
+                    var encodedLength2 = service.EncodeLinked(state, highCompression != 0, native + half, original.Length - half, encoded, encodedLength1, encoded.Length - encodedLength1, DefaultAcceleration);
+                    if (encodedLength1 <= 0 || encodedLength2 <= 0) return null;
+
+                    var decoded = new byte[original.Length];
+                    if (service.DecodeLinked(encoded, 0, encodedLength1, decoded, 0, half, 0, false) != half) return null;
+                    if (service.DecodeLinked(encoded, encodedLength1, encodedLength2, decoded, half, original.Length - half, half, false) != original.Length - half) return null;
+                    if (Encoding.UTF8.GetString(decoded, 0, decoded.Length) != inputText) return null;
+                }
+                finally
+                {
+                    Marshal.FreeHGlobal(native);
+                    service.FreeState(state, highCompression != 0);
+                }
+            }
+
+            // A block compressed with a dictionary, decoded with it
+            for (var highCompression = 0; highCompression < 2; highCompression++)
+            {
+                var state = service.CreateState(highCompression != 0);
+                var dictionaryState = service.CreateState(highCompression != 0);
+                var dictionary = Marshal.AllocHGlobal(original.Length);
+                var native = Marshal.AllocHGlobal(original.Length);
+                try
+                {
+                    if (state == IntPtr.Zero || dictionaryState == IntPtr.Zero) return null;
+                    Marshal.Copy(original, 0, dictionary, original.Length);
+                    Marshal.Copy(original, 0, native, original.Length);
+                    if (service.LoadDictionary(dictionaryState, highCompression != 0, dictionary, original.Length) != original.Length) return null;
+                    service.ResetState(state, highCompression != 0, 0);
+                    service.AttachDictionary(state, highCompression != 0, dictionaryState);
+
+                    // The whole block is found in the dictionary
+                    var encoded = new byte[MaximumOutputLength(original.Length)];
+                    var encodedLength = service.EncodeLinked(state, highCompression != 0, native, original.Length, encoded, 0, encoded.Length, DefaultAcceleration);
+                    if (encodedLength <= 0 || encodedLength > original.Length / 32) return null;
+
+                    var decoded = new byte[original.Length];
+                    if (service.DecodeDictionary(encoded, 0, encodedLength, decoded, 0, decoded.Length, dictionary, original.Length, false) != original.Length) return null;
+                    if (Encoding.UTF8.GetString(decoded, 0, decoded.Length) != inputText) return null;
+                }
+                finally
+                {
+                    Marshal.FreeHGlobal(native);
+                    Marshal.FreeHGlobal(dictionary);
+                    if (dictionaryState != IntPtr.Zero) service.FreeState(dictionaryState, highCompression != 0);
+                    if (state != IntPtr.Zero) service.FreeState(state, highCompression != 0);
+                }
+            }
+
             return service;
         }
 
@@ -208,14 +297,31 @@ namespace SiliconStudio.Core.LZ4
         [MethodImpl(MethodImplOptions.NoInlining)]
         private static void InitializeLZ4Native()
         {
-            _service_Native32 = Try<Native32LZ4Service>();
-            _service_Native64 = Try<Native64LZ4Service>();
+            _service_Native = Try<NativeLZ4Service>();
         }
 
         // ReSharper restore InconsistentNaming
 
         #endregion
 
+        /// <summary>Gets the encoding service.</summary>
+        internal static ILZ4Service Encoder
+        {
+            get { return encoder; }
+        }
+
+        /// <summary>Gets the encoding service for HC algorithm.</summary>
+        internal static ILZ4Service EncoderHC
+        {
+            get { return encoderHC ?? encoder; }
+        }
+
+        /// <summary>Gets the decoding service.</summary>
+        internal static ILZ4Service Decoder
+        {
+            get { return decoder; }
+        }
+
         #region public interface
 
         /// <summary>Gets the name of selected codec(s).</summary>
@@ -242,6 +348,16 @@ namespace SiliconStudio.Core.LZ4
 
         #region Encode
 
+        /// <summary>Gets the compression tables of the current thread, reused by every block it compresses.</summary>
+        /// <param name="highCompression">If set to <c>true</c>, gets the tables of the HC algorithm.</param>
+        /// <returns>The context of the current thread.</returns>
+        internal static LZ4CompressionContext GetThreadContext(bool highCompression)
+        {
+            return highCompression
+                ? threadContextHC ?? (threadContextHC = new LZ4CompressionContext(true))
+                : threadContext ?? (threadContext = new LZ4CompressionContext(false));
+        }
+
         /// <summary>Encodes the specified input.</summary>
         /// <param name="input">The input.</param>
         /// <param name="inputOffset">The input offset.</param>
@@ -249,16 +365,43 @@ namespace SiliconStudio.Core.LZ4
         /// <param name="output">The output.</param>
         /// <param name="outputOffset">The output offset.</param>
         /// <param name="outputLength">Length of the output.</param>
-        /// <returns>Number of bytes written.</returns>
+        /// <param name="acceleration">The acceleration: values above <see cref="DefaultAcceleration"/> compress faster but less.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
+        public static int Encode(
+            byte[] input,
+            int inputOffset,
+            int inputLength,
+            byte[] output,
+            int outputOffset,
+            int outputLength,
+            int acceleration = DefaultAcceleration)
+        {
+            var context = GetThreadContext(false);
+            return context.Encode(input, inputOffset, inputLength, output, outputOffset, outputLength, acceleration);
+        }
+
+        /// <summary>Encodes the specified input, referring to a dictionary.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output.</param>
+        /// <param name="dictionary">The dictionary, which the block is decoded with (see <see cref="Decode(byte[],int,int,byte[],int,int,LZ4Dictionary,bool)"/>).</param>
+        /// <param name="acceleration">The acceleration: values above <see cref="DefaultAcceleration"/> compress faster but less.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
         public static int Encode(
             byte[] input,
             int inputOffset,
             int inputLength,
             byte[] output,
             int outputOffset,
-            int outputLength)
+            int outputLength,
+            LZ4Dictionary dictionary,
+            int acceleration = DefaultAcceleration)
         {
-            return encoder.Encode(input, inputOffset, inputLength, output, outputOffset, outputLength);
+            var context = GetThreadContext(false);
+            return context.Encode(input, inputOffset, inputLength, output, outputOffset, outputLength, acceleration, dictionary);
         }
 
         /// <summary>Encodes the specified input.</summary>
@@ -295,17 +438,82 @@ namespace SiliconStudio.Core.LZ4
         /// <param name="output">The output.</param>
         /// <param name="outputOffset">The output offset.</param>
         /// <param name="outputLength">Length of the output.</param>
-        /// <returns>Number of bytes written.</returns>
+        /// <param name="compressionLevel">The compression level, from <see cref="MinimumCompressionLevelHC"/> to <see cref="MaximumCompressionLevelHC"/>.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
+        public static int EncodeHC(
+            byte[] input,
+            int inputOffset,
+            int inputLength,
+            byte[] output,
+            int outputOffset,
+            int outputLength,
+            int compressionLevel = DefaultCompressionLevelHC)
+        {
+            var context = GetThreadContext(true);
+            return context.Encode(input, inputOffset, inputLength, output, outputOffset, outputLength, compressionLevel);
+        }
+
+        /// <summary>Encodes the specified input, referring to a dictionary.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output.</param>
+        /// <param name="dictionary">The dictionary, which the block is decoded with (see <see cref="Decode(byte[],int,int,byte[],int,int,LZ4Dictionary,bool)"/>).</param>
+        /// <param name="compressionLevel">The compression level, from <see cref="MinimumCompressionLevelHC"/> to <see cref="MaximumCompressionLevelHC"/>.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
         public static int EncodeHC(
             byte[] input,
             int inputOffset,
             int inputLength,
             byte[] output,
             int outputOffset,
-            int outputLength)
+            int outputLength,
+            LZ4Dictionary dictionary,
+            int compressionLevel = DefaultCompressionLevelHC)
+        {
+            var context = GetThreadContext(true);
+            return context.Encode(input, inputOffset, inputLength, output, outputOffset, outputLength, compressionLevel, dictionary);
+        }
+
+        /// <summary>Trains a dictionary out of samples of the blocks to compress, see <see cref="LZ4Dictionary.Train"/>.</summary>
+        /// <param name="samples">The samples, one after the other.</param>
+        /// <param name="sampleLengths">The length of each sample.</param>
+        /// <param name="dictionary">The dictionary, written from its start: its length is the maximum length of the dictionary.</param>
+        /// <returns>The length of the dictionary, or 0 if the samples have too little content in common.</returns>
+        public static int TrainDictionary(byte[] samples, int[] sampleLengths, byte[] dictionary)
+        {
+            if (samples == null) throw new ArgumentNullException("samples");
+            if (sampleLengths == null) throw new ArgumentNullException("sampleLengths");
+            if (dictionary == null) throw new ArgumentNullException("dictionary");
+
+            long samplesLength = 0;
+            foreach (var sampleLength in sampleLengths)
+            {
+                if (sampleLength < 0) throw new ArgumentException("sampleLengths can't be negative", "sampleLengths");
+                samplesLength += sampleLength;
+            }
+            if (samplesLength > samples.Length)
+                throw new ArgumentException("sampleLengths are invalid for given samples");
+
+            return encoder.TrainDictionary(samples, sampleLengths, dictionary);
+        }
+
+        /// <summary>Computes the XXH32 checksum of a buffer, the checksum of the LZ4 frame format (see <see cref="LZ4Checksum"/> for data given in several parts).</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="seed">The seed of the checksum.</param>
+        /// <returns>The checksum.</returns>
+        /// <remarks>The checksum is several times faster to compute than the decompression, so that blocks can be validated before being decoded.</remarks>
+        public static uint Checksum(byte[] input, int inputOffset, int inputLength, uint seed = 0)
         {
-            return (encoderHC ?? encoder)
-                .EncodeHC(input, inputOffset, inputLength, output, outputOffset, outputLength);
+            if (input == null) throw new ArgumentNullException("input");
+            if (inputOffset < 0 || inputLength < 0 || inputOffset + inputLength > input.Length)
+                throw new ArgumentException("inputOffset and inputLength are invalid for given input");
+
+            return decoder.Checksum(input, inputOffset, inputLength, seed);
         }
 
         /// <summary>Encodes the specified input.</summary>
@@ -360,6 +568,82 @@ namespace SiliconStudio.Core.LZ4
             return decoder.Decode(input, inputOffset, inputLength, output, outputOffset, outputLength, knownOutputLength);
         }
 
+        /// <summary>Decodes a block of <see cref="LZ4CompressionContext.EncodeLinked(byte[],int,int,byte[],int,int,int)"/>.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output, where the previous blocks of the sequence have been decoded before <paramref name="outputOffset"/>.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output.</param>
+        /// <param name="historyLength">The number of bytes of the previous blocks preceding <paramref name="outputOffset"/>: the whole sequence so far,
+        /// or at least its last <see cref="LinkedHistoryLength"/> bytes. 0 for the first block.</param>
+        /// <param name="knownOutputLength">Set it to <c>true</c> if output length is known.</param>
+        /// <returns>Number of bytes written.</returns>
+        public static int DecodeLinked(
+            byte[] input,
+            int inputOffset,
+            int inputLength,
+            byte[] output,
+            int outputOffset,
+            int outputLength,
+            int historyLength,
+            bool knownOutputLength = false)
+        {
+            if (historyLength < 0 || historyLength > outputOffset)
+                throw new ArgumentOutOfRangeException("historyLength");
+
+            return decoder.DecodeLinked(input, inputOffset, inputLength, output, outputOffset, outputLength, historyLength, knownOutputLength);
+        }
+
+        /// <summary>Decodes a block compressed with a dictionary.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output.</param>
+        /// <param name="dictionary">The dictionary the block has been compressed with.</param>
+        /// <param name="knownOutputLength">Set it to <c>true</c> if output length is known.</param>
+        /// <returns>Number of bytes written.</returns>
+        public static int Decode(
+            byte[] input,
+            int inputOffset,
+            int inputLength,
+            byte[] output,
+            int outputOffset,
+            int outputLength,
+            LZ4Dictionary dictionary,
+            bool knownOutputLength = false)
+        {
+            if (dictionary == null) throw new ArgumentNullException("dictionary");
+
+            return decoder.DecodeDictionary(input, inputOffset, inputLength, output, outputOffset, outputLength, dictionary.Pointer, dictionary.Length, knownOutputLength);
+        }
+
+        /// <summary>Decodes a block directly into native memory, such as the final destination of the data, its matches referring to a history found anywhere.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputLength">Length of the output, the exact length of the block if known.</param>
+        /// <param name="history">The data the block refers to: the end of the previous linked blocks (see <see cref="DecodeLinked"/>) or the content of the
+        /// dictionary the block has been compressed with. <see cref="IntPtr.Zero"/> for an independent block.</param>
+        /// <param name="historyLength">Length of the history.</param>
+        /// <returns>Number of bytes written, or a negative value if the block is corrupted.</returns>
+        /// <remarks>Even if the block is corrupted, the input is not read beyond <paramref name="inputLength"/> and the output is not written beyond
+        /// <paramref name="outputLength"/>. A history immediately preceding the output decodes as fast as an independent block.</remarks>
+        public static int Decode(byte[] input, int inputOffset, int inputLength, IntPtr output, int outputLength, IntPtr history, int historyLength)
+        {
+            if (input == null) throw new ArgumentNullException("input");
+            if (inputOffset < 0 || inputLength < 0 || inputOffset + inputLength > input.Length)
+                throw new ArgumentException("inputOffset and inputLength are invalid for given input");
+            if (output == IntPtr.Zero && outputLength > 0) throw new ArgumentNullException("output");
+            if (outputLength < 0) throw new ArgumentOutOfRangeException("outputLength");
+            if (historyLength < 0 || (history == IntPtr.Zero && historyLength > 0)) throw new ArgumentOutOfRangeException("historyLength");
+
+            return decoder.Decode(input, inputOffset, inputLength, output, outputLength, history, historyLength);
+        }
+
         /// <summary>Decodes the specified input.</summary>
         /// <param name="input">The input.</param>
         /// <param name="inputOffset">The input offset.</param>
@@ -0,0 +1,263 @@
+﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under BSD 2-Clause License. See LICENSE.md for details.
+using System;
+using System.Runtime.InteropServices;
+
+namespace SiliconStudio.Core.LZ4
+{
+    /// <summary>
+    /// Native LZ4 or LZ4HC compression tables, allocated once and reused for a sequence of blocks.
+    /// </summary>
+    /// <remarks>
+    /// Compressing a block with <see cref="LZ4Codec.Encode(byte[],int,int,byte[],int,int,int)"/> or <see cref="LZ4Codec.EncodeHC(byte[],int,int,byte[],int,int,int)"/>
+    /// uses a context of the calling thread, so that they don't allocate or clear tables for each block (256KB for LZ4HC).
+    /// The blocks stay independent, each one is decoded alone. A context is used by one thread at a time.
+    /// <see cref="EncodeLinked(byte[],int,int,byte[],int,int,int)"/> compresses a sequence of blocks that refer to the previous ones instead, see <see cref="LZ4Codec.DecodeLinked"/>.
+    /// Blocks can also refer to a <see cref="LZ4Dictionary"/> of the content shared by many small blocks.
+    /// </remarks>
+    public sealed class LZ4CompressionContext : IDisposable
+    {
+        // Native copy of the linked blocks, at least this large so that several small blocks follow each other before the history is moved back
+        private const int MinimumHistoryCapacity = 256 * 1024;
+
+        private readonly ILZ4Service service;
+        private IntPtr state;
+
+        // The last 64KB (at most) of the previous linked blocks followed by the current one: the native state refers to them by address,
+        // which managed arrays don't keep from one call to the next
+        private IntPtr history;
+        private int historyCapacity;
+        private int historyLength = -1;   // -1 when the next linked block starts a new sequence
+
+        // Whether the last block referred to a dictionary, which the next linked block must not see
+        private bool dictionaryBlock;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LZ4CompressionContext"/> class.
+        /// </summary>
+        /// <param name="highCompression">If set to <c>true</c>, the context compresses with LZ4HC.</param>
+        /// <exception cref="System.OutOfMemoryException">The native tables could not be allocated.</exception>
+        public LZ4CompressionContext(bool highCompression)
+        {
+            HighCompression = highCompression;
+            service = highCompression ? LZ4Codec.EncoderHC : LZ4Codec.Encoder;
+            state = service.CreateState(highCompression);
+            if (state == IntPtr.Zero)
+                throw new OutOfMemoryException();
+        }
+
+        ~LZ4CompressionContext()
+        {
+            Release();
+        }
+
+        /// <summary>
+        /// Gets a value indicating whether the context compresses with LZ4HC.
+        /// </summary>
+        public bool HighCompression { get; private set; }
+
+        /// <summary>Encodes the specified input as an independent block.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output.</param>
+        /// <param name="compressionLevel">The LZ4HC compression level or the LZ4 acceleration, 0 for the default one.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
+        public int Encode(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel = 0)
+        {
+            if (state == IntPtr.Zero)
+                throw new ObjectDisposedException(GetType().Name);
+
+            // The state is reset by independent blocks
+            historyLength = -1;
+
+            return HighCompression
+                ? service.EncodeHC(state, input, inputOffset, inputLength, output, outputOffset, outputLength, GetCompressionLevel(compressionLevel))
+                : service.Encode(state, input, inputOffset, inputLength, output, outputOffset, outputLength, compressionLevel);
+        }
+
+        /// <summary>Encodes the specified input as an independent block referring to a dictionary.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output.</param>
+        /// <param name="compressionLevel">The LZ4HC compression level or the LZ4 acceleration, 0 for the default one.</param>
+        /// <param name="dictionary">The dictionary, which the block is decoded with by <see cref="LZ4Codec.Decode(byte[],int,int,byte[],int,int,LZ4Dictionary,bool)"/>.
+        /// <c>null</c> for a block without dictionary.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
+        public int Encode(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel, LZ4Dictionary dictionary)
+        {
+            if (dictionary == null)
+                return Encode(input, inputOffset, inputLength, output, outputOffset, outputLength, compressionLevel);
+
+            // A sequence of a single block
+            historyLength = -1;
+            var result = EncodeLinked(input, inputOffset, inputLength, output, outputOffset, outputLength, compressionLevel, dictionary);
+            historyLength = -1;
+            return result;
+        }
+
+        /// <summary>Encodes the specified input as the next block of a sequence, whose matches can refer to the last <see cref="LZ4Codec.LinkedHistoryLength"/> bytes of the previous blocks.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output, at least <see cref="LZ4Codec.MaximumOutputLength"/> so that the following blocks can still refer to this one.</param>
+        /// <param name="compressionLevel">The LZ4 acceleration, or the LZ4HC compression level of the whole sequence given with its first block, 0 for the default one.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
+        /// <remarks>The blocks are decoded in the same order by <see cref="LZ4Codec.DecodeLinked"/>. <see cref="Encode(byte[],int,int,byte[],int,int,int)"/> and <see cref="ResetLinked"/> end the sequence.</remarks>
+        public int EncodeLinked(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel = 0)
+        {
+            return EncodeLinked(input, inputOffset, inputLength, output, outputOffset, outputLength, compressionLevel, null);
+        }
+
+        /// <summary>Encodes the specified input as the next block of a sequence, the first block referring to a dictionary and the next ones to the previous blocks.</summary>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output, at least <see cref="LZ4Codec.MaximumOutputLength"/> so that the following blocks can still refer to this one.</param>
+        /// <param name="compressionLevel">The LZ4 acceleration, or the LZ4HC compression level of the whole sequence given with its first block, 0 for the default one.</param>
+        /// <param name="dictionary">The dictionary of the first block of the sequence, ignored by the next ones. <c>null</c> for a sequence without dictionary.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
+        /// <remarks>The first block is decoded by <see cref="LZ4Codec.Decode(byte[],int,int,byte[],int,int,LZ4Dictionary,bool)"/>, the next ones by
+        /// <see cref="LZ4Codec.DecodeLinked"/>, as if the first one had no dictionary.</remarks>
+        public int EncodeLinked(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel, LZ4Dictionary dictionary)
+        {
+            if (state == IntPtr.Zero)
+                throw new ObjectDisposedException(GetType().Name);
+            if (input == null) throw new ArgumentNullException("input");
+            if (inputOffset < 0 || inputLength < 0 || inputOffset + inputLength > input.Length)
+                throw new ArgumentException("inputOffset and inputLength are invalid for given input");
+
+            if (historyLength < 0)
+            {
+                service.ResetState(state, HighCompression, GetCompressionLevel(compressionLevel));
+                if (dictionary != null)
+                    service.AttachDictionary(state, HighCompression, dictionary.GetState(HighCompression));
+                historyLength = 0;
+                dictionaryBlock = dictionary != null;
+            }
+            else if (dictionaryBlock)
+            {
+                // LZ4HC keeps referring to the dictionary as long as it is in the last 64KB: the history is loaded alone instead
+                var dictionaryLength = Math.Min(historyLength, LZ4Codec.LinkedHistoryLength);
+                service.LoadDictionary(state, HighCompression, history + historyLength - dictionaryLength, dictionaryLength);
+                dictionaryBlock = false;
+            }
+
+            // The block is copied after the history, which is moved back to the start of the buffer (or to a larger one) when there is no room left
+            if (historyLength + inputLength > historyCapacity)
+            {
+                var capacity = Math.Max(LZ4Codec.LinkedHistoryLength + inputLength, MinimumHistoryCapacity);
+                var newHistory = capacity > historyCapacity ? Marshal.AllocHGlobal(capacity) : history;
+                historyLength = historyLength > 0 ? service.SaveDictionary(state, HighCompression, newHistory, LZ4Codec.LinkedHistoryLength) : 0;
+                if (newHistory != history)
+                {
+                    if (history != IntPtr.Zero)
+                        Marshal.FreeHGlobal(history);
+                    history = newHistory;
+                    historyCapacity = capacity;
+                }
+            }
+
+            Marshal.Copy(input, inputOffset, history + historyLength, inputLength);
+            var result = service.EncodeLinked(state, HighCompression, history + historyLength, inputLength, output, outputOffset, outputLength, compressionLevel);
+            historyLength += inputLength;
+            return result;
+        }
+
+        /// <summary>Encodes the specified input as a block of a sequence whose previous blocks end with the given history, as if they had been compressed by this context.</summary>
+        /// <param name="history">The end of the previous blocks of the sequence, of which only the last <see cref="LZ4Codec.LinkedHistoryLength"/> bytes are referred to.</param>
+        /// <param name="historyOffset">The history offset.</param>
+        /// <param name="historyLength">Length of the history, 0 for the first block of the sequence.</param>
+        /// <param name="input">The input.</param>
+        /// <param name="inputOffset">The input offset.</param>
+        /// <param name="inputLength">Length of the input.</param>
+        /// <param name="output">The output.</param>
+        /// <param name="outputOffset">The output offset.</param>
+        /// <param name="outputLength">Length of the output, at least <see cref="LZ4Codec.MaximumOutputLength"/> so that the following blocks can still refer to this one.</param>
+        /// <param name="compressionLevel">The LZ4HC compression level or the LZ4 acceleration, 0 for the default one.</param>
+        /// <returns>Number of bytes written, or 0 if the output is too small.</returns>
+        /// <remarks>The blocks of a sequence don't depend on each other's compression: they can be compressed at the same time by several contexts, and decoded by
+        /// <see cref="LZ4Codec.DecodeLinked"/>. The sequence can be continued by <see cref="EncodeLinked(byte[],int,int,byte[],int,int,int)"/>.</remarks>
+        public int EncodeLinked(byte[] history, int historyOffset, int historyLength, byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel = 0)
+        {
+            if (state == IntPtr.Zero)
+                throw new ObjectDisposedException(GetType().Name);
+            if (history == null) throw new ArgumentNullException("history");
+            if (historyOffset < 0 || historyLength < 0 || historyOffset + historyLength > history.Length)
+                throw new ArgumentException("historyOffset and historyLength are invalid for given history");
+            if (input == null) throw new ArgumentNullException("input");
+            if (inputOffset < 0 || inputLength < 0 || inputOffset + inputLength > input.Length)
+                throw new ArgumentException("inputOffset and inputLength are invalid for given input");
+
+            if (historyLength > LZ4Codec.LinkedHistoryLength)
+            {
+                historyOffset += historyLength - LZ4Codec.LinkedHistoryLength;
+                historyLength = LZ4Codec.LinkedHistoryLength;
+            }
+
+            // The history and the block follow each other in the native buffer, where the block is compressed as the continuation of the history
+            if (historyLength + inputLength > historyCapacity)
+            {
+                var capacity = Math.Max(LZ4Codec.LinkedHistoryLength + inputLength, MinimumHistoryCapacity);
+                if (this.history != IntPtr.Zero)
+                    Marshal.FreeHGlobal(this.history);
+                this.history = Marshal.AllocHGlobal(capacity);
+                historyCapacity = capacity;
+            }
+
+            service.ResetState(state, HighCompression, GetCompressionLevel(compressionLevel));
+            Marshal.Copy(history, historyOffset, this.history, historyLength);
+            if (historyLength > 0)
+                service.LoadDictionary(state, HighCompression, this.history, historyLength);
+            dictionaryBlock = false;
+
+            Marshal.Copy(input, inputOffset, this.history + historyLength, inputLength);
+            var result = service.EncodeLinked(state, HighCompression, this.history + historyLength, inputLength, output, outputOffset, outputLength, compressionLevel);
+            this.historyLength = historyLength + inputLength;
+            return result;
+        }
+
+        /// <summary>Ends the current sequence of linked blocks: the next block given to <see cref="EncodeLinked(byte[],int,int,byte[],int,int,int)"/> starts a new one.</summary>
+        public void ResetLinked()
+        {
+            historyLength = -1;
+        }
+
+        // The native LZ4HC state keeps the level of the last reset and uses it when a block is given level 0.
+        // The level 0 of the managed API always means the default level, so that a sequence compressed at another level does not change the next blocks.
+        private int GetCompressionLevel(int compressionLevel)
+        {
+            return HighCompression && compressionLevel < LZ4Codec.MinimumCompressionLevelHC ? LZ4Codec.DefaultCompressionLevelHC : compressionLevel;
+        }
+
+        public void Dispose()
+        {
+            Release();
+            GC.SuppressFinalize(this);
+        }
+
+        private void Release()
+        {
+            if (state != IntPtr.Zero)
+            {
+                service.FreeState(state, HighCompression);
+                state = IntPtr.Zero;
+            }
+            if (history != IntPtr.Zero)
+            {
+                Marshal.FreeHGlobal(history);
+                history = IntPtr.Zero;
+                historyCapacity = 0;
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under BSD 2-Clause License. See LICENSE.md for details.
+using System;
+using System.Runtime.InteropServices;
+
+namespace SiliconStudio.Core.LZ4
+{
+    /// <summary>
+    /// A dictionary of the content shared by many small blocks, which compress much better with it than alone.
+    /// </summary>
+    /// <remarks>
+    /// A dictionary is trained by <see cref="Train"/> out of samples of the blocks to compress, and stored along with them: the blocks are compressed by
+    /// <see cref="LZ4CompressionContext.Encode(byte[],int,int,byte[],int,int,int,LZ4Dictionary)"/> or the first block of a sequence of
+    /// <see cref="LZ4CompressionContext.EncodeLinked(byte[],int,int,byte[],int,int,int,LZ4Dictionary)"/>, and decoded by
+    /// <see cref="LZ4Codec.Decode(byte[],int,int,byte[],int,int,LZ4Dictionary,bool)"/> with the same dictionary.
+    /// The dictionary is loaded once in the native tables of each compressor, which are then copied for each block instead of hashing the dictionary again.
+    /// A dictionary can be used by several threads at the same time.
+    /// </remarks>
+    public sealed class LZ4Dictionary : IDisposable
+    {
+        /// <summary>The maximum length of a dictionary: blocks can't refer further back.</summary>
+        public const int MaximumLength = LZ4Codec.LinkedHistoryLength;
+
+        private readonly object stateLock = new object();
+
+        // Native copy of the content, which the compression tables refer to by address
+        private IntPtr content;
+
+        // Compression tables loaded with the content, created the first time a block is compressed
+        private IntPtr state;
+        private IntPtr stateHC;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LZ4Dictionary"/> class.
+        /// </summary>
+        /// <param name="content">The content of the dictionary, as returned by <see cref="Train"/> or <see cref="ToArray"/>.</param>
+        /// <exception cref="System.ArgumentNullException">content</exception>
+        /// <exception cref="System.ArgumentException">The content is longer than <see cref="MaximumLength"/>.</exception>
+        public LZ4Dictionary(byte[] content)
+        {
+            if (content == null) throw new ArgumentNullException("content");
+            if (content.Length > MaximumLength)
+                throw new ArgumentException(string.Format("A dictionary can't be longer than {0} bytes", MaximumLength), "content");
+
+            Length = content.Length;
+            this.content = Marshal.AllocHGlobal(Math.Max(Length, 1));
+            Marshal.Copy(content, 0, this.content, Length);
+        }
+
+        ~LZ4Dictionary()
+        {
+            Release();
+        }
+
+        /// <summary>
+        /// Gets the length of the dictionary.
+        /// </summary>
+        public int Length { get; private set; }
+
+        /// <summary>
+        /// Gets the native copy of the content.
+        /// </summary>
+        internal IntPtr Pointer
+        {
+            get
+            {
+                if (content == IntPtr.Zero)
+                    throw new ObjectDisposedException(GetType().Name);
+                return content;
+            }
+        }
+
+        /// <summary>
+        /// Trains a dictionary out of samples of the blocks to compress.
+        /// </summary>
+        /// <param name="samples">The samples, one after the other.</param>
+        /// <param name="sampleLengths">The length of each sample.</param>
+        /// <param name="maximumLength">The maximum length of the dictionary, up to <see cref="MaximumLength"/>.</param>
+        /// <returns>The dictionary, or <c>null</c> if the samples have too little content in common.</returns>
+        /// <remarks>The dictionary is made of the segments of the samples that hold the most sequences found in other samples. A few MB of samples,
+        /// for a dictionary of about 1/100 of their size, make a good one.</remarks>
+        public static LZ4Dictionary Train(byte[] samples, int[] sampleLengths, int maximumLength = MaximumLength)
+        {
+            var dictionary = new byte[Math.Max(0, Math.Min(maximumLength, MaximumLength))];
+            var length = LZ4Codec.TrainDictionary(samples, sampleLengths, dictionary);
+            if (length <= 0)
+                return null;
+
+            Array.Resize(ref dictionary, length);
+            return new LZ4Dictionary(dictionary);
+        }
+
+        /// <summary>
+        /// Copies the content of the dictionary, to be stored along with the blocks compressed with it.
+        /// </summary>
+        /// <returns>The content of the dictionary.</returns>
+        public byte[] ToArray()
+        {
+            var result = new byte[Length];
+            Marshal.Copy(Pointer, result, 0, Length);
+            return result;
+        }
+
+        /// <summary>
+        /// Gets the compression tables loaded with the dictionary, to be attached to the tables of a block.
+        /// </summary>
+        /// <param name="highCompression">If set to <c>true</c>, gets the tables of LZ4HC.</param>
+        /// <returns>The native tables, owned by the dictionary.</returns>
+        internal IntPtr GetState(bool highCompression)
+        {
+            lock (stateLock)
+            {
+                var dictionary = Pointer;
+                var result = highCompression ? stateHC : state;
+                if (result == IntPtr.Zero)
+                {
+                    // The same service as LZ4CompressionContext, whose tables are laid out the same way
+                    var service = highCompression ? LZ4Codec.EncoderHC : LZ4Codec.Encoder;
+                    result = service.CreateState(highCompression);
+                    if (result == IntPtr.Zero)
+                        throw new OutOfMemoryException();
+                    service.LoadDictionary(result, highCompression, dictionary, Length);
+
+                    if (highCompression)
+                        stateHC = result;
+                    else
+                        state = result;
+                }
+                return result;
+            }
+        }
+
+        public void Dispose()
+        {
+            Release();
+            GC.SuppressFinalize(this);
+        }
+
+        private void Release()
+        {
+            if (state != IntPtr.Zero)
+            {
+                LZ4Codec.Encoder.FreeState(state, false);
+                state = IntPtr.Zero;
+            }
+            if (stateHC != IntPtr.Zero)
+            {
+                LZ4Codec.EncoderHC.FreeState(stateHC, true);
+                stateHC = IntPtr.Zero;
+            }
+            if (content != IntPtr.Zero)
+            {
+                Marshal.FreeHGlobal(content);
+                content = IntPtr.Zero;
+            }
+        }
+    }
+}
@@ -22,8 +22,10 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN 
 // IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 using System;
+using System.Collections.Generic;
 using System.IO;
 using System.IO.Compression;
+using System.Threading.Tasks;
 using SiliconStudio.Core.IO;
 
 namespace SiliconStudio.Core.LZ4
@@ -52,6 +54,48 @@ namespace SiliconStudio.Core.LZ4
 			/// <summary>3 bits for number of passes. Currently only 1 pass (value 0) 
 			/// is supported.</summary>
 			Passes = 0x04 | 0x08 | 0x10, // not used currently
+
+			/// <summary>Set if the chunk can refer to the last 64KB of the previous chunks (see <see cref="LZ4CompressionContext.EncodeLinked(byte[],int,int,byte[],int,int,int)"/>).
+			/// Previous readers reject such chunks as having several passes.</summary>
+			Linked = 0x20,
+
+			/// <summary>Set if the chunk refers to the dictionary of the stream instead of the previous chunks (see <see cref="LZ4Dictionary"/>):
+			/// the first chunk of linked ones, or every chunk otherwise. Previous readers reject such chunks as having several passes.</summary>
+			Dictionary = 0x40,
+
+			/// <summary>Set on the header and the end of a frame instead of a chunk (see <see cref="FrameFlags"/>).
+			/// Previous readers reject it as having several passes.</summary>
+			Frame = 0x80,
+		}
+
+		#endregion
+
+		#region FrameFlags
+
+		/// <summary>
+		/// Options of the frame around the chunks of a stream: a header declaring them before the first chunk, and an end after the last one.
+		/// </summary>
+		[Flags]
+		public enum FrameFlags
+		{
+			/// <summary>No frame: the chunks alone, as written by previous versions.</summary>
+			None = 0x00,
+
+			/// <summary>Each chunk is followed by the checksum of its data as stored, checked before decompressing it.</summary>
+			BlockChecksum = 0x01,
+
+			/// <summary>The end of the frame is followed by the checksum of the whole content, checked once the last chunk has been read.</summary>
+			ContentChecksum = 0x02,
+
+			/// <summary>The header declares the length of the content, which is the <see cref="LZ4Stream.Length"/> of the stream before reading it.</summary>
+			ContentSize = 0x04,
+
+			/// <summary>No chunk refers to the previous ones, set by the stream when the chunks are not linked: they can be decompressed at the same time.</summary>
+			IndependentChunks = 0x08,
+
+			/// <summary>The end of the frame is followed by the index of the chunks, their offsets in the content and in the stream, so that the stream
+			/// can seek to any position by decompressing only the chunk holding it (see <see cref="LZ4Stream.CanSeek"/>). The chunks can't be linked.</summary>
+			BlockIndex = 0x10,
 		}
 
 		#endregion
@@ -72,9 +116,42 @@ namespace SiliconStudio.Core.LZ4
         /// </summary>
 	    private readonly bool disposeInnerStream;
 
+	    /// <summary>Whether the chunks refer to the previous ones (compression only).</summary>
+	    private readonly bool linkedChunks;
+
+	    /// <summary>The compression context of the linked chunks, which keeps their history.</summary>
+	    private LZ4CompressionContext linkedContext;
+
+	    /// <summary>Whether a linked chunk has been written since the start of the stream.</summary>
+	    private bool linkedChunksStarted;
+
+	    /// <summary>The dictionary of the chunks, <c>null</c> if none.</summary>
+	    private readonly LZ4Dictionary dictionary;
+
 	    /// <summary>The block size (compression only).</summary>
 		private readonly int blockSize;
 
+		/// <summary>The LZ4HC level or the acceleration of the fast compressor (compression only).</summary>
+		private readonly int compressionLevel;
+
+	    /// <summary>The number of chunks compressed, or decompressed ahead of the reads, at the same time on the thread pool.</summary>
+	    private readonly int threadCount;
+
+	    /// <summary>The chunks being compressed or decompressed on the thread pool, in the order they are written or read (several threads only).</summary>
+	    private readonly Queue<Task<Chunk>> pendingChunks;
+
+	    /// <summary>The buffers of the chunks already written or read, reused by the next ones (several threads only).</summary>
+	    private readonly Stack<byte[]> freeBuffers;
+
+	    /// <summary>The last 64KB of the chunks given to the thread pool, which the next linked chunk refers to (compression only).</summary>
+	    private byte[] pendingHistory;
+
+	    /// <summary>The last chunk given to the thread pool, which the next linked chunk refers to once decompressed (decompression only).</summary>
+	    private Task<Chunk> lastPendingChunk;
+
+	    /// <summary>The end of the data of the last chunk given to the thread pool, in its buffer (decompression only).</summary>
+	    private int lastPendingChunkEnd;
+
         /// <summary>The buffer.</summary>
         private byte[] dataBuffer;
 
@@ -107,6 +184,43 @@ namespace SiliconStudio.Core.LZ4
         /// </summary>
         private readonly long compressedSize;
 
+	    /// <summary>The options of the frame, <see cref="FrameFlags.None"/> if the chunks have none (known once the start of the stream has been read when decompressing).</summary>
+	    private FrameFlags frame;
+
+	    /// <summary>The length of the content declared by the header of the frame, -1 if none (decompression only).</summary>
+	    private long frameContentSize = -1;
+
+	    /// <summary>Whether the header of the frame has been written, or looked for at the start of the stream.</summary>
+	    private bool frameStarted;
+
+	    /// <summary>Whether the end of the frame has been written or read.</summary>
+	    private bool frameEnded;
+
+	    /// <summary>The length of the chunks written, or read, in the frame.</summary>
+	    private long frameChunksLength;
+
+	    /// <summary>The flags of the first chunk, read while looking for the header of the frame, -1 if none (decompression only).</summary>
+	    private long firstChunkFlags = -1;
+
+	    /// <summary>The checksum of the content, written or read so far.</summary>
+	    private LZ4Checksum contentChecksum;
+
+	    /// <summary>The checksum of the content, from the end of the frame (decompression only).</summary>
+	    private uint frameContentChecksum;
+
+	    /// <summary>The offset of the first chunk in the stream, after the header of the frame.</summary>
+	    private long frameHeaderLength;
+
+	    /// <summary>The length of each chunk written, and of the chunk as stored, for the block index (compression only).</summary>
+	    private List<int> indexedChunkLengths;
+	    private List<int> indexedChunkStoredLengths;
+
+	    /// <summary>The position in the content of each chunk of the block index, then the length of the content, <c>null</c> until loaded (decompression only).</summary>
+	    private long[] chunkPositions;
+
+	    /// <summary>The offset in the stream of each chunk of the block index, then the offset of the end of the frame (decompression only).</summary>
+	    private long[] chunkOffsets;
+
 		#endregion
 
 		#region constructor
@@ -118,6 +232,18 @@ namespace SiliconStudio.Core.LZ4
 	    /// <param name="highCompression">if set to <c>true</c> [high compression].</param>
 	    /// <param name="disposeInnerStream">if set to <c>true</c> <paramref name="innerStream"/> is disposed during called to <see cref="Dispose"/></param>
 	    /// <param name="blockSize">Size of the block.</param>
+	    /// <param name="compressionLevel">The LZ4HC level when <paramref name="highCompression"/> is set (see <see cref="LZ4Codec.DefaultCompressionLevelHC"/>),
+	    /// the acceleration of the fast compressor otherwise (see <see cref="LZ4Codec.DefaultAcceleration"/>). 0 selects the default of the mode.</param>
+	    /// <param name="linkedChunks">If set to <c>true</c>, each chunk can refer to the last 64KB of the previous ones, which compresses better than independent
+	    /// chunks, especially small ones, at the same speed. Decompression detects it by itself.</param>
+	    /// <param name="dictionary">The dictionary of the content shared by many small streams, which the compressed chunks refer to (the first one when
+	    /// <paramref name="linkedChunks"/> is set). The stream is decompressed with the same dictionary.</param>
+	    /// <param name="threadCount">The number of chunks compressed, or decompressed ahead of the reads, at the same time on the thread pool, 0 for the number
+	    /// of processors. The chunks are written in order, in the same format as with a single thread: linked ones still refer to the end of the previous chunks,
+	    /// and are decompressed one after the other, ahead of the reads.</param>
+	    /// <param name="frame">The options of the frame written around the chunks (compression only): checksums validating the data before it is used, and the
+	    /// length of the content declared before it, which is then <paramref name="uncompressedSize"/>, and the block index which makes the stream seekable.
+	    /// <see cref="FrameFlags.IndependentChunks"/> is set when <paramref name="linkedChunks"/> isn't. Decompression detects the frame by itself.</param>
 	    public LZ4Stream(
 			Stream innerStream,
 			CompressionMode compressionMode,
@@ -125,15 +251,47 @@ namespace SiliconStudio.Core.LZ4
             long uncompressedSize = -1,
             long compressedSize = -1,
             bool disposeInnerStream = false,
-			int blockSize = 1024*1024)
+			int blockSize = 1024*1024,
+            int compressionLevel = 0,
+            bool linkedChunks = false,
+            LZ4Dictionary dictionary = null,
+            int threadCount = 1,
+            FrameFlags frame = FrameFlags.None)
 		{
 			this.innerStream = innerStream;
 			this.compressionMode = compressionMode;
 			this.highCompression = highCompression;
 		    this.blockSize = Math.Max(16, blockSize);
+		    this.compressionLevel = compressionLevel;
 	        length = uncompressedSize;
 	        this.compressedSize = compressedSize;
             this.disposeInnerStream = disposeInnerStream;
+            this.linkedChunks = linkedChunks;
+            this.dictionary = dictionary;
+            this.threadCount = threadCount > 0 ? threadCount : Environment.ProcessorCount;
+
+            if (this.threadCount > 1)
+            {
+                pendingChunks = new Queue<Task<Chunk>>();
+                freeBuffers = new Stack<byte[]>();
+            }
+
+            if (compressionMode == CompressionMode.Compress && frame != FrameFlags.None)
+            {
+                if ((frame & FrameFlags.ContentSize) != 0 && uncompressedSize < 0)
+                    throw new ArgumentException("The content size of the frame is the uncompressed size, which must be given", "frame");
+                if ((frame & FrameFlags.BlockIndex) != 0 && linkedChunks)
+                    throw new ArgumentException("The chunks of a frame with a block index can't be linked", "frame");
+
+                this.frame = (frame & ~FrameFlags.IndependentChunks) | (linkedChunks ? FrameFlags.None : FrameFlags.IndependentChunks);
+                if ((frame & FrameFlags.ContentChecksum) != 0)
+                    contentChecksum = new LZ4Checksum();
+                if ((frame & FrameFlags.BlockIndex) != 0)
+                {
+                    indexedChunkLengths = new List<int>();
+                    indexedChunkStoredLengths = new List<int>();
+                }
+            }
         }
 
 		#endregion
@@ -157,6 +315,16 @@ namespace SiliconStudio.Core.LZ4
 			return new EndOfStreamException("Unexpected end of stream");
 		}
 
+		/// <summary>Returns the exception of data whose checksum doesn't match.</summary>
+		/// <param name="part">The corrupted part of the stream.</param>
+		/// <returns>InvalidOperationException</returns>
+		private static InvalidOperationException Corrupted(string part)
+		{
+			return new InvalidOperationException(
+				string.Format(
+					"The {0} of the stream is corrupted: its checksum doesn't match", part));
+		}
+
 		/// <summary>Tries to read variable length int.</summary>
 		/// <param name="result">The result.</param>
 		/// <returns><c>true</c> if integer has been read, <c>false</c> if end of stream has been
@@ -236,88 +404,764 @@ namespace SiliconStudio.Core.LZ4
 			}
 		}
 
+		/// <summary>Encodes a variable length integer in a buffer.</summary>
+		/// <param name="buffer">The buffer.</param>
+		/// <param name="offset">The offset of the integer in the buffer.</param>
+		/// <param name="value">The value.</param>
+		/// <returns>The offset after the integer.</returns>
+		private static int PutVarInt(byte[] buffer, int offset, ulong value)
+		{
+			while (true)
+			{
+				var b = (byte)(value & 0x7F);
+				value >>= 7;
+				buffer[offset++] = (byte)(b | (value == 0 ? 0 : 0x80));
+				if (value == 0) return offset;
+			}
+		}
+
+		/// <summary>Writes a 32-bit integer to the inner stream, such as a checksum.</summary>
+		/// <param name="value">The value.</param>
+		private void WriteInnerUInt32(uint value)
+		{
+			var buffer = new[] { (byte)value, (byte)(value >> 8), (byte)(value >> 16), (byte)(value >> 24) };
+			innerStream.Write(buffer, 0, 4);
+			innerStreamPosition += 4;
+		}
+
+		/// <summary>Reads a 32-bit integer from the inner stream, such as a checksum.</summary>
+		/// <returns>The value.</returns>
+		private uint ReadInnerUInt32()
+		{
+			var buffer = new byte[4];
+			if (ReadBlock(buffer, 0, 4) != 4) throw EndOfStream();
+			return buffer[0] | (uint)buffer[1] << 8 | (uint)buffer[2] << 16 | (uint)buffer[3] << 24;
+		}
+
+		/// <summary>Gets the byte of checksum closing the header of a frame.</summary>
+		/// <param name="header">The header.</param>
+		/// <param name="headerLength">The length of the header.</param>
+		/// <returns>The second byte of the checksum of the header, as in the LZ4 frame format.</returns>
+		private static byte HeaderChecksum(byte[] header, int headerLength)
+		{
+			return (byte)(LZ4Codec.Checksum(header, 0, headerLength) >> 8);
+		}
+
+		/// <summary>Writes the header of the frame, before the first chunk.</summary>
+		private void WriteFrameHeader()
+		{
+			// The Frame flag in place of the flags of a chunk, the options of the frame, the length of the content and a byte of checksum
+			var header = new byte[32];
+			var headerLength = PutVarInt(header, 0, (ulong)ChunkFlags.Frame);
+			headerLength = PutVarInt(header, headerLength, (ulong)frame);
+			if ((frame & FrameFlags.ContentSize) != 0)
+				headerLength = PutVarInt(header, headerLength, (ulong)length);
+			header[headerLength] = HeaderChecksum(header, headerLength);
+
+			innerStream.Write(header, 0, headerLength + 1);
+			innerStreamPosition += headerLength + 1;
+			frameStarted = true;
+			frameHeaderLength = innerStreamPosition;
+		}
+
+		/// <summary>Writes the end of the frame, after the last chunk.</summary>
+		private void WriteFrameEnd()
+		{
+			if (frame == FrameFlags.None || frameEnded) return;
+
+			if ((frame & FrameFlags.ContentSize) != 0 && frameChunksLength != length)
+				throw new InvalidOperationException(string.Format("The content of the frame is {0} bytes long instead of the {1} bytes declared", frameChunksLength, length));
+			if (!frameStarted)
+				WriteFrameHeader();
+
+			// The Frame flag again, and the checksum of the content
+			WriteVarInt((ulong)ChunkFlags.Frame);
+			if (contentChecksum != null)
+				WriteInnerUInt32(contentChecksum.Value);
+			if (indexedChunkLengths != null)
+				WriteBlockIndex();
+			frameEnded = true;
+		}
+
+		/// <summary>Writes the block index, after the end of the frame.</summary>
+		private void WriteBlockIndex()
+		{
+			// The number of chunks, the length of each chunk and of the chunk as stored, then the length of the index so that it is found from the end of the stream
+			var index = new byte[10 + indexedChunkLengths.Count * 10];
+			var indexLength = PutVarInt(index, 0, (ulong)indexedChunkLengths.Count);
+			for (int i = 0; i < indexedChunkLengths.Count; i++)
+			{
+				indexLength = PutVarInt(index, indexLength, (ulong)indexedChunkLengths[i]);
+				indexLength = PutVarInt(index, indexLength, (ulong)indexedChunkStoredLengths[i]);
+			}
+
+			innerStream.Write(index, 0, indexLength);
+			innerStreamPosition += indexLength;
+			WriteInnerUInt32((uint)indexLength);
+		}
+
+		/// <summary>Loads the block index from the end of the stream, if the stream can seek.</summary>
+		/// <returns><c>true</c> if the block index has been loaded.</returns>
+		private bool LoadBlockIndex()
+		{
+			if (chunkPositions != null) return true;
+			if (!CanSeek) return false;
+
+			var previousPosition = innerStreamPosition;
+			SeekInnerStream(compressedSize - 4);
+			var indexLength = ReadInnerUInt32();
+			if (indexLength > compressedSize - 4 - frameHeaderLength) throw EndOfStream(); // corrupted
+			SeekInnerStream(compressedSize - 4 - indexLength);
+
+			var count = (long)ReadVarInt();
+			if (count > indexLength) throw EndOfStream(); // corrupted
+			var positions = new long[count + 1];
+			var offsets = new long[count + 1];
+			offsets[0] = frameHeaderLength;
+			for (long i = 0; i < count; i++)
+			{
+				positions[i + 1] = positions[i] + (long)ReadVarInt();
+				offsets[i + 1] = offsets[i] + (long)ReadVarInt();
+			}
+			if (offsets[count] >= compressedSize - 4 - indexLength) throw EndOfStream(); // corrupted
+
+			SeekInnerStream(previousPosition);
+			chunkPositions = positions;
+			chunkOffsets = offsets;
+			return true;
+		}
+
+		/// <summary>Moves the inner stream to an offset from the start of the stream.</summary>
+		/// <param name="offset">The offset.</param>
+		private void SeekInnerStream(long offset)
+		{
+			innerStream.Seek(offset - innerStreamPosition, SeekOrigin.Current);
+			innerStreamPosition = offset;
+		}
+
+		/// <summary>Moves to a position in the content by decompressing only the chunk holding it, found in the block index.</summary>
+		/// <param name="newPosition">The position.</param>
+		private void SeekChunk(long newPosition)
+		{
+			// The chunk holding the position, or the end of the chunks
+			var chunkIndex = Array.BinarySearch(chunkPositions, newPosition);
+			if (chunkIndex < 0)
+				chunkIndex = Math.Max(0, ~chunkIndex - 1);
+
+			DropPendingChunks();
+			SeekInnerStream(chunkOffsets[chunkIndex]);
+			position = chunkPositions[chunkIndex];
+			bufferOffset = bufferLength = 0;
+			frameChunksLength = position;
+			frameEnded = false;
+
+			// The checksum of the content can't be checked anymore, only the one of the chunks
+			if (contentChecksum != null)
+			{
+				contentChecksum.Dispose();
+				contentChecksum = null;
+			}
+
+			Skip(newPosition - position);
+		}
+
+		/// <summary>Moves forward in the content by decompressing the chunks up to the new position, or up to the end of the stream.</summary>
+		/// <param name="count">The length to skip.</param>
+		private void Skip(long count)
+		{
+			while (count > 0)
+			{
+				var chunk = (int)Math.Min(count, bufferLength - bufferOffset);
+				if (chunk > 0)
+				{
+					bufferOffset += chunk;
+					position += chunk;
+					count -= chunk;
+				}
+				else if (AcquireNextChunk(IntPtr.Zero, 0, 0) < 0)
+				{
+					break;
+				}
+			}
+		}
+
 		/// <summary>Flushes current chunk.</summary>
 		private void FlushCurrentChunk()
 		{
 			if (bufferOffset <= 0) return;
 
-			var compressed = new byte[bufferOffset];
-			var compressedLength = highCompression
-				? LZ4Codec.EncodeHC(dataBuffer, 0, bufferOffset, compressed, 0, bufferOffset)
-				: LZ4Codec.Encode(dataBuffer, 0, bufferOffset, compressed, 0, bufferOffset);
+			// Linked chunks: only the first one refers to the dictionary, the next ones to the previous chunks
+			var chunk = new Chunk { Data = dataBuffer, Length = bufferOffset, RefersToDictionary = dictionary != null && !(linkedChunks && linkedChunksStarted) };
+			linkedChunksStarted = true;
+			bufferOffset = 0;
+
+			if (contentChecksum != null)
+				contentChecksum.Update(chunk.Data, 0, chunk.Length);
+
+			if (pendingChunks == null)
+			{
+				if (linkedChunks)
+				{
+					// The following chunks refer to this one even if it is stored uncompressed, so the context must see it whole
+					if (linkedContext == null)
+						linkedContext = new LZ4CompressionContext(highCompression);
+					chunk.Compressed = new byte[LZ4Codec.MaximumOutputLength(chunk.Length)];
+					chunk.CompressedLength = linkedContext.EncodeLinked(chunk.Data, 0, chunk.Length, chunk.Compressed, 0, chunk.Compressed.Length, compressionLevel, dictionary);
+				}
+				else
+				{
+					CompressIndependentChunk(chunk);
+				}
+
+				WriteChunk(chunk);
+				return;
+			}
+
+			// The chunk is compressed on the thread pool with its own copy of the history, and the stream goes on with another buffer
+			var history = pendingHistory;
+			if (linkedChunks)
+				pendingHistory = NextHistory(history, chunk.Data, chunk.Length);
+			pendingChunks.Enqueue(Task.Factory.StartNew(() => CompressPendingChunk(chunk, history)));
+			dataBuffer = TakeBuffer(blockSize);
+
+			while (pendingChunks.Count >= threadCount)
+				WriteChunk(pendingChunks.Dequeue().Result);
+		}
+
+		/// <summary>Writes the chunks still compressed on the thread pool.</summary>
+		private void FlushPendingChunks()
+		{
+			if (pendingChunks == null) return;
+
+			while (pendingChunks.Count > 0)
+				WriteChunk(pendingChunks.Dequeue().Result);
+		}
+
+		/// <summary>Compresses a chunk as an independent block, which can refer to the dictionary.</summary>
+		/// <param name="chunk">The chunk.</param>
+		private void CompressIndependentChunk(Chunk chunk)
+		{
+			chunk.Compressed = new byte[chunk.Length];
+			if (chunk.RefersToDictionary)
+			{
+				chunk.CompressedLength = highCompression
+					? LZ4Codec.EncodeHC(chunk.Data, 0, chunk.Length, chunk.Compressed, 0, chunk.Length, dictionary, compressionLevel)
+					: LZ4Codec.Encode(chunk.Data, 0, chunk.Length, chunk.Compressed, 0, chunk.Length, dictionary, compressionLevel);
+			}
+			else
+			{
+				chunk.CompressedLength = highCompression
+					? LZ4Codec.EncodeHC(chunk.Data, 0, chunk.Length, chunk.Compressed, 0, chunk.Length, compressionLevel)
+					: LZ4Codec.Encode(chunk.Data, 0, chunk.Length, chunk.Compressed, 0, chunk.Length, compressionLevel);
+			}
+		}
+
+		/// <summary>Compresses a chunk on the thread pool, with the compression tables of the current thread.</summary>
+		/// <param name="chunk">The chunk.</param>
+		/// <param name="history">The last 64KB of the previous chunks when they are linked, <c>null</c> for the first chunk.</param>
+		/// <returns>The chunk.</returns>
+		private Chunk CompressPendingChunk(Chunk chunk, byte[] history)
+		{
+			if (!linkedChunks)
+			{
+				CompressIndependentChunk(chunk);
+				return chunk;
+			}
+
+			var context = LZ4Codec.GetThreadContext(highCompression);
+			chunk.Compressed = new byte[LZ4Codec.MaximumOutputLength(chunk.Length)];
+			chunk.CompressedLength = history == null
+				? context.Encode(chunk.Data, 0, chunk.Length, chunk.Compressed, 0, chunk.Compressed.Length, compressionLevel, chunk.RefersToDictionary ? dictionary : null)
+				: context.EncodeLinked(history, 0, history.Length, chunk.Data, 0, chunk.Length, chunk.Compressed, 0, chunk.Compressed.Length, compressionLevel);
+			return chunk;
+		}
 
-			if (compressedLength <= 0 || compressedLength >= bufferOffset)
+		/// <summary>Gets the last 64KB of the chunks, once another one is added.</summary>
+		/// <param name="history">The last 64KB of the previous chunks, <c>null</c> if none.</param>
+		/// <param name="data">The data of the added chunk.</param>
+		/// <param name="dataLength">The length of the added chunk.</param>
+		/// <returns>The new history.</returns>
+		private static byte[] NextHistory(byte[] history, byte[] data, int dataLength)
+		{
+			var previousLength = history != null ? history.Length : 0;
+			var result = new byte[Math.Min(LZ4Codec.LinkedHistoryLength, previousLength + dataLength)];
+			var fromData = Math.Min(dataLength, result.Length);
+			var fromHistory = result.Length - fromData;
+			if (fromHistory > 0)
+				Buffer.BlockCopy(history, previousLength - fromHistory, result, 0, fromHistory);
+			Buffer.BlockCopy(data, dataLength - fromData, result, fromHistory, fromData);
+			return result;
+		}
+
+		/// <summary>Writes a compressed chunk, or its data if it doesn't compress.</summary>
+		/// <param name="chunk">The chunk.</param>
+		private void WriteChunk(Chunk chunk)
+		{
+			var compressed = chunk.Compressed;
+			var compressedLength = chunk.CompressedLength;
+			if (compressedLength <= 0 || compressedLength >= chunk.Length)
 			{
 				// uncompressible block
-				compressed = dataBuffer;
-				compressedLength = bufferOffset;
+				compressed = chunk.Data;
+				compressedLength = chunk.Length;
 			}
 
-			var isCompressed = compressedLength < bufferOffset;
+			var isCompressed = compressedLength < chunk.Length;
 
 			var flags = ChunkFlags.None;
 
 			if (isCompressed) flags |= ChunkFlags.Compressed;
 			if (highCompression) flags |= ChunkFlags.HighCompression;
+			if (linkedChunks) flags |= ChunkFlags.Linked;
+			if (chunk.RefersToDictionary && isCompressed) flags |= ChunkFlags.Dictionary;
+
+			if (frame != FrameFlags.None && !frameStarted)
+				WriteFrameHeader();
 
+			var chunkOffset = innerStreamPosition;
 			WriteVarInt((ulong)flags);
-			WriteVarInt((ulong)bufferOffset);
+			WriteVarInt((ulong)chunk.Length);
 			if (isCompressed) WriteVarInt((ulong)compressedLength);
 
             innerStream.Write(compressed, 0, compressedLength);
             innerStreamPosition += compressedLength;
 
-			bufferOffset = 0;
+			if ((frame & FrameFlags.BlockChecksum) != 0)
+				WriteInnerUInt32(LZ4Codec.Checksum(compressed, 0, compressedLength));
+			frameChunksLength += chunk.Length;
+
+			if (indexedChunkLengths != null)
+			{
+				indexedChunkLengths.Add(chunk.Length);
+				indexedChunkStoredLengths.Add((int)(innerStreamPosition - chunkOffset));
+			}
+
+			// The buffer of a chunk compressed on the thread pool is free again
+			if (freeBuffers != null)
+				ReleaseBuffer(chunk.Data);
 		}
 
-		/// <summary>Reads the next chunk from stream.</summary>
-		/// <returns><c>true</c> if next has been read, or <c>false</c> if it is legitimate end of file.
-		/// Throws <see cref="EndOfStreamException"/> if end of stream was unexpected.</returns>
-		private bool AcquireNextChunk()
+		/// <summary>Reads the next chunk from stream, decompressing it directly into the destination of the read when it fits there whole.</summary>
+		/// <param name="destination">The destination of the read.</param>
+		/// <param name="destinationLength">The length left in the destination, 0 to read the chunk into the buffer of the stream.</param>
+		/// <param name="precedingLength">The length of the data of the stream read just before the destination, in the same memory.</param>
+		/// <returns>The length of the chunk if it has been decompressed into the destination, 0 if it has been read into the buffer of the stream,
+		/// or -1 if it is legitimate end of file. Throws <see cref="EndOfStreamException"/> if end of stream was unexpected.</returns>
+		private int AcquireNextChunk(IntPtr destination, int destinationLength, int precedingLength)
 		{
+			if (pendingChunks != null && pendingChunks.Count > 0)
+				return AcquireNextPendingChunk() ? 0 : EndOfChunks();
+
 			do
 			{
-				ulong varint;
-				if (!TryReadVarInt(out varint)) return false;
-				var flags = (ChunkFlags)varint;
+				ChunkFlags flags;
+				int originalLength, compressedLength;
+				if (!TryReadChunkHeader(out flags, out originalLength, out compressedLength)) return EndOfChunks();
 				var isCompressed = (flags & ChunkFlags.Compressed) != 0;
-
-				var originalLength = (int)ReadVarInt();
-				var compressedLength = isCompressed ? (int)ReadVarInt() : originalLength;
-				if (compressedLength > originalLength) throw EndOfStream(); // corrupted
+				var isLinked = (flags & ChunkFlags.Linked) != 0;
+				var refersToDictionary = (flags & ChunkFlags.Dictionary) != 0;
 
                 if (compressedDataBuffer == null || compressedDataBuffer.Length < compressedLength)
-                    compressedDataBuffer = new byte[compressedLength];
-                var chunk = ReadBlock(compressedDataBuffer, 0, compressedLength);
+                    compressedDataBuffer = freeBuffers != null ? TakeBuffer(compressedLength) : new byte[compressedLength];
+                var checksum = ReadChunkData(compressedDataBuffer, compressedLength);
+
+				// A whole chunk is decompressed directly into the destination, without going through the buffer of the stream
+				var decompressesDirectly = isCompressed && originalLength > 0 && originalLength <= destinationLength;
 
-				if (chunk != compressedLength) throw EndOfStream(); // currupted
+				if (pendingChunks != null && !decompressesDirectly)
+				{
+					// Smaller reads go through the chunks decompressed ahead, starting with this one
+					QueuePendingChunk(new Chunk { Flags = flags, Length = originalLength, CompressedLength = compressedLength, Compressed = compressedDataBuffer, Checksum = checksum });
+					compressedDataBuffer = null;
+					return AcquireNextPendingChunk() ? 0 : EndOfChunks();
+				}
+
+				VerifyChunk(compressedDataBuffer, compressedLength, checksum);
+
+				if (decompressesDirectly)
+				{
+					DecompressChunk(flags, originalLength, compressedLength, destination, precedingLength);
+					if (contentChecksum != null)
+						contentChecksum.Update(destination, originalLength);
+					return originalLength;
+				}
 
-				if (!isCompressed)
+				if (isLinked)
+				{
+					// The data of the chunk follows the end of the previous ones (bufferLength being the end of the last one), which its matches refer to,
+					// unless it refers to the dictionary and starts a new sequence
+					var historyLength = refersToDictionary ? 0 : Math.Min(bufferLength, LZ4Codec.LinkedHistoryLength);
+					var previousDataBuffer = dataBuffer;
+					if (dataBuffer == null || dataBuffer.Length < historyLength + originalLength)
+						dataBuffer = new byte[LZ4Codec.LinkedHistoryLength + originalLength];
+					if (historyLength > 0)
+						Buffer.BlockCopy(previousDataBuffer, bufferLength - historyLength, dataBuffer, 0, historyLength);
+
+					if (refersToDictionary)
+						LZ4Codec.Decode(compressedDataBuffer, 0, compressedLength, dataBuffer, 0, originalLength, dictionary, true);
+					else if (isCompressed)
+						LZ4Codec.DecodeLinked(compressedDataBuffer, 0, compressedLength, dataBuffer, historyLength, originalLength, historyLength, true);
+					else
+						Buffer.BlockCopy(compressedDataBuffer, 0, dataBuffer, historyLength, originalLength);
+
+					bufferOffset = historyLength;
+					bufferLength = historyLength + originalLength;
+				}
+				else if (!isCompressed)
 				{
                     // swap the buffers
 				    var oldDataBuffer = dataBuffer;
                     dataBuffer = compressedDataBuffer; // no compression on this chunk
 				    compressedDataBuffer = oldDataBuffer; // ensure that compressedDataBuffer and dataBuffer are different
 
+					bufferOffset = 0;
 					bufferLength = compressedLength;
 				}
 				else
 				{
 					if (dataBuffer == null || dataBuffer.Length < originalLength)
 						dataBuffer = new byte[originalLength];
-					var passes = (int)flags >> 2;
-					if (passes != 0)
-						throw new NotSupportedException("Chunks with multiple passes are not supported.");
-					LZ4Codec.Decode(compressedDataBuffer, 0, compressedLength, dataBuffer, 0, originalLength, true);
+					if (refersToDictionary)
+						LZ4Codec.Decode(compressedDataBuffer, 0, compressedLength, dataBuffer, 0, originalLength, dictionary, true);
+					else
+						LZ4Codec.Decode(compressedDataBuffer, 0, compressedLength, dataBuffer, 0, originalLength, true);
+					bufferOffset = 0;
 					bufferLength = originalLength;
 				}
 
-				bufferOffset = 0;
-			} while (bufferLength == 0); // skip empty block (shouldn't happen but...)
+				if (contentChecksum != null)
+					contentChecksum.Update(dataBuffer, bufferOffset, bufferLength - bufferOffset);
+			} while (bufferOffset == bufferLength); // skip empty block (shouldn't happen but...)
+
+			return 0;
+		}
+
+		/// <summary>Checks the content once the last chunk has been read.</summary>
+		/// <returns>-1, as the end of file.</returns>
+		private int EndOfChunks()
+		{
+			// The end of the frame has been read, with the checksum of the whole content
+			if (contentChecksum != null && contentChecksum.Value != frameContentChecksum)
+				throw Corrupted("content");
+
+			return -1;
+		}
+
+		/// <summary>Decompresses a chunk directly into the destination of a read, and keeps the end of the data for the next linked chunk.</summary>
+		/// <param name="flags">The flags of the chunk.</param>
+		/// <param name="originalLength">The length of the chunk.</param>
+		/// <param name="compressedLength">The length of the chunk as stored, in <see cref="compressedDataBuffer"/>.</param>
+		/// <param name="destination">The destination, at least <paramref name="originalLength"/> long.</param>
+		/// <param name="precedingLength">The length of the data of the stream read just before the destination, in the same memory.</param>
+		private unsafe void DecompressChunk(ChunkFlags flags, int originalLength, int compressedLength, IntPtr destination, int precedingLength)
+		{
+			var isLinked = (flags & ChunkFlags.Linked) != 0;
+			var refersToDictionary = (flags & ChunkFlags.Dictionary) != 0;
+			var historyLength = isLinked && !refersToDictionary ? Math.Min(bufferLength, LZ4Codec.LinkedHistoryLength) : 0;
+
+			fixed (byte* pData = dataBuffer)
+			{
+				int decodedLength;
+				if (refersToDictionary)
+				{
+					decodedLength = LZ4Codec.Decode(compressedDataBuffer, 0, compressedLength, destination, originalLength, dictionary.Pointer, dictionary.Length);
+				}
+				else
+				{
+					// The end of the previous chunks is also just before the destination when they have been read there, which decodes faster
+					var history = historyLength == 0 ? IntPtr.Zero : precedingLength >= historyLength ? destination - historyLength : (IntPtr)pData + bufferLength - historyLength;
+					decodedLength = LZ4Codec.Decode(compressedDataBuffer, 0, compressedLength, destination, originalLength, history, historyLength);
+				}
+
+				if (decodedLength != originalLength) throw EndOfStream(); // corrupted
+			}
+
+			if (!isLinked)
+			{
+				bufferOffset = bufferLength = 0;
+				return;
+			}
+
+			// The destination belongs to the caller: the end of the data is copied for the next chunk, at the start of the buffer of the stream
+			var keptLength = Math.Min(historyLength + originalLength, LZ4Codec.LinkedHistoryLength);
+			var fromChunk = Math.Min(originalLength, keptLength);
+			var fromHistory = keptLength - fromChunk;
+			var previousDataBuffer = dataBuffer;
+			if (dataBuffer == null || dataBuffer.Length < keptLength)
+				dataBuffer = new byte[LZ4Codec.LinkedHistoryLength];
+			if (fromHistory > 0)
+				Buffer.BlockCopy(previousDataBuffer, bufferLength - fromHistory, dataBuffer, 0, fromHistory);
+			fixed (byte* pData = dataBuffer)
+			{
+				Utilities.CopyMemory((IntPtr)pData + fromHistory, destination + originalLength - fromChunk, fromChunk);
+			}
+
+			bufferOffset = bufferLength = keptLength;
+
+			// The next chunk read ahead refers to this buffer instead of the last one given to the thread pool
+			lastPendingChunk = null;
+		}
+
+		/// <summary>Reads the header of the next chunk.</summary>
+		/// <param name="flags">The flags of the chunk.</param>
+		/// <param name="originalLength">The length of the chunk.</param>
+		/// <param name="compressedLength">The length of the chunk as stored.</param>
+		/// <returns><c>true</c> if the header has been read, or <c>false</c> if it is legitimate end of file.</returns>
+		private bool TryReadChunkHeader(out ChunkFlags flags, out int originalLength, out int compressedLength)
+		{
+			flags = ChunkFlags.None;
+			originalLength = compressedLength = 0;
+
+			// Anything after the end of the frame isn't part of the stream
+			if (frameEnded) return false;
+
+			ulong varint;
+			if (!TryReadChunkFlags(out varint))
+			{
+				if (frame != FrameFlags.None) throw EndOfStream(); // the end of the frame is missing
+				return false;
+			}
+
+			flags = (ChunkFlags)varint;
+			if ((flags & ChunkFlags.Frame) != 0)
+			{
+				if (flags != ChunkFlags.Frame || frame == FrameFlags.None) throw EndOfStream(); // corrupted
+				ReadFrameEnd();
+				return false;
+			}
+
+			var isCompressed = (flags & ChunkFlags.Compressed) != 0;
+
+			originalLength = (int)ReadVarInt();
+			compressedLength = isCompressed ? (int)ReadVarInt() : originalLength;
+			if (compressedLength > originalLength) throw EndOfStream(); // corrupted
+
+			var passes = (int)(flags & ChunkFlags.Passes) >> 2;
+			if (passes != 0)
+				throw new NotSupportedException("Chunks with multiple passes are not supported.");
+			if ((flags & ChunkFlags.Dictionary) != 0 && (dictionary == null || !isCompressed))
+				throw new InvalidOperationException("The chunk refers to a dictionary that has not been given to the stream.");
+
+			frameChunksLength += originalLength;
+			if ((frame & FrameFlags.ContentSize) != 0 && frameChunksLength > frameContentSize)
+				throw EndOfStream(); // corrupted
+			if ((frame & FrameFlags.IndependentChunks) != 0 && (flags & ChunkFlags.Linked) != 0)
+				throw EndOfStream(); // corrupted
+
+			return true;
+		}
+
+		/// <summary>Reads the flags of the next chunk, once the header of the frame has been looked for at the start of the stream.</summary>
+		/// <param name="flags">The flags.</param>
+		/// <returns><c>true</c> if the flags have been read, or <c>false</c> if it is legitimate end of file.</returns>
+		private bool TryReadChunkFlags(out ulong flags)
+		{
+			if (!frameStarted)
+				StartReadingFrame();
+
+			if (firstChunkFlags >= 0)
+			{
+				flags = (ulong)firstChunkFlags;
+				firstChunkFlags = -1;
+				return true;
+			}
+
+			return TryReadVarInt(out flags);
+		}
+
+		/// <summary>Reads the header of the frame at the start of the stream, if any.</summary>
+		private void StartReadingFrame()
+		{
+			frameStarted = true;
 
+			ulong flags;
+			if (!TryReadVarInt(out flags)) return;
+			if (flags != (ulong)ChunkFlags.Frame)
+			{
+				// The chunks have no frame, as written by previous versions
+				firstChunkFlags = (long)flags;
+				return;
+			}
+
+			var header = new byte[32];
+			var headerLength = PutVarInt(header, 0, flags);
+			var options = ReadVarInt();
+			headerLength = PutVarInt(header, headerLength, options);
+			frame = (FrameFlags)options;
+			if ((frame & ~(FrameFlags.BlockChecksum | FrameFlags.ContentChecksum | FrameFlags.ContentSize | FrameFlags.IndependentChunks | FrameFlags.BlockIndex)) != 0)
+				throw new NotSupportedException("The frame has options that are not supported.");
+
+			if ((frame & FrameFlags.ContentSize) != 0)
+			{
+				var contentSize = ReadVarInt();
+				headerLength = PutVarInt(header, headerLength, contentSize);
+				frameContentSize = (long)contentSize;
+			}
+
+			if (ReadBlock(header, headerLength, 1) != 1) throw EndOfStream();
+			if (header[headerLength] != HeaderChecksum(header, headerLength))
+				throw Corrupted("frame header");
+			frameHeaderLength = innerStreamPosition;
+
+			if ((frame & FrameFlags.ContentChecksum) == 0)
+			{
+				if (contentChecksum != null)
+					contentChecksum.Dispose();
+				contentChecksum = null;
+			}
+			else if (contentChecksum == null)
+			{
+				contentChecksum = new LZ4Checksum();
+			}
+			else
+			{
+				contentChecksum.Reset();
+			}
+		}
+
+		/// <summary>Reads the end of the frame, after the last chunk.</summary>
+		private void ReadFrameEnd()
+		{
+			if ((frame & FrameFlags.ContentChecksum) != 0)
+				frameContentChecksum = ReadInnerUInt32();
+			if ((frame & FrameFlags.ContentSize) != 0 && frameChunksLength != frameContentSize)
+				throw EndOfStream(); // corrupted
+			frameEnded = true;
+		}
+
+		/// <summary>Reads the data of a chunk as stored, and its checksum.</summary>
+		/// <param name="buffer">The buffer.</param>
+		/// <param name="length">The length of the data as stored.</param>
+		/// <returns>The checksum following the data, 0 if the frame has none.</returns>
+		private uint ReadChunkData(byte[] buffer, int length)
+		{
+			if (ReadBlock(buffer, 0, length) != length) throw EndOfStream(); // currupted
+
+			return (frame & FrameFlags.BlockChecksum) != 0 ? ReadInnerUInt32() : 0;
+		}
+
+		/// <summary>Checks the data of a chunk as stored before decompressing it, if the frame has checksums.</summary>
+		/// <param name="buffer">The buffer.</param>
+		/// <param name="length">The length of the data as stored.</param>
+		/// <param name="checksum">The checksum following the data.</param>
+		private void VerifyChunk(byte[] buffer, int length, uint checksum)
+		{
+			if ((frame & FrameFlags.BlockChecksum) != 0 && LZ4Codec.Checksum(buffer, 0, length) != checksum)
+				throw Corrupted("chunk");
+		}
+
+		/// <summary>Takes the next chunk decompressed on the thread pool, and reads the following ones ahead.</summary>
+		/// <returns><c>true</c> if next has been read, or <c>false</c> if it is legitimate end of file.</returns>
+		private bool AcquireNextPendingChunk()
+		{
+			do
+			{
+				ReadAhead();
+				if (pendingChunks.Count == 0) return false;
+
+				var chunk = pendingChunks.Dequeue().Result;
+
+				// The previous chunk has been referred to by this one, and the compressed data is decompressed: both buffers are free again
+				ReleaseBuffer(dataBuffer);
+				ReleaseBuffer(chunk.Compressed);
+				chunk.Compressed = null;
+
+				dataBuffer = chunk.Data;
+				bufferOffset = chunk.Offset;
+				bufferLength = chunk.Offset + chunk.Length;
+
+				if (contentChecksum != null)
+					contentChecksum.Update(dataBuffer, bufferOffset, chunk.Length);
+			} while (bufferOffset == bufferLength); // skip empty block (shouldn't happen but...)
+
+			ReadAhead();
 			return true;
 		}
 
+		/// <summary>Reads the next chunks from stream, up to <see cref="threadCount"/> of them, and decompresses them on the thread pool.</summary>
+		private void ReadAhead()
+		{
+			while (pendingChunks.Count < threadCount)
+			{
+				ChunkFlags flags;
+				int originalLength, compressedLength;
+				if (!TryReadChunkHeader(out flags, out originalLength, out compressedLength)) return;
+
+				var chunk = new Chunk { Flags = flags, Length = originalLength, CompressedLength = compressedLength, Compressed = TakeBuffer(compressedLength) };
+				chunk.Checksum = ReadChunkData(chunk.Compressed, compressedLength);
+
+				QueuePendingChunk(chunk);
+			}
+		}
+
+		/// <summary>Decompresses a chunk on the thread pool, once the previous one is when it is linked.</summary>
+		/// <param name="chunk">The chunk, whose compressed data has been read.</param>
+		private void QueuePendingChunk(Chunk chunk)
+		{
+			// The data of a linked chunk follows the end of the previous ones, which its matches refer to, unless it refers to the dictionary.
+			// The end of the previous ones is in the last chunk given to the thread pool, or in the buffer of the stream after a read directly into its destination.
+			var previousChunk = lastPendingChunk;
+			if ((chunk.Flags & ChunkFlags.Linked) != 0 && (chunk.Flags & ChunkFlags.Dictionary) == 0)
+				chunk.Offset = Math.Min(previousChunk != null ? lastPendingChunkEnd : bufferLength, LZ4Codec.LinkedHistoryLength);
+			chunk.Data = TakeBuffer(chunk.Offset + chunk.Length);
+			lastPendingChunkEnd = chunk.Offset + chunk.Length;
+
+			if (chunk.Offset > 0 && previousChunk == null)
+				Buffer.BlockCopy(dataBuffer, bufferLength - chunk.Offset, chunk.Data, 0, chunk.Offset);
+
+			lastPendingChunk = chunk.Offset > 0 && previousChunk != null
+				? previousChunk.ContinueWith(previous => DecompressPendingChunk(chunk, previous.Result))
+				: Task.Factory.StartNew(() => DecompressPendingChunk(chunk, null));
+			pendingChunks.Enqueue(lastPendingChunk);
+		}
+
+		/// <summary>Decompresses a chunk on the thread pool.</summary>
+		/// <param name="chunk">The chunk.</param>
+		/// <param name="previousChunk">The previous chunk, whose end a linked chunk refers to, <c>null</c> if none or if its end has already been copied.</param>
+		/// <returns>The chunk.</returns>
+		private Chunk DecompressPendingChunk(Chunk chunk, Chunk previousChunk)
+		{
+			VerifyChunk(chunk.Compressed, chunk.CompressedLength, chunk.Checksum);
+
+			if (previousChunk != null)
+				Buffer.BlockCopy(previousChunk.Data, previousChunk.Offset + previousChunk.Length - chunk.Offset, chunk.Data, 0, chunk.Offset);
+
+			if ((chunk.Flags & ChunkFlags.Compressed) == 0)
+				Buffer.BlockCopy(chunk.Compressed, 0, chunk.Data, chunk.Offset, chunk.Length);
+			else if ((chunk.Flags & ChunkFlags.Dictionary) != 0)
+				LZ4Codec.Decode(chunk.Compressed, 0, chunk.CompressedLength, chunk.Data, 0, chunk.Length, dictionary, true);
+			else if (chunk.Offset > 0)
+				LZ4Codec.DecodeLinked(chunk.Compressed, 0, chunk.CompressedLength, chunk.Data, chunk.Offset, chunk.Length, chunk.Offset, true);
+			else
+				LZ4Codec.Decode(chunk.Compressed, 0, chunk.CompressedLength, chunk.Data, 0, chunk.Length, true);
+
+			return chunk;
+		}
+
+		/// <summary>Takes a free buffer of a chunk, or allocates one.</summary>
+		/// <param name="length">The minimum length of the buffer.</param>
+		/// <returns>The buffer.</returns>
+		private byte[] TakeBuffer(int length)
+		{
+			while (freeBuffers.Count > 0)
+			{
+				var buffer = freeBuffers.Pop();
+				if (buffer.Length >= length)
+					return buffer;
+			}
+
+			// Large enough for any block and its history, so that the buffers go round
+			return new byte[Math.Max(length, compressionMode == CompressionMode.Compress ? blockSize : blockSize + LZ4Codec.LinkedHistoryLength)];
+		}
+
+		/// <summary>Gives back the buffer of a chunk, to be reused by the next ones.</summary>
+		/// <param name="buffer">The buffer, <c>null</c> if none.</param>
+		private void ReleaseBuffer(byte[] buffer)
+		{
+			if (buffer != null && freeBuffers.Count < 2 * threadCount)
+				freeBuffers.Push(buffer);
+		}
+
 		#endregion
 
 		#region overrides
@@ -331,9 +1175,10 @@ namespace SiliconStudio.Core.LZ4
 
 		/// <summary>When overridden in a derived class, gets a value indicating whether the current stream supports seeking.</summary>
 		/// <returns>true if the stream supports seeking; otherwise, false.</returns>
+		/// <remarks>When decompressing a frame with a block index (see <see cref="FrameFlags.BlockIndex"/>) from a stream which can seek, with the compressed size.</remarks>
 		public override bool CanSeek
 		{
-			get { return false; }
+			get { return CanRead && compressedSize >= 0 && innerStream.CanSeek && (Frame & FrameFlags.BlockIndex) != 0; }
 		}
 
 		/// <summary>When overridden in a derived class, gets a value indicating whether the current stream supports writing.</summary>
@@ -346,14 +1191,37 @@ namespace SiliconStudio.Core.LZ4
 		/// <summary>When overridden in a derived class, clears all buffers for this stream and causes any buffered data to be written to the underlying device.</summary>
 		public override void Flush()
 		{
-			if (bufferOffset > 0 && CanWrite) FlushCurrentChunk();
+			if (!CanWrite) return;
+			if (bufferOffset > 0) FlushCurrentChunk();
+			FlushPendingChunks();
 		}
 
 		/// <summary>When overridden in a derived class, gets the length in bytes of the stream.</summary>
 		/// <returns>A long value representing the length of the stream in bytes.</returns>
+		/// <remarks>When decompressing without the uncompressed size, the length declared by the frame (see <see cref="FrameFlags.ContentSize"/>),
+		/// read from the start of the stream, or the one of the block index, or -1.</remarks>
 		public override long Length
 		{
-			get { return length; }
+			get
+			{
+				if (length < 0 && CanRead && !frameStarted)
+					StartReadingFrame();
+				if (length < 0 && frameContentSize < 0 && CanRead && LoadBlockIndex())
+					return chunkPositions[chunkPositions.Length - 1];
+				return length >= 0 ? length : frameContentSize;
+			}
+		}
+
+		/// <summary>Gets the options of the frame around the chunks, <see cref="FrameFlags.None"/> if they have none.</summary>
+		/// <remarks>When decompressing, they are read from the start of the stream.</remarks>
+		public FrameFlags Frame
+		{
+			get
+			{
+				if (CanRead && !frameStarted)
+					StartReadingFrame();
+				return frame;
+			}
 		}
 
 		/// <summary>The position in the uncompressed stream.</summary>
@@ -361,7 +1229,7 @@ namespace SiliconStudio.Core.LZ4
 		public override long Position
 		{
 			get { return position; }
-			set { throw NotSupported("SetPosition"); }
+			set { Seek(value, SeekOrigin.Begin); }
 		}
 
 		/// <summary>Reads a byte from the stream and advances the position within the stream by one byte, or returns -1 if at the end of the stream.</summary>
@@ -370,8 +1238,11 @@ namespace SiliconStudio.Core.LZ4
 		{
 			if (!CanRead) throw NotSupported("Read");
 
-			if (bufferOffset >= bufferLength && !AcquireNextChunk())
-				return -1; // that's just end of stream
+			while (bufferOffset >= bufferLength)
+			{
+				if (AcquireNextChunk(IntPtr.Zero, 0, 0) < 0)
+					return -1; // that's just end of stream
+			}
             
             position += 1;
 
@@ -383,42 +1254,35 @@ namespace SiliconStudio.Core.LZ4
 		/// <param name="offset">The zero-based byte offset in <paramref name="buffer" /> at which to begin storing the data read from the current stream.</param>
 		/// <param name="count">The maximum number of bytes to be read from the current stream.</param>
 		/// <returns>The total number of bytes read into the buffer. This can be less than the number of bytes requested if that many bytes are not currently available, or zero (0) if the end of the stream has been reached.</returns>
+		/// <remarks>The chunks that fit whole in the buffer are decompressed directly into it.</remarks>
 		public override unsafe int Read(byte[] buffer, int offset, int count)
 		{
 			if (!CanRead) throw NotSupported("Read");
+			if (buffer == null) throw new ArgumentNullException("buffer");
+			if (offset < 0 || count < 0 || offset + count > buffer.Length)
+				throw new ArgumentException("offset and count are invalid for given buffer");
 
-			var total = 0;
-
-			while (count > 0)
+			fixed (byte* pBuffer = buffer)
 			{
-				var chunk = Math.Min(count, bufferLength - bufferOffset);
-				if (chunk > 0)
-                {
-                    fixed (byte* pSrc = dataBuffer)
-                    fixed (byte* pDst = buffer)
-                    {
-                        Utilities.CopyMemory((IntPtr)pDst + offset, (IntPtr)pSrc + bufferOffset, chunk);
-                    }
-					bufferOffset += chunk;
-					offset += chunk;
-					count -= chunk;
-					total += chunk;
-				}
-				else
-				{
-					if (!AcquireNextChunk()) break;
-				}
-            }
-            position += total;
-
-			return total;
+				return ReadTo((IntPtr)pBuffer + offset, count);
+			}
 		}
 
 	    /// <inheritdoc/>
-	    public unsafe override int Read(IntPtr buffer, int count)
+	    /// <remarks>The chunks that fit whole in the buffer are decompressed directly into it, such as the final memory of a texture.</remarks>
+	    public override int Read(IntPtr buffer, int count)
 	    {
             if (!CanRead) throw NotSupported("Read");
 
+            return ReadTo(buffer, count);
+        }
+
+		/// <summary>Reads from the buffered chunk, and decompresses the next ones directly into the destination when they fit there.</summary>
+		/// <param name="buffer">The destination.</param>
+		/// <param name="count">The maximum number of bytes to read.</param>
+		/// <returns>The total number of bytes read into the buffer.</returns>
+		private unsafe int ReadTo(IntPtr buffer, int count)
+		{
             var total = 0;
 
             while (count > 0)
@@ -428,7 +1292,7 @@ namespace SiliconStudio.Core.LZ4
                 {
                     fixed (byte* pSrc = dataBuffer)
                     {
-                        Utilities.CopyMemory((IntPtr)buffer + total, (IntPtr)pSrc + bufferOffset, chunk);
+                        Utilities.CopyMemory(buffer + total, (IntPtr)pSrc + bufferOffset, chunk);
                     }
                     bufferOffset += chunk;
                     count -= chunk;
@@ -436,7 +1300,10 @@ namespace SiliconStudio.Core.LZ4
                 }
                 else
                 {
-                    if (!AcquireNextChunk()) break;
+                    var decompressed = AcquireNextChunk(buffer + total, count, total);
+                    if (decompressed < 0) break;
+                    count -= decompressed;
+                    total += decompressed;
                 }
             }
             position += total;
@@ -448,8 +1315,12 @@ namespace SiliconStudio.Core.LZ4
 		/// <param name="offset">A byte offset relative to the <paramref name="origin" /> parameter.</param>
 		/// <param name="origin">A value of type <see cref="T:System.IO.SeekOrigin" /> indicating the reference point used to obtain the new position.</param>
 		/// <returns>The new position within the current stream.</returns>
+		/// <remarks>Only the chunk holding the new position is decompressed when the stream can seek (see <see cref="CanSeek"/>). Otherwise the stream is
+		/// decompressed up to the new position, from the start of the stream when moving backward, which needs the inner stream to seek.</remarks>
 		public override long Seek(long offset, SeekOrigin origin)
 		{
+		    if (!CanRead) throw NotSupported("Seek");
+
 		    long newPosition;
             switch (origin)
             {
@@ -460,23 +1331,44 @@ namespace SiliconStudio.Core.LZ4
                     newPosition = Position + offset;
                     break;
                 case SeekOrigin.End:
-                    throw NotSupported("Seek");
+                    var streamLength = Length;
+                    if (streamLength < 0) throw NotSupported("Seek");
+                    newPosition = streamLength + offset;
+                    break;
                 default:
                     throw new ArgumentOutOfRangeException("origin");
             }
 
-            if (newPosition == 0)
+            if (newPosition < 0)
+                throw new ArgumentOutOfRangeException("offset");
+
+            if (newPosition == Position)
+            {
+                // nothing to do
+            }
+            else if (newPosition >= position - bufferOffset && newPosition - position <= bufferLength - bufferOffset)
+            {
+                // Still in the data decompressed
+                bufferOffset += (int)(newPosition - position);
+                position = newPosition;
+            }
+            else if (newPosition == 0)
             {
                 innerStream.Seek(-innerStreamPosition, SeekOrigin.Current);
                 Reset();
             }
-            else if (newPosition == Position)
+            else if (LoadBlockIndex())
             {
-                // nothing to do
+                SeekChunk(newPosition);
             }
             else
             {
-                throw NotSupported("Seek");
+                if (newPosition < position)
+                {
+                    innerStream.Seek(-innerStreamPosition, SeekOrigin.Current);
+                    Reset();
+                }
+                Skip(newPosition - position);
             }
 
 		    return Position;
@@ -584,6 +1476,19 @@ namespace SiliconStudio.Core.LZ4
                 }
             }
         }
+	    /// <summary>Drops the chunks given to the thread pool, as the buffered data is.</summary>
+	    private void DropPendingChunks()
+	    {
+	        if (pendingChunks == null) return;
+
+	        foreach (var pendingChunk in pendingChunks)
+	            pendingChunk.Wait();
+	        pendingChunks.Clear();
+	        pendingHistory = null;
+	        lastPendingChunk = null;
+	        lastPendingChunkEnd = 0;
+	    }
+
 	    /// <summary>
         /// Reset the stream to its initial position and state
         /// </summary>
@@ -594,6 +1499,30 @@ namespace SiliconStudio.Core.LZ4
             dataBuffer = null;
             bufferLength = 0;
             bufferOffset = 0;
+            if (linkedContext != null)
+                linkedContext.ResetLinked();
+            linkedChunksStarted = false;
+            DropPendingChunks();
+            if (indexedChunkLengths != null)
+            {
+                indexedChunkLengths.Clear();
+                indexedChunkStoredLengths.Clear();
+            }
+
+            // The frame starts again, read again from the start of the stream when decompressing
+            if (CanRead)
+            {
+                frame = FrameFlags.None;
+                frameContentSize = -1;
+            }
+            else if (contentChecksum != null)
+            {
+                contentChecksum.Reset();
+            }
+            frameStarted = false;
+            frameEnded = false;
+            frameChunksLength = 0;
+            firstChunkFlags = -1;
         }
 
 		/// <summary>Releases the unmanaged resources used by the <see cref="T:System.IO.Stream" /> and optionally releases the managed resources.</summary>
@@ -601,11 +1530,55 @@ namespace SiliconStudio.Core.LZ4
 		protected override void Dispose(bool disposing)
 		{
 			Flush();
+            if (CanWrite)
+                WriteFrameEnd();
+            if (contentChecksum != null)
+            {
+                contentChecksum.Dispose();
+                contentChecksum = null;
+            }
+            if (linkedContext != null)
+            {
+                linkedContext.Dispose();
+                linkedContext = null;
+            }
             if (disposeInnerStream)
 			    innerStream.Dispose();
 			base.Dispose(disposing);
 		}
 
 		#endregion
+
+		#region Chunk
+
+		/// <summary>A chunk and its compressed block, written once compressed or read once decompressed.</summary>
+		private sealed class Chunk
+		{
+			/// <summary>The data of the chunk, after the end of the previous chunks for a linked chunk being decompressed.</summary>
+			public byte[] Data;
+
+			/// <summary>The offset of the chunk in <see cref="Data"/>.</summary>
+			public int Offset;
+
+			/// <summary>The length of the chunk.</summary>
+			public int Length;
+
+			/// <summary>Whether the chunk refers to the dictionary (compression only).</summary>
+			public bool RefersToDictionary;
+
+			/// <summary>The flags of the chunk (decompression only).</summary>
+			public ChunkFlags Flags;
+
+			/// <summary>The compressed block.</summary>
+			public byte[] Compressed;
+
+			/// <summary>The length of the compressed block, 0 if it doesn't fit.</summary>
+			public int CompressedLength;
+
+			/// <summary>The checksum of the compressed block, if the frame has checksums (decompression only).</summary>
+			public uint Checksum;
+		}
+
+		#endregion
 	}
 }
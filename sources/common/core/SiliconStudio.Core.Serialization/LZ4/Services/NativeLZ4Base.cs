@@ -1,5 +1,6 @@
 ﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
 // This file is distributed under BSD 2-Clause License. See LICENSE.md for details.
+using System;
 using System.Runtime.InteropServices;
 
 namespace SiliconStudio.Core.LZ4.Services
@@ -12,28 +13,85 @@ namespace SiliconStudio.Core.LZ4.Services
         }
 
         [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
-        protected unsafe static extern int I32_LZ4_uncompress(byte* source, byte* dest, int maxOutputSize);
+        protected unsafe static extern int Core_LZ4_decompress_fast(byte* source, byte* dest, int originalSize);
 
         [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
-        protected unsafe static extern int I32_LZ4_uncompress_unknownOutputSize(byte* source, byte* dest, int inputSize, int maxOutputSize);
+        protected unsafe static extern int Core_LZ4_decompress_safe(byte* source, byte* dest, int compressedSize, int maxDecompressedSize);
 
         [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
-        protected unsafe static extern int I32_LZ4_compress_limitedOutput(byte* source, byte* dest, int inputSize, int maxOutputSize);
+        protected unsafe static extern int Core_LZ4_compress_fast(byte* source, byte* dest, int inputSize, int maxOutputSize, int acceleration);
 
         [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
-        protected unsafe static extern int I32_LZ4_compressHC_limitedOutput(byte* source, byte* dest, int inputSize, int maxOutputSize);
+        protected unsafe static extern int Core_LZ4_compress_HC(byte* source, byte* dest, int inputSize, int maxOutputSize, int compressionLevel);
 
         [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
-        protected unsafe static extern int I64_LZ4_uncompress(byte* source, byte* dest, int maxOutputSize);
+        protected static extern IntPtr Core_LZ4_createStream();
 
         [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
-        protected unsafe static extern int I64_LZ4_uncompress_unknownOutputSize(byte* source, byte* dest, int inputSize, int maxOutputSize);
+        protected static extern int Core_LZ4_freeStream(IntPtr streamPtr);
 
         [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
-        protected unsafe static extern int I64_LZ4_compress_limitedOutput(byte* source, byte* dest, int inputSize, int maxOutputSize);
+        protected unsafe static extern int Core_LZ4_compress_fast_extState(IntPtr state, byte* source, byte* dest, int inputSize, int maxOutputSize, int acceleration);
 
         [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
-        protected unsafe static extern int I64_LZ4_compressHC_limitedOutput(byte* source, byte* dest, int inputSize, int maxOutputSize);
+        protected static extern IntPtr Core_LZ4_createStreamHC();
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected static extern int Core_LZ4_freeStreamHC(IntPtr streamHCPtr);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_compress_HC_extStateHC(IntPtr state, byte* source, byte* dest, int inputSize, int maxOutputSize, int compressionLevel);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected static extern void Core_LZ4_resetStream(IntPtr streamPtr);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_compress_fast_continue(IntPtr streamPtr, byte* source, byte* dest, int inputSize, int maxOutputSize, int acceleration);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_saveDict(IntPtr streamPtr, byte* safeBuffer, int dictSize);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected static extern void Core_LZ4_resetStreamHC(IntPtr streamHCPtr, int compressionLevel);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_compress_HC_continue(IntPtr streamHCPtr, byte* source, byte* dest, int inputSize, int maxOutputSize);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_saveDictHC(IntPtr streamHCPtr, byte* safeBuffer, int dictSize);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_decompress_safe_usingDict(byte* source, byte* dest, int compressedSize, int maxDecompressedSize, byte* dictStart, int dictSize);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_decompress_fast_usingDict(byte* source, byte* dest, int originalSize, byte* dictStart, int dictSize);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_loadDict(IntPtr streamPtr, byte* dictionary, int dictSize);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_loadDictHC(IntPtr streamHCPtr, byte* dictionary, int dictSize);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected static extern void Core_LZ4_attachDictionary(IntPtr workingStream, IntPtr dictionaryStream);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected static extern void Core_LZ4_attachDictionaryHC(IntPtr workingStream, IntPtr dictionaryStream);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern int Core_LZ4_trainDict(byte* dictBuffer, int dictCapacity, byte* samplesBuffer, int* sampleSizes, int nbSamples);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern uint Core_LZ4_checksum(byte* input, int length, uint seed);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected static extern void Core_LZ4_resetChecksum(IntPtr state, uint seed);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected unsafe static extern void Core_LZ4_updateChecksum(IntPtr state, byte* input, int length);
+
+        [DllImport(NativeLibrary.LibraryName, CallingConvention = NativeLibrary.CallConvention)]
+        protected static extern uint Core_LZ4_digestChecksum(IntPtr state);
 
     }
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under BSD 2-Clause License. See LICENSE.md for details.
+using System;
+
+namespace SiliconStudio.Core.LZ4.Services
+{
+    internal class NativeLZ4Service : NativeLZ4Base, ILZ4Service
+    {
+        public string CodecName
+        {
+            get { return string.Format("NativeMode {0}", IntPtr.Size == 4 ? "32" : "64"); }
+        }
+
+        public unsafe int Decode(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, bool knownOutputLength)
+        {
+            fixed (byte* pInput = input)
+            fixed (byte* pOutput = output)
+            {
+                if (knownOutputLength)
+                {
+                    Core_LZ4_decompress_fast(pInput + inputOffset, pOutput + outputOffset, outputLength);
+
+                    return outputLength;
+                }
+
+                return Core_LZ4_decompress_safe(pInput + inputOffset, pOutput + outputOffset, inputLength, outputLength);
+            }
+        }
+
+        public unsafe int Encode(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int acceleration)
+        {
+            fixed (byte* pInput = input)
+            fixed (byte* pOutput = output)
+            {
+                return Core_LZ4_compress_fast(pInput + inputOffset, pOutput + outputOffset, inputLength, outputLength, acceleration);
+            }
+        }
+
+        public unsafe int EncodeHC(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel)
+        {
+            fixed (byte* pInput = input)
+            fixed (byte* pOutput = output)
+            {
+                return Core_LZ4_compress_HC(pInput + inputOffset, pOutput + outputOffset, inputLength, outputLength, compressionLevel);
+            }
+        }
+
+        public IntPtr CreateState(bool highCompression)
+        {
+            return highCompression ? Core_LZ4_createStreamHC() : Core_LZ4_createStream();
+        }
+
+        public void FreeState(IntPtr state, bool highCompression)
+        {
+            if (highCompression)
+                Core_LZ4_freeStreamHC(state);
+            else
+                Core_LZ4_freeStream(state);
+        }
+
+        public unsafe int Encode(IntPtr state, byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int acceleration)
+        {
+            fixed (byte* pInput = input)
+            fixed (byte* pOutput = output)
+            {
+                return Core_LZ4_compress_fast_extState(state, pInput + inputOffset, pOutput + outputOffset, inputLength, outputLength, acceleration);
+            }
+        }
+
+        public unsafe int EncodeHC(IntPtr state, byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int compressionLevel)
+        {
+            fixed (byte* pInput = input)
+            fixed (byte* pOutput = output)
+            {
+                return Core_LZ4_compress_HC_extStateHC(state, pInput + inputOffset, pOutput + outputOffset, inputLength, outputLength, compressionLevel);
+            }
+        }
+
+        public void ResetState(IntPtr state, bool highCompression, int compressionLevel)
+        {
+            if (highCompression)
+                Core_LZ4_resetStreamHC(state, compressionLevel);
+            else
+                Core_LZ4_resetStream(state);
+        }
+
+        public unsafe int EncodeLinked(IntPtr state, bool highCompression, IntPtr input, int inputLength, byte[] output, int outputOffset, int outputLength, int acceleration)
+        {
+            fixed (byte* pOutput = output)
+            {
+                return highCompression
+                    ? Core_LZ4_compress_HC_continue(state, (byte*)input, pOutput + outputOffset, inputLength, outputLength)
+                    : Core_LZ4_compress_fast_continue(state, (byte*)input, pOutput + outputOffset, inputLength, outputLength, acceleration);
+            }
+        }
+
+        public unsafe int SaveDictionary(IntPtr state, bool highCompression, IntPtr dictionary, int dictionaryLength)
+        {
+            return highCompression
+                ? Core_LZ4_saveDictHC(state, (byte*)dictionary, dictionaryLength)
+                : Core_LZ4_saveDict(state, (byte*)dictionary, dictionaryLength);
+        }
+
+        public unsafe int DecodeLinked(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, int dictionaryLength, bool knownOutputLength)
+        {
+            fixed (byte* pInput = input)
+            fixed (byte* pOutput = output)
+            {
+                // The dictionary precedes the output, which decodes as fast as an independent block
+                if (knownOutputLength)
+                {
+                    Core_LZ4_decompress_fast_usingDict(pInput + inputOffset, pOutput + outputOffset, outputLength, pOutput + outputOffset - dictionaryLength, dictionaryLength);
+
+                    return outputLength;
+                }
+
+                return Core_LZ4_decompress_safe_usingDict(pInput + inputOffset, pOutput + outputOffset, inputLength, outputLength, pOutput + outputOffset - dictionaryLength, dictionaryLength);
+            }
+        }
+
+        public unsafe int TrainDictionary(byte[] samples, int[] sampleLengths, byte[] dictionary)
+        {
+            fixed (byte* pSamples = samples)
+            fixed (int* pSampleLengths = sampleLengths)
+            fixed (byte* pDictionary = dictionary)
+            {
+                return Core_LZ4_trainDict(pDictionary, dictionary.Length, pSamples, pSampleLengths, sampleLengths.Length);
+            }
+        }
+
+        public unsafe int LoadDictionary(IntPtr state, bool highCompression, IntPtr dictionary, int dictionaryLength)
+        {
+            return highCompression
+                ? Core_LZ4_loadDictHC(state, (byte*)dictionary, dictionaryLength)
+                : Core_LZ4_loadDict(state, (byte*)dictionary, dictionaryLength);
+        }
+
+        public void AttachDictionary(IntPtr state, bool highCompression, IntPtr dictionaryState)
+        {
+            if (highCompression)
+                Core_LZ4_attachDictionaryHC(state, dictionaryState);
+            else
+                Core_LZ4_attachDictionary(state, dictionaryState);
+        }
+
+        public unsafe int DecodeDictionary(byte[] input, int inputOffset, int inputLength, byte[] output, int outputOffset, int outputLength, IntPtr dictionary, int dictionaryLength, bool knownOutputLength)
+        {
+            fixed (byte* pInput = input)
+            fixed (byte* pOutput = output)
+            {
+                if (knownOutputLength)
+                {
+                    Core_LZ4_decompress_fast_usingDict(pInput + inputOffset, pOutput + outputOffset, outputLength, (byte*)dictionary, dictionaryLength);
+
+                    return outputLength;
+                }
+
+                return Core_LZ4_decompress_safe_usingDict(pInput + inputOffset, pOutput + outputOffset, inputLength, outputLength, (byte*)dictionary, dictionaryLength);
+            }
+        }
+
+        public unsafe int Decode(byte[] input, int inputOffset, int inputLength, IntPtr output, int outputLength, IntPtr dictionary, int dictionaryLength)
+        {
+            fixed (byte* pInput = input)
+            {
+                return Core_LZ4_decompress_safe_usingDict(pInput + inputOffset, (byte*)output, inputLength, outputLength, (byte*)dictionary, dictionaryLength);
+            }
+        }
+
+        public unsafe uint Checksum(byte[] input, int inputOffset, int inputLength, uint seed)
+        {
+            fixed (byte* pInput = input)
+            {
+                return Core_LZ4_checksum(pInput + inputOffset, inputLength, seed);
+            }
+        }
+
+        public void ResetChecksum(IntPtr state, uint seed)
+        {
+            Core_LZ4_resetChecksum(state, seed);
+        }
+
+        public unsafe void UpdateChecksum(IntPtr state, IntPtr input, int inputLength)
+        {
+            Core_LZ4_updateChecksum(state, (byte*)input, inputLength);
+        }
+
+        public uint DigestChecksum(IntPtr state)
+        {
+            return Core_LZ4_digestChecksum(state);
+        }
+    }
+}
\ No newline at end of file
@@ -28,6 +28,21 @@ namespace SiliconStudio.Core.Storage
         /// </summary>
         public const string BundleExtension = ".bundle";
 
+        // Objects up to this size are sampled to train the dictionary of the bundle, which their first chunk refers to:
+        // small objects compress badly alone, and much better with the content they have in common
+        private const int DictionarySampleMaximumLength = 64 * 1024;
+        private const int DictionarySamplesMaximumLength = 4 * 1024 * 1024;
+        private const int DictionaryMinimumSampleCount = 16;
+
+        // Objects are compressed with LZ4 (LZ4HC when a compression level is given) in chunks of this size, several chunks or small objects at a time, and decompressed ahead of the reads when larger
+        private const int CompressionBlockSize = 1024 * 1024;
+
+        // The chunks of the compressed objects are checked before being decompressed, so that a corrupted bundle is detected at the object read
+        private const LZ4Stream.FrameFlags CompressionFrame = LZ4Stream.FrameFlags.BlockChecksum;
+
+        // The chunks of large objects are independent and indexed instead, so that a partial read (a mip level, an animation clip) only decompresses the chunks it touches
+        private const LZ4Stream.FrameFlags SeekableCompressionFrame = CompressionFrame | LZ4Stream.FrameFlags.BlockIndex;
+
         /// <summary>
         /// The default directory where bundle are stored.
         /// </summary>
@@ -194,6 +209,7 @@ namespace SiliconStudio.Core.Storage
                 }
             }
 
+            LZ4Dictionary dictionary;
             lock (loadedBundles)
             {
                 LoadedBundle loadedBundle = null;
@@ -214,6 +230,7 @@ namespace SiliconStudio.Core.Storage
                         BundleName = bundleName,
                         BundleUrl = bundleUrl,
                         Description = bundle,
+                        Dictionary = bundle.Header.Dictionary != null ? new LZ4Dictionary(bundle.Header.Dictionary) : null,
                         ReferenceCount = 1
                     };
 
@@ -223,6 +240,8 @@ namespace SiliconStudio.Core.Storage
                 {
                     loadedBundle.ReferenceCount++;
                 }
+
+                dictionary = loadedBundle.Dictionary;
             }
 
             // Read objects
@@ -230,7 +249,7 @@ namespace SiliconStudio.Core.Storage
             {
                 foreach (var objectEntry in bundle.Objects)
                 {
-                    objects[objectEntry.Key] = new ObjectLocation { Info = objectEntry.Value, BundleUrl = bundleUrl };
+                    objects[objectEntry.Key] = new ObjectLocation { Info = objectEntry.Value, BundleUrl = bundleUrl, Dictionary = dictionary };
                 }
             }
 
@@ -263,7 +282,7 @@ namespace SiliconStudio.Core.Storage
                     // Read objects
                     foreach (var objectEntry in bundle.Objects)
                     {
-                        objects[objectEntry.Key] = new ObjectLocation { Info = objectEntry.Value, BundleUrl = otherLoadedBundle.BundleUrl };
+                        objects[objectEntry.Key] = new ObjectLocation { Info = objectEntry.Value, BundleUrl = otherLoadedBundle.BundleUrl, Dictionary = otherLoadedBundle.Dictionary };
                     }
 
                     assetIndexMap.Merge(bundle.Assets);
@@ -355,7 +374,7 @@ namespace SiliconStudio.Core.Storage
             result.Header = header;
 
             // Check magic header
-            if (header.MagicHeader != Header.MagicHeaderValid)
+            if (header.MagicHeader != Header.MagicHeaderValid && header.MagicHeader != Header.MagicHeaderDictionary)
             {
                 throw new InvalidOperationException("Invalid bundle header");
             }
@@ -381,7 +400,7 @@ namespace SiliconStudio.Core.Storage
             return result;
         }
 
-        public static void CreateBundle(string vfsUrl, IOdbBackend backend, ObjectId[] objectIds, ISet<ObjectId> disableCompressionIds, Dictionary<string, ObjectId> indexMap, IList<string> dependencies)
+        public static void CreateBundle(string vfsUrl, IOdbBackend backend, ObjectId[] objectIds, ISet<ObjectId> disableCompressionIds, Dictionary<string, ObjectId> indexMap, IList<string> dependencies, int compressionLevel = 0)
         {
             if (objectIds.Length == 0)
                 throw new InvalidOperationException("Nothing to pack.");
@@ -411,10 +430,16 @@ namespace SiliconStudio.Core.Storage
                 }
             }
 
+            using (var dictionary = TrainDictionary(backend, objectIds, disableCompressionIds))
             using (var packStream = VirtualFileSystem.OpenStream(vfsUrl, VirtualFileMode.Create, VirtualFileAccess.Write))
             {
                 var header = new Header();
                 header.MagicHeader = Header.MagicHeaderValid;
+                if (dictionary != null)
+                {
+                    header.MagicHeader = Header.MagicHeaderDictionary;
+                    header.Dictionary = dictionary.ToArray();
+                }
 
                 var binaryWriter = new BinarySerializationWriter(packStream);
                 binaryWriter.Write(header);
@@ -438,73 +463,72 @@ namespace SiliconStudio.Core.Storage
                 // Write index
                 binaryWriter.Write(indexMap.ToList());
 
+                // LZ4HC is much slower to compress, so it is only used when a level is given
+                var highCompression = compressionLevel > 0;
+
+                // Small objects are compressed on the thread pool, several at a time, and written in order
+                var pendingObjects = new Queue<PendingObject>();
+
                 for (int i = 0; i < objectIds.Length; ++i)
                 {
                     using (var objectStream = backend.OpenStream(objectIds[i]))
                     {
                         // Prepare object info
-                        var objectInfo = new ObjectInfo { StartOffset = packStream.Position, SizeNotCompressed = objectStream.Length };
+                        var objectInfo = new ObjectInfo { SizeNotCompressed = objectStream.Length };
 
                         // re-order the file content so that it is not necessary to seek while reading the input stream (header/object/refs -> header/refs/object)
-                        var inputStream = objectStream;
-                        var originalStreamLength = objectStream.Length;
-                        var streamReader = new BinarySerializationReader(inputStream);
-                        var chunkHeader = ChunkHeader.Read(streamReader);
-                        if (chunkHeader != null)
-                        {
-                            // create the reordered stream
-                            var reorderedStream = new MemoryStream((int)originalStreamLength);
-
-                            // copy the header
-                            var streamWriter = new BinarySerializationWriter(reorderedStream);
-                            chunkHeader.Write(streamWriter);
-
-                            // copy the references
-                            var newOffsetReferences = reorderedStream.Position;
-                            inputStream.Position = chunkHeader.OffsetToReferences;
-                            inputStream.CopyTo(reorderedStream);
-
-                            // copy the object
-                            var newOffsetObject = reorderedStream.Position;
-                            inputStream.Position = chunkHeader.OffsetToObject;
-                            inputStream.CopyTo(reorderedStream, chunkHeader.OffsetToReferences - chunkHeader.OffsetToObject);
-
-                            // rewrite the chunk header with correct offsets
-                            chunkHeader.OffsetToObject = (int)newOffsetObject;
-                            chunkHeader.OffsetToReferences = (int)newOffsetReferences;
-                            reorderedStream.Position = 0;
-                            chunkHeader.Write(streamWriter);
-
-                            // change the input stream to use reordered stream
-                            inputStream = reorderedStream;
-                            inputStream.Position = 0;
-                        }
+                        var inputStream = ReorderObject(objectStream);
  
                         // compress the stream
                         if (!disableCompressionIds.Contains(objectIds[i]))
                         {
                             objectInfo.IsCompressed = true;
 
-                            var lz4OutputStream = new LZ4Stream(packStream, CompressionMode.Compress);
-                            inputStream.CopyTo(lz4OutputStream);
-                            lz4OutputStream.Flush();
+                            if (inputStream.Length <= CompressionBlockSize)
+                            {
+                                var data = Utilities.ReadStream(inputStream);
+                                pendingObjects.Enqueue(new PendingObject { Id = objectIds[i], Info = objectInfo, Compressed = Task.Factory.StartNew(() => CompressObject(data, dictionary, highCompression, compressionLevel)) });
+
+                                if (pendingObjects.Count >= Environment.ProcessorCount * 2)
+                                    WritePendingObject(packStream, pendingObjects.Dequeue(), objects);
+                            }
+                            else
+                            {
+                                while (pendingObjects.Count > 0)
+                                    WritePendingObject(packStream, pendingObjects.Dequeue(), objects);
+
+                                // The chunks of a large object are compressed on the thread pool instead
+                                objectInfo.StartOffset = packStream.Position;
+                                using (var lz4OutputStream = new LZ4Stream(packStream, CompressionMode.Compress, highCompression, blockSize: CompressionBlockSize, compressionLevel: compressionLevel, linkedChunks: false, dictionary: dictionary, threadCount: 0, frame: SeekableCompressionFrame))
+                                {
+                                    inputStream.CopyTo(lz4OutputStream);
+                                    lz4OutputStream.Flush();
+                                }
+                                objectInfo.EndOffset = packStream.Position;
+                                objects.Add(new KeyValuePair<ObjectId, ObjectInfo>(objectIds[i], objectInfo));
+                            }
                         }
                         else // copy the stream "as is"
                         {
+                            while (pendingObjects.Count > 0)
+                                WritePendingObject(packStream, pendingObjects.Dequeue(), objects);
+
                             // Write stream
+                            objectInfo.StartOffset = packStream.Position;
                             inputStream.CopyTo(packStream);
+                            objectInfo.EndOffset = packStream.Position;
+                            objects.Add(new KeyValuePair<ObjectId, ObjectInfo>(objectIds[i], objectInfo));
                         }
 
                         // release the reordered created stream
-                        if (chunkHeader != null)
+                        if (inputStream != objectStream)
                             inputStream.Dispose();
-
-                        // Add updated object info
-                        objectInfo.EndOffset = packStream.Position;
-                        objects.Add(new KeyValuePair<ObjectId, ObjectInfo>(objectIds[i], objectInfo));
                     }
                 }
 
+                while (pendingObjects.Count > 0)
+                    WritePendingObject(packStream, pendingObjects.Dequeue(), objects);
+
                 // Rewrite header
                 header.Size = packStream.Length;
                 packStream.Position = 0;
@@ -516,6 +540,125 @@ namespace SiliconStudio.Core.Storage
             }
         }
 
+        /// <summary>
+        /// Compresses a small object as a single independent chunk, on the thread pool.
+        /// </summary>
+        /// <param name="data">The content of the object.</param>
+        /// <param name="dictionary">The dictionary of the bundle, <c>null</c> if none.</param>
+        /// <param name="highCompression">If set to <c>true</c>, the object is compressed with LZ4HC.</param>
+        /// <param name="compressionLevel">The LZ4HC compression level.</param>
+        /// <returns>The compressed object.</returns>
+        private static byte[] CompressObject(byte[] data, LZ4Dictionary dictionary, bool highCompression, int compressionLevel)
+        {
+            // The buffer of the stream is sized to the object, and its single chunk is compressed with the tables of the current thread instead of a context of its own
+            var compressedStream = new MemoryStream(data.Length + 64);
+            using (var lz4OutputStream = new LZ4Stream(compressedStream, CompressionMode.Compress, highCompression, blockSize: data.Length, compressionLevel: compressionLevel, linkedChunks: false, dictionary: dictionary, frame: CompressionFrame))
+            {
+                lz4OutputStream.Write(data, 0, data.Length);
+            }
+            return compressedStream.ToArray();
+        }
+
+        /// <summary>
+        /// Writes an object once it is compressed.
+        /// </summary>
+        /// <param name="packStream">The stream of the bundle.</param>
+        /// <param name="pendingObject">The object.</param>
+        /// <param name="objects">The objects of the bundle, which the object is added to.</param>
+        private static void WritePendingObject(Stream packStream, PendingObject pendingObject, List<KeyValuePair<ObjectId, ObjectInfo>> objects)
+        {
+            var compressed = pendingObject.Compressed.Result;
+            var objectInfo = pendingObject.Info;
+            objectInfo.StartOffset = packStream.Position;
+            packStream.Write(compressed, 0, compressed.Length);
+            objectInfo.EndOffset = packStream.Position;
+            objects.Add(new KeyValuePair<ObjectId, ObjectInfo>(pendingObject.Id, objectInfo));
+        }
+
+        /// <summary>
+        /// Re-orders the content of an object so that it is not necessary to seek while reading it (header/object/refs -> header/refs/object).
+        /// </summary>
+        /// <param name="objectStream">The stream of the object.</param>
+        /// <returns>The reordered stream, or <paramref name="objectStream"/> if the object has no chunk header.</returns>
+        private static Stream ReorderObject(Stream objectStream)
+        {
+            var inputStream = objectStream;
+            var originalStreamLength = objectStream.Length;
+            var streamReader = new BinarySerializationReader(inputStream);
+            var chunkHeader = ChunkHeader.Read(streamReader);
+            if (chunkHeader != null)
+            {
+                // create the reordered stream
+                var reorderedStream = new MemoryStream((int)originalStreamLength);
+
+                // copy the header
+                var streamWriter = new BinarySerializationWriter(reorderedStream);
+                chunkHeader.Write(streamWriter);
+
+                // copy the references
+                var newOffsetReferences = reorderedStream.Position;
+                inputStream.Position = chunkHeader.OffsetToReferences;
+                inputStream.CopyTo(reorderedStream);
+
+                // copy the object
+                var newOffsetObject = reorderedStream.Position;
+                inputStream.Position = chunkHeader.OffsetToObject;
+                inputStream.CopyTo(reorderedStream, chunkHeader.OffsetToReferences - chunkHeader.OffsetToObject);
+
+                // rewrite the chunk header with correct offsets
+                chunkHeader.OffsetToObject = (int)newOffsetObject;
+                chunkHeader.OffsetToReferences = (int)newOffsetReferences;
+                reorderedStream.Position = 0;
+                chunkHeader.Write(streamWriter);
+
+                // change the input stream to use reordered stream
+                inputStream = reorderedStream;
+                inputStream.Position = 0;
+            }
+
+            return inputStream;
+        }
+
+        /// <summary>
+        /// Trains the dictionary of a bundle out of its small compressed objects.
+        /// </summary>
+        /// <param name="backend">The backend of the objects.</param>
+        /// <param name="objectIds">The objects of the bundle.</param>
+        /// <param name="disableCompressionIds">The objects stored uncompressed.</param>
+        /// <returns>The dictionary, or <c>null</c> if there are too few small objects or if they have too little content in common.</returns>
+        private static LZ4Dictionary TrainDictionary(IOdbBackend backend, ObjectId[] objectIds, ISet<ObjectId> disableCompressionIds)
+        {
+            var samples = new MemoryStream();
+            var sampleLengths = new List<int>();
+
+            foreach (var objectId in objectIds)
+            {
+                if (disableCompressionIds.Contains(objectId))
+                    continue;
+
+                using (var objectStream = backend.OpenStream(objectId))
+                {
+                    if (objectStream.Length > DictionarySampleMaximumLength || samples.Length + objectStream.Length > DictionarySamplesMaximumLength)
+                        continue;
+
+                    // The content as it is compressed, once reordered
+                    var inputStream = ReorderObject(objectStream);
+                    var sampleStart = samples.Length;
+                    inputStream.CopyTo(samples);
+                    sampleLengths.Add((int)(samples.Length - sampleStart));
+
+                    if (inputStream != objectStream)
+                        inputStream.Dispose();
+                }
+            }
+
+            if (sampleLengths.Count < DictionaryMinimumSampleCount)
+                return null;
+
+            // About 1/16 of the samples: the dictionary is stored in the bundle, only the content shared by several objects is worth it
+            return LZ4Dictionary.Train(samples.GetBuffer(), sampleLengths.ToArray(), (int)Math.Min(samples.Length / 16, LZ4Dictionary.MaximumLength));
+        }
+
         public Stream OpenStream(ObjectId objectId, VirtualFileMode mode = VirtualFileMode.Open, VirtualFileAccess access = VirtualFileAccess.Read, VirtualFileShare share = VirtualFileShare.Read)
         {
             ObjectLocation objectLocation;
@@ -545,7 +688,10 @@ namespace SiliconStudio.Core.Storage
             if (objectLocation.Info.IsCompressed)
             {
                 stream.Position = objectLocation.Info.StartOffset;
-                return new PackageFileStreamLZ4(this, objectLocation.BundleUrl, stream, CompressionMode.Decompress, objectLocation.Info.SizeNotCompressed, objectLocation.Info.EndOffset - objectLocation.Info.StartOffset);
+
+                // The chunks of large objects (textures, sounds...) are decompressed on the thread pool ahead of the reads
+                var threadCount = objectLocation.Info.SizeNotCompressed > CompressionBlockSize ? 0 : 1;
+                return new PackageFileStreamLZ4(this, objectLocation.BundleUrl, stream, CompressionMode.Decompress, objectLocation.Info.SizeNotCompressed, objectLocation.Info.EndOffset - objectLocation.Info.StartOffset, objectLocation.Dictionary, threadCount);
             }
 
             return new PackageFileStream(this, objectLocation.BundleUrl, stream, objectLocation.Info.StartOffset, objectLocation.Info.EndOffset, false);
@@ -600,6 +746,14 @@ namespace SiliconStudio.Core.Storage
         {
             public ObjectInfo Info;
             public string BundleUrl;
+            public LZ4Dictionary Dictionary;
+        }
+
+        private struct PendingObject
+        {
+            public ObjectId Id;
+            public ObjectInfo Info;
+            public Task<byte[]> Compressed;
         }
 
         private class LoadedBundle
@@ -608,6 +762,7 @@ namespace SiliconStudio.Core.Storage
             public string BundleUrl;
             public int ReferenceCount;
             public BundleDescription Description;
+            public LZ4Dictionary Dictionary; // released by its finalizer, once the streams still reading the bundle are gone
         }
 
         internal void ReleasePackageStream(string packageLocation, Stream stream)
@@ -651,10 +806,12 @@ namespace SiliconStudio.Core.Storage
         public struct Header
         {
             public const uint MagicHeaderValid = 0x42584450; // "PDXB"
+            public const uint MagicHeaderDictionary = 0x44584450; // "PDXD", followed by the dictionary of the compressed objects
 
             public uint MagicHeader;
             public long Size;
             public uint Crc; // currently unused
+            public byte[] Dictionary; // LZ4 dictionary of the compressed objects (MagicHeaderDictionary only)
 
             internal class Serializer : DataSerializer<Header>
             {
@@ -663,6 +820,19 @@ namespace SiliconStudio.Core.Storage
                     stream.Serialize(ref obj.MagicHeader);
                     stream.Serialize(ref obj.Size);
                     stream.Serialize(ref obj.Crc);
+
+                    if (obj.MagicHeader == MagicHeaderDictionary)
+                    {
+                        var dictionaryLength = obj.Dictionary != null ? obj.Dictionary.Length : 0;
+                        stream.Serialize(ref dictionaryLength);
+                        if (mode == ArchiveMode.Deserialize)
+                        {
+                            if (dictionaryLength < 0 || dictionaryLength > LZ4Dictionary.MaximumLength)
+                                throw new InvalidOperationException("Invalid bundle dictionary");
+                            obj.Dictionary = new byte[dictionaryLength];
+                        }
+                        stream.Serialize(obj.Dictionary, 0, dictionaryLength);
+                    }
                 }
             }
         }
@@ -672,8 +842,8 @@ namespace SiliconStudio.Core.Storage
             private readonly string packageLocation;
             private readonly Stream innerStream;
 
-            public PackageFileStreamLZ4(BundleOdbBackend bundleOdbBackend, string packageLocation, Stream innerStream, CompressionMode compressionMode, long uncompressedStreamSize, long compressedSize)
-                : base(innerStream, compressionMode, uncompressedSize: uncompressedStreamSize, compressedSize: compressedSize, disposeInnerStream: false)
+            public PackageFileStreamLZ4(BundleOdbBackend bundleOdbBackend, string packageLocation, Stream innerStream, CompressionMode compressionMode, long uncompressedStreamSize, long compressedSize, LZ4Dictionary dictionary = null, int threadCount = 1)
+                : base(innerStream, compressionMode, uncompressedSize: uncompressedStreamSize, compressedSize: compressedSize, disposeInnerStream: false, dictionary: dictionary, threadCount: threadCount)
             {
                 this.bundleOdbBackend = bundleOdbBackend;
                 this.packageLocation = packageLocation;
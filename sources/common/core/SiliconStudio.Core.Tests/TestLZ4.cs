@@ -0,0 +1,599 @@
+﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
+using System.Runtime.InteropServices;
+using System.Text;
+using NUnit.Framework;
+using SiliconStudio.Core.LZ4;
+
+namespace SiliconStudio.Core.Tests
+{
+    [TestFixture]
+    public class TestLZ4
+    {
+        private const int BlockSize = 64 * 1024;
+
+        private static readonly string[] Words = { "entity ", "component ", "transform ", "model ", "0.5 ", "1.0 ", "texture ", "\n" };
+
+        // Written by the LZ4Stream of previous versions (fast LZ4, 1024 byte chunks, then a flushed incompressible chunk) from BaselineContent()
+        private static readonly byte[] BaselineStream =
+        {
+            0x01, 0x80, 0x08, 0xf2, 0x01, 0xfc, 0x03, 0x58, 0x65, 0x6e, 0x6b, 0x6f, 0x20, 0x4c, 0x5a, 0x34,
+            0x20, 0x63, 0x68, 0x75, 0x6e, 0x6b, 0x20, 0x30, 0x0a, 0x12, 0x00, 0x1d, 0x31, 0x12, 0x00, 0x1d,
+            0x32, 0x12, 0x00, 0x1d, 0x33, 0x12, 0x00, 0x1d, 0x34, 0x12, 0x00, 0x1d, 0x35, 0x12, 0x00, 0x1d,
+            0x36, 0x12, 0x00, 0x1d, 0x37, 0x12, 0x00, 0x1d, 0x38, 0x12, 0x00, 0x1d, 0x39, 0x12, 0x00, 0x1f,
+            0x31, 0xb5, 0x00, 0x00, 0x0e, 0xb6, 0x00, 0x1e, 0x31, 0xb7, 0x00, 0x1e, 0x31, 0xb8, 0x00, 0x1e,
+            0x31, 0xb9, 0x00, 0x1e, 0x31, 0xba, 0x00, 0x1e, 0x31, 0xbb, 0x00, 0x1e, 0x31, 0xbc, 0x00, 0x1e,
+            0x31, 0xbd, 0x00, 0x1e, 0x31, 0xbe, 0x00, 0x1e, 0x32, 0xbe, 0x00, 0x1e, 0x32, 0xbe, 0x00, 0x1e,
+            0x32, 0xbe, 0x00, 0x1e, 0x32, 0xbe, 0x00, 0x1e, 0x32, 0xbe, 0x00, 0x1e, 0x32, 0xbe, 0x00, 0x1e,
+            0x32, 0xbe, 0x00, 0x1e, 0x32, 0xbe, 0x00, 0x1e, 0x32, 0xbe, 0x00, 0x1e, 0x32, 0xbe, 0x00, 0x1e,
+            0x33, 0xbe, 0x00, 0x1e, 0x33, 0xbe, 0x00, 0x1e, 0x33, 0xbe, 0x00, 0x1e, 0x33, 0xbe, 0x00, 0x1e,
+            0x33, 0xbe, 0x00, 0x1e, 0x33, 0xbe, 0x00, 0x1e, 0x33, 0xbe, 0x00, 0x1e, 0x33, 0xbe, 0x00, 0x1e,
+            0x33, 0xbe, 0x00, 0x1e, 0x33, 0xbe, 0x00, 0x1e, 0x34, 0xbe, 0x00, 0x1e, 0x34, 0xbe, 0x00, 0x1e,
+            0x34, 0xbe, 0x00, 0x1e, 0x34, 0xbe, 0x00, 0x1e, 0x34, 0xbe, 0x00, 0x1e, 0x34, 0xbe, 0x00, 0x1e,
+            0x34, 0xbe, 0x00, 0x1e, 0x34, 0xbe, 0x00, 0x1e, 0x34, 0xbe, 0x00, 0x1e, 0x34, 0xbe, 0x00, 0x1e,
+            0x35, 0xbe, 0x00, 0x1e, 0x35, 0xbe, 0x00, 0x1e, 0x35, 0xbe, 0x00, 0xb0, 0x35, 0x33, 0x0a, 0x58,
+            0x65, 0x6e, 0x6b, 0x6f, 0x20, 0x4c, 0x5a, 0x01, 0xe2, 0x06, 0xcd, 0x01, 0xf5, 0x04, 0x34, 0x20,
+            0x63, 0x68, 0x75, 0x6e, 0x6b, 0x20, 0x35, 0x34, 0x0a, 0x58, 0x65, 0x6e, 0x6b, 0x6f, 0x20, 0x4c,
+            0x5a, 0x13, 0x00, 0x1e, 0x35, 0x13, 0x00, 0x1e, 0x36, 0x13, 0x00, 0x1e, 0x37, 0x13, 0x00, 0x1e,
+            0x38, 0x13, 0x00, 0x1d, 0x39, 0x13, 0x00, 0x2e, 0x36, 0x30, 0x13, 0x00, 0x1e, 0x31, 0x13, 0x00,
+            0x1e, 0x32, 0x13, 0x00, 0x1e, 0x33, 0x13, 0x00, 0x0e, 0xbe, 0x00, 0x1e, 0x36, 0xbe, 0x00, 0x1e,
+            0x36, 0xbe, 0x00, 0x1e, 0x36, 0xbe, 0x00, 0x1e, 0x36, 0xbe, 0x00, 0x1e, 0x36, 0xbe, 0x00, 0x1e,
+            0x37, 0xbe, 0x00, 0x1e, 0x37, 0xbe, 0x00, 0x1e, 0x37, 0xbe, 0x00, 0x1e, 0x37, 0xbe, 0x00, 0x1e,
+            0x37, 0xbe, 0x00, 0x1e, 0x37, 0xbe, 0x00, 0x1e, 0x37, 0xbe, 0x00, 0x1e, 0x37, 0xbe, 0x00, 0x1e,
+            0x37, 0xbe, 0x00, 0x1e, 0x37, 0xbe, 0x00, 0x1e, 0x38, 0xbe, 0x00, 0x1e, 0x38, 0xbe, 0x00, 0x1e,
+            0x38, 0xbe, 0x00, 0x1e, 0x38, 0xbe, 0x00, 0x1e, 0x38, 0xbe, 0x00, 0x1e, 0x38, 0xbe, 0x00, 0x1e,
+            0x38, 0xbe, 0x00, 0x1e, 0x38, 0xbe, 0x00, 0x1e, 0x38, 0xbe, 0x00, 0x1e, 0x38, 0xbe, 0x00, 0x1e,
+            0x39, 0xbe, 0x00, 0x1e, 0x39, 0xbe, 0x00, 0x1e, 0x39, 0xbe, 0x00, 0x1e, 0x39, 0xbe, 0x00, 0x1e,
+            0x39, 0xbe, 0x00, 0x1e, 0x39, 0xbe, 0x00, 0x1e, 0x39, 0xbe, 0x00, 0x1e, 0x39, 0xbe, 0x00, 0x1c,
+            0x39, 0xbe, 0x00, 0x50, 0x6b, 0x20, 0x39, 0x39, 0x0a, 0x00, 0x64, 0xc6, 0x7e, 0x81, 0x6b, 0x4b,
+            0xfb, 0xe2, 0xfb, 0x54, 0xf6, 0xbd, 0xdf, 0x7c, 0x1c, 0xe1, 0x87, 0x01, 0xbf, 0x31, 0xde, 0x56,
+            0x72, 0x0f, 0x47, 0x67, 0x66, 0x87, 0x59, 0xaa, 0x88, 0x3c, 0x59, 0xea, 0x56, 0x13, 0x7b, 0xd2,
+            0x85, 0xa1, 0xd8, 0x3c, 0x54, 0x55, 0x2f, 0x37, 0xae, 0x65, 0x5b, 0xda, 0x02, 0x79, 0x98, 0xcc,
+            0xe3, 0x1a, 0x76, 0x8e, 0x5f, 0xd9, 0x99, 0x8f, 0x1f, 0x3f, 0x36, 0xee, 0x43, 0x78, 0x4d, 0x0d,
+            0xfa, 0xbe, 0xa6, 0xda, 0xe4, 0x86, 0x8e, 0xdc, 0x29, 0x6d, 0x4e, 0xff, 0x56, 0xe1, 0x70, 0x20,
+            0xfb, 0x8f, 0xb1, 0x58, 0x05, 0x90, 0xc5, 0x09, 0xdc, 0x53, 0xcd, 0xaa, 0x3b, 0x48, 0x99
+        };
+
+        [Test]
+        public void Codec()
+        {
+            var content = CreateContent(300000, 1);
+            var encoded = new byte[LZ4Codec.MaximumOutputLength(content.Length)];
+            var decoded = new byte[content.Length];
+
+            var encodedLength = LZ4Codec.Encode(content, 0, content.Length, encoded, 0, encoded.Length);
+            Assert.That(encodedLength, Is.GreaterThan(0));
+            Assert.AreEqual(content.Length, LZ4Codec.Decode(encoded, 0, encodedLength, decoded, 0, decoded.Length, true));
+            Assert.AreEqual(content, decoded);
+
+
+            // Higher accelerations compress faster and less, and are decoded the same way
+            foreach (var acceleration in new[] { 4, 16 })
+            {
+                var encodedLengthFast = LZ4Codec.Encode(content, 0, content.Length, encoded, 0, encoded.Length, acceleration);
+                Assert.That(encodedLengthFast, Is.GreaterThan(encodedLength));
+                Array.Clear(decoded, 0, decoded.Length);
+                Assert.AreEqual(content.Length, LZ4Codec.Decode(encoded, 0, encodedLengthFast, decoded, 0, decoded.Length, true));
+                Assert.AreEqual(content, decoded);
+            }
+
+            foreach (var compressionLevel in new[] { LZ4Codec.MinimumCompressionLevelHC, LZ4Codec.DefaultCompressionLevelHC, 12 })
+            {
+                var encodedLengthHC = LZ4Codec.EncodeHC(content, 0, content.Length, encoded, 0, encoded.Length, compressionLevel);
+                Assert.That(encodedLengthHC, Is.GreaterThan(0).And.LessThan(encodedLength));
+                Array.Clear(decoded, 0, decoded.Length);
+                Assert.AreEqual(content.Length, LZ4Codec.Decode(encoded, 0, encodedLengthHC, decoded, 0, decoded.Length, true));
+                Assert.AreEqual(content, decoded);
+            }
+        }
+
+        [Test]
+        public void CompressionContexts()
+        {
+            // A context compresses each block as a new context would, whatever it compressed before
+            var random = new Random(10);
+            foreach (var highCompression in new[] { false, true })
+            using (var context = new LZ4CompressionContext(highCompression))
+            {
+                for (var i = 0; i < 20; i++)
+                {
+                    var content = CreateContent(random.Next(2) == 0 ? random.Next(1, 5000) : random.Next(1, 300000), 10 + i);
+                    var encoded = new byte[LZ4Codec.MaximumOutputLength(content.Length)];
+                    var expected = new byte[encoded.Length];
+                    var encodedLength = context.Encode(content, 0, content.Length, encoded, 0, encoded.Length);
+                    using (var newContext = new LZ4CompressionContext(highCompression))
+                        Assert.AreEqual(newContext.Encode(content, 0, content.Length, expected, 0, expected.Length), encodedLength);
+                    Assert.AreEqual(expected, encoded);
+
+                    var decoded = new byte[content.Length];
+                    Assert.AreEqual(content.Length, LZ4Codec.Decode(encoded, 0, encodedLength, decoded, 0, decoded.Length, true));
+                    Assert.AreEqual(content, decoded);
+                }
+            }
+        }
+
+        [Test]
+        public void DefaultCompressionLevel()
+        {
+            // Level 0 is the default level, even after a sequence compressed at another level by the same context
+            var content = CreateContent(100000, 2);
+            var encoded = new byte[LZ4Codec.MaximumOutputLength(content.Length)];
+            using (var context = new LZ4CompressionContext(true))
+            {
+                var defaultLength = context.Encode(content, 0, content.Length, encoded, 0, encoded.Length, LZ4Codec.DefaultCompressionLevelHC);
+                context.EncodeLinked(content, 0, 1000, encoded, 0, encoded.Length, LZ4Codec.OptimalCompressionLevelHC);
+                Assert.AreEqual(defaultLength, context.Encode(content, 0, content.Length, encoded, 0, encoded.Length));
+
+                context.EncodeLinked(new byte[0], 0, 0, content, 0, 1000, encoded, 0, encoded.Length, LZ4Codec.OptimalCompressionLevelHC);
+                Assert.AreEqual(defaultLength, context.Encode(content, 0, content.Length, encoded, 0, encoded.Length));
+            }
+        }
+
+        [Test]
+        public void LinkedBlocks()
+        {
+            var content = CreateContent(1000000, 4);
+            var random = new Random(4);
+
+            foreach (var highCompression in new[] { false, true })
+            using (var context = new LZ4CompressionContext(highCompression))
+            using (var historyContext = new LZ4CompressionContext(highCompression))
+            {
+                var blocks = new List<byte[]>();
+                var blockLengths = new List<int>();
+                for (var position = 0; position < content.Length;)
+                {
+                    var length = Math.Min(content.Length - position, random.Next(2) == 0 ? random.Next(5000) : random.Next(300000));
+                    var block = new byte[LZ4Codec.MaximumOutputLength(length)];
+                    var blockLength = context.EncodeLinked(content, position, length, block, 0, block.Length);
+                    Array.Resize(ref block, blockLength);
+
+                    // The same block compressed from an explicit history
+                    if (highCompression)
+                    {
+                        var historyBlock = new byte[LZ4Codec.MaximumOutputLength(length)];
+                        var historyBlockLength = historyContext.EncodeLinked(content, 0, position, content, position, length, historyBlock, 0, historyBlock.Length);
+                        Array.Resize(ref historyBlock, historyBlockLength);
+                        Assert.AreEqual(block, historyBlock);
+                    }
+
+                    blocks.Add(block);
+                    blockLengths.Add(length);
+                    position += length;
+                }
+
+                var decoded = new byte[content.Length];
+                for (int i = 0, position = 0; i < blocks.Count; position += blockLengths[i], i++)
+                {
+                    var historyLength = i % 2 == 0 ? position : Math.Min(position, LZ4Codec.LinkedHistoryLength);
+                    Assert.AreEqual(blockLengths[i], LZ4Codec.DecodeLinked(blocks[i], 0, blocks[i].Length, decoded, position, blockLengths[i], historyLength, true));
+                }
+                Assert.AreEqual(content, decoded);
+            }
+        }
+
+        [Test]
+        public void Dictionary()
+        {
+            var random = new Random(5);
+            var objects = new List<byte[]>();
+            for (var i = 0; i < 300; i++)
+            {
+                var builder = new StringBuilder("!SiliconStudio.Xenko.Engine.Entity,SiliconStudio.Xenko.Engine\nId: " + random.Next() + "\n");
+                for (var j = 3 + random.Next(40); j > 0; j--)
+                    builder.Append("    " + Words[random.Next(Words.Length)].Trim() + ": {X: " + random.Next(100) + ", Y: " + random.Next(1000) + "}\n");
+                objects.Add(Encoding.UTF8.GetBytes(builder.ToString()));
+            }
+
+            // Trained on the first objects, used for the others
+            var samples = new MemoryStream();
+            var sampleLengths = new int[200];
+            for (var i = 0; i < sampleLengths.Length; i++)
+            {
+                samples.Write(objects[i], 0, objects[i].Length);
+                sampleLengths[i] = objects[i].Length;
+            }
+
+            using (var dictionary = LZ4Dictionary.Train(samples.ToArray(), sampleLengths, (int)samples.Length / 16))
+            using (var loadedDictionary = new LZ4Dictionary(dictionary.ToArray()))
+            {
+                Assert.IsNotNull(dictionary);
+
+                foreach (var highCompression in new[] { false, true })
+                {
+                    foreach (var linkedChunks in new[] { false, true })
+                    {
+                        long plainLength = 0, dictionaryLength = 0;
+                        for (var i = sampleLengths.Length; i < objects.Count; i++)
+                        {
+                            var plain = Compress(objects[i], highCompression, linkedChunks, null, 1, LZ4Stream.FrameFlags.None);
+                            var compressed = Compress(objects[i], highCompression, linkedChunks, dictionary, 1, LZ4Stream.FrameFlags.None);
+                            plainLength += plain.Length;
+                            dictionaryLength += compressed.Length;
+
+                            using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress, dictionary: loadedDictionary))
+                                Assert.AreEqual(objects[i], ReadAll(stream));
+                            using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress))
+                                Assert.Throws<InvalidOperationException>(() => ReadAll(stream));
+                        }
+                        Assert.That(dictionaryLength, Is.LessThan(plainLength));
+                    }
+
+                    // Independent blocks
+                    var content = objects[objects.Count - 1];
+                    var encoded = new byte[LZ4Codec.MaximumOutputLength(content.Length)];
+                    var encodedLength = highCompression
+                        ? LZ4Codec.EncodeHC(content, 0, content.Length, encoded, 0, encoded.Length, dictionary)
+                        : LZ4Codec.Encode(content, 0, content.Length, encoded, 0, encoded.Length, dictionary);
+                    var decoded = new byte[content.Length];
+                    Assert.AreEqual(content.Length, LZ4Codec.Decode(encoded, 0, encodedLength, decoded, 0, decoded.Length, loadedDictionary, true));
+                    Assert.AreEqual(content, decoded);
+                }
+            }
+        }
+
+        [Test]
+        public void CompressionThreadCount()
+        {
+            var content = CreateContent(1000000, 6);
+
+            foreach (var highCompression in new[] { false, true })
+            foreach (var linkedChunks in new[] { false, true })
+            {
+                var serial = Compress(content, highCompression, linkedChunks, null, 1, LZ4Stream.FrameFlags.BlockChecksum);
+                foreach (var threadCount in new[] { 0, 4 })
+                {
+                    var compressed = Compress(content, highCompression, linkedChunks, null, threadCount, LZ4Stream.FrameFlags.BlockChecksum);
+
+                    // The fast compressor of a linked chunk finds other matches in a history copied to another thread
+                    if (highCompression || !linkedChunks)
+                        Assert.AreEqual(serial, compressed);
+
+                    using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress))
+                        Assert.AreEqual(content, ReadAll(stream));
+                }
+            }
+        }
+
+        [Test]
+        public void DecompressionThreadCount()
+        {
+            var content = CreateContent(1000000, 11);
+            var random = new Random(11);
+
+            foreach (var highCompression in new[] { false, true })
+            foreach (var linkedChunks in new[] { false, true })
+            {
+                var compressed = Compress(content, highCompression, linkedChunks, null, 1, LZ4Stream.FrameFlags.None);
+                foreach (var threadCount in new[] { 0, 1, 4 })
+                {
+                    using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress, threadCount: threadCount))
+                        Assert.AreEqual(content, ReadAll(stream));
+
+                    // Reads smaller than a chunk, served from the chunks decompressed ahead
+                    using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress, threadCount: threadCount))
+                    {
+                        var decoded = new byte[content.Length];
+                        int position = 0, read;
+                        while ((read = stream.Read(decoded, position, Math.Min(decoded.Length - position, 1 + random.Next(5000)))) > 0)
+                            position += read;
+                        Assert.AreEqual(content.Length, position);
+                        Assert.AreEqual(content, decoded);
+                    }
+                }
+            }
+        }
+
+        [Test]
+        public void DirectReads()
+        {
+            // Reads with room for whole chunks decompress them into the destination, before and after reads through the buffer of the stream
+            var content = CreateContent(1000000, 12);
+            var random = new Random(12);
+
+            foreach (var linkedChunks in new[] { false, true })
+            foreach (var threadCount in new[] { 1, 3 })
+            {
+                var compressed = Compress(content, false, linkedChunks, null, 1, LZ4Stream.FrameFlags.None);
+                var destination = Marshal.AllocHGlobal(content.Length);
+                try
+                {
+                    using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress, threadCount: threadCount))
+                    {
+                        for (var position = 0; position < content.Length;)
+                        {
+                            var length = random.Next(2) == 0 ? random.Next(1, 1000) : random.Next(BlockSize, 4 * BlockSize);
+                            var read = stream.Read(destination + position, Math.Min(length, content.Length - position));
+                            Assert.That(read, Is.GreaterThan(0));
+                            position += read;
+                        }
+                        Assert.AreEqual(0, stream.Read(destination, content.Length));
+                    }
+
+                    var decoded = new byte[content.Length];
+                    Marshal.Copy(destination, decoded, 0, decoded.Length);
+                    Assert.AreEqual(content, decoded);
+                }
+                finally
+                {
+                    Marshal.FreeHGlobal(destination);
+                }
+            }
+        }
+
+        [Test]
+        public void Frames()
+        {
+            var content = CreateContent(300000, 3);
+            var options = new[] { LZ4Stream.FrameFlags.BlockChecksum, LZ4Stream.FrameFlags.ContentChecksum, LZ4Stream.FrameFlags.ContentSize, LZ4Stream.FrameFlags.BlockIndex };
+
+            // Every combination of the options
+            for (var combination = 0; combination < 1 << options.Length; combination++)
+            {
+                var frame = LZ4Stream.FrameFlags.None;
+                for (var i = 0; i < options.Length; i++)
+                {
+                    if ((combination & (1 << i)) != 0)
+                        frame |= options[i];
+                }
+
+                foreach (var linkedChunks in new[] { false, true })
+                {
+                    if (linkedChunks && (frame & LZ4Stream.FrameFlags.BlockIndex) != 0)
+                    {
+                        Assert.Throws<ArgumentException>(() => new LZ4Stream(new MemoryStream(), CompressionMode.Compress, linkedChunks: true, frame: frame));
+                        continue;
+                    }
+
+                    var compressed = Compress(content, false, linkedChunks, null, 1, frame);
+                    var expectedFrame = frame == LZ4Stream.FrameFlags.None ? frame : frame | (linkedChunks ? LZ4Stream.FrameFlags.None : LZ4Stream.FrameFlags.IndependentChunks);
+
+                    foreach (var threadCount in new[] { 1, 3 })
+                    {
+                        using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress, threadCount: threadCount))
+                        {
+                            Assert.AreEqual(expectedFrame, stream.Frame);
+                            Assert.AreEqual((frame & LZ4Stream.FrameFlags.ContentSize) != 0 ? content.Length : -1, stream.Length);
+                            Assert.AreEqual(content, ReadAll(stream));
+                            Assert.AreEqual(-1, stream.ReadByte());
+                        }
+                    }
+                }
+            }
+        }
+
+        [Test]
+        public void Checksum()
+        {
+            // Test vector of xxHash32
+            Assert.AreEqual(0xe2293b2f, LZ4Codec.Checksum(Encoding.ASCII.GetBytes("Nobody inspects the spammish repetition"), 0, 39));
+
+            var content = CreateContent(100000, 8);
+            var random = new Random(8);
+            foreach (var seed in new[] { 0u, 1234u })
+            using (var checksum = new LZ4Checksum(seed))
+            {
+                for (var position = 0; position < content.Length;)
+                {
+                    var length = Math.Min(content.Length - position, random.Next(5000));
+                    checksum.Update(content, position, length);
+                    position += length;
+                }
+                Assert.AreEqual(LZ4Codec.Checksum(content, 0, content.Length, seed), checksum.Value);
+            }
+        }
+
+        [Test]
+        public void CorruptedStream()
+        {
+            // Random bytes are stored uncompressed: a byte changed in the middle of the stream changes the content alone
+            var content = new byte[300000];
+            new Random(9).NextBytes(content);
+
+            foreach (var frame in new[] { LZ4Stream.FrameFlags.BlockChecksum, LZ4Stream.FrameFlags.ContentChecksum })
+            {
+                var corrupted = Compress(content, false, false, null, 1, frame);
+                corrupted[corrupted.Length / 2] ^= 0x10;
+                using (var stream = new LZ4Stream(new MemoryStream(corrupted), CompressionMode.Decompress))
+                {
+                    var exception = Assert.Throws<InvalidOperationException>(() => ReadAll(stream));
+                    StringAssert.Contains("checksum", exception.Message);
+                }
+            }
+
+            // A frame without its end
+            var truncated = Compress(CreateContent(300000, 9), false, false, null, 1, LZ4Stream.FrameFlags.BlockChecksum);
+            Array.Resize(ref truncated, truncated.Length - 3);
+            using (var stream = new LZ4Stream(new MemoryStream(truncated), CompressionMode.Decompress))
+                Assert.Throws<EndOfStreamException>(() => ReadAll(stream));
+        }
+
+        [Test]
+        public void Baseline()
+        {
+            // Streams of previous versions have no frame
+            foreach (var threadCount in new[] { 1, 3 })
+            using (var stream = new LZ4Stream(new MemoryStream(BaselineStream), CompressionMode.Decompress, threadCount: threadCount))
+            {
+                Assert.AreEqual(LZ4Stream.FrameFlags.None, stream.Frame);
+                Assert.AreEqual(BaselineContent(), ReadAll(stream));
+            }
+
+            // and are still written without one by default
+            var content = BaselineContent();
+            var compressed = new MemoryStream();
+            using (var stream = new LZ4Stream(compressed, CompressionMode.Compress, blockSize: 1024))
+            {
+                stream.Write(content, 0, content.Length - 100);
+                stream.Flush();
+                stream.Write(content, content.Length - 100, 100);
+            }
+            Assert.AreEqual(BaselineStream, compressed.ToArray());
+        }
+
+        [Test]
+        public void Seek()
+        {
+            var content = CreateContent(1000000, 7);
+            var random = new Random(7);
+            var compressed = Compress(content, false, false, null, 1, LZ4Stream.FrameFlags.BlockChecksum | LZ4Stream.FrameFlags.BlockIndex);
+
+            // The block index is found from the end of the stream
+            using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress))
+                Assert.IsFalse(stream.CanSeek);
+
+            foreach (var threadCount in new[] { 1, 3 })
+            using (var stream = new LZ4Stream(new MemoryStream(compressed), CompressionMode.Decompress, compressedSize: compressed.Length, threadCount: threadCount))
+            {
+                Assert.IsTrue(stream.CanSeek);
+                Assert.AreEqual(content.Length, stream.Length);
+
+                for (var i = 0; i < 100; i++)
+                {
+                    var target = random.Next(content.Length + 1);
+                    if (i % 10 == 9)
+                        stream.Seek(target - content.Length, SeekOrigin.End);
+                    else
+                        stream.Position = target;
+                    Assert.AreEqual(target, stream.Position);
+
+                    var buffer = new byte[random.Next(2) == 0 ? 10 : 200000];
+                    var expectedLength = Math.Min(buffer.Length, content.Length - target);
+                    int length = 0, read;
+                    while (length < buffer.Length && (read = stream.Read(buffer, length, buffer.Length - length)) > 0)
+                        length += read;
+                    Assert.AreEqual(expectedLength, length);
+                    for (var j = 0; j < length; j++)
+                        Assert.AreEqual(content[target + j], buffer[j]);
+                }
+
+                stream.Seek(0, SeekOrigin.Begin);
+                Assert.AreEqual(content, ReadAll(stream));
+            }
+        }
+
+        [Test]
+        public void OptimalCompressionLevel()
+        {
+            var content = CreateContent(300000, 13);
+            var encoded = new byte[LZ4Codec.MaximumOutputLength(content.Length)];
+            var decoded = new byte[content.Length];
+
+            var defaultLength = LZ4Codec.EncodeHC(content, 0, content.Length, encoded, 0, encoded.Length, LZ4Codec.DefaultCompressionLevelHC);
+            var optimalLength = LZ4Codec.EncodeHC(content, 0, content.Length, encoded, 0, encoded.Length, LZ4Codec.OptimalCompressionLevelHC);
+            Assert.That(optimalLength, Is.GreaterThan(0).And.LessThan(defaultLength));
+            Assert.AreEqual(content.Length, LZ4Codec.Decode(encoded, 0, optimalLength, decoded, 0, decoded.Length, true));
+            Assert.AreEqual(content, decoded);
+
+            // Linked chunks of a stream
+            var compressed = new MemoryStream();
+            using (var stream = new LZ4Stream(compressed, CompressionMode.Compress, true, blockSize: BlockSize, compressionLevel: LZ4Codec.OptimalCompressionLevelHC, linkedChunks: true))
+                stream.Write(content, 0, content.Length);
+            using (var stream = new LZ4Stream(new MemoryStream(compressed.ToArray()), CompressionMode.Decompress))
+                Assert.AreEqual(content, ReadAll(stream));
+        }
+
+        [Test]
+        public void DecoderCopies()
+        {
+            // Literal runs and matches of every length, at offsets below and above the 16 bytes copied at a time,
+            // decoded into an output of their exact length: the copies must not write past its end
+            var random = new Random(14);
+            for (var offset = 1; offset <= 40; offset++)
+            {
+                var content = new byte[1000 + random.Next(1000)];
+                for (var position = 0; position < content.Length;)
+                {
+                    for (var literalLength = random.Next(40); literalLength > 0 && position < content.Length; literalLength--)
+                        content[position++] = (byte)random.Next(256);
+                    for (var matchLength = 4 + random.Next(60); matchLength > 0 && position < content.Length; matchLength--, position++)
+                        content[position] = position >= offset ? content[position - offset] : (byte)random.Next(256);
+                }
+
+                var encoded = new byte[LZ4Codec.MaximumOutputLength(content.Length)];
+                var encodedLength = LZ4Codec.Encode(content, 0, content.Length, encoded, 0, encoded.Length);
+                foreach (var knownOutputLength in new[] { true, false })
+                {
+                    var decoded = new byte[content.Length + 32];
+                    for (var i = content.Length; i < decoded.Length; i++)
+                        decoded[i] = 0xcd;
+
+                    Assert.AreEqual(content.Length, LZ4Codec.Decode(encoded, 0, encodedLength, decoded, 0, content.Length, knownOutputLength));
+                    for (var i = 0; i < content.Length; i++)
+                        Assert.AreEqual(content[i], decoded[i]);
+                    for (var i = content.Length; i < decoded.Length; i++)
+                        Assert.AreEqual(0xcd, decoded[i]);
+                }
+            }
+        }
+
+        private static byte[] BaselineContent()
+        {
+            var text = new StringBuilder();
+            for (var i = 0; i < 100; i++)
+                text.Append("Xenko LZ4 chunk " + i + "\n");
+
+            var content = new byte[text.Length + 100];
+            Encoding.ASCII.GetBytes(text.ToString(), 0, text.Length, content, 0);
+            var seed = 1u;
+            for (var i = text.Length; i < content.Length; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                content[i] = (byte)(seed >> 16);
+            }
+            return content;
+        }
+
+        private static byte[] CreateContent(int length, int seed)
+        {
+            // Text made of a few words, and an incompressible area
+            var random = new Random(seed);
+            var content = new byte[length];
+            for (var position = 0; position < length;)
+            {
+                foreach (var c in Words[random.Next(Words.Length)])
+                {
+                    if (position < length)
+                        content[position++] = (byte)c;
+                }
+            }
+            for (var position = length / 3; position < length / 3 + length / 10; position++)
+                content[position] = (byte)random.Next(256);
+            return content;
+        }
+
+        private static byte[] Compress(byte[] content, bool highCompression, bool linkedChunks, LZ4Dictionary dictionary, int threadCount, LZ4Stream.FrameFlags frame)
+        {
+            var random = new Random(content.Length);
+            var compressed = new MemoryStream();
+            using (var stream = new LZ4Stream(compressed, CompressionMode.Compress, highCompression, content.Length, blockSize: BlockSize, linkedChunks: linkedChunks, dictionary: dictionary, threadCount: threadCount, frame: frame))
+            {
+                // Writes of various sizes, some of them smaller than a chunk
+                for (var position = 0; position < content.Length;)
+                {
+                    var length = Math.Min(content.Length - position, random.Next(3) == 0 ? 1 : random.Next(200000));
+                    if (length == 1)
+                        stream.WriteByte(content[position]);
+                    else
+                        stream.Write(content, position, length);
+                    position += length;
+                }
+            }
+            return compressed.ToArray();
+        }
+
+        private static byte[] ReadAll(Stream stream)
+        {
+            var result = new MemoryStream();
+            var buffer = new byte[100000];
+            int read;
+            while ((read = stream.Read(buffer, 0, buffer.Length)) > 0)
+                result.Write(buffer, 0, read);
+            return result.ToArray();
+        }
+    }
+}
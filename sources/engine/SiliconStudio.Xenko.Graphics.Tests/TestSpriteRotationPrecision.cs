@@ -0,0 +1,73 @@
+﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+using System;
+
+using NUnit.Framework;
+
+using SiliconStudio.Core.Mathematics;
+
+namespace SiliconStudio.Xenko.Graphics.Tests
+{
+    /// <summary>
+    /// Test the accuracy of the sprite rotations evaluated with each <see cref="SpriteRotationPrecision"/> against the standard math library.
+    /// </summary>
+    [TestFixture]
+    public class TestSpriteRotationPrecision
+    {
+        private const int AngleCount = 100000;
+
+        [TestCase(SpriteRotationPrecision.Exact, 100f, 1e-6)]
+        [TestCase(SpriteRotationPrecision.Exact, 65536f, 1e-6)]
+        [TestCase(SpriteRotationPrecision.Fast, 100f, 2e-7)]
+        [TestCase(SpriteRotationPrecision.Fast, 65536f, 2e-6)]
+        [TestCase(SpriteRotationPrecision.Fast, 1e7f, 2e-6)]
+        [TestCase(SpriteRotationPrecision.Approximate, 100f, 2e-5)]
+        [TestCase(SpriteRotationPrecision.Approximate, 65536f, 2e-5)]
+        public void TestAccuracy(SpriteRotationPrecision precision, float range, double maximumError)
+        {
+            var random = new Random(0);
+            var angles = new float[AngleCount];
+            for (int i = 0; i < angles.Length; i++)
+                angles[i] = (float)((random.NextDouble() * 2 - 1) * range);
+
+            var sines = new float[AngleCount];
+            var cosines = new float[AngleCount];
+            SpriteBatch.SinCos(angles, sines, cosines, precision);
+
+            for (int i = 0; i < angles.Length; i++)
+            {
+                // rotations below 1e-6 are not applied
+                var expectedSine = Math.Abs(angles[i]) > 1e-6f ? Math.Sin(angles[i]) : 0.0;
+                var expectedCosine = Math.Abs(angles[i]) > 1e-6f ? Math.Cos(angles[i]) : 1.0;
+
+                Assert.That(sines[i], Is.EqualTo(expectedSine).Within(maximumError), "Sine of {0}", angles[i]);
+                Assert.That(cosines[i], Is.EqualTo(expectedCosine).Within(maximumError), "Cosine of {0}", angles[i]);
+            }
+        }
+
+        [TestCase(SpriteRotationPrecision.Exact)]
+        [TestCase(SpriteRotationPrecision.Fast)]
+        [TestCase(SpriteRotationPrecision.Approximate)]
+        public void TestSpecialAngles(SpriteRotationPrecision precision)
+        {
+            var angles = new[] { 0.0f, -0.0f, 1e-7f, -1e-6f, float.NaN, MathUtil.PiOverTwo, -MathUtil.Pi, MathUtil.TwoPi };
+            var sines = new float[angles.Length];
+            var cosines = new float[angles.Length];
+            SpriteBatch.SinCos(angles, sines, cosines, precision);
+
+            // no rotation: exactly 0 and 1
+            for (int i = 0; i < 5; i++)
+            {
+                Assert.That(sines[i], Is.EqualTo(0.0f), "Sine of {0}", angles[i]);
+                Assert.That(cosines[i], Is.EqualTo(1.0f), "Cosine of {0}", angles[i]);
+            }
+
+            var tolerance = precision == SpriteRotationPrecision.Approximate ? 2e-5 : 1e-6;
+            for (int i = 5; i < angles.Length; i++)
+            {
+                Assert.That(sines[i], Is.EqualTo(Math.Sin(angles[i])).Within(tolerance), "Sine of {0}", angles[i]);
+                Assert.That(cosines[i], Is.EqualTo(Math.Cos(angles[i])).Within(tolerance), "Cosine of {0}", angles[i]);
+            }
+        }
+    }
+}
@@ -25,6 +25,7 @@ using System;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
 using SiliconStudio.Core;
+using SiliconStudio.Xenko.Native;
 using SiliconStudio.Xenko.Rendering;
 using SiliconStudio.Xenko.Shaders;
 
@@ -86,6 +87,10 @@ namespace SiliconStudio.Xenko.Graphics
         private ObjectParameterAccessor<SamplerState>? samplerUpdater;
 
         private int[] sortIndices;
+        private int[] sortIndicesTemp;
+        private ulong[] sortKeys;
+        private ulong[] sortKeysTemp;
+        private readonly Dictionary<Texture, int> textureSortIds = new Dictionary<Texture, int>();
         private ElementInfo[] sortedDraws;
         private ElementInfo[] drawsQueue;
         private int drawsQueueCount;
@@ -111,8 +116,17 @@ namespace SiliconStudio.Xenko.Graphics
         protected QueueComparer<ElementInfo> BackToFrontComparer { get; set; }
         protected QueueComparer<ElementInfo> FrontToBackComparer { get; set; }
 
+        private readonly TextureIdComparer defaultTextureComparer;
+        private readonly QueueComparer<ElementInfo> defaultBackToFrontComparer;
+        private readonly QueueComparer<ElementInfo> defaultFrontToBackComparer;
+
         internal const float DepthBiasShiftOneUnit = 0.0001f;
 
+        /// <summary>
+        /// The size in bytes of an <see cref="ElementInfo"/>, i.e. the stride between two consecutive draw infos of an element array.
+        /// </summary>
+        protected static readonly int ElementInfoSize = Utilities.SizeOf<ElementInfo>();
+
         protected BatchBase(GraphicsDevice device, EffectBytecode defaultEffectByteCode, EffectBytecode defaultEffectByteCodeSRgb, ResourceBufferInfo resourceBufferInfo, VertexDeclaration vertexDeclaration, int indexSize = sizeof(short))
         {
             if (defaultEffectByteCode == null) throw new ArgumentNullException(nameof(defaultEffectByteCode));
@@ -129,9 +143,9 @@ namespace SiliconStudio.Xenko.Graphics
             drawsQueue = new ElementInfo[resourceBufferInfo.BatchCapacity];
             drawTextures = new Texture[resourceBufferInfo.BatchCapacity];
 
-            TextureComparer = new TextureIdComparer();
-            BackToFrontComparer = new SpriteBackToFrontComparer();
-            FrontToBackComparer = new SpriteFrontToBackComparer();
+            TextureComparer = defaultTextureComparer = new TextureIdComparer();
+            BackToFrontComparer = defaultBackToFrontComparer = new SpriteBackToFrontComparer();
+            FrontToBackComparer = defaultFrontToBackComparer = new SpriteFrontToBackComparer();
 
             // set the vertex layout and size
             indexStructSize = indexSize;
@@ -292,6 +306,19 @@ namespace SiliconStudio.Xenko.Graphics
         
         private void SortSprites()
         {
+            if ((sortIndices == null) || (sortIndices.Length < drawsQueueCount))
+            {
+                sortIndices = new int[drawsQueueCount];
+                sortedDraws = new ElementInfo[drawsQueueCount];
+            }
+
+            // The default orders are sorted natively on packed keys, custom comparers still go through Array.Sort
+            if (TextureComparer == defaultTextureComparer && BackToFrontComparer == defaultBackToFrontComparer && FrontToBackComparer == defaultFrontToBackComparer)
+            {
+                SortSpritesByKey();
+                return;
+            }
+
             IComparer<int> comparer;
 
             switch (SortMode)
@@ -314,12 +341,6 @@ namespace SiliconStudio.Xenko.Graphics
                     throw new NotSupportedException();
             }
 
-            if ((sortIndices == null) || (sortIndices.Length < drawsQueueCount))
-            {
-                sortIndices = new int[drawsQueueCount];
-                sortedDraws = new ElementInfo[drawsQueueCount];
-            }
-
             // Reset all indices to the original order
             for (int i = 0; i < drawsQueueCount; i++)
             {
@@ -329,6 +350,70 @@ namespace SiliconStudio.Xenko.Graphics
             Array.Sort(sortIndices, 0, drawsQueueCount, comparer);
         }
 
+        /// <summary>
+        /// Sorts the queued sprites with a stable radix sort on 64-bit keys: the depth in the high bits (if any) and the texture id in the low bits.
+        /// </summary>
+        /// <remarks>Texture ids are given in order of first use, so that sprites sharing a texture (or a depth and a texture) stay together in submission order.</remarks>
+        private unsafe void SortSpritesByKey()
+        {
+            if ((sortKeys == null) || (sortKeys.Length < sortIndices.Length))
+            {
+                sortKeys = new ulong[sortIndices.Length];
+                sortKeysTemp = new ulong[sortIndices.Length];
+                sortIndicesTemp = new int[sortIndices.Length];
+            }
+
+            for (int i = 0; i < drawsQueueCount; i++)
+            {
+                var texture = drawTextures[i];
+                int textureId;
+                if (!textureSortIds.TryGetValue(texture, out textureId))
+                {
+                    textureId = textureSortIds.Count;
+                    textureSortIds.Add(texture, textureId);
+                }
+
+                switch (SortMode)
+                {
+                    case SpriteSortMode.Texture:
+                        sortKeys[i] = (ulong)textureId;
+                        break;
+
+                    case SpriteSortMode.BackToFront:
+                        sortKeys[i] = ((ulong)DepthToSortKey(drawsQueue[i].Depth) << 32) | (uint)textureId;
+                        break;
+
+                    case SpriteSortMode.FrontToBack:
+                        sortKeys[i] = ((ulong)~DepthToSortKey(drawsQueue[i].Depth) << 32) | (uint)textureId;
+                        break;
+                    default:
+                        throw new NotSupportedException();
+                }
+            }
+            textureSortIds.Clear();
+
+            fixed (ulong* keys = sortKeys)
+            fixed (ulong* tempKeys = sortKeysTemp)
+            fixed (int* indices = sortIndices)
+            fixed (int* tempIndices = sortIndicesTemp)
+            {
+                NativeInvoke.SortSpriteKeys(new IntPtr(keys), new IntPtr(indices), drawsQueueCount, new IntPtr(tempKeys), new IntPtr(tempIndices));
+            }
+        }
+
+        /// <summary>
+        /// Maps a depth to an unsigned integer with the same ordering.
+        /// </summary>
+        private static unsafe uint DepthToSortKey(float depth)
+        {
+            // -0 and +0 must give the same key
+            if (depth == 0.0f)
+                depth = 0.0f;
+
+            var bits = *(uint*)&depth;
+            return (bits & 0x80000000) != 0 ? ~bits : bits | 0x80000000;
+        }
+
         private void FlushBatch()
         {
             ElementInfo[] spriteQueueForBatch;
@@ -486,16 +571,8 @@ namespace SiliconStudio.Xenko.Graphics
                     var vertexPointer = mappedVertices.DataBox.DataPointer;
                     var indexPointer = mappedIndices.DataBox.DataPointer;
 
-                    for (var i = 0; i < batchSize; i++)
-                    {
-                        var spriteIndex = offset + i;
-
-                        UpdateBufferValuesFromElementInfo(ref sprites[spriteIndex], vertexPointer, indexPointer, ResourceContext.VertexBufferPosition);
-                        
-                        ResourceContext.VertexBufferPosition += sprites[spriteIndex].VertexCount;
-                        vertexPointer += vertexStructSize * sprites[spriteIndex].VertexCount;
-                        indexPointer += indexStructSize * sprites[spriteIndex].IndexCount;
-                    }
+                    UpdateBufferValuesFromElementInfo(sprites, offset, batchSize, vertexPointer, indexPointer, ResourceContext.VertexBufferPosition);
+                    ResourceContext.VertexBufferPosition += vertexCount;
 
                     GraphicsContext.CommandList.UnmapSubresource(mappedVertices);
                     if (ResourceContext.IsIndexBufferDynamic)
@@ -550,6 +627,31 @@ namespace SiliconStudio.Xenko.Graphics
         /// <param name="indexPointer">The pointer to the index array buffer to update. This value is null if the index buffer used is static.</param>
         /// <param name="vexterStartOffset">The offset in the vertex buffer where the vertex of the element starts</param>
         protected abstract void UpdateBufferValuesFromElementInfo(ref ElementInfo elementInfo, IntPtr vertexPointer, IntPtr indexPointer, int vexterStartOffset);
+
+        /// <summary>
+        /// Update the mapped vertex and index buffer values using a contiguous range of element infos.
+        /// </summary>
+        /// <remarks>The default implementation calls <see cref="UpdateBufferValuesFromElementInfo(ref ElementInfo, IntPtr, IntPtr, int)"/> for each element. 
+        /// Override it to fill the whole range at once (for example in a single native call).</remarks>
+        /// <param name="elementInfos">The array containing the information about the elements to draw.</param>
+        /// <param name="offset">The index of the first element to draw in <paramref name="elementInfos"/>.</param>
+        /// <param name="count">The number of elements to draw.</param>
+        /// <param name="vertexPointer">The pointer to the vertex array buffer to update.</param>
+        /// <param name="indexPointer">The pointer to the index array buffer to update. This value is null if the index buffer used is static.</param>
+        /// <param name="vertexStartOffset">The offset in the vertex buffer where the vertex of the first element starts</param>
+        protected virtual void UpdateBufferValuesFromElementInfo(ElementInfo[] elementInfos, int offset, int count, IntPtr vertexPointer, IntPtr indexPointer, int vertexStartOffset)
+        {
+            for (var i = 0; i < count; i++)
+            {
+                var elementIndex = offset + i;
+
+                UpdateBufferValuesFromElementInfo(ref elementInfos[elementIndex], vertexPointer, indexPointer, vertexStartOffset);
+
+                vertexStartOffset += elementInfos[elementIndex].VertexCount;
+                vertexPointer += vertexStructSize * elementInfos[elementIndex].VertexCount;
+                indexPointer += indexStructSize * elementInfos[elementIndex].IndexCount;
+            }
+        }
         
         #region Nested types
 
@@ -5,6 +5,7 @@ using System;
 using System.Runtime.InteropServices;
 
 using SiliconStudio.Core.Mathematics;
+using SiliconStudio.Xenko.Native;
 using SiliconStudio.Xenko.Rendering;
 
 namespace SiliconStudio.Xenko.Graphics
@@ -173,6 +174,15 @@ namespace SiliconStudio.Xenko.Graphics
                 }
             }
         }
+
+
+        protected override unsafe void UpdateBufferValuesFromElementInfo(ElementInfo[] elementInfos, int offset, int count, IntPtr vertexPointer, IntPtr indexPointer, int vertexStartOffset)
+        {
+            fixed (Sprite3DDrawInfo* drawInfo = &elementInfos[offset].DrawInfo)
+            {
+                NativeInvoke.UpdateSprite3DBufferValuesFromElementInfoBatch(new IntPtr(drawInfo), ElementInfoSize, IntPtr.Zero, count, vertexPointer, indexPointer, vertexStartOffset);
+            }
+        }
          
         [StructLayout(LayoutKind.Sequential)]
         public struct Sprite3DDrawInfo
@@ -4,6 +4,7 @@
 using System;
 using System.Runtime.InteropServices;
 using System.Text;
+using System.Threading.Tasks;
 using SiliconStudio.Core.Mathematics;
 using SiliconStudio.Xenko.Rendering;
 using SiliconStudio.Xenko.Native;
@@ -18,12 +19,19 @@ namespace SiliconStudio.Xenko.Graphics
         private static readonly Vector2[] CornerOffsets = { Vector2.Zero, Vector2.UnitX, Vector2.One, Vector2.UnitY };
         private static Vector2 vector2Zero = Vector2.Zero;
         private static RectangleF? nullRectangle;
+
+        /// <summary>
+        /// The minimum number of sprites filled by each thread when a batch is filled in parallel.
+        /// </summary>
+        private const int MinSpritesPerFillThread = 512;
         
         private Matrix userViewMatrix;
         private Matrix userProjectionMatrix;
 
         private readonly Matrix defaultViewMatrix = Matrix.Identity;
         private Matrix defaultProjectionMatrix;
+
+        private readonly int vertexSize;
         
         /// <summary>
         /// Gets or sets the default depth value used by the <see cref="SpriteBatch"/> when the <see cref="VirtualResolution"/> is not set. 
@@ -36,16 +44,39 @@ namespace SiliconStudio.Xenko.Graphics
         /// </summary>
         public Vector3? VirtualResolution { get; set; }
 
+        /// <summary>
+        /// Gets or sets the number of sprites from which the vertices of a batch are filled by several threads. A value of 0 disables the parallel fill.
+        /// </summary>
+        /// <remarks>A batch never holds more sprites than the <c>bufferElementCount</c> given to the constructor. The default threshold (4096) is only reached by batches created with a <c>bufferElementCount</c> of at least 4096. Batches of the default size (1024 sprites) are filled by a single thread.</remarks>
+        public int ParallelFillThreshold { get; set; }
+
+        /// <summary>
+        /// Gets a value indicating whether this batch uploads <see cref="VertexPositionColorTextureSwizzleCompact"/> vertices instead of <see cref="VertexPositionColorTextureSwizzle"/> ones.
+        /// </summary>
+        public bool UseCompactVertices { get; }
+
+        /// <summary>
+        /// Gets or sets how the sine and cosine of the sprite rotations are evaluated. Default is <see cref="SpriteRotationPrecision.Fast"/>.
+        /// </summary>
+        public SpriteRotationPrecision RotationPrecision { get; set; }
+
         /// <summary>
         /// Initializes a new instance of the <see cref="SpriteBatch" /> class.
         /// </summary>
         /// <param name="graphicsDevice">The graphics device.</param>
         /// <param name="bufferElementCount">The maximum number element that can be batched in one time.</param>
         /// <param name="batchCapacity">The batch capacity default to 64.</param>
-        public SpriteBatch(GraphicsDevice graphicsDevice, int bufferElementCount = 1024, int batchCapacity = 64)
-            : base(graphicsDevice, Bytecode, BytecodeSRgb, StaticQuadBufferInfo.CreateQuadBufferInfo("SpriteBatch.VertexIndexBuffer", true, bufferElementCount, batchCapacity), VertexPositionColorTextureSwizzle.Layout)
-        {
+        /// <param name="compactVertices">If true, use the compact vertex format (24 bytes instead of 44 per vertex). Colors and texture coordinates are then clamped to [0, 1].</param>
+        public SpriteBatch(GraphicsDevice graphicsDevice, int bufferElementCount = 1024, int batchCapacity = 64, bool compactVertices = false)
+            : base(graphicsDevice, Bytecode, BytecodeSRgb, 
+                  StaticQuadBufferInfo.CreateQuadBufferInfo(compactVertices ? "SpriteBatch.VertexIndexBuffer.Compact" : "SpriteBatch.VertexIndexBuffer", true, bufferElementCount, batchCapacity), 
+                  compactVertices ? VertexPositionColorTextureSwizzleCompact.Layout : VertexPositionColorTextureSwizzle.Layout)
+        {
+            UseCompactVertices = compactVertices;
+            vertexSize = compactVertices ? VertexPositionColorTextureSwizzleCompact.Size : VertexPositionColorTextureSwizzle.Size;
             DefaultDepth = 200f;
+            ParallelFillThreshold = 4096;
+            RotationPrecision = SpriteRotationPrecision.Fast;
         }
 
         /// <summary>
@@ -585,7 +616,54 @@ namespace SiliconStudio.Xenko.Graphics
         {
             fixed (SpriteDrawInfo* drawInfo = &elementInfo.DrawInfo)
             {
-                NativeInvoke.UpdateBufferValuesFromElementInfo(new IntPtr(drawInfo), vertexPtr, indexPtr, vertexOffset);
+                UpdateBufferValuesFromDrawInfos(new IntPtr(drawInfo), 1, vertexPtr, indexPtr, vertexOffset);
+            }
+        }
+
+        protected override unsafe void UpdateBufferValuesFromElementInfo(ElementInfo[] elementInfos, int offset, int count, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset)
+        {
+            fixed (SpriteDrawInfo* drawInfo = &elementInfos[offset].DrawInfo)
+            {
+                var threadCount = Math.Min(Environment.ProcessorCount, count / MinSpritesPerFillThread);
+                if (ParallelFillThreshold <= 0 || count < ParallelFillThreshold || threadCount <= 1)
+                {
+                    UpdateBufferValuesFromDrawInfos(new IntPtr(drawInfo), count, vertexPtr, indexPtr, vertexOffset);
+                    return;
+                }
+
+                // Each thread fills the vertices (and indices) of a disjoint range of sprites
+                var drawInfoPtr = new IntPtr(drawInfo);
+                Parallel.For(0, threadCount, thread =>
+                {
+                    var start = (int)((long)count * thread / threadCount);
+                    var end = (int)((long)count * (thread + 1) / threadCount);
+                    var rangeIndexPtr = indexPtr == IntPtr.Zero ? IntPtr.Zero : indexPtr + start * 6 * sizeof(short);
+                    UpdateBufferValuesFromDrawInfos(drawInfoPtr + start * ElementInfoSize, end - start, vertexPtr + start * 4 * vertexSize, rangeIndexPtr, vertexOffset + start * 4);
+                });
+            }
+        }
+
+        private void UpdateBufferValuesFromDrawInfos(IntPtr drawInfos, int count, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset)
+        {
+            if (UseCompactVertices)
+                NativeInvoke.UpdateBufferValuesFromElementInfoBatchCompact(drawInfos, ElementInfoSize, IntPtr.Zero, count, vertexPtr, indexPtr, vertexOffset, (int)RotationPrecision);
+            else
+                NativeInvoke.UpdateBufferValuesFromElementInfoBatch(drawInfos, ElementInfoSize, IntPtr.Zero, count, vertexPtr, indexPtr, vertexOffset, (int)RotationPrecision);
+        }
+
+        /// <summary>
+        /// Evaluates the sine and cosine of the given angles as the sprite rotations are evaluated with the given precision.
+        /// </summary>
+        internal static unsafe void SinCos(float[] angles, float[] sines, float[] cosines, SpriteRotationPrecision precision)
+        {
+            if (sines.Length < angles.Length || cosines.Length < angles.Length)
+                throw new ArgumentException("The sine and cosine arrays must be as long as the angle array");
+
+            fixed (float* anglesPtr = angles)
+            fixed (float* sinesPtr = sines)
+            fixed (float* cosinesPtr = cosines)
+            {
+                NativeInvoke.FastSinCosBatch(new IntPtr(anglesPtr), new IntPtr(sinesPtr), new IntPtr(cosinesPtr), angles.Length, (int)precision);
             }
         }
 
@@ -0,0 +1,28 @@
+﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+using SiliconStudio.Core;
+
+namespace SiliconStudio.Xenko.Graphics
+{
+    /// <summary>
+    /// Defines how the sine and cosine of the sprite rotations are evaluated when filling the vertices of a <see cref="SpriteBatch"/>.
+    /// </summary>
+    [DataContract]
+    public enum SpriteRotationPrecision
+    {
+        /// <summary>
+        /// Same precision as the standard sine and cosine functions.
+        /// </summary>
+        Exact = 0,
+
+        /// <summary>
+        /// Vectorized polynomial approximation, with an absolute error below 2e-7 for angles under 100 radians.
+        /// </summary>
+        Fast = 1,
+
+        /// <summary>
+        /// Lower degree polynomial approximation, with an absolute error below 2e-5.
+        /// </summary>
+        Approximate = 2,
+    }
+}
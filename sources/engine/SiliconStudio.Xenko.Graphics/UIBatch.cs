@@ -2,10 +2,11 @@
 // This file is distributed under GPL v3. See LICENSE.md for details.
 
 using System;
-using System.Collections.Generic;
 using System.Runtime.InteropServices;
 
+using SiliconStudio.Core;
 using SiliconStudio.Core.Mathematics;
+using SiliconStudio.Xenko.Native;
 
 namespace SiliconStudio.Xenko.Graphics
 {
@@ -14,8 +15,6 @@ namespace SiliconStudio.Xenko.Graphics
     /// </summary>
     public class UIBatch : BatchBase<UIBatch.UIImageDrawInfo>
     {
-        private static readonly List<short[]> PrimiteTypeToIndices = new List<short[]>(4);
-
         private const int MaxVerticesPerElement = 16;
         private const int MaxIndicesPerElement = 54;
         private const int MaxElementBatchNumber = 2048;
@@ -29,100 +28,8 @@ namespace SiliconStudio.Xenko.Graphics
 
         private Vector4 vector4LeftTop = new Vector4(-0.5f, -0.5f, -0.5f, 1);
 
-        private readonly Vector4[] shiftVectorX = new Vector4[4];
-        private readonly Vector4[] shiftVectorY = new Vector4[4];
-
         private readonly Texture whiteTexture;
 
-        static UIBatch()
-        {
-            PrimiteTypeToIndices.Add(new short[6]);  // rectangle
-            PrimiteTypeToIndices.Add(new short[54]); // border rectangle
-            PrimiteTypeToIndices.Add(new short[36]); // cube
-            PrimiteTypeToIndices.Add(new short[36]); // reverse cube
-
-            // rectangle
-            var indices = PrimiteTypeToIndices[(int)PrimitiveType.Rectangle];
-            indices[0] = 0;
-            indices[1] = 1;
-            indices[2] = 2;
-            indices[3] = 1;
-            indices[4] = 3;
-            indices[5] = 2;
-
-            // border rectangle
-            indices = PrimiteTypeToIndices[(int)PrimitiveType.BorderRectangle];
-            var count = 0;
-            for (var j = 0; j < 3; ++j)
-            {
-                for (var l = 0; l < 3; ++l)
-                {
-                    indices[count++] = (short)((j << 2) + l + 0);
-                    indices[count++] = (short)((j << 2) + l + 1);
-                    indices[count++] = (short)((j << 2) + l + 4);
-
-                    indices[count++] = (short)((j << 2) + l + 1);
-                    indices[count++] = (short)((j << 2) + l + 5);
-                    indices[count++] = (short)((j << 2) + l + 4);
-                }
-            }
-
-            // cube
-            count = 0;
-            indices = PrimiteTypeToIndices[(int)PrimitiveType.Cube];
-            indices[count++] = 0; //front
-            indices[count++] = 1;
-            indices[count++] = 2;
-            indices[count++] = 1;
-            indices[count++] = 3;
-            indices[count++] = 2;
-
-            indices[count++] = 1; // right
-            indices[count++] = 5;
-            indices[count++] = 7;
-            indices[count++] = 1;
-            indices[count++] = 7;
-            indices[count++] = 3;
-
-            indices[count++] = 5; // back
-            indices[count++] = 4;
-            indices[count++] = 6;
-            indices[count++] = 5;
-            indices[count++] = 6;
-            indices[count++] = 7;
-
-            indices[count++] = 4; // left
-            indices[count++] = 0;
-            indices[count++] = 2;
-            indices[count++] = 4;
-            indices[count++] = 2;
-            indices[count++] = 6;
-
-            indices[count++] = 1; // top 
-            indices[count++] = 0;
-            indices[count++] = 4;
-            indices[count++] = 1;
-            indices[count++] = 4;
-            indices[count++] = 5;
-
-            indices[count++] = 2; // bottom 
-            indices[count++] = 3;
-            indices[count++] = 6;
-            indices[count++] = 3;
-            indices[count++] = 7;
-            indices[count  ] = 6;
-
-            // reverse cube
-            var cubeIndices = PrimiteTypeToIndices[(int)PrimitiveType.Cube];
-            indices = PrimiteTypeToIndices[(int)PrimitiveType.ReverseCube];
-            for( var i=0; i<cubeIndices.Length; i += 3)
-            {
-                indices[i+0] = cubeIndices[i+0];
-                indices[i+1] = cubeIndices[i+2];
-                indices[i+2] = cubeIndices[i+1];
-            }
-        }
-
         /// <summary>
         /// Creates a new instance of <see cref="UIBatch"/>.
         /// </summary>
@@ -467,180 +374,40 @@ namespace SiliconStudio.Xenko.Graphics
 
         protected override unsafe void UpdateBufferValuesFromElementInfo(ref ElementInfo elementInfo, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset)
         {
-            // the vertex buffer
-            var vertex = (VertexPositionColorTextureSwizzle*)vertexPtr;
             fixed (UIImageDrawInfo* drawInfo = &elementInfo.DrawInfo)
             {
-                switch (drawInfo->Primitive)
-                {
-                    case PrimitiveType.Rectangle:
-                        CalculateRectangleVertices(drawInfo, vertex);
-                        break;
-                    case PrimitiveType.BorderRectangle:
-                        CalculateBorderRectangleVertices(drawInfo, vertex);
-                        break;
-                    case PrimitiveType.Cube:
-                    case PrimitiveType.ReverseCube:
-                        CalculateCubeVertices(drawInfo, vertex);
-                        break;
-                    default:
-                        throw new ArgumentOutOfRangeException();
-                }
-
-                // the index buffer
-                var index = (short*)indexPtr;
-                var indices = PrimiteTypeToIndices[(int)drawInfo->Primitive];
-                for (var i = 0; i < indices.Length; ++i)
-                    index[i] = (short)(indices[i] + vertexOffset);
+                UpdateBufferValues(drawInfo, 1, vertexPtr, indexPtr, vertexOffset);
             }
         }
 
-        private unsafe void CalculateCubeVertices(UIImageDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertex)
+        protected override unsafe void UpdateBufferValuesFromElementInfo(ElementInfo[] elementInfos, int offset, int count, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset)
         {
-            var currentPosition = drawInfo->LeftTopCornerWorld;
-            
-            // set the two first line of vertices
-            for (var l = 0; l < 2; ++l)
+            fixed (UIImageDrawInfo* drawInfo = &elementInfos[offset].DrawInfo)
             {
-                for (int r = 0; r < 2; r++)
-                {
-                    for (int c = 0; c < 2; c++)
-                    {
-                        vertex->Color = drawInfo->Color;
-                        vertex->Swizzle = (int)drawInfo->Swizzle;
-                        vertex->TextureCoordinate.X = 0; // cubes are used only for color
-                        vertex->TextureCoordinate.Y = 0; // cubes are used only for color
-
-                        vertex->Position.X = currentPosition.X;
-                        vertex->Position.Y = currentPosition.Y;
-                        vertex->Position.Z = currentPosition.Z - currentPosition.W*drawInfo->DepthBias*DepthBiasShiftOneUnit;
-                        vertex->Position.W = currentPosition.W;
-
-                        vertex++;
-
-                        if (c == 0)
-                            Vector4.Add(ref currentPosition, ref drawInfo->UnitXWorld, out currentPosition);
-                        else
-                            Vector4.Subtract(ref currentPosition, ref drawInfo->UnitXWorld, out currentPosition);
-                    }
-
-                    if (r == 0)
-                        Vector4.Add(ref currentPosition, ref drawInfo->UnitYWorld, out currentPosition);
-                    else
-                        Vector4.Subtract(ref currentPosition, ref drawInfo->UnitYWorld, out currentPosition);
-                }
-
-                Vector4.Add(ref currentPosition, ref drawInfo->UnitZWorld, out currentPosition);
+                UpdateBufferValues(drawInfo, count, vertexPtr, indexPtr, vertexOffset);
             }
         }
 
-        private unsafe void CalculateBorderRectangleVertices(UIImageDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertex)
+        private unsafe void UpdateBufferValues(UIImageDrawInfo* drawInfo, int count, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset)
         {
-            // set the texture uv vectors
-            var uvX = new Vector4();
-            uvX[0] = drawInfo->Source.Left;
-            uvX[3] = drawInfo->Source.Right;
-            uvX[1] = uvX[0] + drawInfo->Source.Width * drawInfo->BorderSize.X;
-            uvX[2] = uvX[3] - drawInfo->Source.Width * drawInfo->BorderSize.Z;
-            var uvY = new Vector4();
-            uvY[0] = drawInfo->Source.Top;
-            uvY[3] = drawInfo->Source.Bottom;
-            uvY[1] = uvY[0] + drawInfo->Source.Height * drawInfo->BorderSize.Y;
-            uvY[2] = uvY[3] - drawInfo->Source.Height * drawInfo->BorderSize.W;
-
-            // set the shift vectors
-            shiftVectorX[0] = Vector4.Zero;
-            Vector4.Multiply(ref drawInfo->UnitXWorld, drawInfo->VertexShift.X, out shiftVectorX[1]);
-            Vector4.Multiply(ref drawInfo->UnitXWorld, drawInfo->VertexShift.Z, out shiftVectorX[2]);
-            shiftVectorX[3] = drawInfo->UnitXWorld;
-
-            shiftVectorY[0] = Vector4.Zero;
-            Vector4.Multiply(ref drawInfo->UnitYWorld, drawInfo->VertexShift.Y, out shiftVectorY[1]);
-            Vector4.Multiply(ref drawInfo->UnitYWorld, drawInfo->VertexShift.W, out shiftVectorY[2]);
-            shiftVectorY[3] = drawInfo->UnitYWorld;
-
-            for (int r = 0; r < 4; r++)
-            {
-                Vector4 currentRowPosition;
-                Vector4.Add(ref drawInfo->LeftTopCornerWorld, ref shiftVectorY[r], out currentRowPosition);
+            var renderTarget = GraphicsContext.CommandList.RenderTarget;
+            var backBufferHalfWidth = renderTarget != null ? renderTarget.ViewWidth / 2 : 0;
+            var backBufferHalfHeight = renderTarget != null ? renderTarget.ViewHeight / 2 : 0;
 
-                for (int c = 0; c < 4; c++)
-                {
-                    Vector4 currentPosition;
-                    Vector4.Add(ref currentRowPosition, ref shiftVectorX[c], out currentPosition);
-
-                    vertex->Position.X = currentPosition.X;
-                    vertex->Position.Y = currentPosition.Y;
-                    vertex->Position.Z = currentPosition.Z - currentPosition.W * drawInfo->DepthBias * DepthBiasShiftOneUnit;
-                    vertex->Position.W = currentPosition.W;
-
-                    vertex->Color = drawInfo->Color;
-
-                    vertex->TextureCoordinate.X = uvX[c];
-                    vertex->TextureCoordinate.Y = uvY[r];
-
-                    vertex->Swizzle = (int)drawInfo->Swizzle;
-
-                    vertex++;
-                }
-            }
-        }
-
-        private unsafe void CalculateRectangleVertices(UIImageDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertex)
-        {
-            var currentPosition = drawInfo->LeftTopCornerWorld;
-
-            // snap first pixel to prevent possible problems when left/top is in the middle of a pixel
-            if (drawInfo->SnapImage)
-            {
-                var invW = 1.0f / currentPosition.W;
-                var backBufferHalfWidth = GraphicsContext.CommandList.RenderTarget.ViewWidth / 2;
-                var backBufferHalfHeight = GraphicsContext.CommandList.RenderTarget.ViewHeight / 2;
-
-                currentPosition.X *= invW;
-                currentPosition.Y *= invW;
-                currentPosition.X = (float)(Math.Round(currentPosition.X * backBufferHalfWidth) / backBufferHalfWidth);
-                currentPosition.Y = (float)(Math.Round(currentPosition.Y * backBufferHalfHeight) / backBufferHalfHeight);
-                currentPosition.X *= currentPosition.W;
-                currentPosition.Y *= currentPosition.W;
-            }
-
-            var textureCoordX = new Vector2(drawInfo->Source.Left, drawInfo->Source.Right);
-            var textureCoordY = new Vector2(drawInfo->Source.Top, drawInfo->Source.Bottom);
-
-            // set the two first line of vertices
-            for (int r = 0; r < 2; r++)
+            // snapped images are rounded to the pixels of the render target
+            if (renderTarget == null)
             {
-                for (int c = 0; c < 2; c++)
+                for (var i = 0; i < count; i++)
                 {
-                    vertex->Color = drawInfo->Color;
-                    vertex->Swizzle = (int)drawInfo->Swizzle;
-                    vertex->TextureCoordinate.X = textureCoordX[c];
-                    vertex->TextureCoordinate.Y = textureCoordY[r];
-
-                    vertex->Position.X = currentPosition.X;
-                    vertex->Position.Y = currentPosition.Y;
-                    vertex->Position.Z = currentPosition.Z - currentPosition.W * drawInfo->DepthBias * DepthBiasShiftOneUnit;
-                    vertex->Position.W = currentPosition.W;
-
-                    if (drawInfo->SnapImage)
-                    {
-                        var backBufferHalfWidth = GraphicsContext.CommandList.RenderTarget.ViewWidth / 2;
-                        var backBufferHalfHeight = GraphicsContext.CommandList.RenderTarget.ViewHeight / 2;
-                        vertex->Position.X = (float)(Math.Round(vertex->Position.X * backBufferHalfWidth) / backBufferHalfWidth);
-                        vertex->Position.Y = (float)(Math.Round(vertex->Position.Y * backBufferHalfHeight) / backBufferHalfHeight);
-                    }
-
-                    vertex++;
-
-                    if (c == 0)
-                        Vector4.Add(ref currentPosition, ref drawInfo->UnitXWorld, out currentPosition);
-                    else
-                        Vector4.Subtract(ref currentPosition, ref drawInfo->UnitXWorld, out currentPosition);
+                    if (((UIImageDrawInfo*)((byte*)drawInfo + i * ElementInfoSize))->SnapImage)
+                        throw new InvalidOperationException("A snapped image cannot be drawn without a render target.");
                 }
-
-                Vector4.Add(ref currentPosition, ref drawInfo->UnitYWorld, out currentPosition);
             }
+
+            // the native code stops at the first element with an unknown primitive type
+            var written = NativeInvoke.UpdateUIBufferValuesFromElementInfoBatch(new IntPtr(drawInfo), ElementInfoSize, IntPtr.Zero, count, vertexPtr, indexPtr, vertexOffset, backBufferHalfWidth, backBufferHalfHeight);
+            if (written != count)
+                throw new ArgumentOutOfRangeException("drawInfo", "Element [{0}] of the batch has an unknown primitive type.".ToFormat(written));
         }
 
         /// <summary>
@@ -0,0 +1,142 @@
+﻿// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+using System;
+using System.Runtime.InteropServices;
+
+using SiliconStudio.Core.Mathematics;
+
+namespace SiliconStudio.Xenko.Graphics
+{
+    /// <summary>
+    /// Describes a compact version of <see cref="VertexPositionColorTextureSwizzle"/> (24 bytes instead of 44): the W of the position is implicitly 1, 
+    /// the color is stored as 8-bit unsigned normalized components and the texture coordinates as 16-bit unsigned normalized components.
+    /// </summary>
+    /// <remarks>The color components and texture coordinates are clamped to [0, 1].</remarks>
+    [StructLayout(LayoutKind.Sequential, Pack = 4)]
+    public struct VertexPositionColorTextureSwizzleCompact : IEquatable<VertexPositionColorTextureSwizzleCompact>, IVertex
+    {
+        /// <summary>
+        /// Initializes a new <see cref="VertexPositionColorTextureSwizzleCompact"/> instance.
+        /// </summary>
+        /// <param name="position">The position of this vertex.</param>
+        /// <param name="color">The color of this vertex.</param>
+        /// <param name="textureCoordinate">UV texture coordinates.</param>
+        /// <param name="swizzle">The swizzle mode</param>
+        public VertexPositionColorTextureSwizzleCompact(Vector3 position, Color color, Vector2 textureCoordinate, SwizzleMode swizzle)
+            : this()
+        {
+            Position = position;
+            Color = color;
+            TextureCoordinateX = ToUNorm16(textureCoordinate.X);
+            TextureCoordinateY = ToUNorm16(textureCoordinate.Y);
+            Swizzle = (int)swizzle;
+        }
+
+        /// <summary>
+        /// XYZ position.
+        /// </summary>
+        public Vector3 Position;
+
+        /// <summary>
+        /// The vertex color.
+        /// </summary>
+        public Color Color;
+
+        /// <summary>
+        /// U texture coordinate, as a 16-bit unsigned normalized value.
+        /// </summary>
+        public ushort TextureCoordinateX;
+
+        /// <summary>
+        /// V texture coordinate, as a 16-bit unsigned normalized value.
+        /// </summary>
+        public ushort TextureCoordinateY;
+
+        /// <summary>
+        /// The Swizzle mode
+        /// </summary>
+        public float Swizzle;
+
+        /// <summary>
+        /// Defines structure byte size.
+        /// </summary>
+        public static readonly int Size = 24;
+
+        /// <summary>
+        /// The vertex layout of this struct.
+        /// </summary>
+        public static readonly VertexDeclaration Layout = new VertexDeclaration(
+            VertexElement.Position<Vector3>(),
+            VertexElement.Color<Color>(),
+            VertexElement.TextureCoordinate(PixelFormat.R16G16_UNorm),
+            new VertexElement("BATCH_SWIZZLE", PixelFormat.R32_Float)
+            );
+
+        /// <summary>
+        /// Gets or sets the UV texture coordinates.
+        /// </summary>
+        public Vector2 TextureCoordinate
+        {
+            get { return new Vector2(TextureCoordinateX / 65535.0f, TextureCoordinateY / 65535.0f); }
+            set
+            {
+                TextureCoordinateX = ToUNorm16(value.X);
+                TextureCoordinateY = ToUNorm16(value.Y);
+            }
+        }
+
+        private static ushort ToUNorm16(float value)
+        {
+            return (ushort)(MathUtil.Clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        }
+
+        public bool Equals(VertexPositionColorTextureSwizzleCompact other)
+        {
+            return Position.Equals(other.Position) && Color.Equals(other.Color) && TextureCoordinateX == other.TextureCoordinateX && TextureCoordinateY == other.TextureCoordinateY && Swizzle.Equals(other.Swizzle);
+        }
+
+        public override bool Equals(object obj)
+        {
+            if (ReferenceEquals(null, obj)) return false;
+            return obj is VertexPositionColorTextureSwizzleCompact && Equals((VertexPositionColorTextureSwizzleCompact)obj);
+        }
+
+        public override int GetHashCode()
+        {
+            unchecked
+            {
+                int hashCode = Position.GetHashCode();
+                hashCode = (hashCode * 397) ^ Color.GetHashCode();
+                hashCode = (hashCode * 397) ^ TextureCoordinateX.GetHashCode();
+                hashCode = (hashCode * 397) ^ TextureCoordinateY.GetHashCode();
+                hashCode = (hashCode * 397) ^ Swizzle.GetHashCode();
+                return hashCode;
+            }
+        }
+
+        public static bool operator ==(VertexPositionColorTextureSwizzleCompact left, VertexPositionColorTextureSwizzleCompact right)
+        {
+            return left.Equals(right);
+        }
+
+        public static bool operator !=(VertexPositionColorTextureSwizzleCompact left, VertexPositionColorTextureSwizzleCompact right)
+        {
+            return !left.Equals(right);
+        }
+
+        public override string ToString()
+        {
+            return string.Format("Position: {0}, Color: {1}, Texcoord: {2}, Swizzle: {3}", Position, Color, TextureCoordinate, Swizzle);
+        }
+
+        public VertexDeclaration GetLayout()
+        {
+            return Layout;
+        }
+
+        public void FlipWinding()
+        {
+            TextureCoordinateX = (ushort)(65535 - TextureCoordinateX);
+        }
+    }
+}
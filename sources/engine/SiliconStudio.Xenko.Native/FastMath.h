@@ -0,0 +1,169 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+#pragma once
+
+#include "../../../deps/NativePath/NativePath.h"
+#include "../../../deps/NativePath/NativeMath.h"
+#include "../../../deps/NativePath/standard/math.h"
+#include "XenkoNative.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Same values as SpriteRotationPrecision
+#define FAST_MATH_PRECISION_EXACT 0			// npLolSincosf
+#define FAST_MATH_PRECISION_FAST 1			// absolute error below 2e-7 for angles under 100 radians, 2e-6 up to FAST_SINCOS_MAX_ANGLE
+#define FAST_MATH_PRECISION_APPROXIMATE 2	// absolute error below 2e-5
+
+// Beyond this angle the 3 part reduction loses precision, such angles fall back to npLolSincosf
+#define FAST_SINCOS_MAX_ANGLE 65536.0f
+
+// Angles are reduced to r in [-pi/4, pi/4] by the nearest multiple q of pi/2 (Cody-Waite, pi/2 split in 3 parts).
+// 1.5 * 2^23 rounds x * 2/pi to the nearest integer and leaves q in the low bits of the mantissa.
+#define FAST_SINCOS_ROUNDING 12582912.0f
+#define FAST_SINCOS_TWO_OVER_PI 0.636619772f
+#define FAST_SINCOS_PI_OVER_TWO_1 1.5703125f
+#define FAST_SINCOS_PI_OVER_TWO_2 4.837512969970703125e-4f
+#define FAST_SINCOS_PI_OVER_TWO_3 7.54978995489188216e-8f
+
+// Minimax polynomials of sin(r) and cos(r) on [-pi/4, pi/4] (Cephes sinf/cosf)
+#define FAST_SIN_1 -1.6666654611e-1f
+#define FAST_SIN_2 8.3321608736e-3f
+#define FAST_SIN_3 -1.9515295891e-4f
+#define FAST_COS_1 4.166664568298827e-2f
+#define FAST_COS_2 -1.388731625493765e-3f
+#define FAST_COS_3 2.443315711809948e-5f
+
+// Lower degree polynomials of the approximate precision
+#define APPROXIMATE_SIN_1 -1.6662755e-1f
+#define APPROXIMATE_SIN_2 8.1515757e-3f
+#define APPROXIMATE_COS_1 -4.9977254e-1f
+#define APPROXIMATE_COS_2 4.0481893e-2f
+
+// Reciprocal of the last value seen: sprites of a batch share their texture, so 1/TextureSize is computed once per batch instead of once per sprite
+typedef struct ReciprocalCache
+{
+	Vector2 Value;
+	Vector2 Reciprocal;
+} ReciprocalCache;
+
+static inline void ReciprocalCacheInitialize(ReciprocalCache* cache)
+{
+	cache->Value.X = cache->Value.Y = 0;
+	cache->Reciprocal.X = cache->Reciprocal.Y = 0;
+}
+
+static inline Vector2 ReciprocalCacheGet(ReciprocalCache* cache, Vector2 value)
+{
+	if (cache->Value.X != value.X || cache->Value.Y != value.Y)
+	{
+		cache->Value = value;
+		cache->Reciprocal.X = 1.0f / value.X;
+		cache->Reciprocal.Y = 1.0f / value.Y;
+	}
+	return cache->Reciprocal;
+}
+
+// Sine and cosine of a sprite rotation. Rotations below 1e-6 are treated as no rotation, as in UpdateSpriteVertices.
+static inline void FastSinCos(float angle, float* sine, float* cosine, int precision)
+{
+	float absoluteAngle = fabsf(angle);
+	if (!(absoluteAngle > 1e-6f))
+	{
+		*sine = 0.0f;
+		*cosine = 1.0f;
+		return;
+	}
+
+	if (precision == FAST_MATH_PRECISION_EXACT || !(absoluteAngle <= FAST_SINCOS_MAX_ANGLE))
+	{
+		npLolSincosf(angle, sine, cosine);
+		return;
+	}
+
+	float rounded = angle * FAST_SINCOS_TWO_OVER_PI + FAST_SINCOS_ROUNDING;
+	int quadrant = (int)(rounded - FAST_SINCOS_ROUNDING);
+	float q = rounded - FAST_SINCOS_ROUNDING;
+	float r = angle - q * FAST_SINCOS_PI_OVER_TWO_1;
+	r = r - q * FAST_SINCOS_PI_OVER_TWO_2;
+	r = r - q * FAST_SINCOS_PI_OVER_TWO_3;
+	float r2 = r * r;
+
+	float s, c;
+	if (precision == FAST_MATH_PRECISION_APPROXIMATE)
+	{
+		s = r + r * r2 * (APPROXIMATE_SIN_1 + r2 * APPROXIMATE_SIN_2);
+		c = 1.0f + r2 * (APPROXIMATE_COS_1 + r2 * APPROXIMATE_COS_2);
+	}
+	else
+	{
+		s = r + r * r2 * (FAST_SIN_1 + r2 * (FAST_SIN_2 + r2 * FAST_SIN_3));
+		c = 1.0f - 0.5f * r2 + r2 * r2 * (FAST_COS_1 + r2 * (FAST_COS_2 + r2 * FAST_COS_3));
+	}
+
+	// sin(r + q pi/2) and cos(r + q pi/2) by quadrant
+	float resultSine = (quadrant & 1) ? c : s;
+	float resultCosine = (quadrant & 1) ? s : c;
+	*sine = (quadrant & 2) ? -resultSine : resultSine;
+	*cosine = ((quadrant + 1) & 2) ? -resultCosine : resultCosine;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+
+// Vector version of FastSinCos for the non exact precisions, 'laneCount' angles at a time.
+// 'angles', 'sines' and 'cosines' are aligned on the vector size and 'count' is a multiple of 'laneCount'.
+#define FAST_SINCOS_KERNEL(name, vectorType, maskType, laneCount, attributes) \
+static attributes void name(const float* angles, float* sines, float* cosines, int count, int precision) \
+{ \
+	for (int i = 0; i < count; i += laneCount) \
+	{ \
+		vectorType angle = *(const vectorType*)&angles[i]; \
+		vectorType absoluteAngle = (vectorType)((maskType)angle & 0x7FFFFFFF); \
+		\
+		vectorType rounded = angle * FAST_SINCOS_TWO_OVER_PI + FAST_SINCOS_ROUNDING; \
+		maskType quadrant = (maskType)rounded; \
+		vectorType q = rounded - FAST_SINCOS_ROUNDING; \
+		vectorType r = angle - q * FAST_SINCOS_PI_OVER_TWO_1; \
+		r = r - q * FAST_SINCOS_PI_OVER_TWO_2; \
+		r = r - q * FAST_SINCOS_PI_OVER_TWO_3; \
+		vectorType r2 = r * r; \
+		\
+		vectorType s, c; \
+		if (precision == FAST_MATH_PRECISION_APPROXIMATE) \
+		{ \
+			s = r + r * r2 * (APPROXIMATE_SIN_1 + r2 * APPROXIMATE_SIN_2); \
+			c = 1.0f + r2 * (APPROXIMATE_COS_1 + r2 * APPROXIMATE_COS_2); \
+		} \
+		else \
+		{ \
+			s = r + r * r2 * (FAST_SIN_1 + r2 * (FAST_SIN_2 + r2 * FAST_SIN_3)); \
+			c = 1.0f - 0.5f * r2 + r2 * r2 * (FAST_COS_1 + r2 * (FAST_COS_2 + r2 * FAST_COS_3)); \
+		} \
+		\
+		/* swap sine and cosine in the odd quadrants and apply the quadrant signs to the bits */ \
+		maskType swap = -(quadrant & 1); \
+		maskType sineBits = (((maskType)c & swap) | ((maskType)s & ~swap)) ^ ((quadrant & 2) << 30); \
+		maskType cosineBits = (((maskType)s & swap) | ((maskType)c & ~swap)) ^ (((quadrant + 1) & 2) << 30); \
+		\
+		/* no rotation below 1e-6 */ \
+		maskType rotated = absoluteAngle > 1e-6f; \
+		*(vectorType*)&sines[i] = (vectorType)(sineBits & rotated); \
+		*(vectorType*)&cosines[i] = (vectorType)((cosineBits & rotated) | (0x3F800000 & ~rotated)); /* 1.0f */ \
+		\
+		/* large angles are rare enough to be patched one by one */ \
+		maskType large = ~(absoluteAngle <= FAST_SINCOS_MAX_ANGLE) & rotated; \
+		for (int l = 0; l < laneCount; l++) \
+		{ \
+			if (large[l]) \
+				npLolSincosf(angles[i + l], &sines[i + l], &cosines[i + l]); \
+		} \
+	} \
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
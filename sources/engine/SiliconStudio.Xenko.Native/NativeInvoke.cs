@@ -30,5 +30,41 @@ namespace SiliconStudio.Xenko.Native
 #endif
         [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
         internal static extern void UpdateBufferValuesFromElementInfo(IntPtr drawInfo, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset);
+
+#if !SILICONSTUDIO_RUNTIME_CORECLR
+        [SuppressUnmanagedCodeSecurity]
+#endif
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void UpdateBufferValuesFromElementInfoBatch(IntPtr drawInfos, int drawInfoStride, IntPtr sortIndices, int count, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset, int rotationPrecision);
+
+#if !SILICONSTUDIO_RUNTIME_CORECLR
+        [SuppressUnmanagedCodeSecurity]
+#endif
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void UpdateBufferValuesFromElementInfoBatchCompact(IntPtr drawInfos, int drawInfoStride, IntPtr sortIndices, int count, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset, int rotationPrecision);
+
+#if !SILICONSTUDIO_RUNTIME_CORECLR
+        [SuppressUnmanagedCodeSecurity]
+#endif
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void FastSinCosBatch(IntPtr angles, IntPtr sines, IntPtr cosines, int count, int precision);
+
+#if !SILICONSTUDIO_RUNTIME_CORECLR
+        [SuppressUnmanagedCodeSecurity]
+#endif
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void SortSpriteKeys(IntPtr keys, IntPtr indices, int count, IntPtr tempKeys, IntPtr tempIndices);
+
+#if !SILICONSTUDIO_RUNTIME_CORECLR
+        [SuppressUnmanagedCodeSecurity]
+#endif
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int UpdateUIBufferValuesFromElementInfoBatch(IntPtr drawInfos, int drawInfoStride, IntPtr sortIndices, int count, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset, int backBufferHalfWidth, int backBufferHalfHeight);
+
+#if !SILICONSTUDIO_RUNTIME_CORECLR
+        [SuppressUnmanagedCodeSecurity]
+#endif
+        [DllImport(Library, CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void UpdateSprite3DBufferValuesFromElementInfoBatch(IntPtr drawInfos, int drawInfoStride, IntPtr sortIndices, int count, IntPtr vertexPtr, IntPtr indexPtr, int vertexOffset);
     }
 }
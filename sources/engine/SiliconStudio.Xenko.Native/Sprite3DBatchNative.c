@@ -0,0 +1,86 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+#include "../../../deps/NativePath/NativePath.h"
+#include "XenkoNative.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline void UpdateSprite3DVertices(const Sprite3DDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertex)
+{
+	Vector4 currentPosition = drawInfo->LeftTopCornerWorld;
+	const Vector4* unitX = &drawInfo->UnitXWorld;
+	const Vector4* unitY = &drawInfo->UnitYWorld;
+
+	float textureCoordX[2] = { drawInfo->Source.x, drawInfo->Source.x + drawInfo->Source.width };
+	float textureCoordY[2] = { drawInfo->Source.y, drawInfo->Source.y + drawInfo->Source.height };
+
+	for (int r = 0; r < 2; r++)
+	{
+		for (int c = 0; c < 2; c++)
+		{
+			vertex->Color = drawInfo->Color;
+			vertex->Swizzle = (float)drawInfo->Swizzle;
+			vertex->TextureCoordinate.X = textureCoordX[c];
+			vertex->TextureCoordinate.Y = textureCoordY[r];
+			vertex->Position = currentPosition;
+
+			vertex++;
+
+			// walk the corners in the same order as Sprite3DBatch: left-top, right-top, left-bottom, right-bottom
+			if (c == 0)
+			{
+				currentPosition.X += unitX->X;
+				currentPosition.Y += unitX->Y;
+				currentPosition.Z += unitX->Z;
+				currentPosition.W += unitX->W;
+			}
+			else
+			{
+				currentPosition.X -= unitX->X;
+				currentPosition.Y -= unitX->Y;
+				currentPosition.Z -= unitX->Z;
+				currentPosition.W -= unitX->W;
+			}
+		}
+
+		currentPosition.X += unitY->X;
+		currentPosition.Y += unitY->Y;
+		currentPosition.Z += unitY->Z;
+		currentPosition.W += unitY->W;
+	}
+}
+
+void UpdateSprite3DBufferValuesFromElementInfoBatch(Sprite3DDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, VertexPositionColorTextureSwizzle* vertexPointer, short* indexPointer, int vertexStartOffset)
+{
+	char* drawInfoBase = (char*)drawInfos;
+
+	for (int i = 0; i < count; i++)
+	{
+		int drawIndex = sortIndices ? sortIndices[i] : i;
+		UpdateSprite3DVertices((const Sprite3DDrawInfo*)(drawInfoBase + drawIndex * drawInfoStride), vertexPointer);
+		vertexPointer += 4;
+	}
+
+	// Same quad indices as the static index buffer of Sprite3DBatch
+	if (indexPointer)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			short firstVertex = (short)(vertexStartOffset + (i << 2));
+			indexPointer[0] = firstVertex;
+			indexPointer[1] = firstVertex + 1;
+			indexPointer[2] = firstVertex + 2;
+			indexPointer[3] = firstVertex + 1;
+			indexPointer[4] = firstVertex + 3;
+			indexPointer[5] = firstVertex + 2;
+			indexPointer += 6;
+		}
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
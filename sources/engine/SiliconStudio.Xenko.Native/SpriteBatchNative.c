@@ -5,26 +5,20 @@
 #include "../../../deps/NativePath/NativeMath.h"
 #include "../../../deps/NativePath/standard/math.h"
 #include "XenkoNative.h"
+#include "FastMath.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void UpdateBufferValuesFromElementInfo(SpriteDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertexPointer, void* indexPointer, int vertexStartOffset)
+static inline void UpdateSpriteVertices(SpriteDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertexPointer, ReciprocalCache* textureSizeCache, int rotationPrecision)
 {
-	float deltaX = 1.0f / drawInfo->TextureSize.X;
-	float deltaY = 1.0f / drawInfo->TextureSize.Y;
+	Vector2 inverseTextureSize = ReciprocalCacheGet(textureSizeCache, drawInfo->TextureSize);
+	float deltaX = inverseTextureSize.X;
+	float deltaY = inverseTextureSize.Y;
 
 	Vector2 rotation;
-	rotation.X = 1;
-	rotation.Y = 0;
-
-	if (fabs(drawInfo->Rotation) > 1e-6f)
-	{
-		npLolSincosf(drawInfo->Rotation, &rotation.Y, &rotation.X);
-		//rotation.X = cos(drawInfo->Rotation);
-		//rotation.Y = sin(drawInfo->Rotation);
-	}
+	FastSinCos(drawInfo->Rotation, &rotation.Y, &rotation.X, rotationPrecision);
 
 	Vector2 origin = drawInfo->Origin;
 	origin.X /= fmax(1e-6f, drawInfo->Source.width);
@@ -61,6 +55,423 @@ void UpdateBufferValuesFromElementInfo(SpriteDrawInfo* drawInfo, VertexPositionC
 	}
 }
 
+void UpdateBufferValuesFromElementInfo(SpriteDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertexPointer, void* indexPointer, int vertexStartOffset)
+{
+	ReciprocalCache textureSizeCache;
+	ReciprocalCacheInitialize(&textureSizeCache);
+	UpdateSpriteVertices(drawInfo, vertexPointer, &textureSizeCache, FAST_MATH_PRECISION_EXACT);
+}
+
+static inline unsigned char ToUNorm8(float value)
+{
+	value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+static inline unsigned short ToUNorm16(float value)
+{
+	value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return (unsigned short)(value * 65535.0f + 0.5f);
+}
+
+static inline Color ToColor(const Color4* color)
+{
+	Color result;
+	result.R = ToUNorm8(color->R);
+	result.G = ToUNorm8(color->G);
+	result.B = ToUNorm8(color->B);
+	result.A = ToUNorm8(color->A);
+	return result;
+}
+
+static inline void SetCompactVertex(VertexPositionColorTextureSwizzleCompact* vertex, float x, float y, float z, Color color, float u, float v, float swizzle)
+{
+	vertex->Position.X = x;
+	vertex->Position.Y = y;
+	vertex->Position.Z = z;
+	vertex->Color = color;
+	vertex->TextureCoordinateX = ToUNorm16(u);
+	vertex->TextureCoordinateY = ToUNorm16(v);
+	vertex->Swizzle = swizzle;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SPRITE_SIMD 1
+#endif
+
+#if SPRITE_SIMD && (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
+#define SPRITE_SIMD_AVX2 1
+#endif
+
+#if SPRITE_SIMD
+
+// Number of sprites staged at once, a multiple of the widest vector
+#define SPRITE_CHUNK_SIZE 64
+
+typedef float SpriteFloat4 __attribute__((vector_size(16)));
+typedef float SpriteFloat8 __attribute__((vector_size(32)));
+typedef int SpriteInt4 __attribute__((vector_size(16)));
+typedef int SpriteInt8 __attribute__((vector_size(32)));
+
+// Sprites of a chunk in SoA form: one array per input value and per output value of each corner.
+// Filling the arrays before evaluating them avoids the store forwarding stalls of building vectors lane by lane.
+typedef struct SpriteChunk
+{
+	float DestinationX[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float DestinationY[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float DestinationWidth[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float DestinationHeight[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float OriginX[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float OriginY[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float Rotation[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float RotationX[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float RotationY[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float SourceX[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float SourceY[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float SourceWidth[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float SourceHeight[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float DeltaX[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float DeltaY[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float CornerU[4][SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float CornerV[4][SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+
+	float PositionX[4][SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float PositionY[4][SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float TextureU[4][SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+	float TextureV[4][SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+
+	const SpriteDrawInfo* DrawInfos[SPRITE_CHUNK_SIZE];
+
+	// 1/TextureSize is only recomputed when the texture size changes, which never happens inside a batch
+	ReciprocalCache TextureSizeReciprocal;
+} SpriteChunk;
+
+static const float CornerOffsetsX[4] = { 0, 1, 1, 0 };
+static const float CornerOffsetsY[4] = { 0, 0, 1, 1 };
+
+static void StageSprites(SpriteChunk* chunk, int count, int paddedCount, int rotationPrecision)
+{
+	for (int k = 0; k < paddedCount; k++)
+	{
+		// The padding lanes repeat the last sprite so that they only hold valid floats
+		const SpriteDrawInfo* drawInfo = chunk->DrawInfos[k < count ? k : count - 1];
+
+		Vector2 inverseTextureSize = ReciprocalCacheGet(&chunk->TextureSizeReciprocal, drawInfo->TextureSize);
+		chunk->DeltaX[k] = inverseTextureSize.X;
+		chunk->DeltaY[k] = inverseTextureSize.Y;
+
+		// The fast precisions evaluate the rotations of the whole chunk at once in the kernel
+		if (rotationPrecision == FAST_MATH_PRECISION_EXACT)
+		{
+			FastSinCos(drawInfo->Rotation, &chunk->RotationY[k], &chunk->RotationX[k], FAST_MATH_PRECISION_EXACT);
+		}
+		else
+		{
+			chunk->Rotation[k] = drawInfo->Rotation;
+		}
+
+		chunk->DestinationX[k] = drawInfo->Destination.x;
+		chunk->DestinationY[k] = drawInfo->Destination.y;
+		chunk->DestinationWidth[k] = drawInfo->Destination.width;
+		chunk->DestinationHeight[k] = drawInfo->Destination.height;
+		chunk->OriginX[k] = drawInfo->Origin.X;
+		chunk->OriginY[k] = drawInfo->Origin.Y;
+		chunk->SourceX[k] = drawInfo->Source.x;
+		chunk->SourceY[k] = drawInfo->Source.y;
+		chunk->SourceWidth[k] = drawInfo->Source.width;
+		chunk->SourceHeight[k] = drawInfo->Source.height;
+
+		for (int j = 0; j < 4; j++)
+		{
+			int corner = ((j ^ drawInfo->SpriteEffects) + drawInfo->Orientation) & 3;
+			chunk->CornerU[j][k] = CornerOffsetsX[corner];
+			chunk->CornerV[j][k] = CornerOffsetsY[corner];
+		}
+	}
+}
+
+// Evaluates the rotation and texture coordinates of the 4 corners, 'laneCount' sprites at a time.
+// The arithmetic is kept identical to UpdateSpriteVertices so that both paths output the same vertices.
+#define SPRITE_CHUNK_KERNEL(name, vectorType, maskType, laneCount, attributes) \
+static attributes void name(SpriteChunk* chunk, int paddedCount) \
+{ \
+	for (int i = 0; i < paddedCount; i += laneCount) \
+	{ \
+		vectorType destinationX = *(vectorType*)&chunk->DestinationX[i]; \
+		vectorType destinationY = *(vectorType*)&chunk->DestinationY[i]; \
+		vectorType destinationWidth = *(vectorType*)&chunk->DestinationWidth[i]; \
+		vectorType destinationHeight = *(vectorType*)&chunk->DestinationHeight[i]; \
+		vectorType rotationX = *(vectorType*)&chunk->RotationX[i]; \
+		vectorType rotationY = *(vectorType*)&chunk->RotationY[i]; \
+		vectorType sourceX = *(vectorType*)&chunk->SourceX[i]; \
+		vectorType sourceY = *(vectorType*)&chunk->SourceY[i]; \
+		vectorType sourceWidth = *(vectorType*)&chunk->SourceWidth[i]; \
+		vectorType sourceHeight = *(vectorType*)&chunk->SourceHeight[i]; \
+		vectorType deltaX = *(vectorType*)&chunk->DeltaX[i]; \
+		vectorType deltaY = *(vectorType*)&chunk->DeltaY[i]; \
+		\
+		/* origin / max(1e-6, source size), the max being selected with the comparison mask */ \
+		vectorType epsilon = destinationX - destinationX + 1e-6f; \
+		maskType widthMask = sourceWidth > epsilon; \
+		maskType heightMask = sourceHeight > epsilon; \
+		vectorType originX = *(vectorType*)&chunk->OriginX[i] / (vectorType)(((maskType)sourceWidth & widthMask) | ((maskType)epsilon & ~widthMask)); \
+		vectorType originY = *(vectorType*)&chunk->OriginY[i] / (vectorType)(((maskType)sourceHeight & heightMask) | ((maskType)epsilon & ~heightMask)); \
+		\
+		for (int j = 0; j < 4; j++) \
+		{ \
+			float cornerX = (j == 1 || j == 2) ? 1.0f : 0.0f; \
+			float cornerY = j >= 2 ? 1.0f : 0.0f; \
+			vectorType positionX = (cornerX - originX) * destinationWidth; \
+			vectorType positionY = (cornerY - originY) * destinationHeight; \
+			*(vectorType*)&chunk->PositionX[j][i] = destinationX + (positionX * rotationX) - (positionY * rotationY); \
+			*(vectorType*)&chunk->PositionY[j][i] = destinationY + (positionX * rotationY) + (positionY * rotationX); \
+			*(vectorType*)&chunk->TextureU[j][i] = (sourceX + *(vectorType*)&chunk->CornerU[j][i] * sourceWidth) * deltaX; \
+			*(vectorType*)&chunk->TextureV[j][i] = (sourceY + *(vectorType*)&chunk->CornerV[j][i] * sourceHeight) * deltaY; \
+		} \
+	} \
+}
+
+SPRITE_CHUNK_KERNEL(EvaluateSpriteChunk4, SpriteFloat4, SpriteInt4, 4, )
+FAST_SINCOS_KERNEL(FastSinCos4, SpriteFloat4, SpriteInt4, 4, )
+
+#if SPRITE_SIMD_AVX2
+SPRITE_CHUNK_KERNEL(EvaluateSpriteChunk8, SpriteFloat8, SpriteInt8, 8, __attribute__((target("avx2"))))
+FAST_SINCOS_KERNEL(FastSinCos8, SpriteFloat8, SpriteInt8, 8, __attribute__((target("avx2"))))
+
+// AVX2 needs both the CPU flag and the OS saving the YMM registers (OSXSAVE + XCR0)
+static int CpuSupportsAvx2()
+{
+	unsigned int eax, ebx, ecx, edx;
+	__asm__ __volatile__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(0), "c"(0));
+	if (eax < 7)
+		return 0;
+
+	__asm__ __volatile__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1), "c"(0));
+	if ((ecx & (1u << 27)) == 0 || (ecx & (1u << 28)) == 0)
+		return 0;
+
+	unsigned int xcr0Low, xcr0High;
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0)); // xgetbv
+	if ((xcr0Low & 6) != 6)
+		return 0;
+
+	__asm__ __volatile__("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(7), "c"(0));
+	return (ebx & (1u << 5)) != 0;
+}
+#endif
+
+typedef struct SpriteChunkKernel
+{
+	int LaneCount;
+	void (*Evaluate)(SpriteChunk* chunk, int paddedCount);
+	void (*SinCos)(const float* angles, float* sines, float* cosines, int count, int precision);
+} SpriteChunkKernel;
+
+static const SpriteChunkKernel SpriteChunkKernel4 = { 4, EvaluateSpriteChunk4, FastSinCos4 };
+#if SPRITE_SIMD_AVX2
+static const SpriteChunkKernel SpriteChunkKernel8 = { 8, EvaluateSpriteChunk8, FastSinCos8 };
+#endif
+
+// Selected on first use. Batches can be filled from several threads at once: the selection is published
+// through a single pointer so that concurrent first calls always see a complete kernel.
+static const SpriteChunkKernel* SelectedSpriteChunkKernel;
+
+static const SpriteChunkKernel* GetSpriteChunkKernel()
+{
+	const SpriteChunkKernel* kernel = __atomic_load_n(&SelectedSpriteChunkKernel, __ATOMIC_ACQUIRE);
+	if (kernel)
+		return kernel;
+
+	kernel = &SpriteChunkKernel4;
+#if SPRITE_SIMD_AVX2
+	if (CpuSupportsAvx2())
+		kernel = &SpriteChunkKernel8;
+#endif
+	__atomic_store_n(&SelectedSpriteChunkKernel, kernel, __ATOMIC_RELEASE);
+	return kernel;
+}
+
+static void WriteSpriteChunk(SpriteChunk* chunk, int count, VertexPositionColorTextureSwizzle* vertexPointer)
+{
+	for (int k = 0; k < count; k++)
+	{
+		const SpriteDrawInfo* drawInfo = chunk->DrawInfos[k];
+		float swizzle = (float)drawInfo->Swizzle;
+
+		for (int j = 0; j < 4; j++)
+		{
+			vertexPointer->Position.X = chunk->PositionX[j][k];
+			vertexPointer->Position.Y = chunk->PositionY[j][k];
+			vertexPointer->Position.Z = drawInfo->Depth;
+			vertexPointer->Position.W = 1.0f;
+			vertexPointer->Color = drawInfo->Color;
+			vertexPointer->TextureCoordinate.X = chunk->TextureU[j][k];
+			vertexPointer->TextureCoordinate.Y = chunk->TextureV[j][k];
+			vertexPointer->Swizzle = swizzle;
+			vertexPointer++;
+		}
+	}
+}
+
+static void WriteSpriteChunkCompact(SpriteChunk* chunk, int count, VertexPositionColorTextureSwizzleCompact* vertexPointer)
+{
+	for (int k = 0; k < count; k++)
+	{
+		const SpriteDrawInfo* drawInfo = chunk->DrawInfos[k];
+		Color color = ToColor(&drawInfo->Color);
+		float swizzle = (float)drawInfo->Swizzle;
+
+		for (int j = 0; j < 4; j++)
+		{
+			SetCompactVertex(vertexPointer, chunk->PositionX[j][k], chunk->PositionY[j][k], drawInfo->Depth, color, chunk->TextureU[j][k], chunk->TextureV[j][k], swizzle);
+			vertexPointer++;
+		}
+	}
+}
+
+static void UpdateSpriteVerticesSimd(char* drawInfoBase, int drawInfoStride, int* sortIndices, int count, void* vertexPointer, int compactVertices, int rotationPrecision)
+{
+	const SpriteChunkKernel* kernel = GetSpriteChunkKernel();
+
+	SpriteChunk chunk;
+	ReciprocalCacheInitialize(&chunk.TextureSizeReciprocal);
+
+	for (int start = 0; start < count; start += SPRITE_CHUNK_SIZE)
+	{
+		int chunkCount = count - start < SPRITE_CHUNK_SIZE ? count - start : SPRITE_CHUNK_SIZE;
+		int paddedCount = (chunkCount + kernel->LaneCount - 1) & ~(kernel->LaneCount - 1);
+
+		for (int k = 0; k < chunkCount; k++)
+		{
+			int drawIndex = sortIndices ? sortIndices[start + k] : start + k;
+			chunk.DrawInfos[k] = (const SpriteDrawInfo*)(drawInfoBase + drawIndex * drawInfoStride);
+		}
+
+		StageSprites(&chunk, chunkCount, paddedCount, rotationPrecision);
+		if (rotationPrecision != FAST_MATH_PRECISION_EXACT)
+		{
+			kernel->SinCos(chunk.Rotation, chunk.RotationY, chunk.RotationX, paddedCount, rotationPrecision);
+		}
+		kernel->Evaluate(&chunk, paddedCount);
+		if (compactVertices)
+		{
+			WriteSpriteChunkCompact(&chunk, chunkCount, (VertexPositionColorTextureSwizzleCompact*)vertexPointer + 4 * start);
+		}
+		else
+		{
+			WriteSpriteChunk(&chunk, chunkCount, (VertexPositionColorTextureSwizzle*)vertexPointer + 4 * start);
+		}
+	}
+}
+
+#endif
+
+#if !SPRITE_SIMD
+static void UpdateSpriteVerticesScalar(char* drawInfoBase, int drawInfoStride, int* sortIndices, int count, void* vertexPointer, int compactVertices, int rotationPrecision)
+{
+	ReciprocalCache textureSizeCache;
+	ReciprocalCacheInitialize(&textureSizeCache);
+
+	for (int i = 0; i < count; i++)
+	{
+		int drawIndex = sortIndices ? sortIndices[i] : i;
+		SpriteDrawInfo* drawInfo = (SpriteDrawInfo*)(drawInfoBase + drawIndex * drawInfoStride);
+
+		if (compactVertices)
+		{
+			VertexPositionColorTextureSwizzle vertices[4];
+			UpdateSpriteVertices(drawInfo, vertices, &textureSizeCache, rotationPrecision);
+
+			Color color = ToColor(&drawInfo->Color);
+			VertexPositionColorTextureSwizzleCompact* compactVertex = (VertexPositionColorTextureSwizzleCompact*)vertexPointer + 4 * i;
+			for (int j = 0; j < 4; j++)
+			{
+				SetCompactVertex(compactVertex + j, vertices[j].Position.X, vertices[j].Position.Y, vertices[j].Position.Z, color, vertices[j].TextureCoordinate.X, vertices[j].TextureCoordinate.Y, vertices[j].Swizzle);
+			}
+		}
+		else
+		{
+			UpdateSpriteVertices(drawInfo, (VertexPositionColorTextureSwizzle*)vertexPointer + 4 * i, &textureSizeCache, rotationPrecision);
+		}
+	}
+}
+#endif
+
+static void UpdateSpriteBatch(SpriteDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, void* vertexPointer, short* indexPointer, int vertexStartOffset, int compactVertices, int rotationPrecision)
+{
+#if SPRITE_SIMD
+	UpdateSpriteVerticesSimd((char*)drawInfos, drawInfoStride, sortIndices, count, vertexPointer, compactVertices, rotationPrecision);
+#else
+	UpdateSpriteVerticesScalar((char*)drawInfos, drawInfoStride, sortIndices, count, vertexPointer, compactVertices, rotationPrecision);
+#endif
+
+	// Sprites normally use a static index buffer, only fill the indices when the caller maps a dynamic one
+	if (indexPointer)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			short firstVertex = (short)(vertexStartOffset + (i << 2));
+			indexPointer[0] = firstVertex;
+			indexPointer[1] = firstVertex + 1;
+			indexPointer[2] = firstVertex + 2;
+			indexPointer[3] = firstVertex;
+			indexPointer[4] = firstVertex + 2;
+			indexPointer[5] = firstVertex + 3;
+			indexPointer += 6;
+		}
+	}
+}
+
+void UpdateBufferValuesFromElementInfoBatch(SpriteDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, VertexPositionColorTextureSwizzle* vertexPointer, void* indexPointer, int vertexStartOffset, int rotationPrecision)
+{
+	UpdateSpriteBatch(drawInfos, drawInfoStride, sortIndices, count, vertexPointer, (short*)indexPointer, vertexStartOffset, 0, rotationPrecision);
+}
+
+void UpdateBufferValuesFromElementInfoBatchCompact(SpriteDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, VertexPositionColorTextureSwizzleCompact* vertexPointer, void* indexPointer, int vertexStartOffset, int rotationPrecision)
+{
+	UpdateSpriteBatch(drawInfos, drawInfoStride, sortIndices, count, vertexPointer, (short*)indexPointer, vertexStartOffset, 1, rotationPrecision);
+}
+
+void FastSinCosBatch(float* angles, float* sines, float* cosines, int count, int precision)
+{
+#if SPRITE_SIMD
+	if (precision != FAST_MATH_PRECISION_EXACT)
+	{
+		const SpriteChunkKernel* kernel = GetSpriteChunkKernel();
+
+		// The kernels need aligned arrays padded to the vector size
+		float alignedAngles[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+		float alignedSines[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+		float alignedCosines[SPRITE_CHUNK_SIZE] __attribute__((aligned(32)));
+
+		for (int start = 0; start < count; start += SPRITE_CHUNK_SIZE)
+		{
+			int chunkCount = count - start < SPRITE_CHUNK_SIZE ? count - start : SPRITE_CHUNK_SIZE;
+			int paddedCount = (chunkCount + kernel->LaneCount - 1) & ~(kernel->LaneCount - 1);
+
+			for (int k = 0; k < paddedCount; k++)
+			{
+				alignedAngles[k] = k < chunkCount ? angles[start + k] : 0.0f;
+			}
+
+			kernel->SinCos(alignedAngles, alignedSines, alignedCosines, paddedCount, precision);
+
+			for (int k = 0; k < chunkCount; k++)
+			{
+				sines[start + k] = alignedSines[k];
+				cosines[start + k] = alignedCosines[k];
+			}
+		}
+		return;
+	}
+#endif
+
+	for (int i = 0; i < count; i++)
+	{
+		FastSinCos(angles[i], &sines[i], &cosines[i], precision);
+	}
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,93 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+#include "../../../deps/NativePath/NativePath.h"
+#include "XenkoNative.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void SortSpriteKeys(unsigned long long* keys, int* indices, int count, unsigned long long* tempKeys, int* tempIndices)
+{
+	for (int i = 0; i < count; i++)
+	{
+		indices[i] = i;
+	}
+
+	if (count < 2)
+		return;
+
+	// Histograms of the 8 bytes of the keys, built in a single pass
+	int histograms[8][256];
+	for (int pass = 0; pass < 8; pass++)
+	{
+		for (int bucket = 0; bucket < 256; bucket++)
+		{
+			histograms[pass][bucket] = 0;
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		unsigned long long key = keys[i];
+		for (int pass = 0; pass < 8; pass++)
+		{
+			histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	unsigned long long* sourceKeys = keys;
+	int* sourceIndices = indices;
+	unsigned long long* destinationKeys = tempKeys;
+	int* destinationIndices = tempIndices;
+
+	// Stable LSD radix sort, 8 bits per pass
+	for (int pass = 0; pass < 8; pass++)
+	{
+		int* histogram = histograms[pass];
+		int shift = pass * 8;
+
+		// All the keys have the same byte, this pass would not change the order
+		if (histogram[(sourceKeys[0] >> shift) & 0xFF] == count)
+			continue;
+
+		int offset = 0;
+		for (int bucket = 0; bucket < 256; bucket++)
+		{
+			int bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			unsigned long long key = sourceKeys[i];
+			int position = histogram[(key >> shift) & 0xFF]++;
+			destinationKeys[position] = key;
+			destinationIndices[position] = sourceIndices[i];
+		}
+
+		unsigned long long* swapKeys = sourceKeys;
+		sourceKeys = destinationKeys;
+		destinationKeys = swapKeys;
+
+		int* swapIndices = sourceIndices;
+		sourceIndices = destinationIndices;
+		destinationIndices = swapIndices;
+	}
+
+	// An odd number of passes left the result in the temporary buffers
+	if (sourceKeys != keys)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			keys[i] = sourceKeys[i];
+			indices[i] = sourceIndices[i];
+		}
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,290 @@
+// Copyright (c) 2014 Silicon Studio Corp. (http://siliconstudio.co.jp)
+// This file is distributed under GPL v3. See LICENSE.md for details.
+
+#include "../../../deps/NativePath/NativePath.h"
+#include "XenkoNative.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Same values as UIBatch.PrimitiveType
+#define UI_PRIMITIVE_RECTANGLE 0
+#define UI_PRIMITIVE_BORDER_RECTANGLE 1
+#define UI_PRIMITIVE_CUBE 2
+#define UI_PRIMITIVE_REVERSE_CUBE 3
+
+// Same value as BatchBase.DepthBiasShiftOneUnit
+#define DEPTH_BIAS_SHIFT_ONE_UNIT 0.0001f
+
+static const short RectangleIndices[6] = { 0, 1, 2, 1, 3, 2 };
+
+static const short BorderRectangleIndices[54] =
+{
+	0, 1, 4, 1, 5, 4,		1, 2, 5, 2, 6, 5,		2, 3, 6, 3, 7, 6,
+	4, 5, 8, 5, 9, 8,		5, 6, 9, 6, 10, 9,		6, 7, 10, 7, 11, 10,
+	8, 9, 12, 9, 13, 12,	9, 10, 13, 10, 14, 13,	10, 11, 14, 11, 15, 14,
+};
+
+static const short CubeIndices[36] =
+{
+	0, 1, 2, 1, 3, 2, // front
+	1, 5, 7, 1, 7, 3, // right
+	5, 4, 6, 5, 6, 7, // back
+	4, 0, 2, 4, 2, 6, // left
+	1, 0, 4, 1, 4, 5, // top
+	2, 3, 6, 3, 7, 6, // bottom
+};
+
+static const short ReverseCubeIndices[36] =
+{
+	0, 2, 1, 1, 2, 3, // front
+	1, 7, 5, 1, 3, 7, // right
+	5, 6, 4, 5, 7, 6, // back
+	4, 2, 0, 4, 6, 2, // left
+	1, 4, 0, 1, 5, 4, // top
+	2, 6, 3, 3, 6, 7, // bottom
+};
+
+static inline void Vector4Add(Vector4* result, const Vector4* left, const Vector4* right)
+{
+	result->X = left->X + right->X;
+	result->Y = left->Y + right->Y;
+	result->Z = left->Z + right->Z;
+	result->W = left->W + right->W;
+}
+
+static inline void Vector4Subtract(Vector4* result, const Vector4* left, const Vector4* right)
+{
+	result->X = left->X - right->X;
+	result->Y = left->Y - right->Y;
+	result->Z = left->Z - right->Z;
+	result->W = left->W - right->W;
+}
+
+static inline void Vector4Multiply(Vector4* result, const Vector4* value, float scale)
+{
+	result->X = value->X * scale;
+	result->Y = value->Y * scale;
+	result->Z = value->Z * scale;
+	result->W = value->W * scale;
+}
+
+// Rounds to the nearest integer, ties to even (same as Math.Round)
+static inline double RoundHalfToEven(double value)
+{
+	if (!(value > -4503599627370496.0 && value < 4503599627370496.0)) // already integral (or NaN) above 2^52
+		return value;
+
+	double floorValue = (double)(long long)value;
+	if (floorValue > value)
+		floorValue -= 1.0;
+
+	double fraction = value - floorValue;
+	if (fraction > 0.5)
+		return floorValue + 1.0;
+	if (fraction < 0.5)
+		return floorValue;
+
+	return ((long long)floorValue & 1) ? floorValue + 1.0 : floorValue;
+}
+
+static inline float SnapToPixel(float value, int backBufferHalfSize)
+{
+	return (float)(RoundHalfToEven(value * backBufferHalfSize) / backBufferHalfSize);
+}
+
+static inline void SetVertexPosition(VertexPositionColorTextureSwizzle* vertex, const Vector4* position, int depthBias)
+{
+	vertex->Position.X = position->X;
+	vertex->Position.Y = position->Y;
+	vertex->Position.Z = position->Z - position->W * depthBias * DEPTH_BIAS_SHIFT_ONE_UNIT;
+	vertex->Position.W = position->W;
+}
+
+static inline void SetVertexColor(VertexPositionColorTextureSwizzle* vertex, const UIImageDrawInfo* drawInfo)
+{
+	vertex->Color.R = drawInfo->Color.R / 255.0f;
+	vertex->Color.G = drawInfo->Color.G / 255.0f;
+	vertex->Color.B = drawInfo->Color.B / 255.0f;
+	vertex->Color.A = drawInfo->Color.A / 255.0f;
+	vertex->Swizzle = (float)drawInfo->Swizzle;
+}
+
+static void CalculateRectangleVertices(const UIImageDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertex, int backBufferHalfWidth, int backBufferHalfHeight)
+{
+	Vector4 currentPosition = drawInfo->LeftTopCornerWorld;
+
+	// snap first pixel to prevent possible problems when left/top is in the middle of a pixel
+	if (drawInfo->SnapImage)
+	{
+		float invW = 1.0f / currentPosition.W;
+		currentPosition.X *= invW;
+		currentPosition.Y *= invW;
+		currentPosition.X = SnapToPixel(currentPosition.X, backBufferHalfWidth);
+		currentPosition.Y = SnapToPixel(currentPosition.Y, backBufferHalfHeight);
+		currentPosition.X *= currentPosition.W;
+		currentPosition.Y *= currentPosition.W;
+	}
+
+	float textureCoordX[2] = { drawInfo->Source.x, drawInfo->Source.x + drawInfo->Source.width };
+	float textureCoordY[2] = { drawInfo->Source.y, drawInfo->Source.y + drawInfo->Source.height };
+
+	for (int r = 0; r < 2; r++)
+	{
+		for (int c = 0; c < 2; c++)
+		{
+			SetVertexColor(vertex, drawInfo);
+			vertex->TextureCoordinate.X = textureCoordX[c];
+			vertex->TextureCoordinate.Y = textureCoordY[r];
+			SetVertexPosition(vertex, &currentPosition, drawInfo->DepthBias);
+
+			if (drawInfo->SnapImage)
+			{
+				vertex->Position.X = SnapToPixel(vertex->Position.X, backBufferHalfWidth);
+				vertex->Position.Y = SnapToPixel(vertex->Position.Y, backBufferHalfHeight);
+			}
+
+			vertex++;
+
+			if (c == 0)
+				Vector4Add(&currentPosition, &currentPosition, &drawInfo->UnitXWorld);
+			else
+				Vector4Subtract(&currentPosition, &currentPosition, &drawInfo->UnitXWorld);
+		}
+
+		Vector4Add(&currentPosition, &currentPosition, &drawInfo->UnitYWorld);
+	}
+}
+
+static void CalculateBorderRectangleVertices(const UIImageDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertex)
+{
+	// set the texture uv vectors
+	float uvX[4], uvY[4];
+	uvX[0] = drawInfo->Source.x;
+	uvX[3] = drawInfo->Source.x + drawInfo->Source.width;
+	uvX[1] = uvX[0] + drawInfo->Source.width * drawInfo->BorderSize.X;
+	uvX[2] = uvX[3] - drawInfo->Source.width * drawInfo->BorderSize.Z;
+	uvY[0] = drawInfo->Source.y;
+	uvY[3] = drawInfo->Source.y + drawInfo->Source.height;
+	uvY[1] = uvY[0] + drawInfo->Source.height * drawInfo->BorderSize.Y;
+	uvY[2] = uvY[3] - drawInfo->Source.height * drawInfo->BorderSize.W;
+
+	// set the shift vectors
+	Vector4 shiftVectorX[4], shiftVectorY[4];
+	shiftVectorX[0].X = shiftVectorX[0].Y = shiftVectorX[0].Z = shiftVectorX[0].W = 0;
+	Vector4Multiply(&shiftVectorX[1], &drawInfo->UnitXWorld, drawInfo->VertexShift.X);
+	Vector4Multiply(&shiftVectorX[2], &drawInfo->UnitXWorld, drawInfo->VertexShift.Z);
+	shiftVectorX[3] = drawInfo->UnitXWorld;
+
+	shiftVectorY[0] = shiftVectorX[0];
+	Vector4Multiply(&shiftVectorY[1], &drawInfo->UnitYWorld, drawInfo->VertexShift.Y);
+	Vector4Multiply(&shiftVectorY[2], &drawInfo->UnitYWorld, drawInfo->VertexShift.W);
+	shiftVectorY[3] = drawInfo->UnitYWorld;
+
+	for (int r = 0; r < 4; r++)
+	{
+		Vector4 currentRowPosition;
+		Vector4Add(&currentRowPosition, &drawInfo->LeftTopCornerWorld, &shiftVectorY[r]);
+
+		for (int c = 0; c < 4; c++)
+		{
+			Vector4 currentPosition;
+			Vector4Add(&currentPosition, &currentRowPosition, &shiftVectorX[c]);
+
+			SetVertexPosition(vertex, &currentPosition, drawInfo->DepthBias);
+			SetVertexColor(vertex, drawInfo);
+			vertex->TextureCoordinate.X = uvX[c];
+			vertex->TextureCoordinate.Y = uvY[r];
+
+			vertex++;
+		}
+	}
+}
+
+static void CalculateCubeVertices(const UIImageDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertex)
+{
+	Vector4 currentPosition = drawInfo->LeftTopCornerWorld;
+
+	for (int l = 0; l < 2; l++)
+	{
+		for (int r = 0; r < 2; r++)
+		{
+			for (int c = 0; c < 2; c++)
+			{
+				SetVertexColor(vertex, drawInfo);
+				vertex->TextureCoordinate.X = 0; // cubes are used only for color
+				vertex->TextureCoordinate.Y = 0;
+				SetVertexPosition(vertex, &currentPosition, drawInfo->DepthBias);
+
+				vertex++;
+
+				if (c == 0)
+					Vector4Add(&currentPosition, &currentPosition, &drawInfo->UnitXWorld);
+				else
+					Vector4Subtract(&currentPosition, &currentPosition, &drawInfo->UnitXWorld);
+			}
+
+			if (r == 0)
+				Vector4Add(&currentPosition, &currentPosition, &drawInfo->UnitYWorld);
+			else
+				Vector4Subtract(&currentPosition, &currentPosition, &drawInfo->UnitYWorld);
+		}
+
+		Vector4Add(&currentPosition, &currentPosition, &drawInfo->UnitZWorld);
+	}
+}
+
+int UpdateUIBufferValuesFromElementInfoBatch(UIImageDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, VertexPositionColorTextureSwizzle* vertexPointer, short* indexPointer, int vertexStartOffset, int backBufferHalfWidth, int backBufferHalfHeight)
+{
+	char* drawInfoBase = (char*)drawInfos;
+
+	for (int i = 0; i < count; i++)
+	{
+		int drawIndex = sortIndices ? sortIndices[i] : i;
+		const UIImageDrawInfo* drawInfo = (const UIImageDrawInfo*)(drawInfoBase + drawIndex * drawInfoStride);
+
+		const short* indices;
+		int vertexCount, indexCount;
+		switch (drawInfo->Primitive)
+		{
+			case UI_PRIMITIVE_RECTANGLE:
+				CalculateRectangleVertices(drawInfo, vertexPointer, backBufferHalfWidth, backBufferHalfHeight);
+				indices = RectangleIndices;
+				vertexCount = 4;
+				indexCount = 6;
+				break;
+			case UI_PRIMITIVE_BORDER_RECTANGLE:
+				CalculateBorderRectangleVertices(drawInfo, vertexPointer);
+				indices = BorderRectangleIndices;
+				vertexCount = 16;
+				indexCount = 54;
+				break;
+			case UI_PRIMITIVE_CUBE:
+			case UI_PRIMITIVE_REVERSE_CUBE:
+				CalculateCubeVertices(drawInfo, vertexPointer);
+				indices = drawInfo->Primitive == UI_PRIMITIVE_CUBE ? CubeIndices : ReverseCubeIndices;
+				vertexCount = 8;
+				indexCount = 36;
+				break;
+			default:
+				// unknown primitive, the caller reports the error
+				return i;
+		}
+
+		for (int j = 0; j < indexCount; j++)
+		{
+			indexPointer[j] = (short)(indices[j] + vertexStartOffset);
+		}
+
+		vertexPointer += vertexCount;
+		indexPointer += indexCount;
+		vertexStartOffset += vertexCount;
+	}
+
+	return count;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,6 +14,13 @@ typedef struct Vector2
 	float Y;
 } Vector2;
 
+typedef struct Vector3
+{
+	float X;
+	float Y;
+	float Z;
+} Vector3;
+
 typedef struct Vector4
 {
 	float X;
@@ -30,6 +37,14 @@ typedef struct Color4
 	float A;
 } Color4;
 
+typedef struct Color
+{
+	unsigned char R;
+	unsigned char G;
+	unsigned char B;
+	unsigned char A;
+} Color;
+
 typedef struct RectangleF
 {
 	float x;
@@ -45,6 +60,16 @@ typedef struct VertexPositionColorTextureSwizzle
 	Vector2 TextureCoordinate;
 	float Swizzle;
 } VertexPositionColorTextureSwizzle;
+
+// Compact vertex: W is implicitly 1, R8G8B8A8_UNorm color and R16G16_UNorm texture coordinates
+typedef struct VertexPositionColorTextureSwizzleCompact
+{
+	Vector3 Position;
+	Color Color;
+	unsigned short TextureCoordinateX;
+	unsigned short TextureCoordinateY;
+	float Swizzle;
+} VertexPositionColorTextureSwizzleCompact;
 #pragma pack(pop)
 
 #pragma pack(push, 8)
@@ -61,10 +86,59 @@ typedef struct SpriteDrawInfo
 	Vector2 TextureSize;
 	int Orientation;
 } SpriteDrawInfo;
+
+typedef struct UIImageDrawInfo
+{
+	Vector4 LeftTopCornerWorld;
+	Vector4 UnitXWorld;
+	Vector4 UnitYWorld;
+	Vector4 UnitZWorld;
+	RectangleF Source;
+	Vector4 BorderSize;
+	Vector4 VertexShift;
+	Color Color;
+	int DepthBias;
+	int Swizzle;
+	unsigned char SnapImage;
+	int Primitive;
+} UIImageDrawInfo;
+
+typedef struct Sprite3DDrawInfo
+{
+	Vector4 LeftTopCornerWorld;
+	Vector4 UnitXWorld;
+	Vector4 UnitYWorld;
+	RectangleF Source;
+	Color4 Color;
+	int Swizzle;
+} Sprite3DDrawInfo;
 #pragma pack(pop)
 
 extern void UpdateBufferValuesFromElementInfo(SpriteDrawInfo* drawInfo, VertexPositionColorTextureSwizzle* vertexPointer, void* indexPointer, int vertexStartOffset);
 
+// Fills the vertices of 'count' sprites in one call. Consecutive draw infos are 'drawInfoStride' bytes apart and are visited in 'sortIndices' order when it is not null.
+// When 'indexPointer' is not null, 6 indices per sprite are also written, starting at 'vertexStartOffset'.
+// Disjoint ranges of a batch can be filled concurrently from several threads. 'rotationPrecision' selects how the sprite rotations are evaluated (see FastMath.h).
+extern void UpdateBufferValuesFromElementInfoBatch(SpriteDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, VertexPositionColorTextureSwizzle* vertexPointer, void* indexPointer, int vertexStartOffset, int rotationPrecision);
+
+// Same as UpdateBufferValuesFromElementInfoBatch, writing compact vertices (colors and texture coordinates clamped to [0, 1]).
+extern void UpdateBufferValuesFromElementInfoBatchCompact(SpriteDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, VertexPositionColorTextureSwizzleCompact* vertexPointer, void* indexPointer, int vertexStartOffset, int rotationPrecision);
+
+// Sine and cosine of 'count' angles with the given precision, as used for the sprite rotations (angles below 1e-6 give 0 and 1).
+extern void FastSinCosBatch(float* angles, float* sines, float* cosines, int count, int precision);
+
+// Stable radix sort of 'count' 64-bit sort keys in ascending order. 'indices' receives the permutation (the original position of each sorted key) and 'keys' the sorted keys.
+// 'tempKeys' and 'tempIndices' are scratch buffers of 'count' elements provided by the caller.
+extern void SortSpriteKeys(unsigned long long* keys, int* indices, int count, unsigned long long* tempKeys, int* tempIndices);
+
+// Fills the vertices and indices of 'count' UI elements (rectangles, border rectangles and cubes), the number of vertices and indices written for each element depending on its primitive type.
+// The indices are offset by 'vertexStartOffset', the position of the first vertex in the vertex buffer. The back buffer half sizes are used to snap the rectangles to pixels.
+// Returns the number of elements written, which is less than 'count' when an element has an unknown primitive type.
+extern int UpdateUIBufferValuesFromElementInfoBatch(UIImageDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, VertexPositionColorTextureSwizzle* vertexPointer, short* indexPointer, int vertexStartOffset, int backBufferHalfWidth, int backBufferHalfHeight);
+
+// Fills the 4 vertices of 'count' world space quads, and their 6 indices when 'indexPointer' is not null.
+extern void UpdateSprite3DBufferValuesFromElementInfoBatch(Sprite3DDrawInfo* drawInfos, int drawInfoStride, int* sortIndices, int count, VertexPositionColorTextureSwizzle* vertexPointer, short* indexPointer, int vertexStartOffset);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,7 @@ namespace SiliconStudio.Xenko
         /// <remarks>
         /// Impact on compilation on other components:
         /// - Shaders are compiled in optimization level 2 with <c>no debug</c> information.
+        /// - Bundles are compressed with the optimal parsing of LZ4HC.
         /// </remarks>
         AppStore,
 
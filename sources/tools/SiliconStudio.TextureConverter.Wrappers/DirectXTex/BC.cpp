@@ -367,6 +367,286 @@ inline static void DecodeBC1( _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColo
 }
 
 
+//-------------------------------------------------------------------------------------
+// Quick BC1 color encoding (BC_FLAGS_QUICK)
+//
+// Instead of the root finding of OptimizeRGB, the endpoints are fitted along the principal
+// axis of the block, every pixel takes the nearest of the four palette entries, and the
+// endpoints are refined once by least squares. The pixels are processed four at a time,
+// transposed into XMVECTORs. Only 4-color blocks are produced, colorkeyed and dithered
+// blocks go through EncodeBC1.
+//-------------------------------------------------------------------------------------
+inline static uint16_t QuantizeRGB565(_Out_ XMVECTOR *pDecoded, _In_ FXMVECTOR color)
+{
+    static const XMVECTORF32 s_Scale    = { 31.f, 63.f, 31.f, 0.f };
+    static const XMVECTORF32 s_ScaleInv = { 1.f/31.f, 1.f/63.f, 1.f/31.f, 0.f };
+
+    XMVECTOR v = XMVectorTruncate( XMVectorMultiplyAdd( XMVectorSaturate( color ), s_Scale, g_XMOneHalf ) );
+    *pDecoded = XMVectorMultiply( v, s_ScaleInv );
+
+    XMFLOAT4 q;
+    XMStoreFloat4( &q, v );
+
+    return (uint16_t) ((static_cast<uint32_t>(q.x) << 11) |
+                       (static_cast<uint32_t>(q.y) <<  5) |
+                       (static_cast<uint32_t>(q.z) <<  0));
+}
+
+// Encodes the (unweighted) endpoints with the nearest palette entry for every point, returns the weighted squared error.
+// The points are transposed, each matrix holding the channels of four pixels in its rows.
+static float EncodeBC1Endpoints(_Out_ D3DX_BC1 *pBC, _In_ FXMVECTOR colorA, _In_ FXMVECTOR colorB,
+                                _In_reads_(NUM_PIXELS_PER_BLOCK / 4) const XMMATRIX *pPoints, _In_ FXMVECTOR weights)
+{
+    static const XMVECTORF32 s_Three    = { 3.f, 3.f, 3.f, 3.f };
+    static const XMVECTORF32 s_OneThird = { 1.f/3.f, 1.f/3.f, 1.f/3.f, 1.f/3.f };
+    static const uint32_t pSteps4[] = { 0, 2, 3, 1 };
+
+    XMVECTOR clr0, clr1;
+    uint16_t wColor0 = QuantizeRGB565( &clr0, colorA );
+    uint16_t wColor1 = QuantizeRGB565( &clr1, colorB );
+
+    // 4-color mode needs rgb[0] > rgb[1]
+    if ( wColor0 < wColor1 )
+    {
+        std::swap( wColor0, wColor1 );
+        std::swap( clr0, clr1 );
+    }
+
+    pBC->rgb[0] = wColor0;
+    pBC->rgb[1] = wColor1;
+
+    clr0 = XMVectorMultiply( clr0, weights );
+    clr1 = XMVectorMultiply( clr1, weights );
+
+    // The palette is evenly spaced on the segment between the endpoints, so the nearest entry to a point
+    // is given by its projection on the segment (always the first entry for a single color block)
+    XMVECTOR vDir = XMVectorSubtract( clr1, clr0 );
+    float fLen = XMVectorGetX( XMVector3LengthSq( vDir ) );
+    float fScale = (wColor0 != wColor1) ? (3.0f / fLen) : 0.0f;
+
+    XMVECTOR clrR = XMVectorSplatX( clr0 );
+    XMVECTOR clrG = XMVectorSplatY( clr0 );
+    XMVECTOR clrB = XMVectorSplatZ( clr0 );
+
+    XMVECTOR dirR = XMVectorSplatX( vDir );
+    XMVECTOR dirG = XMVectorSplatY( vDir );
+    XMVECTOR dirB = XMVectorSplatZ( vDir );
+
+    XMVECTOR vError = XMVectorZero();
+    uint32_t dw = 0;
+
+    for(size_t iQuad = 0; iQuad < NUM_PIXELS_PER_BLOCK / 4; ++iQuad)
+    {
+        const XMMATRIX& P = pPoints[iQuad];
+
+        XMVECTOR dr = XMVectorSubtract( P.r[0], clrR );
+        XMVECTOR dg = XMVectorSubtract( P.r[1], clrG );
+        XMVECTOR db = XMVectorSubtract( P.r[2], clrB );
+
+        XMVECTOR t = XMVectorMultiply( dr, dirR );
+        t = XMVectorMultiplyAdd( dg, dirG, t );
+        t = XMVectorMultiplyAdd( db, dirB, t );
+
+        // Nearest step, from 0 at the first endpoint to 3 at the second one
+        t = XMVectorClamp( XMVectorScale( t, fScale ), g_XMZero, s_Three );
+        t = XMVectorTruncate( XMVectorAdd( t, g_XMOneHalf ) );
+
+        XMVECTOR f = XMVectorMultiply( t, s_OneThird );
+        dr = XMVectorNegativeMultiplySubtract( f, dirR, dr );
+        dg = XMVectorNegativeMultiplySubtract( f, dirG, dg );
+        db = XMVectorNegativeMultiplySubtract( f, dirB, db );
+
+        vError = XMVectorMultiplyAdd( dr, dr, vError );
+        vError = XMVectorMultiplyAdd( dg, dg, vError );
+        vError = XMVectorMultiplyAdd( db, db, vError );
+
+        XMFLOAT4 step;
+        XMStoreFloat4( &step, t );
+
+        dw |= ((pSteps4[static_cast<size_t>(step.x)] << 0) |
+               (pSteps4[static_cast<size_t>(step.y)] << 2) |
+               (pSteps4[static_cast<size_t>(step.z)] << 4) |
+               (pSteps4[static_cast<size_t>(step.w)] << 6)) << (8 * iQuad);
+    }
+
+    pBC->bitmap = dw;
+
+    vError = XMVectorAdd( vError, XMVectorSwizzle<1, 0, 3, 2>( vError ) );
+    vError = XMVectorAdd( vError, XMVectorSwizzle<2, 3, 0, 1>( vError ) );
+
+    return XMVectorGetX( vError );
+}
+
+static void EncodeBC1Quick(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *pColor, _In_ DWORD flags)
+{
+    assert( pBC && pColor );
+
+    // Weight of the first endpoint for each index
+    static const float pC4[] = { 1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f };
+
+    XMVECTOR weights, weightsInv;
+    if ( flags & BC_FLAGS_UNIFORM )
+    {
+        weights = weightsInv = g_XMOne;
+    }
+    else
+    {
+        weights = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( &g_Luminance ) );
+        weightsInv = XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( &g_LuminanceInv ) );
+    }
+
+    XMVECTOR Points[NUM_PIXELS_PER_BLOCK];
+    XMVECTOR vMean = XMVectorZero();
+
+    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        Points[i] = XMVectorMultiply( XMLoadFloat4( reinterpret_cast<const XMFLOAT4*>( &pColor[i] ) ), weights );
+        vMean = XMVectorAdd( vMean, Points[i] );
+    }
+
+    vMean = XMVectorScale( vMean, 1.0f / NUM_PIXELS_PER_BLOCK );
+
+    // Transposed copy of the points, four pixels at a time in each channel
+    XMMATRIX Quads[NUM_PIXELS_PER_BLOCK / 4];
+
+    for(size_t iQuad = 0; iQuad < NUM_PIXELS_PER_BLOCK / 4; ++iQuad)
+    {
+        const XMVECTOR *pQuad = &Points[iQuad * 4];
+        Quads[iQuad] = XMMatrixTranspose( XMMATRIX( pQuad[0], pQuad[1], pQuad[2], pQuad[3] ) );
+    }
+
+    // Covariance matrix, as its diagonal (rr, gg, bb) and the other terms (rg, gb, br)
+    XMVECTOR vDiag = XMVectorZero();
+    XMVECTOR vCross = XMVectorZero();
+
+    for(size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        XMVECTOR d = XMVectorSubtract( Points[i], vMean );
+        vDiag = XMVectorMultiplyAdd( d, d, vDiag );
+        vCross = XMVectorMultiplyAdd( d, XMVectorSwizzle<1, 2, 0, 3>( d ), vCross );
+    }
+
+    XMFLOAT4 diag;
+    XMStoreFloat4( &diag, vDiag );
+
+    float fTrace = diag.x + diag.y + diag.z;
+
+    // Single color block.. no axis to fit
+    if ( fTrace < FLT_MIN )
+    {
+        XMVECTOR clr = XMVectorMultiply( vMean, weightsInv );
+        EncodeBC1Endpoints( pBC, clr, clr, Quads, weights );
+        return;
+    }
+
+    // Principal axis by power iteration, starting from the column of the channel with the largest variance.
+    // The matrix is scaled by its trace, which keeps the largest eigenvalue between 1/3 and 1.
+    vDiag = XMVectorScale( vDiag, 1.0f / fTrace );
+    vCross = XMVectorScale( vCross, 1.0f / fTrace );
+
+    XMVECTOR col0 = XMVectorPermute<XM_PERMUTE_0X, XM_PERMUTE_1X, XM_PERMUTE_1Z, XM_PERMUTE_0W>( vDiag, vCross );
+    XMVECTOR col1 = XMVectorPermute<XM_PERMUTE_1X, XM_PERMUTE_0Y, XM_PERMUTE_1Y, XM_PERMUTE_0W>( vDiag, vCross );
+    XMVECTOR col2 = XMVectorPermute<XM_PERMUTE_1Z, XM_PERMUTE_1Y, XM_PERMUTE_0Z, XM_PERMUTE_0W>( vDiag, vCross );
+
+    XMVECTOR vAxis = (diag.x > diag.y) ? ((diag.x > diag.z) ? col0 : col2) : ((diag.y > diag.z) ? col1 : col2);
+
+    for(size_t iIteration = 0; iIteration < 4; ++iIteration)
+    {
+        XMVECTOR v = XMVectorMultiply( col0, XMVectorSplatX( vAxis ) );
+        v = XMVectorMultiplyAdd( col1, XMVectorSplatY( vAxis ), v );
+        vAxis = XMVectorMultiplyAdd( col2, XMVectorSplatZ( vAxis ), v );
+    }
+
+    vAxis = XMVector3Normalize( vAxis );
+
+    // Endpoints at the extent of the points along the axis, inset by 1/16th of the range
+    XMVECTOR axisR = XMVectorSplatX( vAxis );
+    XMVECTOR axisG = XMVectorSplatY( vAxis );
+    XMVECTOR axisB = XMVectorSplatZ( vAxis );
+
+    XMVECTOR tMin = g_XMFltMax;
+    XMVECTOR tMax = XMVectorNegate( g_XMFltMax );
+
+    for(size_t iQuad = 0; iQuad < NUM_PIXELS_PER_BLOCK / 4; ++iQuad)
+    {
+        XMVECTOR t = XMVectorMultiply( Quads[iQuad].r[0], axisR );
+        t = XMVectorMultiplyAdd( Quads[iQuad].r[1], axisG, t );
+        t = XMVectorMultiplyAdd( Quads[iQuad].r[2], axisB, t );
+
+        tMin = XMVectorMin( tMin, t );
+        tMax = XMVectorMax( tMax, t );
+    }
+
+    tMin = XMVectorMin( tMin, XMVectorSwizzle<1, 0, 3, 2>( tMin ) );
+    tMin = XMVectorMin( tMin, XMVectorSwizzle<2, 3, 0, 1>( tMin ) );
+    tMax = XMVectorMax( tMax, XMVectorSwizzle<1, 0, 3, 2>( tMax ) );
+    tMax = XMVectorMax( tMax, XMVectorSwizzle<2, 3, 0, 1>( tMax ) );
+
+    XMVECTOR tInset = XMVectorScale( XMVectorSubtract( tMax, tMin ), 1.0f / 16.0f );
+    tMin = XMVectorAdd( tMin, tInset );
+    tMax = XMVectorSubtract( tMax, tInset );
+
+    XMVECTOR tMean = XMVector3Dot( vMean, vAxis );
+
+    XMVECTOR clrA = XMVectorMultiplyAdd( vAxis, XMVectorSubtract( tMax, tMean ), vMean );
+    XMVECTOR clrB = XMVectorMultiplyAdd( vAxis, XMVectorSubtract( tMin, tMean ), vMean );
+
+    float fError = EncodeBC1Endpoints( pBC, XMVectorMultiply( clrA, weightsInv ), XMVectorMultiply( clrB, weightsInv ), Quads, weights );
+
+    if ( fError <= 0.0f )
+        return;
+
+    // Least squares endpoints for the chosen indices, kept if they improve the block.
+    // With a the weight of the first endpoint for each point x: sums of a.x (per channel), a and a.a
+    XMVECTOR vAR = XMVectorZero();
+    XMVECTOR vAG = XMVectorZero();
+    XMVECTOR vAB = XMVectorZero();
+    XMVECTOR vA = XMVectorZero();
+    XMVECTOR vAA = XMVectorZero();
+
+    for(size_t iQuad = 0; iQuad < NUM_PIXELS_PER_BLOCK / 4; ++iQuad)
+    {
+        uint32_t dw = pBC->bitmap >> (8 * iQuad);
+        XMVECTOR a = XMVectorSet( pC4[dw & 3], pC4[(dw >> 2) & 3], pC4[(dw >> 4) & 3], pC4[(dw >> 6) & 3] );
+
+        vAR = XMVectorMultiplyAdd( a, Quads[iQuad].r[0], vAR );
+        vAG = XMVectorMultiplyAdd( a, Quads[iQuad].r[1], vAG );
+        vAB = XMVectorMultiplyAdd( a, Quads[iQuad].r[2], vAB );
+        vA = XMVectorAdd( vA, a );
+        vAA = XMVectorMultiplyAdd( a, a, vAA );
+    }
+
+    XMMATRIX sums = XMMatrixTranspose( XMMATRIX( vAR, vAG, vAB, vA ) );
+    XMVECTOR vAX = XMVectorAdd( XMVectorAdd( sums.r[0], sums.r[1] ), XMVectorAdd( sums.r[2], sums.r[3] ) );
+    XMVECTOR vBX = XMVectorSubtract( XMVectorScale( vMean, (float) NUM_PIXELS_PER_BLOCK ), vAX );
+
+    vAA = XMVectorAdd( vAA, XMVectorSwizzle<1, 0, 3, 2>( vAA ) );
+    vAA = XMVectorAdd( vAA, XMVectorSwizzle<2, 3, 0, 1>( vAA ) );
+
+    float fA = XMVectorGetW( vAX );
+    float fAA = XMVectorGetX( vAA );
+    float fAB = fA - fAA;
+    float fBB = (float) NUM_PIXELS_PER_BLOCK - 2.0f * fA + fAA;
+
+    float fDet = fAA * fBB - fAB * fAB;
+
+    // All the points on one index, nothing to solve
+    if ( fDet < 1.0f / 16.0f )
+        return;
+
+    float fInvDet = 1.0f / fDet;
+
+    clrA = XMVectorScale( XMVectorSubtract( XMVectorScale( vAX, fBB ), XMVectorScale( vBX, fAB ) ), fInvDet );
+    clrB = XMVectorScale( XMVectorSubtract( XMVectorScale( vBX, fAA ), XMVectorScale( vAX, fAB ) ), fInvDet );
+
+    D3DX_BC1 BC;
+    if ( EncodeBC1Endpoints( &BC, XMVectorMultiply( clrA, weightsInv ), XMVectorMultiply( clrB, weightsInv ), Quads, weights ) < fError )
+    {
+        *pBC = BC;
+    }
+}
+
+
 //-------------------------------------------------------------------------------------
 
 static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA *pColor,
@@ -403,6 +683,12 @@ static void EncodeBC1(_Out_ D3DX_BC1 *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) cons
         uSteps = 4;
     }
 
+    if ( (flags & BC_FLAGS_QUICK) && (4 == uSteps) && !(flags & BC_FLAGS_DITHER_RGB) )
+    {
+        EncodeBC1Quick(pBC, pColor, flags);
+        return;
+    }
+
     // Quantize block to R56B5, using Floyd Stienberg error diffusion.  This 
     // increases the chance that colors will map directly to the quantized 
     // axis endpoints.
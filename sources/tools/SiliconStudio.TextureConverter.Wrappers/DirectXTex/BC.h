@@ -60,6 +60,7 @@ enum BC_FLAGS
     BC_FLAGS_DITHER_A   = 0x20000,  // Enables dithering for Alpha channel for BC1-3
     BC_FLAGS_UNIFORM    = 0x40000,  // By default, uses perceptual weighting for BC1-3; this flag makes it a uniform weighting
     BC_FLAGS_USE_3SUBSETS = 0x80000,// By default, BC7 skips mode 0 & 2; this flag adds those modes back
+    BC_FLAGS_QUICK      = 0x100000, // Uses a principal axis fit instead of the iterative endpoint search for BC1-3 colors
 };
 
 //-------------------------------------------------------------------------------------
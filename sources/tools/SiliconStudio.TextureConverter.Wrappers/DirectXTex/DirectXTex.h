@@ -514,6 +514,9 @@ namespace DirectX
         TEX_COMPRESS_BC7_USE_3SUBSETS = 0x80000,
             // Enables exhaustive search for BC7 compress for mode 0 and 2; by default skips trying these modes
 
+        TEX_COMPRESS_QUICK          = 0x100000,
+            // Quick BC1-3 color compression (principal axis fit instead of iterative endpoint search); ignored when dithering RGB
+
         TEX_COMPRESS_SRGB_IN        = 0x1000000,
         TEX_COMPRESS_SRGB_OUT       = 0x2000000,
         TEX_COMPRESS_SRGB           = ( TEX_COMPRESS_SRGB_IN | TEX_COMPRESS_SRGB_OUT ),
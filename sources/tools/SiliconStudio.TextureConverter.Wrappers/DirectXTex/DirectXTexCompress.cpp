@@ -15,10 +15,9 @@
 
 #include "directxtexp.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#pragma warning(disable : 4616 6993)
-#endif
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #include "bc.h"
 
@@ -33,7 +32,8 @@ inline static DWORD _GetBCFlags( _In_ DWORD compress )
     static_assert( TEX_COMPRESS_DITHER == (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A), "TEX_COMPRESS_* flags should match BC_FLAGS_*"  );
     static_assert( TEX_COMPRESS_UNIFORM == BC_FLAGS_UNIFORM, "TEX_COMPRESS_* flags should match BC_FLAGS_*"  );
     static_assert( TEX_COMPRESS_BC7_USE_3SUBSETS == BC_FLAGS_USE_3SUBSETS, "TEX_COMPRESS_* flags should match BC_FLAGS_*"  );
-    return ( compress & (BC_FLAGS_DITHER_RGB|BC_FLAGS_DITHER_A|BC_FLAGS_UNIFORM|BC_FLAGS_USE_3SUBSETS) );
+    static_assert( TEX_COMPRESS_QUICK == BC_FLAGS_QUICK, "TEX_COMPRESS_* flags should match BC_FLAGS_*"  );
+    return ( compress & (BC_FLAGS_DITHER_RGB|BC_FLAGS_DITHER_A|BC_FLAGS_UNIFORM|BC_FLAGS_USE_3SUBSETS|BC_FLAGS_QUICK) );
 }
 
 inline static DWORD _GetSRGBFlags( _In_ DWORD compress )
@@ -187,17 +187,171 @@ static HRESULT _CompressBC( _In_ const Image& image, _In_ const Image& result, _
 
 
 //-------------------------------------------------------------------------------------
-#ifdef _OPENMP
-static HRESULT _CompressBC_Parallel( _In_ const Image& image, _In_ const Image& result, _In_ DWORD bcflags,
-                                     _In_ DWORD srgb, _In_ float alphaRef )
+// Parallel compression
+//
+// The blocks of all the images compressed at once (mips, array slices and cube faces alike) are numbered one after the
+// other, and each thread starts with an equal contiguous range of them. A thread compresses its range from the front, a
+// few blocks at a time; once it is empty, it steals the back half of the largest range left, so that all the threads
+// finish together even though the blocks don't cost the same (small mips, flat areas, BC6H/BC7 modes). The threads stop
+// when every range is empty.
+//-------------------------------------------------------------------------------------
+namespace
 {
-    if ( !image.pixels || !result.pixels )
-        return E_POINTER;
+    // Blocks taken at once from the front of a range
+    const size_t BC_PARALLEL_GRAIN = 16;
 
-    assert( image.width == result.width );
-    assert( image.height == result.height );
+    struct BCEncoderSettings
+    {
+        BC_ENCODE   pfEncode;
+        size_t      blocksize;
+        DWORD       cflags;
+        DWORD       bcflags;
+        DWORD       srgb;
+        float       alphaRef;
+    };
+
+    class BCBlockRange
+    {
+    public:
+        BCBlockRange() : m_begin(0), m_end(0) {}
 
-    const DXGI_FORMAT format = image.format;
+        void Reset( _In_ size_t begin, _In_ size_t end )
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_begin = begin;
+            m_end = end;
+        }
+
+        size_t Size()
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            return m_end - m_begin;
+        }
+
+        // Takes up to count blocks from the front, the ones the owner of the range compresses next
+        bool Pop( _In_ size_t count, _Out_ size_t& begin, _Out_ size_t& end )
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if ( m_begin >= m_end )
+                return false;
+
+            begin = m_begin;
+            end = std::min<size_t>( m_end, m_begin + count );
+            m_begin = end;
+            return true;
+        }
+
+        // Takes the back half of the range, leaving its owner the blocks it is about to compress
+        bool Steal( _Out_ size_t& begin, _Out_ size_t& end )
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            size_t count = m_end - m_begin;
+            if ( !count )
+                return false;
+
+            end = m_end;
+            begin = m_end - ( count + 1 ) / 2;
+            m_end = begin;
+            return true;
+        }
+
+    private:
+        std::mutex  m_mutex;
+        size_t      m_begin;
+        size_t      m_end;
+    };
+}
+
+//-------------------------------------------------------------------------------------
+static bool _CompressBlock( _In_ const Image& image, _In_ const Image& result, _In_ size_t nb, _In_ size_t sbpp,
+                            _In_ const BCEncoderSettings& settings )
+{
+    const size_t nbWidth = std::max<size_t>(1, (image.width + 3) / 4 );
+
+    const size_t y = ( nb / nbWidth ) * 4;
+    const size_t x = ( nb - ( nb / nbWidth ) * nbWidth ) * 4;
+
+    assert( x < image.width && y < image.height );
+
+    size_t rowPitch = image.rowPitch;
+    const uint8_t *pSrc = image.pixels + (y*rowPitch) + (x*sbpp);
+
+    uint8_t *pDest = result.pixels + (nb*settings.blocksize);
+
+    size_t ph = std::min<size_t>( 4, image.height - y );
+    size_t pw = std::min<size_t>( 4, image.width - x );
+    assert( pw > 0 && ph > 0 );
+
+    XMVECTOR temp[16];
+    if ( !_LoadScanline( &temp[0], pw, pSrc, rowPitch, image.format ) )
+        return false;
+
+    if ( ph > 1 )
+    {
+        if ( !_LoadScanline( &temp[4], pw, pSrc + rowPitch, rowPitch, image.format ) )
+            return false;
+
+        if ( ph > 2 )
+        {
+            if ( !_LoadScanline( &temp[8], pw, pSrc + rowPitch*2, rowPitch, image.format ) )
+                return false;
+
+            if ( ph > 3 )
+            {
+                if ( !_LoadScanline( &temp[12], pw, pSrc + rowPitch*3, rowPitch, image.format ) )
+                    return false;
+            }
+        }
+    }
+
+    if ( pw != 4 || ph != 4 )
+    {
+        // Replicate pixels for partial block
+        static const size_t uSrc[] = { 0, 0, 0, 1 };
+
+        if ( pw < 4 )
+        {
+            for( size_t t = 0; t < ph && t < 4; ++t )
+            {
+                for( size_t s = pw; s < 4; ++s )
+                {
+#pragma prefast(suppress: 26000, "PREFAST false positive")
+                    temp[ (t << 2) | s ] = temp[ (t << 2) | uSrc[s] ]; 
+                }
+            }
+        }
+
+        if ( ph < 4 )
+        {
+            for( size_t t = ph; t < 4; ++t )
+            {
+                for( size_t s = 0; s < 4; ++s )
+                {
+#pragma prefast(suppress: 26000, "PREFAST false positive")
+                    temp[ (t << 2) | s ] = temp[ (uSrc[t] << 2) | s ]; 
+                }
+            }
+        }
+    }
+
+    _ConvertScanline( temp, 16, result.format, image.format, settings.cflags | settings.srgb );
+
+    if ( settings.pfEncode )
+        settings.pfEncode( pDest, temp, settings.bcflags );
+    else
+        D3DXEncodeBC1( pDest, temp, settings.alphaRef, settings.bcflags );
+
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------
+static HRESULT _CompressBC_Parallel( _In_reads_(nimages) const Image* images, _In_reads_(nimages) const Image* results, _In_ size_t nimages,
+                                     _In_ DWORD bcflags, _In_ DWORD srgb, _In_ float alphaRef )
+{
+    assert( images && results && nimages > 0 );
+
+    const DXGI_FORMAT format = images[0].format;
     size_t sbpp = BitsPerPixel( format );
     if ( !sbpp )
         return E_FAIL;
@@ -212,99 +366,129 @@ static HRESULT _CompressBC_Parallel( _In_ const Image& image, _In_ const Image&
     sbpp = ( sbpp + 7 ) / 8;
 
     // Determine BC format encoder
-    BC_ENCODE pfEncode;
-    size_t blocksize;
-    DWORD cflags;
-    if ( !_DetermineEncoderSettings( result.format, pfEncode, blocksize, cflags ) )
+    BCEncoderSettings settings;
+    if ( !_DetermineEncoderSettings( results[0].format, settings.pfEncode, settings.blocksize, settings.cflags ) )
         return HRESULT_FROM_WIN32( ERROR_NOT_SUPPORTED );
 
-    // Refactored version of loop to support parallel independance
-    const size_t nBlocks = std::max<size_t>(1, (image.width + 3) / 4 ) * std::max<size_t>(1, (image.height + 3) / 4 );
+    settings.bcflags = bcflags;
+    settings.srgb = srgb;
+    settings.alphaRef = alphaRef;
 
-    bool fail = false;
+    // Number the blocks of all the images one after the other
+    std::unique_ptr<size_t[]> firstBlocks( new (std::nothrow) size_t[ nimages + 1 ] );
+    if ( !firstBlocks )
+        return E_OUTOFMEMORY;
 
-#pragma omp parallel for
-    for( int nb=0; nb < static_cast<int>( nBlocks ); ++nb )
+    firstBlocks[0] = 0;
+    for( size_t index = 0; index < nimages; ++index )
     {
-        const size_t nbWidth = std::max<size_t>(1, (image.width + 3) / 4 );
+        const Image& image = images[ index ];
+        const Image& result = results[ index ];
 
-        const size_t y = nb / nbWidth;
-        const size_t x = nb - (y*nbWidth);
+        if ( !image.pixels || !result.pixels )
+            return E_POINTER;
 
-        assert( x < image.width && y < image.height );
+        assert( image.width == result.width );
+        assert( image.height == result.height );
 
-        size_t rowPitch = image.rowPitch;
-        const uint8_t *pSrc = image.pixels + (y*4*rowPitch) + (x*4*sbpp);
+        if ( image.format != format || result.format != results[0].format )
+            return E_FAIL;
 
-        uint8_t *pDest = result.pixels + (nb*blocksize);
+        const size_t nBlocks = std::max<size_t>(1, (image.width + 3) / 4 ) * std::max<size_t>(1, (image.height + 3) / 4 );
+        firstBlocks[ index + 1 ] = firstBlocks[ index ] + nBlocks;
+    }
 
-        size_t ph = std::min<size_t>( 4, image.height - y );
-        size_t pw = std::min<size_t>( 4, image.width - x );
-        assert( pw > 0 && ph > 0 );
+    const size_t totalBlocks = firstBlocks[ nimages ];
 
-        XMVECTOR temp[16];
-        if ( !_LoadScanline( &temp[0], pw, pSrc, rowPitch, format ) )
-            fail = true;
+    size_t nthreads = std::max<size_t>( 1, std::thread::hardware_concurrency() );
+    nthreads = std::min<size_t>( nthreads, ( totalBlocks + BC_PARALLEL_GRAIN - 1 ) / BC_PARALLEL_GRAIN );
 
-        if ( ph > 1 )
-        {
-            if ( !_LoadScanline( &temp[4], pw, pSrc + rowPitch, rowPitch, format ) )
-                fail = true;
+    std::unique_ptr<BCBlockRange[]> ranges( new (std::nothrow) BCBlockRange[ nthreads ] );
+    if ( !ranges )
+        return E_OUTOFMEMORY;
 
-            if ( ph > 2 )
-            {
-                if ( !_LoadScanline( &temp[8], pw, pSrc + rowPitch*2, rowPitch, format ) )
-                    fail = true;
+    for( size_t t = 0; t < nthreads; ++t )
+    {
+        ranges[ t ].Reset( totalBlocks * t / nthreads, totalBlocks * (t + 1) / nthreads );
+    }
 
-                if ( ph > 3 )
-                {
-                    if ( !_LoadScanline( &temp[12], pw, pSrc + rowPitch*3, rowPitch, format ) )
-                        fail = true;
-                }
-            }
-        }
+    std::atomic<bool> fail( false );
 
-        if ( pw != 4 || ph != 4 )
-        {
-            // Replicate pixels for partial block
-            static const size_t uSrc[] = { 0, 0, 0, 1 };
+    auto worker = [&]( size_t t )
+    {
+        BCBlockRange& own = ranges[ t ];
+        size_t index = 0;
 
-            if ( pw < 4 )
+        while ( !fail )
+        {
+            size_t begin, end;
+            if ( !own.Pop( BC_PARALLEL_GRAIN, begin, end ) )
             {
-                for( size_t t = 0; t < ph && t < 4; ++t )
+                // Steal from the largest range left, until all of them are empty
+                size_t victim = t;
+                size_t victimSize = 0;
+                for( size_t v = 0; v < nthreads; ++v )
                 {
-                    for( size_t s = pw; s < 4; ++s )
+                    size_t size = ( v != t ) ? ranges[ v ].Size() : 0;
+                    if ( size > victimSize )
                     {
-                        temp[ (t << 2) | s ] = temp[ (t << 2) | uSrc[s] ]; 
+                        victim = v;
+                        victimSize = size;
                     }
                 }
+
+                if ( !victimSize )
+                    break;
+
+                if ( ranges[ victim ].Steal( begin, end ) )
+                    own.Reset( begin, end );
+
+                continue;
             }
 
-            if ( ph < 4 )
+            // Find the image of the first block; the following ones are in the same image or the next ones
+            if ( begin < firstBlocks[ index ] || begin >= firstBlocks[ index + 1 ] )
+                index = std::upper_bound( &firstBlocks[0], &firstBlocks[ nimages ], begin ) - &firstBlocks[0] - 1;
+
+            for( size_t nb = begin; nb < end; ++nb )
             {
-                for( size_t t = ph; t < 4; ++t )
-                {
-                    for( size_t s = 0; s < 4; ++s )
-                    {
-                        temp[ (t << 2) | s ] = temp[ (uSrc[t] << 2) | s ]; 
-                    }
-                }
+                while ( nb >= firstBlocks[ index + 1 ] )
+                    ++index;
+
+                if ( !_CompressBlock( images[ index ], results[ index ], nb - firstBlocks[ index ], sbpp, settings ) )
+                    fail = true;
             }
         }
+    };
 
-        _ConvertScanline( temp, 16, result.format, format, cflags | srgb );
-            
-        if ( pfEncode )
-            pfEncode( pDest, temp, bcflags );
-        else
-            D3DXEncodeBC1( pDest, temp, alphaRef, bcflags );
+    // The calling thread compresses the first range; if a thread can't be started, its range is stolen by the others
+    std::unique_ptr<std::thread[]> threads( new (std::nothrow) std::thread[ nthreads ] );
+    if ( !threads )
+        return E_OUTOFMEMORY;
+
+    for( size_t t = 1; t < nthreads; ++t )
+    {
+        try
+        {
+            threads[ t ] = std::thread( worker, t );
+        }
+        catch( ... )
+        {
+            break;
+        }
+    }
+
+    worker( 0 );
+
+    for( size_t t = 1; t < nthreads; ++t )
+    {
+        if ( threads[ t ].joinable() )
+            threads[ t ].join();
     }
 
     return (fail) ? E_FAIL : S_OK;
 }
 
-#endif // _OPENMP
-
 
 //-------------------------------------------------------------------------------------
 static DXGI_FORMAT _DefaultDecompress( _In_ DXGI_FORMAT format )
@@ -586,11 +770,7 @@ HRESULT Compress( const Image& srcImage, DXGI_FORMAT format, DWORD compress, flo
     // Compress single image
     if (compress & TEX_COMPRESS_PARALLEL)
     {
-#ifndef _OPENMP
-        return E_NOTIMPL;
-#else
-        hr = _CompressBC_Parallel( srcImage, *img, _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
-#endif // _OPENMP
+        hr = _CompressBC_Parallel( &srcImage, img, 1, _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
     }
     else
     {
@@ -650,23 +830,7 @@ HRESULT Compress( const Image* srcImages, size_t nimages, const TexMetadata& met
             return E_FAIL;
         }
 
-        if ( (compress & TEX_COMPRESS_PARALLEL) )
-        {
-#ifndef _OPENMP
-            return E_NOTIMPL;
-#else
-            if ( compress & TEX_COMPRESS_PARALLEL )
-            {
-                hr = _CompressBC_Parallel( src, dest[ index ], _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
-                if ( FAILED(hr) )
-                {
-                    cImages.Release();
-                    return  hr;
-                }
-            }
-#endif // _OPENMP
-        }
-        else
+        if ( !(compress & TEX_COMPRESS_PARALLEL) )
         {
             hr = _CompressBC( src, dest[ index ], _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
             if ( FAILED(hr) )
@@ -677,6 +841,17 @@ HRESULT Compress( const Image* srcImages, size_t nimages, const TexMetadata& met
         }
     }
 
+    if ( compress & TEX_COMPRESS_PARALLEL )
+    {
+        // Compress all the images at once, so that the threads share the blocks of every mip, array slice and cube face
+        hr = _CompressBC_Parallel( srcImages, dest, nimages, _GetBCFlags( compress ), _GetSRGBFlags( compress ), alphaRef );
+        if ( FAILED(hr) )
+        {
+            cImages.Release();
+            return hr;
+        }
+    }
+
     return S_OK;
 }
 
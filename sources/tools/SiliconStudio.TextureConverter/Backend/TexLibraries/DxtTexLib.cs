@@ -303,8 +303,12 @@ namespace SiliconStudio.TextureConverter.TexLibraries
                     throw new TextureToolsException(string.Format("The provided texture cannot be compressed into format '{0}' " +
                                                                   "because its top resolution ({1}-{2}) is not a multiple of 4.", request.Format, topImage.Width, topImage.Height));
 
+                var compressFlags = TEX_COMPRESS_FLAGS.TEX_COMPRESS_PARALLEL;
+                if (request.Quality == TextureQuality.Fast)
+                    compressFlags |= TEX_COMPRESS_FLAGS.TEX_COMPRESS_QUICK;
+
                 hr = Utilities.Compress(libraryData.DxtImages, libraryData.DxtImages.Length, ref libraryData.Metadata, 
-                                        RetrieveNativeFormat(request.Format), TEX_COMPRESS_FLAGS.TEX_COMPRESS_DEFAULT, 0.5f, scratchImage);
+                                        RetrieveNativeFormat(request.Format), compressFlags, 0.5f, scratchImage);
             }
             else
             {
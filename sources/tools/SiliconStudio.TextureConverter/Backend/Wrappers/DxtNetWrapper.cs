@@ -230,6 +230,11 @@ namespace SiliconStudio.TextureConverter.DxtWrapper
         /// </summary>
         TEX_COMPRESS_UNIFORM = 0x40000,
 
+        /// <summary>
+        /// Quick BC1-3 color compression, fitting the endpoints on the principal axis of each block; ignored when dithering RGB colors
+        /// </summary>
+        TEX_COMPRESS_QUICK = 0x100000,
+
         /// <summary>
         /// Compress is free to use multithreading to improve performance (by default it does not use multithreading)
         /// </summary>